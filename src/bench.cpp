@@ -0,0 +1,387 @@
+#include <destoer/destoer.h>
+#include <albion/lib.h>
+
+// simple timing harness for hot paths that are hard to measure inside a full frontend
+// run with -b <rom>
+
+#include <albion/scheduler.h>
+
+// events that rearm themselves with a spread of periods, like the timers and ppus do
+// with a reschedule thrown in every few steps, like a register write moving a timer
+enum class bench_event
+{
+    e0, e1, e2, e3, e4, e5, e6,
+};
+
+static constexpr u32 BENCH_EVENT_SIZE = 7;
+static constexpr u64 BENCH_EVENT_PERIOD[BENCH_EVENT_SIZE] = {4,16,64,228,456,1024,70224};
+
+struct BenchScheduler final : public Scheduler<BENCH_EVENT_SIZE,bench_event,BenchScheduler>
+{
+    void arm(const EventNode<bench_event>& node)
+    {
+        insert(node,false);
+    }
+
+    u64 serviced = 0;
+
+protected:
+    friend Scheduler;
+
+    void service_event(const EventNode<bench_event>& node)
+    {
+        serviced += node.end;
+        insert(create_event(BENCH_EVENT_PERIOD[u32(node.type)],node.type),false);
+    }
+};
+
+// the scheduler as it was, a binary heap behind a virtual handler
+struct HeapBenchScheduler
+{
+    virtual ~HeapBenchScheduler() {}
+
+    void arm(const EventNode<bench_event>& node)
+    {
+        event_list.remove(node.type);
+        event_list.insert(node);
+        min_timestamp = event_list.peek().end;
+    }
+
+    void tick(u32 cycles)
+    {
+        timestamp += cycles;
+
+        while(event_list.size() && timestamp >= min_timestamp)
+        {
+            const auto event = event_list.peek();
+            event_list.pop();
+            min_timestamp = event_list.peek().end;
+            service_event(event);
+        }
+    }
+
+    u64 get_timestamp() const
+    {
+        return timestamp;
+    }
+
+    virtual void service_event(const EventNode<bench_event>& node) = 0;
+
+    MinHeap<BENCH_EVENT_SIZE,bench_event> event_list;
+    u64 timestamp = 0;
+    u64 min_timestamp = 0;
+};
+
+struct HeapBench final : public HeapBenchScheduler
+{
+    u64 serviced = 0;
+
+    void service_event(const EventNode<bench_event>& node) override
+    {
+        serviced += node.end;
+        arm(EventNode<bench_event>(timestamp,timestamp + BENCH_EVENT_PERIOD[u32(node.type)],node.type));
+    }
+};
+
+template<typename T>
+f64 scheduler_bench_run(T& scheduler)
+{
+    static constexpr u32 STEPS = 50'000'000;
+
+    for(u32 i = 0; i < BENCH_EVENT_SIZE; i++)
+    {
+        const auto type = static_cast<bench_event>(i);
+        scheduler.arm(EventNode<bench_event>(0,BENCH_EVENT_PERIOD[i],type));
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for(u32 i = 0; i < STEPS; i++)
+    {
+        if((i & 7) == 0)
+        {
+            const u32 idx = (i >> 3) % BENCH_EVENT_SIZE;
+            const u64 timestamp = scheduler.get_timestamp();
+            scheduler.arm(EventNode<bench_event>(timestamp,timestamp + BENCH_EVENT_PERIOD[idx] + (i & 0xf0),static_cast<bench_event>(idx)));
+        }
+
+        scheduler.tick((i % 5) + 1);
+    }
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    return f64(ns) / STEPS;
+}
+
+void scheduler_bench()
+{
+    HeapBench heap;
+    const f64 heap_ns = scheduler_bench_run(heap);
+
+    BenchScheduler slots;
+    const f64 slot_ns = scheduler_bench_run(slots);
+
+    printf("scheduler (serviced %lx, %lx)\n",heap.serviced,slots.serviced);
+    printf("min heap: %f ns/step\n",heap_ns);
+    printf("slots: %f ns/step\n",slot_ns);
+}
+
+#ifdef GB_ENABLED
+#include <gb/gb.h>
+
+void gb_bench_save_state(const std::string& rom)
+{
+    gameboy::GB gb;
+    gb.reset(rom);
+    gb.throttle_emu = false;
+
+    // get the emulator into a somewhat realistic state first
+    for(int i = 0; i < 60; i++)
+    {
+        gb.run();
+    }
+
+    std::vector<u8> buf(gb.save_state_size());
+
+    static constexpr int ITER = 10000;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < ITER; i++)
+    {
+        if(!gb.save_state(buf.data(),buf.size()))
+        {
+            puts("save state buffer too small");
+            return;
+        }
+
+        if(gb.load_state(buf.data(),buf.size()) == dtr_res::err)
+        {
+            puts("save state restore failed");
+            return;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    printf("gb save state (%s): %zd bytes\n",gb.cpu.is_cgb? "cgb" : "dmg",buf.size());
+    printf("snapshot + restore: %f us\n",(double(ns) / ITER) / 1000.0);
+}
+#endif
+
+#if defined(GB_ENABLED) || defined(GBA_ENABLED)
+#include <psg/psg.h>
+#include <albion/audio.h>
+
+// old per sample path for comparison
+static void mix_per_sample(const gameboy_psg::Psg& psg, f32* out)
+{
+    f32 output[4];
+    for(int i = 0; i < 4; i++)
+    {
+        output[i] = f32(psg.channels[i].output) / 16.0f;
+    }
+
+    out[0] = gameboy_psg::mix_psg_channels(output,(psg.nr50 >> 4) & 7,(psg.nr51 >> 4) & 0xf,true);
+    out[1] = gameboy_psg::mix_psg_channels(output,psg.nr50 & 7,psg.nr51 & 0xf,true);
+}
+
+void psg_bench_mixer()
+{
+    gameboy_psg::Psg psg;
+    psg.init(gameboy_psg::psg_mode::cgb,false);
+    psg.nr50 = 0x77;
+    psg.nr51 = 0xf3;
+
+    gameboy_psg::Mixer mixer;
+    mixer.init(gameboy_psg::psg_mode::cgb,1.0f / 16.0f,AUDIO_BUFFER_SAMPLE_RATE,{});
+
+    // one minute of audio
+    static constexpr u32 SAMPLES = AUDIO_BUFFER_SAMPLE_RATE * 60;
+
+    // keep the optimiser from throwing the output away
+    f32 sink = 0.0f;
+    f32 out[2];
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(u32 i = 0; i < SAMPLES; i++)
+    {
+        for(u32 c = 0; c < 4; c++)
+        {
+            psg.channels[c].output = (i >> c) & 0xf;
+        }
+
+        mix_per_sample(psg,out);
+        sink += out[0] + out[1];
+    }
+
+    const auto per_sample_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    for(u32 i = 0; i < SAMPLES; i++)
+    {
+        for(u32 c = 0; c < 4; c++)
+        {
+            psg.channels[c].output = (i >> c) & 0xf;
+        }
+
+        if(mixer.push(psg))
+        {
+            const u32 samples = mixer.mix();
+            sink += mixer.output[0] + mixer.output[(samples * 2) - 1];
+        }
+    }
+
+    const auto block_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    printf("psg mixer (%u samples, sink %f)\n",SAMPLES,sink);
+    printf("per sample: %f ns/sample\n",f64(per_sample_ns) / SAMPLES);
+    printf("block (filtered): %f ns/sample\n",f64(block_ns) / SAMPLES);
+}
+#endif
+
+#ifdef N64_ENABLED
+#include <n64/n64.h>
+
+void n64_bench_pi_dma()
+{
+    auto n64 = std::make_unique<nintendo64::N64>();
+    auto& mem = n64->mem;
+
+    // enough of the memory map for rom to rdram transfers, without needing a rom file
+    mem.rom.resize(32 * 1024 * 1024);
+
+    for(u32 i = 0; i < mem.rom.size(); i++)
+    {
+        mem.rom[i] = u8(i * 7);
+    }
+
+    if(mem.fastmem.rd_ram)
+    {
+        mem.rd_ram = mem.fastmem.rd_ram;
+    }
+
+    else
+    {
+        mem.rd_ram_buffer.resize(nintendo64::RD_RAM_SIZE);
+        mem.rd_ram = mem.rd_ram_buffer.data();
+    }
+
+    mem.sp_dmem.resize(0x1000);
+    mem.sp_imem.resize(0x1000);
+    mem.page_table_read.resize(nintendo64::PAGE_TABLE_SIZE);
+    mem.page_table_write.resize(nintendo64::PAGE_TABLE_SIZE);
+    nintendo64::write_physical_table(mem);
+
+    // usual header timings
+    mem.pi.bsd_dom1_lat = 0x40;
+    mem.pi.bsd_dom1_pwd = 0x12;
+    mem.pi.bsd_dom1_pgs = 0x7;
+    mem.pi.bsd_dom1_rls = 0x3;
+
+    static constexpr u32 LEN = 4 * 1024 * 1024;
+    static constexpr int ITER = 64;
+
+    // aligned, then with the cart side half a word off
+    for(u32 offset : {0u,2u})
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for(int i = 0; i < ITER; i++)
+        {
+            nintendo64::dma_copy(*n64,0x1000'0000 + offset,0x0010'0000,LEN);
+        }
+
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        const f64 mb = (f64(LEN) * ITER) / (1024.0 * 1024.0);
+
+        const u32 cycles = nintendo64::pi_dma_cycles(mem.pi,0x1000'0000,LEN);
+
+        printf("n64 pi dma (%u MB, cart offset %u)\n",LEN / (1024 * 1024),offset);
+        printf("host: %f MB/s\n",mb / (f64(ns) / 1e9));
+        printf("guest: %u cpu cycles, %f ms\n",cycles,(f64(cycles) * 1000.0) / nintendo64::N64_CLOCK_CYCLES);
+    }
+}
+#endif
+
+#include <albion/upscale.h>
+
+// what each filter costs on a handheld screen headed for a 4k display
+void upscale_bench()
+{
+    static constexpr u32 FRAMES = 120;
+    static constexpr u32 TARGET_X = 3840;
+    static constexpr u32 TARGET_Y = 2160;
+
+    static constexpr u32 SCREENS[2][2] = {{160,144},{240,160}};
+
+    Upscaler upscaler;
+    init_upscaler(upscaler);
+
+    printf("upscale to %ux%u (%u threads)\n",TARGET_X,TARGET_Y,upscaler.pool->size());
+
+    for(const auto& screen : SCREENS)
+    {
+        const u32 x = screen[0];
+        const u32 y = screen[1];
+
+        // something with edges in it for scale2x to chase
+        std::vector<u32> src(x * y);
+
+        for(u32 i = 0; i < src.size(); i++)
+        {
+            src[i] = 0xff000000 | (((i % x) / 8 + (i / x) / 8) & 1? 0x00f8f8f8 : 0x00081830) | ((i * 0x0800) & 0x00f800);
+        }
+
+        for(u32 f = 0; f < UPSCALE_FILTER_SIZE; f++)
+        {
+            for(u32 c = 0; c < 2; c++)
+            {
+                const auto filter = upscale_filter(f);
+                const auto correction = c? colour_correction::gbc : colour_correction::none;
+
+                set_upscale_filter(upscaler,filter);
+                set_colour_correction(upscaler,correction);
+
+                // keep the optimiser from throwing the output away
+                u32 sink = 0;
+
+                const auto start = std::chrono::steady_clock::now();
+
+                for(u32 i = 0; i < FRAMES; i++)
+                {
+                    sink += upscale_frame(upscaler,src.data(),x,y,TARGET_X,TARGET_Y)[i];
+                }
+
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                printf("%ux%u %s colour %s -> %ux%u: %f ms/frame (sink %x)\n",x,y,upscale_filter_name(filter),colour_correction_name(correction),
+                    upscaler.out_x,upscaler.out_y,(f64(ns) / FRAMES) / 1e6,sink);
+            }
+        }
+    }
+}
+
+void run_benchmarks(const std::string& rom)
+{
+    scheduler_bench();
+    upscale_bench();
+
+#ifdef GB_ENABLED
+    gb_bench_save_state(rom);
+#endif
+
+#if defined(GB_ENABLED) || defined(GBA_ENABLED)
+    psg_bench_mixer();
+#endif
+
+#ifdef N64_ENABLED
+    n64_bench_pi_dma();
+#endif
+
+    UNUSED(rom);
+}
@@ -13,7 +13,7 @@ struct AudioBuffer
     /// Audio ring buffer owned
     std::vector<f32> buffer;
 
-    Playback* playback;
+    Playback* playback = nullptr;
 };
 
 void push_samples(Playback* playback,AudioBuffer& audio_buffer);
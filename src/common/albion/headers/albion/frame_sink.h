@@ -0,0 +1,16 @@
+#pragma once
+#include <albion/lib.h>
+
+// where a core hands its finished screens, set by the frontend like the audio playback
+// screens are abgr8888 with rows packed back to back, so the pitch is always the width
+// the frontend keeps a small pool of buffers and swaps a free one in for the finished screen
+// so a frame is never copied out of a core, and only allocated when the size changes
+struct FrameSink
+{
+    virtual ~FrameSink() = default;
+
+    // takes the x by y screen and leaves a free buffer of the same size in its place
+    // what comes back holds an older screen, so the core has to draw over all of it
+    // a core that has nothing new to show just does not submit, the last screen stays up
+    virtual void submit_frame(std::vector<u32>& screen, u32 x, u32 y) = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <albion/lib.h>
 #include <albion/debug.h>
+#include <albion/save_state.h>
 
 // TODO: remove undeeded generics with this and just replace the event type with an int
 // we can just pass the system struct into the event method and not require all this overkill
@@ -58,8 +59,8 @@ class MinHeap
 public:
     MinHeap();
 
-    void save_state(std::ofstream &fp);
-    dtr_res load_state(std::ifstream &fp);
+    void save_state(StateWriter& writer) const;
+    dtr_res load_state(StateReader& reader);
 
     EventNode<event_type> peek() const;
     void pop();
@@ -336,39 +337,44 @@ EventNode<event_type> MinHeap<SIZE,event_type>::remove(u32 idx)
 
 
 template<u32 SIZE,typename event_type>
-void MinHeap<SIZE,event_type>::save_state(std::ofstream &fp)
+void MinHeap<SIZE,event_type>::save_state(StateWriter& writer) const
 {
-    file_write_arr(fp,type_idx.data(),sizeof(type_idx[0]) * type_idx.size());
+    state_write_arr(writer,type_idx.data(),sizeof(type_idx[0]) * type_idx.size());
 
-
-    file_write_arr(fp,buf.data(),sizeof(buf[0]) * buf.size());
+    state_write_arr(writer,buf.data(),sizeof(buf[0]) * buf.size());
 
     // ok as our heap now has pointers we will write out indexes and re populate the pointers
     // instead 
-    const auto start = size_t(&buf[0]);
-    std::array<size_t,SIZE> idx_list;
+    std::array<u32,SIZE> idx_list;
 
     for(size_t i = 0; i < SIZE; i++)
     {
-        const auto ptr = size_t(heap[i]);
-        idx_list[i] = ((ptr - start) / sizeof(EventNode<event_type>));
+        idx_list[i] = heap[i] - &buf[0];
     }
 
-    file_write_arr(fp,idx_list.data(),sizeof(idx_list[0]) * idx_list.size());
+    state_write_arr(writer,idx_list.data(),sizeof(idx_list[0]) * idx_list.size());
 
-    file_write_var(fp,len);
+    state_write_var(writer,len);
 }
 
 template<u32 SIZE,typename event_type>
-dtr_res MinHeap<SIZE,event_type>::load_state(std::ifstream &fp)
+dtr_res MinHeap<SIZE,event_type>::load_state(StateReader& reader)
 {
-    dtr_res err = file_read_arr(fp,type_idx.data(),sizeof(type_idx[0]) * type_idx.size());
+    dtr_res err = state_read_arr(reader,type_idx.data(),sizeof(type_idx[0]) * type_idx.size());
   
-    err |= file_read_arr(fp,buf.data(),sizeof(buf[0]) * buf.size());
+    err |= state_read_arr(reader,buf.data(),sizeof(buf[0]) * buf.size());
 
     // read idx back in so we can reconstruct our ptrs
-    std::array<size_t,SIZE> idx_list;
-    err |= file_read_arr(fp,idx_list.data(),sizeof(idx_list[0]) * idx_list.size());
+    std::array<u32,SIZE> idx_list;
+    err |= state_read_arr(reader,idx_list.data(),sizeof(idx_list[0]) * idx_list.size());
+
+    err |= state_read_var(reader,len);
+
+    if(err == dtr_res::err)
+    {
+        spdlog::error("minheap state truncated");
+        return dtr_res::err;
+    }
 
     // verify idx bounds 
     for(const auto &x: idx_list)
@@ -385,9 +391,6 @@ dtr_res MinHeap<SIZE,event_type>::load_state(std::ifstream &fp)
         heap[i] = &buf[idx_list[i]];
     }
 
-    err |= file_read_var(fp,len);
-
-
     if(len > SIZE)
     {
         spdlog::error("minheap invalid len");
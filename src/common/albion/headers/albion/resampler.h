@@ -0,0 +1,36 @@
+#pragma once
+#include <albion/lib.h>
+#include <albion/audio.h>
+
+// band limited stereo rate conversion from a core's native rate to the host rate
+// polyphase windowed sinc, interpolating between neighbouring phases of the table
+
+struct Resampler
+{
+    static constexpr u32 TAPS = 16;
+    static constexpr u32 PHASE_BITS = 8;
+    static constexpr u32 PHASES = 1 << PHASE_BITS;
+
+    // every input frame is written twice, so the newest TAPS frames are always one run
+    alignas(16) f32 history[AUDIO_CHANNEL_COUNT][TAPS * 2] = {};
+    u32 head = 0;
+
+    // 32.32 fixed point position in input frames past the middle of the window
+    u64 frac = 0;
+    u64 step = u64(1) << 32;
+
+    // PHASES + 1 rows of TAPS, the extra row is there to interpolate the last phase against
+    std::vector<f32> filter;
+
+    // relative to the input nyquist, only changes when the ratio crosses 1 by enough to matter
+    f32 cutoff = 0.0f;
+};
+
+void reset_resampler(Resampler& resampler);
+
+// input frames per output frame
+void set_resampler_ratio(Resampler& resampler, f64 ratio);
+
+// feed one input frame, anything it completes goes out through push_sample
+// returns the number of output frames produced
+u32 resample_frame(Resampler& resampler, AudioBuffer& buffer, f32 left, f32 right);
@@ -0,0 +1,167 @@
+#pragma once
+#include <albion/lib.h>
+#include <cstddef>
+
+// in memory save states
+// components serialise into a caller owned contiguous buffer
+// so snapshots can be taken every frame without touching the heap
+// a writer without a buffer just measures how large the state is
+
+static constexpr u32 SAVE_STATE_MAGIC = 0x4154'5341; // "ASTA"
+
+struct SaveStateHeader
+{
+    u32 magic = SAVE_STATE_MAGIC;
+    u32 version = 0;
+    u64 size = 0;
+};
+
+struct StateWriter
+{
+    u8* buf = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+};
+
+struct StateReader
+{
+    const u8* buf = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+};
+
+inline StateWriter make_state_writer(u8* buf, size_t size)
+{
+    StateWriter writer;
+    writer.buf = buf;
+    writer.size = size;
+    writer.offset = 0;
+
+    return writer;
+}
+
+// measure only, nothing is written
+inline StateWriter make_state_sizer()
+{
+    return make_state_writer(nullptr,0);
+}
+
+inline StateReader make_state_reader(const u8* buf, size_t size)
+{
+    StateReader reader;
+    reader.buf = buf;
+    reader.size = size;
+    reader.offset = 0;
+
+    return reader;
+}
+
+// did everything written actually fit in the buffer?
+inline bool state_writer_valid(const StateWriter& writer)
+{
+    return writer.buf && writer.offset <= writer.size;
+}
+
+inline void state_write_arr(StateWriter& writer, const void* data, size_t len)
+{
+    // keep counting on overflow so the caller can find out how much was required
+    if(writer.buf && writer.offset + len <= writer.size)
+    {
+        memcpy(&writer.buf[writer.offset],data,len);
+    }
+
+    writer.offset += len;
+}
+
+template<typename T>
+inline void state_write_var(StateWriter& writer, const T& v)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    state_write_arr(writer,&v,sizeof(T));
+}
+
+// NOTE: the length is not stored, the reader must have a container of the same size
+template<typename T>
+inline void state_write_vec(StateWriter& writer, const std::vector<T>& v)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    state_write_arr(writer,v.data(),v.size() * sizeof(T));
+}
+
+inline dtr_res state_read_arr(StateReader& reader, void* data, size_t len)
+{
+    if(reader.offset + len > reader.size)
+    {
+        return dtr_res::err;
+    }
+
+    memcpy(data,&reader.buf[reader.offset],len);
+    reader.offset += len;
+
+    return dtr_res::ok;
+}
+
+template<typename T>
+inline dtr_res state_read_var(StateReader& reader, T& v)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    return state_read_arr(reader,&v,sizeof(T));
+}
+
+template<typename T>
+inline dtr_res state_read_vec(StateReader& reader, std::vector<T>& v)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    return state_read_arr(reader,v.data(),v.size() * sizeof(T));
+}
+
+inline void state_write_header(StateWriter& writer, u32 version)
+{
+    SaveStateHeader header;
+    header.version = version;
+
+    // size gets patched in by state_finish_header when we know it
+    header.size = 0;
+
+    state_write_var(writer,header);
+}
+
+inline void state_finish_header(StateWriter& writer)
+{
+    if(state_writer_valid(writer))
+    {
+        const u64 size = writer.offset;
+        memcpy(&writer.buf[offsetof(SaveStateHeader,size)],&size,sizeof(size));
+    }
+}
+
+inline dtr_res state_read_header(StateReader& reader, u32 version)
+{
+    SaveStateHeader header;
+
+    if(state_read_var(reader,header) == dtr_res::err)
+    {
+        spdlog::error("save state too small for header");
+        return dtr_res::err;
+    }
+
+    if(header.magic != SAVE_STATE_MAGIC)
+    {
+        spdlog::error("save state bad magic {:x}",header.magic);
+        return dtr_res::err;
+    }
+
+    if(header.version != version)
+    {
+        spdlog::error("save state version mismatch {} != {}",header.version,version);
+        return dtr_res::err;
+    }
+
+    if(header.size != reader.size)
+    {
+        spdlog::error("save state size mismatch {} != {}",header.size,reader.size);
+        return dtr_res::err;
+    }
+
+    return dtr_res::ok;
+}
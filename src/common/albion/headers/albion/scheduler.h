@@ -1,15 +1,24 @@
 #pragma once
 #include<albion/min_heap.h>
+#include <bit>
 
-// needs a save state impl
-template<size_t EVENT_SIZE,typename event_type>
+// every core only has a handful of event types, and each type is only ever pending once
+// so rather than a heap each type just owns a deadline slot
+// arming or cancelling an event writes its slot, and the next deadline is found with a branchless scan
+// Derived provides service_event(const EventNode<event_type>&), called directly rather than through a vtable
+template<size_t EVENT_SIZE,typename event_type,typename Derived>
 class Scheduler
 {
 public:
+    Scheduler()
+    {
+        init();
+    }
+
     void init();
 
-    void save_state(std::ofstream &fp);
-    dtr_res load_state(std::ifstream &fp);    
+    void save_state(StateWriter& writer) const;
+    dtr_res load_state(StateReader& reader);
 
     void tick(uint32_t cycles);
     void delay_tick(uint32_t cycles);
@@ -30,140 +39,201 @@ public:
     uint64_t get_next_event_cycles() const;
 
     size_t size() const
-    { 
-        return event_list.size(); 
-    } 
+    {
+        return std::popcount(event_active);
+    }
 
     // helper to create events
     EventNode<event_type> create_event(u64 duration, event_type t) const;
 
-    void adjust_timestamp();
-
 protected:
-    virtual void service_event(const EventNode<event_type> & node) = 0;
+    static_assert(EVENT_SIZE != 0 && EVENT_SIZE <= 32);
+
+    static constexpr u64 EVENT_INACTIVE = 0xffff'ffff'ffff'ffff;
+
+    // deadlines are kept apart from the rest so the scan only walks one small array
+    // an inactive slot never fires as it is at the end of time
+    std::array<u64,EVENT_SIZE> event_end;
+    std::array<u64,EVENT_SIZE> event_start;
 
+    // bumped each time a slot is armed or cancelled
+    // so a pending event can be told apart from one armed in its place
+    // only ever compared within a single remove, so it is not part of the save state
+    std::array<u32,EVENT_SIZE> event_gen;
 
-    MinHeap<EVENT_SIZE,event_type> event_list;
+    u32 event_active = 0;
+
+    // slot holding min_timestamp
+    u32 next_event = 0;
 
     // current elapsed time
     u64 timestamp = 0;
     u64 min_timestamp = 0;
+
+private:
+    void find_next_event();
+    void retire_event(u32 idx);
+    EventNode<event_type> slot_event(u32 idx) const;
 };
 
 
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::init()
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::init()
 {
-    event_list.clear();
+    event_end.fill(EVENT_INACTIVE);
+    event_start.fill(0);
+    event_gen.fill(0);
+    event_active = 0;
+
     timestamp = 0;
-    min_timestamp = 0xffffffff;
+    find_next_event();
 }
 
-template<size_t SIZE,typename event_type>
-bool Scheduler<SIZE,event_type>::is_active(event_type t) const
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::find_next_event()
 {
-    return event_list.is_active(t);
+    u64 min = event_end[0];
+    u32 idx = 0;
+
+    // written as selects so it compiles down to cmovs, which deadline is next is unpredictable
+    // ties go to the lowest type so the order events fire in is always the same
+    for(u32 i = 1; i < SIZE; i++)
+    {
+        const bool sooner = event_end[i] < min;
+        min = sooner? event_end[i] : min;
+        idx = sooner? i : idx;
+    }
+
+    min_timestamp = min;
+    next_event = idx;
 }
-template<size_t SIZE,typename event_type>
-bool Scheduler<SIZE,event_type>::event_ready() const
+
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::retire_event(u32 idx)
+{
+    event_end[idx] = EVENT_INACTIVE;
+    event_active &= ~(1u << idx);
+    event_gen[idx]++;
+
+    // only the next event going away can move the deadline
+    if(idx == next_event)
+    {
+        find_next_event();
+    }
+}
+
+template<size_t SIZE,typename event_type,typename Derived>
+EventNode<event_type> Scheduler<SIZE,event_type,Derived>::slot_event(u32 idx) const
+{
+    return EventNode<event_type>(event_start[idx],event_end[idx],static_cast<event_type>(idx));
+}
+
+template<size_t SIZE,typename event_type,typename Derived>
+bool Scheduler<SIZE,event_type,Derived>::is_active(event_type t) const
+{
+    return (event_active >> u32(t)) & 1;
+}
+
+template<size_t SIZE,typename event_type,typename Derived>
+bool Scheduler<SIZE,event_type,Derived>::event_ready() const
 {
     return timestamp >= min_timestamp;
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::delay_tick(uint32_t cycles)
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::delay_tick(uint32_t cycles)
 {
     timestamp += cycles;
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::service_events()
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::service_events()
 {
-    // if the timestamp is greater than the event fire
-    // handle the event and remove it
-    // as the list is sorted the next event is first
-    // any subsequent events aernt going to fire so we can return early
-    while(event_list.size() && event_ready())
+    // nothing is pending when every slot is inactive, so this cannot spin on an empty list
+    // the slot is freed before the handler runs so it can rearm itself
+    while(event_ready())
     {
-        // remove min event
-        const auto event = event_list.peek();
-        event_list.pop();
-        min_timestamp = event_list.peek().end;
-        service_event(event);
+        const auto event = slot_event(next_event);
+        retire_event(next_event);
+        static_cast<Derived*>(this)->service_event(event);
     }
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::tick(uint32_t cycles)
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::tick(uint32_t cycles)
 {
     timestamp += cycles;
 
     service_events();
 }
 
-// using a 64 bit timestamp not required
-/*
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::adjust_timestamp()
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::insert(const EventNode<event_type> &node,bool tick_old)
 {
-    // timestamp will soon overflow
-    if(is_set(timestamp,31))
+    remove(node.type,tick_old);
+
+    // no cycles would be ticked this event does nothing
+    if(node.start == node.end)
     {
-        uint32_t min = 0xffffffff;
-        //puts("timestamp overflow");
-        for(const auto &x: event_list.buf)
-        {
-            if(event_list.is_active(x.type))
-            {
-                min = std::min(min,x.start);
-            }
-        }
+        return;
+    }
 
-        for(auto &x: event_list.buf)
-        {
-            if(event_list.is_active(x.type))
-            {
-                x.end -= min;
-                x.start -= min;
-            }
-        }
-        timestamp -= min;
-        min_timestamp -= min;
-    }    
-}
-*/
+    const u32 idx = u32(node.type);
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::insert(const EventNode<event_type> &node,bool tick_old)
-{
-    remove(node.type,tick_old);
-    event_list.insert(node);
-    min_timestamp = event_list.peek().end;
+    event_start[idx] = node.start;
+    event_end[idx] = node.end;
+    event_active |= 1u << idx;
+    event_gen[idx]++;
+
+    // the slot was empty, so this can only pull the deadline in
+    if(node.end < min_timestamp || (node.end == min_timestamp && idx < next_event))
+    {
+        min_timestamp = node.end;
+        next_event = idx;
+    }
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::remove(event_type type,bool tick_old)
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::remove(event_type type,bool tick_old)
 {
-    const auto event = event_list.remove(type);
+    const u32 idx = u32(type);
 
-    // if it was removed and we want to tick off cycles
-    if(event && tick_old)
+    if(!is_active(type))
     {
-        service_event(event.value());
-        event_list.remove(type);
+        return;
+    }
+
+    const auto event = slot_event(idx);
+    retire_event(idx);
+
+    // if we want to tick off cycles
+    if(tick_old)
+    {
+        const u32 gen = event_gen[idx];
+        static_cast<Derived*>(this)->service_event(event);
+
+        // the caller is replacing this event, so anything the handler armed in its place goes
+        if(event_gen[idx] != gen)
+        {
+            retire_event(idx);
+        }
     }
-    min_timestamp = event_list.peek().end;
 }
 
-template<size_t SIZE,typename event_type>
-std::optional<EventNode<event_type>> Scheduler<SIZE,event_type>::get(event_type t) const
+template<size_t SIZE,typename event_type,typename Derived>
+std::optional<EventNode<event_type>> Scheduler<SIZE,event_type,Derived>::get(event_type t) const
 {
-    return event_list.get(t);
+    if(!is_active(t))
+    {
+        return std::nullopt;
+    }
+
+    return slot_event(u32(t));
 }
 
-template<size_t SIZE,typename event_type>
-std::optional<size_t> Scheduler<SIZE,event_type>::get_event_ticks(event_type t) const
+template<size_t SIZE,typename event_type,typename Derived>
+std::optional<size_t> Scheduler<SIZE,event_type,Derived>::get_event_ticks(event_type t) const
 {
     const auto event = get(t);
 
@@ -175,38 +245,61 @@ std::optional<size_t> Scheduler<SIZE,event_type>::get_event_ticks(event_type t)
     return timestamp - event.value().start;
 }
 
-template<size_t SIZE,typename event_type>
-uint64_t Scheduler<SIZE,event_type>::get_timestamp() const
+template<size_t SIZE,typename event_type,typename Derived>
+uint64_t Scheduler<SIZE,event_type,Derived>::get_timestamp() const
 {
     return timestamp;
 }
 
-template<size_t SIZE,typename event_type>
-uint64_t Scheduler<SIZE,event_type>::get_next_event_cycles() const
+template<size_t SIZE,typename event_type,typename Derived>
+uint64_t Scheduler<SIZE,event_type,Derived>::get_next_event_cycles() const
 {
     return min_timestamp - timestamp;
 }
 
-template<size_t SIZE,typename event_type>
-EventNode<event_type> Scheduler<SIZE,event_type>::create_event(u64 duration, event_type t) const
+template<size_t SIZE,typename event_type,typename Derived>
+EventNode<event_type> Scheduler<SIZE,event_type,Derived>::create_event(u64 duration, event_type t) const
 {
     return EventNode<event_type>(timestamp,duration+timestamp,t);
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::save_state(std::ofstream &fp)
+template<size_t SIZE,typename event_type,typename Derived>
+void Scheduler<SIZE,event_type,Derived>::save_state(StateWriter& writer) const
 {
-    file_write_var(fp,min_timestamp);
-    file_write_var(fp,timestamp);
-    event_list.save_state(fp);
+    state_write_var(writer,timestamp);
+    state_write_arr(writer,event_end.data(),sizeof(event_end[0]) * event_end.size());
+    state_write_arr(writer,event_start.data(),sizeof(event_start[0]) * event_start.size());
+    state_write_var(writer,event_active);
 }
 
-template<size_t SIZE,typename event_type>
-dtr_res Scheduler<SIZE,event_type>::load_state(std::ifstream &fp)
+template<size_t SIZE,typename event_type,typename Derived>
+dtr_res Scheduler<SIZE,event_type,Derived>::load_state(StateReader& reader)
 {
-    dtr_res err = file_read_var(fp,min_timestamp);
-    err |= file_read_var(fp,timestamp);
-    err |= event_list.load_state(fp);
+    dtr_res err = state_read_var(reader,timestamp);
+    err |= state_read_arr(reader,event_end.data(),sizeof(event_end[0]) * event_end.size());
+    err |= state_read_arr(reader,event_start.data(),sizeof(event_start[0]) * event_start.size());
+    err |= state_read_var(reader,event_active);
+
+    if(err == dtr_res::err)
+    {
+        spdlog::error("scheduler state truncated");
+        return dtr_res::err;
+    }
+
+    // the active mask has to agree with the slots, or events would fire that are not there
+    for(u32 i = 0; i < 32; i++)
+    {
+        const bool active = (event_active >> i) & 1;
+
+        if(i >= SIZE? active : active != (event_end[i] != EVENT_INACTIVE))
+        {
+            spdlog::error("scheduler invalid event slot {}",i);
+            return dtr_res::err;
+        }
+    }
+
+    // derived from the slots rather than trusted from the file
+    find_next_event();
 
     return err;
 }
@@ -0,0 +1,58 @@
+#pragma once
+#include <albion/lib.h>
+#include <atomic>
+#include <array>
+
+// lock free bounded queue for one producer and one consumer
+// the indexes only ever count up, and wrap through the mask
+
+template<typename T, u32 SIZE>
+class SpscQueue
+{
+public:
+    static_assert(SIZE != 0 && (SIZE & (SIZE - 1)) == 0);
+
+    // false when full, the value is dropped
+    bool push(const T& v)
+    {
+        const u32 w = write_idx.load(std::memory_order_relaxed);
+
+        if(w - read_idx.load(std::memory_order_acquire) == SIZE)
+        {
+            return false;
+        }
+
+        buf[w & (SIZE - 1)] = v;
+        write_idx.store(w + 1,std::memory_order_release);
+
+        return true;
+    }
+
+    bool pop(T& v)
+    {
+        const u32 r = read_idx.load(std::memory_order_relaxed);
+
+        if(r == write_idx.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        v = buf[r & (SIZE - 1)];
+        read_idx.store(r + 1,std::memory_order_release);
+
+        return true;
+    }
+
+    // only a snapshot when read from the other side
+    u32 size() const
+    {
+        return write_idx.load(std::memory_order_acquire) - read_idx.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T,SIZE> buf;
+
+    // kept on their own lines so the two sides do not fight over them
+    alignas(64) std::atomic<u32> write_idx = 0;
+    alignas(64) std::atomic<u32> read_idx = 0;
+};
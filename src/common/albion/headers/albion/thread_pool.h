@@ -0,0 +1,176 @@
+#pragma once
+#include <albion/lib.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+// work stealing thread pool
+// every worker owns a queue and takes from the front of it,
+// when it runs dry it steals from the back of the other queues
+// tasks are told which worker is running them so callers can keep per worker state
+
+class ThreadPool
+{
+public:
+    using Task = std::function<void(u32 worker)>;
+
+    explicit ThreadPool(u32 threads = 0)
+    {
+        if(threads == 0)
+        {
+            threads = std::max(1u,std::thread::hardware_concurrency());
+        }
+
+        for(u32 i = 0; i < threads; i++)
+        {
+            queues.push_back(std::make_unique<WorkQueue>());
+        }
+
+        for(u32 i = 0; i < threads; i++)
+        {
+            workers.emplace_back(&ThreadPool::worker_main,this,i);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::scoped_lock lock(sleep_mutex);
+            quit = true;
+        }
+        sleep_cv.notify_all();
+
+        for(auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    u32 size() const
+    {
+        return u32(workers.size());
+    }
+
+    // queues are handed out round robin, stealing evens out the rest
+    void submit(Task task)
+    {
+        outstanding++;
+
+        // bump under the lock so a worker about to sleep cant miss it
+        {
+            std::scoped_lock lock(sleep_mutex);
+            queued++;
+        }
+
+        auto& queue = *queues[next_queue];
+        next_queue = (next_queue + 1) % queues.size();
+
+        {
+            std::scoped_lock lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+
+        sleep_cv.notify_one();
+    }
+
+    // block until every submitted task has finished
+    void wait()
+    {
+        std::unique_lock lock(done_mutex);
+        done_cv.wait(lock,[this]{ return outstanding == 0; });
+    }
+
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(u32 id, Task& task)
+    {
+        auto& queue = *queues[id];
+        std::scoped_lock lock(queue.mutex);
+
+        if(queue.tasks.empty())
+        {
+            return false;
+        }
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    bool steal(u32 id, Task& task)
+    {
+        for(size_t i = 1; i < queues.size(); i++)
+        {
+            auto& queue = *queues[(id + i) % queues.size()];
+            std::scoped_lock lock(queue.mutex);
+
+            if(!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void worker_main(u32 id)
+    {
+        for(;;)
+        {
+            Task task;
+
+            if(pop(id,task) || steal(id,task))
+            {
+                queued--;
+                task(id);
+
+                if(--outstanding == 0)
+                {
+                    std::scoped_lock lock(done_mutex);
+                    done_cv.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock lock(sleep_mutex);
+            sleep_cv.wait(lock,[this]{ return quit || queued != 0; });
+
+            if(quit && queued == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+    size_t next_queue = 0;
+
+    // tasks sitting in a queue
+    std::atomic<u32> queued = 0;
+
+    // tasks not yet finished
+    std::atomic<u32> outstanding = 0;
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    bool quit = false;
+
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <albion/lib.h>
+#include <atomic>
+#include <array>
+
+// lock free triple buffer for one producer and one consumer
+// the producer always has a free slot to write into, and the consumer always has the last complete one
+// so neither side blocks the other, a value the consumer was too slow to see just gets replaced
+
+template<typename T>
+class TripleBuffer
+{
+public:
+    // producer side, the slot being filled
+    T& back()
+    {
+        return slots[back_idx];
+    }
+
+    // hand the back slot over, false if the value it replaces was never taken
+    bool publish()
+    {
+        const u32 old = state.exchange(back_idx | FRESH,std::memory_order_acq_rel);
+
+        back_idx = old & IDX_MASK;
+        return !(old & FRESH);
+    }
+
+    // consumer side, swaps in the newest value if there is one
+    bool take()
+    {
+        if(!(state.load(std::memory_order_acquire) & FRESH))
+        {
+            return false;
+        }
+
+        const u32 old = state.exchange(front_idx,std::memory_order_acq_rel);
+
+        front_idx = old & IDX_MASK;
+        return true;
+    }
+
+    const T& front() const
+    {
+        return slots[front_idx];
+    }
+
+private:
+    static constexpr u32 IDX_MASK = 0b11;
+    static constexpr u32 FRESH = 1 << 2;
+
+    std::array<T,3> slots;
+
+    // only touched by their own side
+    u32 back_idx = 0;
+    u32 front_idx = 1;
+
+    // the slot in the middle, with whether it has been published since the consumer last took one
+    alignas(64) std::atomic<u32> state = 2;
+};
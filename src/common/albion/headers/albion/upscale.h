@@ -0,0 +1,75 @@
+#pragma once
+#include <albion/lib.h>
+#include <albion/thread_pool.h>
+
+// cpu post processing between a core's screen and the texture upload
+// colour correction, then an upscale, all abgr8888
+// every pass splits the frame into bands of rows across a small worker pool
+
+enum class upscale_filter
+{
+    // handed over as is for the gpu to stretch
+    none,
+
+    // every pixel becomes a scale by scale block
+    integer,
+
+    // scale2x, follows diagonal edges instead of blocking them out
+    // run twice for 4x, anything past that is left to the gpu
+    scale2x,
+
+    // integer scale with the gaps between the lcd cells darkened
+    lcd_grid,
+};
+
+static constexpr u32 UPSCALE_FILTER_SIZE = 4;
+
+enum class colour_correction
+{
+    none,
+
+    // both screens are darker and less saturated than the raw colours, with the channels bleeding into each other
+    gbc,
+    gba,
+};
+
+static constexpr u32 COLOUR_CORRECTION_SIZE = 3;
+
+struct Upscaler
+{
+    upscale_filter filter = upscale_filter::none;
+    colour_correction correction = colour_correction::none;
+
+    // largest the integer filters go, well past what a 4k display needs for the handhelds
+    static constexpr u32 MAX_SCALE = 16;
+
+    // the sources are all 15 bit colour, so correction is a lookup on the top 5 bits of each channel
+    std::vector<u32> correction_lut;
+
+    std::vector<u32> corrected;
+
+    // scale2x goes through this on the way to 4x
+    std::vector<u32> doubled;
+
+    std::vector<u32> out;
+    u32 out_x = 0;
+    u32 out_y = 0;
+
+    std::unique_ptr<ThreadPool> pool;
+};
+
+// threads of 0 picks a few for the host
+void init_upscaler(Upscaler& upscaler, u32 threads = 0);
+
+void set_upscale_filter(Upscaler& upscaler, upscale_filter filter);
+void set_colour_correction(Upscaler& upscaler, colour_correction correction);
+
+const char* upscale_filter_name(upscale_filter filter);
+const char* colour_correction_name(colour_correction correction);
+
+// scale the filter will actually run at, to fit an x by y screen into a target_x by target_y output
+u32 upscale_factor(upscale_filter filter, u32 x, u32 y, u32 target_x, u32 target_y);
+
+// runs an x by y screen through, sized to fit in target_x by target_y
+// the result is in out, or is src itself when there was nothing to do
+const u32* upscale_frame(Upscaler& upscaler, const u32* src, u32 x, u32 y, u32 target_x, u32 target_y);
@@ -0,0 +1,156 @@
+#include <albion/resampler.h>
+#include <cmath>
+#include <numbers>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static constexpr u64 FRAC_ONE = u64(1) << 32;
+
+// leave a little room below nyquist for the window's transition band
+static constexpr f32 CUTOFF_SCALE = 0.92f;
+
+static void build_filter(Resampler& resampler, f32 cutoff)
+{
+    constexpr u32 TAPS = Resampler::TAPS;
+    constexpr u32 PHASES = Resampler::PHASES;
+    constexpr f64 HALF = TAPS / 2;
+
+    resampler.cutoff = cutoff;
+    resampler.filter.resize((PHASES + 1) * TAPS);
+
+    for(u32 p = 0; p <= PHASES; p++)
+    {
+        f32* row = &resampler.filter[p * TAPS];
+        f64 sum = 0.0;
+
+        for(u32 k = 0; k < TAPS; k++)
+        {
+            // distance of the tap from the output point, in input frames
+            const f64 d = f64(k) - (HALF - 1) - (f64(p) / PHASES);
+
+            const f64 x = std::numbers::pi * cutoff * d;
+            const f64 sinc = d == 0.0? 1.0 : std::sin(x) / x;
+
+            // blackman, reaching zero at the ends of the window
+            const f64 w = std::numbers::pi * d / HALF;
+            const f64 window = 0.42 + (0.5 * std::cos(w)) + (0.08 * std::cos(2.0 * w));
+
+            const f64 h = std::abs(d) >= HALF? 0.0 : sinc * window;
+
+            row[k] = f32(h);
+            sum += h;
+        }
+
+        // unity gain at dc for every phase, so a rate change does not wobble the level
+        for(u32 k = 0; k < TAPS; k++)
+        {
+            row[k] = f32(row[k] / sum);
+        }
+    }
+}
+
+void reset_resampler(Resampler& resampler)
+{
+    resampler = {};
+    build_filter(resampler,CUTOFF_SCALE);
+}
+
+void set_resampler_ratio(Resampler& resampler, f64 ratio)
+{
+    resampler.step = std::max<u64>(1,u64(ratio * f64(FRAC_ONE)));
+
+    // going down in rate the filter has to follow the output nyquist instead
+    const f32 cutoff = f32(std::min(1.0,1.0 / ratio)) * CUTOFF_SCALE;
+
+    // small rate corrections stay on the same table
+    if(resampler.filter.empty() || std::abs(cutoff - resampler.cutoff) > 0.01f)
+    {
+        build_filter(resampler,cutoff);
+    }
+}
+
+static void filter_frame(const Resampler& resampler, f32& left, f32& right)
+{
+    constexpr u32 TAPS = Resampler::TAPS;
+
+    const u32 phase = u32(resampler.frac >> (32 - Resampler::PHASE_BITS));
+    const f32 t = f32(resampler.frac & ((FRAC_ONE >> Resampler::PHASE_BITS) - 1)) / f32(FRAC_ONE >> Resampler::PHASE_BITS);
+
+    const f32* a = &resampler.filter[phase * TAPS];
+    const f32* b = a + TAPS;
+
+    const f32* l = &resampler.history[0][resampler.head];
+    const f32* r = &resampler.history[1][resampler.head];
+
+#ifdef __SSE2__
+    const __m128 vt = _mm_set1_ps(t);
+    __m128 acc_l = _mm_setzero_ps();
+    __m128 acc_r = _mm_setzero_ps();
+
+    for(u32 k = 0; k < TAPS; k += 4)
+    {
+        const __m128 ca = _mm_loadu_ps(&a[k]);
+        const __m128 cb = _mm_loadu_ps(&b[k]);
+        const __m128 c = _mm_add_ps(ca,_mm_mul_ps(_mm_sub_ps(cb,ca),vt));
+
+        acc_l = _mm_add_ps(acc_l,_mm_mul_ps(c,_mm_loadu_ps(&l[k])));
+        acc_r = _mm_add_ps(acc_r,_mm_mul_ps(c,_mm_loadu_ps(&r[k])));
+    }
+
+    // reduce both channels at once, left in the low pair and right in the high pair
+    const __m128 lo = _mm_unpacklo_ps(acc_l,acc_r);
+    const __m128 hi = _mm_unpackhi_ps(acc_l,acc_r);
+    const __m128 sum = _mm_add_ps(lo,hi);
+    const __m128 out = _mm_add_ps(sum,_mm_movehl_ps(sum,sum));
+
+    left = _mm_cvtss_f32(out);
+    right = _mm_cvtss_f32(_mm_shuffle_ps(out,out,1));
+#else
+    left = 0.0f;
+    right = 0.0f;
+
+    for(u32 k = 0; k < TAPS; k++)
+    {
+        const f32 c = a[k] + ((b[k] - a[k]) * t);
+        left += c * l[k];
+        right += c * r[k];
+    }
+#endif
+}
+
+u32 resample_frame(Resampler& resampler, AudioBuffer& buffer, f32 left, f32 right)
+{
+    constexpr u32 TAPS = Resampler::TAPS;
+
+    if(resampler.filter.empty())
+    {
+        build_filter(resampler,CUTOFF_SCALE);
+    }
+
+    resampler.history[0][resampler.head] = left;
+    resampler.history[0][resampler.head + TAPS] = left;
+    resampler.history[1][resampler.head] = right;
+    resampler.history[1][resampler.head + TAPS] = right;
+    resampler.head = (resampler.head + 1) % TAPS;
+
+    // every output point that falls before the next input frame
+    u32 produced = 0;
+
+    while(resampler.frac < FRAC_ONE)
+    {
+        f32 out_left;
+        f32 out_right;
+        filter_frame(resampler,out_left,out_right);
+
+        push_sample(buffer,out_left,out_right);
+        produced++;
+
+        resampler.frac += resampler.step;
+    }
+
+    resampler.frac -= FRAC_ONE;
+
+    return produced;
+}
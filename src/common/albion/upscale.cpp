@@ -0,0 +1,432 @@
+#include <albion/upscale.h>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// splits rows into bands across the pool and waits on them
+// a couple of bands a worker, so one slow band does not hold the frame up
+template<typename FUNC>
+static void run_bands(Upscaler& upscaler, u32 rows, FUNC func)
+{
+    if(!upscaler.pool)
+    {
+        func(0,rows);
+        return;
+    }
+
+    auto& pool = *upscaler.pool;
+
+    const u32 bands = pool.size() * 2;
+    const u32 band_rows = std::max(1u,(rows + bands - 1) / bands);
+
+    for(u32 y = 0; y < rows; y += band_rows)
+    {
+        const u32 end = std::min(y + band_rows,rows);
+
+        pool.submit([&func,y,end](u32 worker)
+        {
+            UNUSED(worker);
+            func(y,end);
+        });
+    }
+
+    pool.wait();
+}
+
+static u32 pack_colour(f64 r, f64 g, f64 b)
+{
+    const auto channel = [](f64 v)
+    {
+        return u32(std::clamp(v,0.0,255.0) + 0.5);
+    };
+
+    return channel(r) | (channel(g) << 8) | (channel(b) << 16);
+}
+
+// both after byuu's colour emulation
+static u32 correct_colour(colour_correction correction, u32 r, u32 g, u32 b)
+{
+    switch(correction)
+    {
+        // channels mix and the top end gets cut off
+        case colour_correction::gbc:
+        {
+            const f64 scale = 255.0 / 960.0;
+
+            return pack_colour(std::min((r * 26) + (g * 4) + (b * 2),960u) * scale,
+                std::min((g * 24) + (b * 8),960u) * scale,
+                std::min((r * 6) + (g * 4) + (b * 22),960u) * scale);
+        }
+
+        // the lcd is mixed in linear light at a gamma of 4, and then brought back for a 2.2 display
+        case colour_correction::gba:
+        {
+            const f64 lr = std::pow(r / 31.0,4.0);
+            const f64 lg = std::pow(g / 31.0,4.0);
+            const f64 lb = std::pow(b / 31.0,4.0);
+
+            const f64 scale = (255.0 * 255.0) / 280.0;
+            const f64 gamma = 1.0 / 2.2;
+
+            return pack_colour(std::pow(((50.0 * lg) + (255.0 * lr)) / 255.0,gamma) * scale,
+                std::pow(((30.0 * lb) + (230.0 * lg) + (10.0 * lr)) / 255.0,gamma) * scale,
+                std::pow(((220.0 * lb) + (10.0 * lg) + (50.0 * lr)) / 255.0,gamma) * scale);
+        }
+
+        case colour_correction::none: break;
+    }
+
+    return pack_colour(r * (255.0 / 31.0),g * (255.0 / 31.0),b * (255.0 / 31.0));
+}
+
+static void correct_rows(const u32* lut, const u32* src, u32* dst, u32 count)
+{
+    // alpha is passed through as is
+    for(u32 i = 0; i < count; i++)
+    {
+        const u32 c = src[i];
+        const u32 idx = ((c >> 3) & 0x1f) | ((c >> 6) & 0x3e0) | ((c >> 9) & 0x7c00);
+
+        dst[i] = lut[idx] | (c & 0xff00'0000);
+    }
+}
+
+// a quarter off each colour channel, leaving alpha alone
+inline u32 darken_pixel(u32 c)
+{
+    return c - ((c >> 2) & 0x003f'3f3f);
+}
+
+static void darken_row(const u32* src, u32* dst, u32 width)
+{
+    u32 x = 0;
+
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi32(0x003f'3f3f);
+
+    for(; x + 4 <= width; x += 4)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)&src[x]);
+        const __m128i quarter = _mm_and_si128(_mm_srli_epi32(v,2),mask);
+
+        _mm_storeu_si128((__m128i*)&dst[x],_mm_sub_epi32(v,quarter));
+    }
+#endif
+
+    for(; x < width; x++)
+    {
+        dst[x] = darken_pixel(src[x]);
+    }
+}
+
+// every pixel out to scale copies of itself
+static void expand_row(const u32* src, u32 width, u32 scale, u32* dst)
+{
+#ifdef __SSE2__
+    if(scale >= 4)
+    {
+        for(u32 x = 0; x < width; x++)
+        {
+            const __m128i v = _mm_set1_epi32(src[x]);
+            u32* out = &dst[x * scale];
+
+            u32 i = 0;
+
+            for(; i + 4 <= scale; i += 4)
+            {
+                _mm_storeu_si128((__m128i*)&out[i],v);
+            }
+
+            // the tail just overlaps the last store
+            if(i != scale)
+            {
+                _mm_storeu_si128((__m128i*)&out[scale - 4],v);
+            }
+        }
+
+        return;
+    }
+#endif
+
+    for(u32 x = 0; x < width; x++)
+    {
+        std::fill_n(&dst[x * scale],scale,src[x]);
+    }
+}
+
+// the first row of each block is built, and the rest copied down from it
+static void integer_rows(const u32* src, u32 width, u32 scale, u32* dst, u32 start, u32 end)
+{
+    const u32 out_width = width * scale;
+
+    for(u32 y = start; y < end; y++)
+    {
+        u32* row = &dst[(y * scale) * out_width];
+        expand_row(&src[y * width],width,scale,row);
+
+        for(u32 i = 1; i < scale; i++)
+        {
+            std::copy(row,row + out_width,row + (i * out_width));
+        }
+    }
+}
+
+// as integer, but the last row and column of every cell is the gap between lcd cells
+static void lcd_grid_rows(const u32* src, u32 width, u32 scale, u32* dst, u32 start, u32 end)
+{
+    const u32 out_width = width * scale;
+
+    for(u32 y = start; y < end; y++)
+    {
+        u32* row = &dst[(y * scale) * out_width];
+        expand_row(&src[y * width],width,scale,row);
+
+        for(u32 x = scale - 1; x < out_width; x += scale)
+        {
+            row[x] = darken_pixel(row[x]);
+        }
+
+        for(u32 i = 1; i < scale - 1; i++)
+        {
+            std::copy(row,row + out_width,row + (i * out_width));
+        }
+
+        darken_row(row,row + ((scale - 1) * out_width),out_width);
+    }
+}
+
+// a above, b right, c left, d below
+// a corner only takes a neighbour when the two sides meeting there agree and the cross is not flat
+inline void scale2x_pixel(u32 a, u32 b, u32 c, u32 d, u32 p, u32* top, u32* bottom)
+{
+    const b32 flat = a == d || c == b;
+
+    top[0] = !flat && c == a? c : p;
+    top[1] = !flat && a == b? b : p;
+    bottom[0] = !flat && d == c? c : p;
+    bottom[1] = !flat && b == d? b : p;
+}
+
+#ifdef __SSE2__
+inline __m128i select_pixels(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask,a),_mm_andnot_si128(mask,b));
+}
+#endif
+
+static void scale2x_rows(const u32* src, u32 width, u32 height, u32* dst, u32 start, u32 end)
+{
+    const u32 out_width = width * 2;
+
+    for(u32 y = start; y < end; y++)
+    {
+        // the edges just repeat themselves
+        const u32* above = &src[(y == 0? 0 : y - 1) * width];
+        const u32* row = &src[y * width];
+        const u32* below = &src[std::min(y + 1,height - 1) * width];
+
+        u32* top = &dst[(y * 2) * out_width];
+        u32* bottom = top + out_width;
+
+        const auto pixel = [&](u32 x)
+        {
+            const u32 left = row[x == 0? 0 : x - 1];
+            const u32 right = row[std::min(x + 1,width - 1)];
+
+            scale2x_pixel(above[x],right,left,below[x],row[x],&top[x * 2],&bottom[x * 2]);
+        };
+
+        pixel(0);
+
+        u32 x = 1;
+
+#ifdef __SSE2__
+        // four pixels at a time, until the right neighbour would run off the end
+        for(; x + 5 <= width; x += 4)
+        {
+            const __m128i a = _mm_loadu_si128((const __m128i*)&above[x]);
+            const __m128i b = _mm_loadu_si128((const __m128i*)&row[x + 1]);
+            const __m128i c = _mm_loadu_si128((const __m128i*)&row[x - 1]);
+            const __m128i d = _mm_loadu_si128((const __m128i*)&below[x]);
+            const __m128i p = _mm_loadu_si128((const __m128i*)&row[x]);
+
+            const __m128i flat = _mm_or_si128(_mm_cmpeq_epi32(a,d),_mm_cmpeq_epi32(c,b));
+
+            const __m128i e0 = select_pixels(_mm_andnot_si128(flat,_mm_cmpeq_epi32(c,a)),c,p);
+            const __m128i e1 = select_pixels(_mm_andnot_si128(flat,_mm_cmpeq_epi32(a,b)),b,p);
+            const __m128i e2 = select_pixels(_mm_andnot_si128(flat,_mm_cmpeq_epi32(d,c)),c,p);
+            const __m128i e3 = select_pixels(_mm_andnot_si128(flat,_mm_cmpeq_epi32(b,d)),b,p);
+
+            // interleave the left and right halves of each output pixel back together
+            _mm_storeu_si128((__m128i*)&top[x * 2],_mm_unpacklo_epi32(e0,e1));
+            _mm_storeu_si128((__m128i*)&top[(x * 2) + 4],_mm_unpackhi_epi32(e0,e1));
+            _mm_storeu_si128((__m128i*)&bottom[x * 2],_mm_unpacklo_epi32(e2,e3));
+            _mm_storeu_si128((__m128i*)&bottom[(x * 2) + 4],_mm_unpackhi_epi32(e2,e3));
+        }
+#endif
+
+        for(; x < width; x++)
+        {
+            pixel(x);
+        }
+    }
+}
+
+static void scale2x_pass(Upscaler& upscaler, const u32* src, u32 width, u32 height, u32* dst)
+{
+    run_bands(upscaler,height,[=](u32 start, u32 end)
+    {
+        scale2x_rows(src,width,height,dst,start,end);
+    });
+}
+
+void init_upscaler(Upscaler& upscaler, u32 threads)
+{
+    if(threads == 0)
+    {
+        threads = std::clamp(std::thread::hardware_concurrency() / 2,1u,4u);
+    }
+
+    upscaler.pool = std::make_unique<ThreadPool>(threads);
+    set_colour_correction(upscaler,upscaler.correction);
+}
+
+void set_upscale_filter(Upscaler& upscaler, upscale_filter filter)
+{
+    upscaler.filter = filter;
+}
+
+void set_colour_correction(Upscaler& upscaler, colour_correction correction)
+{
+    upscaler.correction = correction;
+    upscaler.correction_lut.resize(32 * 32 * 32);
+
+    for(u32 c = 0; c < upscaler.correction_lut.size(); c++)
+    {
+        upscaler.correction_lut[c] = correct_colour(correction,c & 0x1f,(c >> 5) & 0x1f,(c >> 10) & 0x1f);
+    }
+}
+
+const char* upscale_filter_name(upscale_filter filter)
+{
+    switch(filter)
+    {
+        case upscale_filter::none: return "none";
+        case upscale_filter::integer: return "integer";
+        case upscale_filter::scale2x: return "scale2x";
+        case upscale_filter::lcd_grid: return "lcd grid";
+    }
+
+    return "unknown";
+}
+
+const char* colour_correction_name(colour_correction correction)
+{
+    switch(correction)
+    {
+        case colour_correction::none: return "none";
+        case colour_correction::gbc: return "gbc";
+        case colour_correction::gba: return "gba";
+    }
+
+    return "unknown";
+}
+
+u32 upscale_factor(upscale_filter filter, u32 x, u32 y, u32 target_x, u32 target_y)
+{
+    if(!x || !y)
+    {
+        return 1;
+    }
+
+    const u32 fit = std::clamp(std::min(target_x / x,target_y / y),1u,Upscaler::MAX_SCALE);
+
+    switch(filter)
+    {
+        case upscale_filter::none: return 1;
+
+        case upscale_filter::scale2x: return fit >= 4? 4 : (fit >= 2? 2 : 1);
+
+        case upscale_filter::integer:
+        case upscale_filter::lcd_grid: return fit;
+    }
+
+    return 1;
+}
+
+const u32* upscale_frame(Upscaler& upscaler, const u32* src, u32 x, u32 y, u32 target_x, u32 target_y)
+{
+    const u32 scale = upscale_factor(upscaler.filter,x,y,target_x,target_y);
+
+    upscaler.out_x = x * scale;
+    upscaler.out_y = y * scale;
+
+    if(upscaler.correction != colour_correction::none)
+    {
+        auto& corrected = upscaler.corrected;
+        corrected.resize(x * y);
+
+        const u32* lut = upscaler.correction_lut.data();
+        u32* dst = corrected.data();
+
+        run_bands(upscaler,y,[=](u32 start, u32 end)
+        {
+            correct_rows(lut,&src[start * x],&dst[start * x],(end - start) * x);
+        });
+
+        src = dst;
+    }
+
+    if(scale == 1)
+    {
+        return src;
+    }
+
+    auto& out = upscaler.out;
+    out.resize(upscaler.out_x * upscaler.out_y);
+
+    u32* dst = out.data();
+
+    switch(upscaler.filter)
+    {
+        case upscale_filter::integer:
+        {
+            run_bands(upscaler,y,[=](u32 start, u32 end)
+            {
+                integer_rows(src,x,scale,dst,start,end);
+            });
+            break;
+        }
+
+        case upscale_filter::lcd_grid:
+        {
+            run_bands(upscaler,y,[=](u32 start, u32 end)
+            {
+                lcd_grid_rows(src,x,scale,dst,start,end);
+            });
+            break;
+        }
+
+        case upscale_filter::scale2x:
+        {
+            if(scale == 2)
+            {
+                scale2x_pass(upscaler,src,x,y,dst);
+            }
+
+            else
+            {
+                upscaler.doubled.resize((x * 2) * (y * 2));
+                scale2x_pass(upscaler,src,x,y,upscaler.doubled.data());
+                scale2x_pass(upscaler,upscaler.doubled.data(),x * 2,y * 2,dst);
+            }
+            break;
+        }
+
+        case upscale_filter::none: break;
+    }
+
+    return dst;
+}
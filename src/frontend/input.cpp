@@ -151,6 +151,30 @@ emu_control Input::handle_input(SDL_Window* window, b32 ignore_key_inputs)
 						break;
 					}
 
+					case SDLK_M:
+					{
+						control = emu_control::metrics_t;
+						break;
+					}
+
+					case SDLK_J:
+					{
+						control = emu_control::fast_forward_t;
+						break;
+					}
+
+					case SDLK_O:
+					{
+						control = emu_control::filter_t;
+						break;
+					}
+
+					case SDLK_I:
+					{
+						control = emu_control::colour_t;
+						break;
+					}
+
 					default:
 					{
 						add_event_from_key(event.key.key,true);
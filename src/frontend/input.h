@@ -16,6 +16,10 @@ enum class emu_control
     unbound_t,
     break_t,
     quit_t,
+    metrics_t,
+    fast_forward_t,
+    filter_t,
+    colour_t,
     none_t,
 };
 
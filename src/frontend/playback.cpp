@@ -2,6 +2,9 @@
 #include "playback.h"
 #include <algorithm>
 
+// per update, how far the averages move towards the latest reading
+static constexpr f64 LATENCY_SMOOTH = 0.05;
+static constexpr f64 DRIFT_SMOOTH = 0.02;
 
 void Playback::init(AudioBuffer& buffer) noexcept
 {
@@ -26,6 +29,7 @@ void Playback::init(AudioBuffer& buffer) noexcept
 void Playback::start() noexcept
 {
 	play_audio = true;
+    reset_sync();
     SDL_ResumeAudioStreamDevice(stream);
 }
 
@@ -62,14 +66,119 @@ void Playback::push_samples(AudioBuffer& audio_buffer)
 
     const u32 buffer_size = audio_buffer.length * sizeof(f32);
 
-    // delay execution and let the queue drain
-    while(SDL_GetAudioStreamQueued(stream) > (int)buffer_size)
+    // the core is paced by the frontend now, so this never waits on the queue
+    // it only stops a core that has got well ahead from growing it without bound
+    if(queued_ms() > MAX_LATENCY_MS * speed)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }			
+        return;
+    }
 
     if(!SDL_PutAudioStreamData(stream,audio_buffer.buffer.data(),buffer_size))
     {
         printf("Failed to queue audio %s\n",SDL_GetError()); exit(1);
     }
 }
+
+// in emulated time, as that is the rate samples went in at
+f64 Playback::queued_ms() const noexcept
+{
+    const int queued = SDL_GetAudioStreamQueued(stream);
+
+    if(queued <= 0)
+    {
+        return 0.0;
+    }
+
+    return (f64(queued) / (sizeof(f32) * AUDIO_CHANNEL_COUNT * AUDIO_BUFFER_SAMPLE_RATE)) * 1000.0;
+}
+
+void Playback::apply_rate() noexcept
+{
+    SDL_SetAudioStreamFrequencyRatio(stream,f32(ratio * speed));
+}
+
+void Playback::reset_sync() noexcept
+{
+    ratio = 1.0;
+    latency_avg = TARGET_LATENCY_MS;
+    drift_avg = 0.0;
+    sync_started = false;
+    filling = false;
+
+    apply_rate();
+}
+
+void Playback::set_speed(f32 multiplier) noexcept
+{
+    speed = multiplier;
+
+    // the queue is heard at a different rate now, so the averages start over
+    reset_sync();
+}
+
+void Playback::update_rate() noexcept
+{
+    if(!play_audio || !stream)
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    // the stream plays the queue back at ratio * speed, so this is how long it takes to hear
+    const f64 latency = queued_ms() / (ratio * speed);
+
+    if(!sync_started)
+    {
+        latency_avg = latency;
+        last_update = now;
+        sync_started = true;
+        return;
+    }
+
+    const f64 dt = std::chrono::duration<f64>(now - last_update).count();
+    last_update = now;
+
+    const f64 last_latency = latency_avg;
+    latency_avg += (latency - latency_avg) * LATENCY_SMOOTH;
+
+    if(dt > 0.0)
+    {
+        // the correction already takes (ratio - 1) of a second off each second, add that back for the raw drift
+        const f64 drift = ((latency_avg - last_latency) / dt) + ((ratio - 1.0) * 1000.0);
+        drift_avg += (drift - drift_avg) * DRIFT_SMOOTH;
+    }
+
+    // proportional, a queue on target plays at the native rate
+    // and one at double or empty gets the full adjustment
+    const f64 error = std::clamp((latency_avg - TARGET_LATENCY_MS) / TARGET_LATENCY_MS,-1.0,1.0);
+    ratio = 1.0 + (error * MAX_RATE_ADJUST);
+    apply_rate();
+
+    stats.latency_ms.store(f32(latency_avg),std::memory_order_relaxed);
+    stats.drift.store(f32(drift_avg),std::memory_order_relaxed);
+    stats.ratio.store(f32(ratio),std::memory_order_relaxed);
+}
+
+bool Playback::needs_fill() noexcept
+{
+    if(!play_audio || !stream)
+    {
+        return false;
+    }
+
+    const f64 latency = queued_ms() / speed;
+
+    // once it has run dry fill right back up to the target, rather than sit just above empty
+    if(latency < LOW_LATENCY_MS)
+    {
+        filling = true;
+    }
+
+    else if(latency >= TARGET_LATENCY_MS)
+    {
+        filling = false;
+    }
+
+    return filling;
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <destoer/destoer.h>
 #include <albion/audio.h>
+#include <atomic>
+#include <chrono>
 
 #define SDL_MAIN_HANDLED
 #ifdef _WIN32
@@ -9,12 +11,30 @@
 #include <SDL3/SDL.h>
 #endif
 
+// written by the emulation thread, read back for the metrics overlay
+struct AudioSyncStats
+{
+    // how long a sample pushed now takes to be heard
+    std::atomic<f32> latency_ms = 0.0;
+
+    // how fast the queue would fill without any correction, in ms per second
+    // this is the gap between the emulated audio clock and the device one
+    std::atomic<f32> drift = 0.0;
+
+    // rate the stream is played back at to correct for it, before any fast forward
+    std::atomic<f32> ratio = 1.0;
+};
+
+// the core is held to its own clock and the speakers to theirs, so the queue slowly drifts
+// rather than blocking the core on it, the playback rate is nudged to hold the queue at a target latency
+// the change is small enough that the pitch shift cannot be heard
 class Playback
 {
 public:
     void init(AudioBuffer& buffer) noexcept;
 
     bool is_playing() const noexcept { return play_audio; }
+    bool is_open() const noexcept { return stream != nullptr; }
 
     void start() noexcept;
     void stop() noexcept;
@@ -22,7 +42,41 @@ public:
     ~Playback();
     void push_samples(AudioBuffer& audio_buffer);
 
+    // once a frame, corrects the playback rate from how full the queue is
+    void update_rate() noexcept;
+
+    // play this many times faster, the core has to be sped up to match
+    void set_speed(f32 multiplier) noexcept;
+
+    // the queue is close to running dry, far quicker for the core to run ahead and fill it than to correct the rate
+    bool needs_fill() noexcept;
+
+    AudioSyncStats stats;
+
+    static constexpr f64 TARGET_LATENCY_MS = 50.0;
+    static constexpr f64 LOW_LATENCY_MS = 10.0;
+
+    // samples past this are dropped, the rate correction would take too long to get it back down
+    static constexpr f64 MAX_LATENCY_MS = 250.0;
+
+    // most the rate is ever moved either way
+    static constexpr f64 MAX_RATE_ADJUST = 0.005;
+
 private:
-    SDL_AudioStream *stream;
+    f64 queued_ms() const noexcept;
+    void apply_rate() noexcept;
+    void reset_sync() noexcept;
+
+    SDL_AudioStream *stream = nullptr;
     bool play_audio = false;
+
+    f32 speed = 1.0;
+    f64 ratio = 1.0;
+
+    // smoothed, the device takes from the queue in whole chunks so a single reading jumps about
+    f64 latency_avg = TARGET_LATENCY_MS;
+    f64 drift_avg = 0.0;
+    b32 sync_started = false;
+    b32 filling = false;
+    std::chrono::steady_clock::time_point last_update;
 };
\ No newline at end of file
@@ -1,35 +1,259 @@
 #include <gb/gb.h>
 #include "gb_window.h"
 
+s64 elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+void RunAheadBudget::add_frame(s64 real, s64 hidden, s64 snapshot, s64 restore, u32 hidden_count)
+{
+    real_ns += real;
+    hidden_ns += hidden;
+    snapshot_ns += snapshot;
+    restore_ns += restore;
+    hidden_frames += hidden_count;
+    frames++;
+}
+
+void RunAheadBudget::report(b32 second_instance)
+{
+    if(frames < REPORT_FRAMES)
+    {
+        return;
+    }
+
+    const f64 frame_budget_ms = 1000.0 / 60.0;
+
+    const f64 real_ms = (f64(real_ns) / frames) / 1000'000.0;
+    const f64 hidden_ms = hidden_frames? (f64(hidden_ns) / hidden_frames) / 1000'000.0 : real_ms;
+    const f64 snapshot_ms = (f64(snapshot_ns) / frames) / 1000'000.0;
+    const f64 restore_ms = (f64(restore_ns) / frames) / 1000'000.0;
+
+    // the second instance runs in parallel with the real frame
+    // so only the restore eats into its time
+    const f64 overhead_ms = second_instance? restore_ms : real_ms + snapshot_ms + restore_ms;
+    const f64 remain_ms = frame_budget_ms - overhead_ms;
+
+    const s64 fit = remain_ms > 0.0? s64(remain_ms / hidden_ms) - second_instance : 0;
+
+    spdlog::info("run ahead: frame {:.3f}ms, hidden {:.3f}ms, snapshot {:.3f}us, restore {:.3f}us, {} frames fit in {:.1f}ms",
+        real_ms,hidden_ms,snapshot_ms * 1000.0,restore_ms * 1000.0,std::max(fit,s64(0)),frame_budget_ms);
+
+    *this = {};
+}
+
+GameboyWindow::~GameboyWindow()
+{
+    stop_shadow();
+}
+
+void GameboyWindow::set_run_ahead(u32 frames, b32 second_instance)
+{
+    run_ahead = frames;
+    run_ahead_second_instance = second_instance;
+}
 
 void GameboyWindow::init(const std::string& filename,Playback& playback)
 {
     init_sdl(gameboy::SCREEN_WIDTH,gameboy::SCREEN_HEIGHT);
     input.init();
-    gb.reset(filename);	
+    gb.reset(filename);
+    gb.ppu.frame_sink = this;
+    set_upscale(upscale_filter::integer,gb.cpu.is_cgb? colour_correction::gbc : colour_correction::none);
     gb.apu.audio_buffer.playback = &playback;
     playback.init(gb.apu.audio_buffer);
+
+    if(run_ahead)
+    {
+        spdlog::info("run ahead {} frames{}",run_ahead,run_ahead_second_instance? " (second instance)" : "");
+
+        // state size is fixed once the rom is loaded
+        run_ahead_state.resize(gb.save_state_size());
+
+        if(run_ahead_second_instance)
+        {
+            start_shadow(filename);
+        }
+    }
 }
 
 void GameboyWindow::pass_input_to_core()
 {
-    gb.handle_input(input.controller);
-    input.controller.input_events.clear();
+    gb.handle_input(core_input);
+
+    if(shadow)
+    {
+        shadow_input.input_events = core_input.input_events;
+    }
+
+    core_input.input_events.clear();
 }
 
 void GameboyWindow::core_quit()
 {
+    stop_shadow();
     gb.mem.save_cart_ram();
-    exit(0);   
+    exit(0);
+}
+
+void GameboyWindow::run_ahead_frame()
+{
+    // advance the real machine, this is the only frame that is heard
+    auto start = std::chrono::steady_clock::now();
+    gb.run_suppressed(false,true);
+    const s64 real = elapsed_ns(start);
+
+    start = std::chrono::steady_clock::now();
+    gb.save_state(run_ahead_state.data(),run_ahead_state.size());
+    const s64 snapshot = elapsed_ns(start);
+
+    // run the hidden frames, only the last one gets presented
+    start = std::chrono::steady_clock::now();
+    for(u32 i = 0; i < run_ahead; i++)
+    {
+        gb.run_suppressed(i == run_ahead - 1,false);
+    }
+    const s64 hidden = elapsed_ns(start);
+
+    start = std::chrono::steady_clock::now();
+    if(gb.load_state(run_ahead_state.data(),run_ahead_state.size()) == dtr_res::err)
+    {
+        gb.cpu.panic("run ahead: failed to restore state");
+    }
+    const s64 restore = elapsed_ns(start);
+
+    budget.add_frame(real,hidden,snapshot,restore,run_ahead);
+    budget.report(false);
+}
+
+void GameboyWindow::run_ahead_second_instance_frame()
+{
+    // kick the shadow off from last frames state with this frames input
+    // it runs ahead while we advance the real machine
+    {
+        std::scoped_lock lock(shadow_mutex);
+        shadow_pending = true;
+    }
+    shadow_cv.notify_one();
+
+    auto start = std::chrono::steady_clock::now();
+    gb.run_suppressed(false,true);
+    const s64 real = elapsed_ns(start);
+
+    start = std::chrono::steady_clock::now();
+    {
+        std::unique_lock lock(shadow_mutex);
+        shadow_cv.wait(lock,[this]{ return !shadow_pending; });
+    }
+    const s64 hidden = elapsed_ns(start) + real;
+
+    // the shadow is idle again so we are free to hand it the next state
+    start = std::chrono::steady_clock::now();
+    gb.save_state(run_ahead_state.data(),run_ahead_state.size());
+    const s64 snapshot = elapsed_ns(start);
+
+    budget.add_frame(real,hidden - shadow_restore_ns,snapshot,shadow_restore_ns,run_ahead + 1);
+    budget.report(true);
+}
+
+void GameboyWindow::start_shadow(const std::string& filename)
+{
+    shadow = std::make_unique<gameboy::GB>();
+    shadow->reset(filename);
+
+    // the shadow is never heard and never allowed to write out cart ram
+    // but the frames it runs ahead to are the ones that get shown
+    shadow->apu.audio_buffer.playback = nullptr;
+    shadow->ppu.frame_sink = this;
+    shadow->throttle_emu = false;
+
+    gb.save_state(run_ahead_state.data(),run_ahead_state.size());
+
+    shadow_quit = false;
+    shadow_pending = false;
+    shadow_thread = std::thread(&GameboyWindow::shadow_main,this);
+}
+
+void GameboyWindow::stop_shadow()
+{
+    if(!shadow_thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(shadow_mutex);
+        shadow_quit = true;
+    }
+    shadow_cv.notify_one();
+
+    shadow_thread.join();
+}
+
+void GameboyWindow::shadow_main()
+{
+    for(;;)
+    {
+        {
+            std::unique_lock lock(shadow_mutex);
+            shadow_cv.wait(lock,[this]{ return shadow_pending || shadow_quit; });
+
+            if(shadow_quit)
+            {
+                return;
+            }
+        }
+
+        // the state is a frame behind the real machine
+        // so run one extra frame to end up at the same point as single instance run ahead
+        const auto start = std::chrono::steady_clock::now();
+        if(shadow->load_state(run_ahead_state.data(),run_ahead_state.size()) == dtr_res::err)
+        {
+            spdlog::error("run ahead: shadow failed to load state");
+        }
+        shadow_restore_ns = elapsed_ns(start);
+
+        shadow->handle_input(shadow_input);
+
+        for(u32 i = 0; i <= run_ahead; i++)
+        {
+            shadow->run_suppressed(i == run_ahead,false);
+        }
+
+        {
+            std::scoped_lock lock(shadow_mutex);
+            shadow_pending = false;
+        }
+        shadow_cv.notify_one();
+    }
 }
 
 void GameboyWindow::run_frame(bool paused)
 {
-    if(!paused)
+    // frames go out at vblank from whichever instance is presenting
+    // so a paused core has nothing to hand over, and the last one stays up
+    if(paused)
+    {
+        return;
+    }
+
+    // dont try to run ahead when the debugger wants to see every frame
+    if(!run_ahead || gb.debug.breakpoints_enabled)
     {
         gb.run();
     }
-    render(gb.ppu.rendered.data());
+
+    else if(shadow)
+    {
+        run_ahead_second_instance_frame();
+    }
+
+    else
+    {
+        run_ahead_frame();
+    }
 }
 
 void GameboyWindow::debug_halt()
@@ -47,7 +271,7 @@ void GameboyWindow::core_throttle()
 void GameboyWindow::core_unbound()
 {
     playback.stop();
-    gb.throttle_emu = false; 
+    gb.throttle_emu = false;
 }
 
 void GameboyWindow::handle_debug()
@@ -56,4 +280,4 @@ void GameboyWindow::handle_debug()
     {
         gb.debug.debug_input();
     }
-}
\ No newline at end of file
+}
@@ -1,9 +1,36 @@
 #pragma once
 #include <gb/gb.h>
 #include "sdl_window.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// rolling timings for run ahead so we can see how many frames fit in a 60hz frame
+struct RunAheadBudget
+{
+    void add_frame(s64 real_ns, s64 hidden_ns, s64 snapshot_ns, s64 restore_ns, u32 hidden_frames);
+    void report(b32 second_instance);
+
+    s64 real_ns = 0;
+    s64 hidden_ns = 0;
+    s64 snapshot_ns = 0;
+    s64 restore_ns = 0;
+
+    u32 frames = 0;
+    u32 hidden_frames = 0;
+
+    static constexpr u32 REPORT_FRAMES = 300;
+};
 
 class GameboyWindow final : public SDLMainWindow
 {
+public:
+    ~GameboyWindow();
+
+    // run ahead N frames to hide the input latency of the game
+    // the second instance variant runs a shadow machine on its own thread
+    void set_run_ahead(u32 frames, b32 second_instance);
+
 protected:
     void init(const std::string& filename,Playback& playback) override;
     void pass_input_to_core() override;
@@ -15,5 +42,27 @@ protected:
     void debug_halt() override;
 
 private:
+    void run_ahead_frame();
+    void run_ahead_second_instance_frame();
+
+    void start_shadow(const std::string& filename);
+    void stop_shadow();
+    void shadow_main();
+
     gameboy::GB gb;
+
+    u32 run_ahead = 0;
+    b32 run_ahead_second_instance = false;
+    std::vector<u8> run_ahead_state;
+    RunAheadBudget budget;
+
+    // second instance run ahead
+    std::unique_ptr<gameboy::GB> shadow;
+    std::thread shadow_thread;
+    std::mutex shadow_mutex;
+    std::condition_variable shadow_cv;
+    b32 shadow_pending = false;
+    b32 shadow_quit = false;
+    s64 shadow_restore_ns = 0;
+    Controller shadow_input;
 };
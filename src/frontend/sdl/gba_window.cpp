@@ -3,16 +3,19 @@
 void GBAWindow::init(const std::string& filename, Playback& playback)
 {
     init_sdl(gameboyadvance::SCREEN_WIDTH,gameboyadvance::SCREEN_HEIGHT);
+    frame_rate = gameboyadvance::FRAME_RATE;
     input.init();
     gba.reset(filename);	
+    gba.disp.frame_sink = this;
+    set_upscale(upscale_filter::integer,colour_correction::gba);
     gba.apu.audio_buffer.playback = &playback;
     playback.init(gba.apu.audio_buffer);
 }
 
 void GBAWindow::pass_input_to_core()
 {
-    gba.handle_input(input.controller);
-    input.controller.input_events.clear();
+    gba.handle_input(core_input);
+    core_input.input_events.clear();
 }
 
 void GBAWindow::core_quit()
@@ -23,11 +26,11 @@ void GBAWindow::core_quit()
 
 void GBAWindow::run_frame(bool paused)
 {
+    // the screen goes out at vblank
     if(!paused)
     {
         gba.run();
     }
-    render(gba.disp.screen.data());
 }
 
 void GBAWindow::debug_halt()
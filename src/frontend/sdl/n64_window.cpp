@@ -3,18 +3,31 @@
 
 void N64Window::init(const std::string& filename,Playback& playback)
 {
-    UNUSED(playback);
     init_sdl(320,240);
     input.init();
     reset(n64,filename);
+    set_rsp_threaded(n64,rsp_thread);
+    set_dynarec_enabled(n64,!interpreter);
+    n64.rdp.frame_sink = this;
     input.controller.simulate_dpad = false;	
+    n64.audio_buffer.playback = &playback;
     playback.init(n64.audio_buffer);
 }
 
+void N64Window::set_rsp_thread(b32 threaded)
+{
+    rsp_thread = threaded;
+}
+
+void N64Window::set_interpreter(b32 enabled)
+{
+    interpreter = enabled;
+}
+
 void N64Window::pass_input_to_core()
 {
-    nintendo64::handle_input(n64,input.controller);
-    input.controller.input_events.clear();
+    nintendo64::handle_input(n64,core_input);
+    core_input.input_events.clear();
 }
 
 void N64Window::core_quit()
@@ -25,18 +38,11 @@ void N64Window::core_quit()
 
 void N64Window::run_frame(bool paused)
 {
+    // the screen goes out from the vi when it is scanned out, with its size
     if(!paused)
     {
         run(n64);
-
-        if(n64.size_change)
-        {
-            create_texture(n64.rdp.screen_x,n64.rdp.screen_y);
-            n64.size_change = false;
-        }
     }
-    
-    render(n64.rdp.screen.data());
 }
 
 void N64Window::debug_halt()
@@ -46,12 +52,13 @@ void N64Window::debug_halt()
 
 void N64Window::core_throttle()
 {
-
+    playback.start();
+    reset_audio_buffer(n64.audio_buffer);
 }
 
 void N64Window::core_unbound()
 {
-
+    playback.stop();
 }
 
 void N64Window::handle_debug()
@@ -4,6 +4,10 @@
 
 class N64Window final : public SDLMainWindow
 {
+public:
+    void set_rsp_thread(b32 threaded);
+    void set_interpreter(b32 enabled);
+
 protected:
     void init(const std::string& filename,Playback& playback) override;
     void pass_input_to_core() override;
@@ -16,4 +20,6 @@ protected:
 
 private:
     nintendo64::N64 n64;
+    b32 rsp_thread = false;
+    b32 interpreter = false;
 };
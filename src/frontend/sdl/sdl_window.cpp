@@ -35,6 +35,9 @@ void start_emu(std::string filename, Config& cfg)
 			case emu_type::gameboy:
 			{
 				GameboyWindow gb;
+				gb.set_run_ahead(cfg.run_ahead_frames,cfg.run_ahead_second_instance);
+				gb.set_pacing(cfg.pacing);
+				gb.set_fast_forward(cfg.fast_forward);
 				gb.main(filename,cfg.start_debug);
 				break;
 			}
@@ -44,6 +47,8 @@ void start_emu(std::string filename, Config& cfg)
 			case emu_type::gba:
 			{
 				GBAWindow gba;
+				gba.set_pacing(cfg.pacing);
+				gba.set_fast_forward(cfg.fast_forward);
 				gba.main(filename,cfg.start_debug);
 				break;
 			}
@@ -53,6 +58,10 @@ void start_emu(std::string filename, Config& cfg)
 			case emu_type::n64:
 			{
 				N64Window n64;
+				n64.set_rsp_thread(cfg.rsp_thread);
+				n64.set_interpreter(cfg.interpreter);
+				n64.set_pacing(cfg.pacing);
+				n64.set_fast_forward(cfg.fast_forward);
 				n64.main(filename,cfg.start_debug);
 				break;
 			}
@@ -81,15 +90,11 @@ void SDLMainWindow::create_texture(u32 x, u32 y)
 		SDL_DestroyTexture(texture);
 	}
 
-	X = x;
-	Y = y;
+	texture_x = x;
+	texture_y = y;
 
 	texture = SDL_CreateTexture(renderer,
 		SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, x, y);
-
-
-	// resize the window
-	SDL_SetWindowSize(window,x * 2, y * 2);
 }
 
 void SDLMainWindow::init_sdl(u32 x, u32 y)
@@ -100,20 +105,144 @@ void SDLMainWindow::init_sdl(u32 x, u32 y)
 	// set a render for our window
 	renderer = SDL_CreateRenderer(window, NULL);
 
+	X = x;
+	Y = y;
 	create_texture(x,y);
+
+	init_upscaler(upscaler);
+}
+
+void SDLMainWindow::set_upscale(upscale_filter filter, colour_correction correction)
+{
+	core_correction = correction;
+
+	set_upscale_filter(upscaler,filter);
+	set_colour_correction(upscaler,correction);
+}
+
+void SDLMainWindow::cycle_upscale_filter()
+{
+	const auto filter = upscale_filter((u32(upscaler.filter) + 1) % UPSCALE_FILTER_SIZE);
+	set_upscale_filter(upscaler,filter);
+	refilter = true;
+
+	spdlog::info("upscale filter: {}",upscale_filter_name(filter));
+}
+
+void SDLMainWindow::toggle_colour_correction()
+{
+	const auto correction = upscaler.correction == colour_correction::none? core_correction : colour_correction::none;
+	set_colour_correction(upscaler,correction);
+	refilter = true;
+
+	spdlog::info("colour correction: {}",colour_correction_name(correction));
+}
+
+void SDLMainWindow::set_pacing(frame_pacing mode)
+{
+	pacing = mode;
 }
 
-void SDLMainWindow::render(const u32* data)
+void SDLMainWindow::set_fast_forward(f32 multiplier)
 {
-    // do our screen blit
-    SDL_UpdateTexture(texture, NULL, data,  4 * X);
-    SDL_RenderTexture(renderer, texture, NULL, NULL);
-    SDL_RenderPresent(renderer);    	
+	fast_forward = multiplier;
+}
+
+void SDLMainWindow::submit_frame(std::vector<u32>& screen, u32 x, u32 y)
+{
+	auto& frame = frames.back();
+
+	std::swap(frame.pixels,screen);
+	frame.x = x;
+	frame.y = y;
+
+	if(!frames.publish())
+	{
+		metrics.frames_skipped.fetch_add(1,std::memory_order_relaxed);
+	}
+
+	// the slot we got back may be from before a resolution change, or never used at all
+	screen.resize(x * y);
+}
+
+// returns if there was a new frame to show
+b32 SDLMainWindow::present_frame(b32 show_metrics, f32 present_fps)
+{
+	const b32 fresh = frames.take();
+	const auto& frame = frames.front();
+
+	const b32 redraw = (fresh || refilter) && frame.x && frame.y;
+	refilter = false;
+
+	if(redraw)
+	{
+		// the core changed resolution
+		if(s32(frame.x) != X || s32(frame.y) != Y)
+		{
+			X = frame.x;
+			Y = frame.y;
+			SDL_SetWindowSize(window,X * 2,Y * 2);
+		}
+
+		// scaled up to fit whatever the window is now, the gpu only stretches what is left
+		int target_x = 0;
+		int target_y = 0;
+		SDL_GetRenderOutputSize(renderer,&target_x,&target_y);
+
+		const auto start = std::chrono::steady_clock::now();
+		const u32* pixels = upscale_frame(upscaler,frame.pixels.data(),frame.x,frame.y,std::max(target_x,0),std::max(target_y,0));
+		upscale_ms = std::chrono::duration<f32,std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if(upscaler.out_x != texture_x || upscaler.out_y != texture_y)
+		{
+			create_texture(upscaler.out_x,upscaler.out_y);
+		}
+
+		SDL_UpdateTexture(texture, NULL, pixels, upscaler.out_x * sizeof(u32));
+	}
+
+	// with vsync the present is what paces this thread, so it always happens
+	if(!redraw && pacing != frame_pacing::vsync)
+	{
+		return false;
+	}
+
+	SDL_RenderTexture(renderer, texture, NULL, NULL);
+
+	if(show_metrics)
+	{
+		const std::string lines[] = 
+		{
+			fmt::format("emu {:.1f} fps {:.2f} ms",metrics.emu_fps.load(std::memory_order_relaxed),metrics.emu_frame_ms.load(std::memory_order_relaxed)),
+			fmt::format("present {:.1f} fps",present_fps),
+			fmt::format("skipped {} input queue {}",metrics.frames_skipped.load(std::memory_order_relaxed),metrics.input_depth.load(std::memory_order_relaxed)),
+			fmt::format("audio {:.1f} ms drift {:+.2f} ms/s ratio {:.4f}",playback.stats.latency_ms.load(std::memory_order_relaxed),
+				playback.stats.drift.load(std::memory_order_relaxed),playback.stats.ratio.load(std::memory_order_relaxed)),
+			fmt::format("filter {} {}x{} colour {} {:.2f} ms",upscale_filter_name(upscaler.filter),upscaler.out_x,upscaler.out_y,
+				colour_correction_name(upscaler.correction),upscale_ms),
+		};
+
+		SDL_SetRenderDrawColor(renderer,0xff,0xff,0xff,0xff);
+
+		for(u32 i = 0; i < sizeof(lines) / sizeof(lines[0]); i++)
+		{
+			SDL_RenderDebugText(renderer,4.0f,4.0f + (i * 10.0f),lines[i].c_str());
+		}
+	}
+
+	SDL_RenderPresent(renderer);
+
+	presents.fetch_add(1,std::memory_order_release);
+	presents.notify_all();
+
+	return fresh;
 }
 
 
 SDLMainWindow::~SDLMainWindow()
 {
+	stop_emu();
+
 	if(renderer)
 	{
     	SDL_DestroyRenderer(renderer);
@@ -137,78 +266,275 @@ bool window_in_focus(SDL_Window* window)
 	return (SDL_GetWindowFlags(window) & SDL_WINDOW_OCCLUDED) != 0;
 }
 
+u64 pack_joystick(const Joystick& stick)
+{
+	return (u64(u32(stick.x)) << 32) | u32(stick.y);
+}
+
+Joystick unpack_joystick(u64 v)
+{
+	Joystick stick;
+
+	stick.x = s32(u32(v >> 32));
+	stick.y = s32(u32(v));
+	stick.in_deadzone = !stick.x && !stick.y;
+
+	return stick;
+}
+
 void SDLMainWindow::main(std::string filename, b32 start_debug)
 {
 	init(filename,playback);
 
-	FpsCounter fps_counter;
+	playback.start();
 
-	if(start_debug)
-	{
-		debug_halt();
-	}
+	// with vsync the present waits on the display, and the core waits on the present
+	SDL_SetRenderVSync(renderer,pacing == frame_pacing::vsync? 1 : 0);
 
-	playback.start();
+	throttle_request = pacing != frame_pacing::free_run;
+	emu_thread = std::thread(&SDLMainWindow::emu_main,this,start_debug);
 
-	bool throttle = true;
+	b32 show_metrics = false;
+	f32 present_fps = 0.0;
+	u32 presented = 0;
+	auto second_start = std::chrono::steady_clock::now();
 
     for(;;)
     {
-		const auto start = std::chrono::steady_clock::now();
-
-		fps_counter.reading_start();
 		auto control = input.handle_input(window);
-		
-		pass_input_to_core();
 
+		// if the core is stuck in the debugger these just get dropped
+		for(const auto& event : input.controller.input_events)
+		{
+			input_queue.push(event);
+		}
+
+		input.controller.input_events.clear();
+		stick.store(pack_joystick(input.controller.left),std::memory_order_relaxed);
 
-		run_frame(window_in_focus(window));
+		paused = window_in_focus(window);
 		
 		switch(control)
 		{
 			case emu_control::quit_t:
 			{
+				stop_emu();
 				core_quit();
 				break;
 			}
 
 			case emu_control::throttle_t:
 			{
-				throttle = true;
-				core_throttle();
+				throttle_request = true;
 				break;
 			}
 
 			case emu_control::unbound_t:
 			{
-				throttle = false;
-				core_unbound();
+				throttle_request = false;
 				break;
 			}
 
 			case emu_control::break_t:
 			{
-				debug_halt();
+				break_request = true;
+				break;
+			}
+
+			case emu_control::metrics_t:
+			{
+				show_metrics = !show_metrics;
+				break;
+			}
+
+			case emu_control::fast_forward_t:
+			{
+				speed_request = speed_request == 1.0f? fast_forward : 1.0f;
+				break;
+			}
+
+			case emu_control::filter_t:
+			{
+				cycle_upscale_filter();
+				break;
+			}
+
+			case emu_control::colour_t:
+			{
+				toggle_colour_correction();
 				break;
 			}
 
 			case emu_control::none_t: break;
 		}
 
-		const auto end = std::chrono::steady_clock::now();
-		const s64 elapsed = std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
-		const s64 remain = ((1000'000'000 / 60) - elapsed);
+		// the core threw, hand it back out on this thread
+		if(emu_failed.load(std::memory_order_acquire))
+		{
+			stop_emu();
+			std::rethrow_exception(emu_error);
+		}
+
+		if(present_frame(show_metrics,present_fps))
+		{
+			presented++;
+		}
 
-		if(throttle && remain > 0)
+		// without vsync nothing holds this loop back, so just poll for the next frame
+		else if(pacing != frame_pacing::vsync)
 		{
-			SDL_DelayPrecise(remain);
+			SDL_Delay(1);
 		}
 
-		fps_counter.reading_end();
-		SDL_SetWindowTitle(window,fmt::format("albion: {:.2f}",fps_counter.get_fps()).c_str());
+		const auto now = std::chrono::steady_clock::now();
+		const s64 second_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - second_start).count();
 
+		if(second_ns >= 1000'000'000)
+		{
+			present_fps = f32((f64(presented) * 1e9) / second_ns);
+			presented = 0;
+			second_start = now;
 
-		// we hit a breakpoint go back to the prompt
-		handle_debug();
+			SDL_SetWindowTitle(window,fmt::format("albion: {:.2f}",metrics.emu_fps.load(std::memory_order_relaxed)).c_str());
+		}
     }	
 }
+
+void SDLMainWindow::emu_main(b32 start_debug)
+{
+	try
+	{
+		if(start_debug)
+		{
+			debug_halt();
+		}
+
+		FpsCounter fps_counter;
+		b32 throttle = true;
+		f32 speed = 1.0;
+
+		while(!emu_quit.load(std::memory_order_acquire))
+		{
+			const auto start = std::chrono::steady_clock::now();
+			fps_counter.reading_start();
+
+			metrics.input_depth.store(input_queue.size(),std::memory_order_relaxed);
+
+			InputEvent event;
+
+			while(input_queue.pop(event))
+			{
+				core_input.add_event(event);
+			}
+
+			core_input.left = unpack_joystick(stick.load(std::memory_order_relaxed));
+			pass_input_to_core();
+
+			const b32 want_throttle = throttle_request;
+
+			if(want_throttle != throttle)
+			{
+				throttle = want_throttle;
+
+				if(throttle)
+				{
+					core_throttle();
+				}
+
+				else
+				{
+					core_unbound();
+				}
+			}
+
+			const f32 want_speed = speed_request;
+
+			if(want_speed != speed)
+			{
+				speed = want_speed;
+				playback.set_speed(speed);
+			}
+
+			if(break_request.exchange(false))
+			{
+				debug_halt();
+			}
+
+			const b32 frame_paused = paused;
+			run_frame(frame_paused);
+
+			const s64 elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			metrics.emu_frame_ms.store(f32(elapsed) / 1000'000.0f,std::memory_order_relaxed);
+
+			// nothing goes into the queue while paused, so there is nothing to correct for
+			if(throttle && !frame_paused)
+			{
+				playback.update_rate();
+			}
+
+			pace_frame(throttle,speed,frame_paused);
+
+			fps_counter.reading_end();
+			metrics.emu_fps.store(fps_counter.get_fps(),std::memory_order_relaxed);
+
+			// we hit a breakpoint go back to the prompt
+			handle_debug();
+		}
+	}
+
+	catch(...)
+	{
+		emu_error = std::current_exception();
+		emu_failed.store(true,std::memory_order_release);
+	}
+}
+
+void SDLMainWindow::pace_frame(b32 throttle, f32 speed, b32 frame_paused)
+{
+	// any further behind than this and the clock starts again, rather than running a burst of frames to catch up
+	static constexpr auto MAX_FRAME_LAG = std::chrono::milliseconds(100);
+
+	const auto now = std::chrono::steady_clock::now();
+
+	// the queue is close to running dry, at the start or after a stall
+	// so run on and fill it back up, the rate correction is far too slow to
+	if(!throttle || (!frame_paused && playback.needs_fill()))
+	{
+		frame_deadline = now;
+		return;
+	}
+
+	if(pacing == frame_pacing::vsync)
+	{
+		presents.wait(paced_presents,std::memory_order_acquire);
+		paced_presents = presents.load(std::memory_order_acquire);
+		return;
+	}
+
+	// sleep once a frame until it is due on the emulated clock
+	frame_deadline += std::chrono::nanoseconds(s64(1e9 / (frame_rate * speed)));
+
+	if(now - frame_deadline > MAX_FRAME_LAG)
+	{
+		frame_deadline = now;
+	}
+
+	else if(frame_deadline > now)
+	{
+		SDL_DelayPrecise(std::chrono::duration_cast<std::chrono::nanoseconds>(frame_deadline - now).count());
+	}
+}
+
+void SDLMainWindow::stop_emu()
+{
+	emu_quit = true;
+
+	// let a core waiting on the present go
+	presents.fetch_add(1,std::memory_order_release);
+	presents.notify_all();
+
+	if(emu_thread.joinable())
+	{
+		emu_thread.join();
+	}
+}
@@ -1,6 +1,11 @@
 #pragma once
 #include <frontend/input.h>
 #include <frontend/playback.h>
+#include <albion/triple_buffer.h>
+#include <albion/spsc_queue.h>
+#include <albion/frame_sink.h>
+#include <albion/upscale.h>
+#include <thread>
 
 #define SDL_MAIN_HANDLED
 #ifdef _WIN32
@@ -10,13 +15,58 @@
 #endif
 
 
-class SDLMainWindow
+// how the emulation thread is held to real time
+enum class frame_pacing
+{
+    // held to the emulated clock, with the audio rate corrected to match
+    audio,
+
+    // no faster than the display presents
+    vsync,
+
+    // as fast as it will go, with no audio
+    free_run,
+};
+
+// a screen handed over from the emulation thread, the pixels are swapped in from the core
+struct Frame
+{
+    std::vector<u32> pixels;
+    u32 x = 0;
+    u32 y = 0;
+};
+
+// written by the emulation thread, drawn over the screen by the presentation thread
+struct FrameMetrics
+{
+    std::atomic<f32> emu_fps = 0.0;
+    std::atomic<f32> emu_frame_ms = 0.0;
+
+    // input events waiting when the core went to take them
+    std::atomic<u32> input_depth = 0;
+
+    // frames replaced before they were ever presented
+    std::atomic<u32> frames_skipped = 0;
+};
+
+// the core runs on its own thread, so a slow present never stalls emulation or the other way round
+// frames go out through a triple buffer, input comes back through a queue
+// and audio goes straight into the sdl stream from the core
+// the triple buffer slots are also the pool the cores render into, so a screen is only copied on upload
+class SDLMainWindow : public FrameSink
 {
 public:
     ~SDLMainWindow();
     void main(std::string filename, b32 start_debug);
+    void set_pacing(frame_pacing mode);
+    void set_fast_forward(f32 multiplier);
+
+    // emulation thread, or whichever thread is running the core that frame
+    void submit_frame(std::vector<u32>& screen, u32 x, u32 y) override;
 
 protected:
+    // init and core_quit are called on the presentation thread with the core stopped
+    // everything else is called on the emulation thread
     // This should setup the playback with an appropiate buffer
     virtual void init(const std::string& filename,Playback& playback) = 0;
     virtual void pass_input_to_core() = 0;
@@ -29,10 +79,11 @@ protected:
 
 
     void init_sdl(u32 x, u32 y);
-    void create_texture(u32 x, u32 y); 
-    void render(const u32* data);
 
-    // sdl gfx
+    // what a core looks best with, it can be changed at runtime from there
+    void set_upscale(upscale_filter filter, colour_correction correction);
+
+    // sdl gfx, presentation thread only
 	SDL_Window * window = NULL;
 	SDL_Renderer * renderer = NULL;
 	SDL_Texture * texture = NULL;
@@ -42,7 +93,67 @@ protected:
     Input input;
     Playback playback;
 
+    // emulation thread only, holds what the presentation thread polled
+    Controller core_input;
+
     b32 throttle_emu;       
+
+    // emulated frames a second, most cores run a frame off a sixtieth of their clock
+    f64 frame_rate = 60.0;
+
+private:
+    void create_texture(u32 x, u32 y);
+    b32 present_frame(b32 show_metrics, f32 present_fps);
+    void cycle_upscale_filter();
+    void toggle_colour_correction();
+
+    void emu_main(b32 start_debug);
+    void pace_frame(b32 throttle, f32 speed, b32 frame_paused);
+    void stop_emu();
+
+    static constexpr u32 INPUT_QUEUE_SIZE = 256;
+
+    frame_pacing pacing = frame_pacing::audio;
+
+    // how much faster the emulated clock runs while fast forwarding
+    f32 fast_forward = 2.0;
+
+    // emulation thread only, when the next frame is due on the emulated clock
+    std::chrono::steady_clock::time_point frame_deadline;
+
+    std::thread emu_thread;
+    std::exception_ptr emu_error;
+
+    TripleBuffer<Frame> frames;
+
+    // bumped on every present, with vsync the core runs one frame per present
+    // a core does not submit a screen that has not changed, so this cannot go by frames taken
+    std::atomic<u32> presents = 0;
+    u32 paced_presents = 0;
+
+    SpscQueue<InputEvent,INPUT_QUEUE_SIZE> input_queue;
+
+    // the stick goes over as one word, so the core never sees half an update
+    std::atomic<u64> stick = 0;
+
+    std::atomic<b32> emu_quit = false;
+    std::atomic<b32> emu_failed = false;
+    std::atomic<b32> throttle_request = true;
+    std::atomic<f32> speed_request = 1.0;
+    std::atomic<b32> break_request = false;
+    std::atomic<b32> paused = false;
+
+    FrameMetrics metrics;
+
+    // presentation thread only
+    // the front frame is filtered again when the filter changes, as a core may not send another for a while
+    Upscaler upscaler;
+    colour_correction core_correction = colour_correction::none;
+    b32 refilter = false;
+    f32 upscale_ms = 0.0;
+
+    u32 texture_x = 0;
+    u32 texture_y = 0;
 };
 
 
@@ -50,6 +161,19 @@ protected:
 struct Config
 {
     b32 start_debug = false;
+
+    // gb only for now
+    u32 run_ahead_frames = 0;
+    b32 run_ahead_second_instance = false;
+
+    // n64 only
+    b32 rsp_thread = false;
+    b32 interpreter = false;
+
+    frame_pacing pacing = frame_pacing::audio;
+
+    // each x doubles it
+    f32 fast_forward = 2.0;
 };
 
 inline Config get_config(int argc, char* argv[])
@@ -66,6 +190,13 @@ inline Config get_config(int argc, char* argv[])
             switch(c)
             {
                 case 'd': cfg.start_debug = true; break;
+                case 'r': cfg.run_ahead_frames++; break;
+                case 's': cfg.run_ahead_second_instance = true; break;
+                case 't': cfg.rsp_thread = true; break;
+                case 'i': cfg.interpreter = true; break;
+                case 'v': cfg.pacing = frame_pacing::vsync; break;
+                case 'f': cfg.pacing = frame_pacing::free_run; break;
+                case 'x': cfg.fast_forward *= 2.0; break;
                 case '-': break;
                 default: printf("warning unknown flag: %c\n",c);
             }
@@ -19,54 +19,30 @@ struct Apu
 
 	void push_samples(u32 cycles) noexcept;
 
+	// hand a finished block from the mixer to the audio buffer
+	void flush_mixer() noexcept;
+
 	void init(gameboy_psg::psg_mode mode, bool use_bios) noexcept;
 
-	void tick(u32 cycles) noexcept;
+	// catch the psg channels up to the scheduler
+	// must be called before the psg is observed or modified
+	void sync_psg() noexcept;
 
 	void disable_sound() noexcept;
 	void enable_sound() noexcept;
 
-	void save_state(std::ofstream &fp);
-	dtr_res load_state(std::ifstream &fp);
-
-	void insert_chan1_period_event()
-	{
-		insert_period_event(psg.channels[0].period,gameboy_event::c1_period_elapse);
-	}
-
-	void insert_chan2_period_event()
-	{
-		insert_period_event(psg.channels[1].period,gameboy_event::c2_period_elapse);
-	}
-
-	void insert_chan3_period_event()
-	{
-		insert_period_event(psg.channels[2].period,gameboy_event::c3_period_elapse);
-	}
-
-	void insert_chan4_period_event()
-	{
-		insert_period_event(psg.channels[3].period,gameboy_event::c4_period_elapse);
-	}
+	void save_state(StateWriter& writer) const;
+	dtr_res load_state(StateReader& reader);
 
 	gameboy_psg::Psg psg;
+	gameboy_psg::Mixer mixer;
+	gameboy_psg::MixerConfig mixer_config;
 	AudioBuffer audio_buffer;
 
-	bool is_cgb;
-
-	void insert_period_event(int period, gameboy_event chan) noexcept
-	{
-		// create  a new event as the period has changed
-		// need to half the ammount if we are in double speed
-		const auto event = scheduler.create_event(period << scheduler.is_double(),chan);
+	// run ahead: keep the sample timing but dont output anything
+	bool suppress_frame = false;
 
-		// dont tick off the old event as 
-		// it will use the new value as we have just overwritten 
-		// the old internal counter
-		// this is not an event we are dropping and expecting to start later 
-
-		scheduler.insert(event,false);
-	}
+	bool is_cgb;
 
 	GameboyScheduler &scheduler;
 
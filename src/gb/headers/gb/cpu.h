@@ -148,8 +148,8 @@ struct Cpu final
     bool read_flag_c() const noexcept { return carry;}
 
     // save states
-    void save_state(std::ofstream &fp);
-    dtr_res load_state(std::ifstream &fp);
+    void save_state(StateWriter& writer) const;
+    dtr_res load_state(StateReader& reader);
 
     Memory &mem;
     Apu &apu;
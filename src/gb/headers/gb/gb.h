@@ -30,6 +30,10 @@ struct GB
     void reset(std::string rom_name, bool with_rom=true, bool use_bios = false);
     void run();
 
+    // run a frame with its video and or audio output hidden
+    // frames without audio are speculative (run ahead) and will be rolled back
+    void run_suppressed(bool video, bool audio);
+
 
     void handle_input(Controller& controller);
     void key_input(button b, b32 down);
@@ -39,6 +43,16 @@ struct GB
     void save_state(std::string filename);
     void load_state(std::string filename);
 
+    // in memory save states into a caller owned buffer
+    // these do not allocate so they are cheap enough to use every frame
+    size_t save_state_size() const;
+    size_t save_state(u8* buf, size_t size) const;
+    dtr_res load_state(const u8* buf, size_t size);
+    void write_state(StateWriter& writer) const;
+
+    // bump this whenever the layout of any component state changes
+    static constexpr u32 SAVE_STATE_VERSION = 3;
+
     void change_breakpoint_enable(bool enabled);
 
     // NOTE: see n64 core for better example of how to structure this
@@ -85,8 +85,8 @@ struct Memory final
 
     // public underlying memory for direct access
     // required for handling io and vram
-    std::vector<u8> io; // 0x100
-    std::vector<std::vector<u8>> vram; // 0x4000
+    std::array<u8,0x100> io;
+    std::array<std::array<u8,0x2000>,2> vram;
     std::vector<u8> oam; // 0xa0
     std::array<u8*,16> page_table;
 
@@ -106,8 +106,11 @@ struct Memory final
     void load_cart_ram();
 
     // save states
-    void save_state(std::ofstream &fp);
-    dtr_res load_state(std::ifstream &fp);
+    void save_state(StateWriter& writer) const;
+    dtr_res load_state(StateReader& reader);
+
+    // restore the memory ptrs after a state load
+    void rebuild_mem_table() noexcept;
 
     template<bool DEBUG_ENABLE>
     void do_hdma() noexcept;
@@ -222,8 +225,8 @@ struct Memory final
 
 	// underlying memory
     std::vector<u8> bios;
-    std::vector<u8> wram; // 0x1000
-    std::vector<std::vector<u8>> cgb_wram_bank; // 0x7000 
+    std::array<u8,0x1000> wram;
+    std::array<std::array<u8,0x1000>,7> cgb_wram_bank;
     std::vector<u8> rom; // variable
     std::vector<std::vector<u8>> cart_ram_banks;
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "forward_def.h"
 #include <albion/lib.h>
+#include <albion/frame_sink.h>
 #include <gb/scheduler.h>
 
 namespace gameboy
@@ -38,6 +39,9 @@ struct Ppu
     std::vector<u32> rendered; 
     std::vector<u32> screen; // 160 by 144
 
+    // finished frames go here as well when set, which takes rendered off us
+    FrameSink* frame_sink = nullptr;
+
     // inform ppu that registers that can affect
     // pixel transfer have been written
     void ppu_write() noexcept;
@@ -46,6 +50,9 @@ struct Ppu
 
     bool new_vblank = false;
 
+    // run ahead: render nothing and dont swap out the presented frame
+    bool suppress_frame = false;
+
     void update_graphics(u32 cycles) noexcept;
 
     unsigned int get_current_line() const noexcept
@@ -79,8 +86,8 @@ struct Ppu
 
 
     // save states
-    void save_state(std::ofstream &fp);
-    dtr_res load_state(std::ifstream &fp);
+    void save_state(StateWriter& writer) const;
+    dtr_res load_state(StateReader& reader);
 
 
     // display viewer
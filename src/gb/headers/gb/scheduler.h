@@ -11,10 +11,6 @@ namespace gameboy
 enum class gameboy_event
 {
     oam_dma_end,
-    c1_period_elapse,
-    c2_period_elapse,
-    c3_period_elapse,
-    c4_period_elapse,
     sample_push,
     internal_timer,
     timer_reload,
@@ -23,9 +19,9 @@ enum class gameboy_event
     cycle_frame,
 };
 
-constexpr size_t EVENT_SIZE = 11;
+constexpr size_t EVENT_SIZE = 7;
 
-struct GameboyScheduler final : public Scheduler<EVENT_SIZE,gameboy_event>
+struct GameboyScheduler final : public Scheduler<EVENT_SIZE,gameboy_event,GameboyScheduler>
 {
     GameboyScheduler(GB &gb);
 
@@ -38,7 +34,8 @@ struct GameboyScheduler final : public Scheduler<EVENT_SIZE,gameboy_event>
     Memory &mem;
 
 protected:
-    void service_event(const EventNode<gameboy_event> & node) override;
+    friend Scheduler;
+    void service_event(const EventNode<gameboy_event> & node);
 };
 
 }
\ No newline at end of file
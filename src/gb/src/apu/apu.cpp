@@ -14,6 +14,7 @@ void Apu::init(gameboy_psg::psg_mode mode, bool use_bios) noexcept
 {
     reset_audio_buffer(audio_buffer);
     psg.init(mode,use_bios);
+    mixer.init(mode,1.0f / 16.0f,AUDIO_BUFFER_SAMPLE_RATE,mixer_config);
 
 	enable_sound();
 
@@ -22,39 +23,22 @@ void Apu::init(gameboy_psg::psg_mode mode, bool use_bios) noexcept
     insert_new_sample_event(); 
 }
 
-void Apu::tick(u32 cycles) noexcept
+void Apu::sync_psg() noexcept
 {
-    if(!psg.sound_enabled)
-    {
-        return;
-    }
-
-    psg.tick_periods(cycles);
-
-    push_samples(cycles);
+    // psg runs at the same speed regardless of double speed
+    psg.sync(scheduler.get_timestamp(),scheduler.is_double());
 }
 
 void Apu::disable_sound() noexcept
 {
+    sync_psg();
     psg.disable_sound();
-
-    // remove all our events for the apu until we renable it
-    scheduler.remove(gameboy_event::c1_period_elapse,false);
-    scheduler.remove(gameboy_event::c2_period_elapse,false);
-    scheduler.remove(gameboy_event::c3_period_elapse,false);
-    scheduler.remove(gameboy_event::c4_period_elapse,false);
-
 }
 
 void Apu::enable_sound() noexcept
 {
+    sync_psg();
     psg.enable_sound();
-
-    // renable our events in the scheduler
-    insert_chan1_period_event();
-    insert_chan2_period_event();
-    insert_chan3_period_event();
-    insert_chan4_period_event();
 }
 
 void Apu::insert_new_sample_event() noexcept
@@ -73,21 +57,28 @@ void Apu::push_samples(u32 cycles) noexcept
 		down_sample_cnt += DOWN_SAMPLE_LIMIT;
         insert_new_sample_event();
 
-        f32 output[4];
-        for(int i = 0; i < 4; i++)
+        sync_psg();
+
+        // hidden frames must not be heard
+        if(suppress_frame)
         {
-            output[i] = f32(psg.channels[i].output) / 16.0f;
+            return;
         }
 
+        if(mixer.push(psg))
+        {
+            flush_mixer();
+        }
+    }
+}
 
-		const auto sound_select = psg.read_nr51();
-        const auto nr50 = psg.read_nr50();
-
-        const f32 left = gameboy_psg::mix_psg_channels(output,(nr50 >> 4) & 7,(sound_select >> 4) & 0xf,true);
-        const f32 right = gameboy_psg::mix_psg_channels(output,nr50 & 7,sound_select & 0xf,true);
+void Apu::flush_mixer() noexcept
+{
+    const u32 samples = mixer.mix();
 
-        // push our samples!
-        push_sample(audio_buffer,left,right);
+    for(u32 i = 0; i < samples; i++)
+    {
+        push_sample(audio_buffer,mixer.output[i * 2],mixer.output[(i * 2) + 1]);
     }
 }
 
@@ -12,19 +12,19 @@ namespace gameboy_psg
 namespace gameboy
 {
 
-dtr_res Apu::load_state(std::ifstream &fp)
+dtr_res Apu::load_state(StateReader& reader)
 {
-	dtr_res err = file_read_var(fp,down_sample_cnt);
-	err |= psg.load_state(fp);
+	dtr_res err = state_read_var(reader,down_sample_cnt);
+	err |= psg.load_state(reader);
 
 	return err;
 }
 
 
-void Apu::save_state(std::ofstream &fp)
+void Apu::save_state(StateWriter& writer) const
 {
-	file_write_var(fp,down_sample_cnt);
-	psg.save_state(fp);
+	state_write_var(writer,down_sample_cnt);
+	psg.save_state(writer);
 }
 
 }
\ No newline at end of file
@@ -167,22 +167,19 @@ void Cpu::switch_double_speed() noexcept
 	
 	scheduler.service_events();
 
-	const bool c1_active = scheduler.is_active(gameboy_event::c1_period_elapse);
-	const bool c2_active = scheduler.is_active(gameboy_event::c2_period_elapse);
-	const bool c3_active = scheduler.is_active(gameboy_event::c3_period_elapse);
-	const bool c4_active = scheduler.is_active(gameboy_event::c4_period_elapse);
 	const bool sample_push_active = scheduler.is_active(gameboy_event::sample_push);
 	const bool internal_timer_active = scheduler.is_active(gameboy_event::internal_timer);
 	const bool ppu_active = scheduler.is_active(gameboy_event::ppu);
 
-	static constexpr std::array<gameboy_event,7> double_speed_events = 
+	static constexpr std::array<gameboy_event,3> double_speed_events = 
 	{
 		gameboy_event::sample_push,gameboy_event::internal_timer,
-		gameboy_event::c1_period_elapse,gameboy_event::c2_period_elapse,
-		gameboy_event::c3_period_elapse,gameboy_event::c4_period_elapse,
 		gameboy_event::ppu
 	};
 
+	// psg is lazily caught up so bring it in line before the clock changes
+	apu.sync_psg();
+
 	// remove all double speed events so they can be ticked off
 	for(const auto &e: double_speed_events)
 	{
@@ -192,26 +189,6 @@ void Cpu::switch_double_speed() noexcept
 	is_double = !is_double;
 
 
-	if(c1_active)
-	{
-		apu.insert_chan1_period_event();
-	}
-
-	if(c2_active)
-	{
-		apu.insert_chan2_period_event();
-	}
-
-	if(c3_active)
-	{
-		apu.insert_chan3_period_event();
-	}
-
-	if(c4_active)
-	{
-		apu.insert_chan4_period_event();
-	}
-
 	if(sample_push_active)
 	{
 		apu.insert_new_sample_event();
@@ -362,6 +339,7 @@ void Cpu::update_timers(u32 cycles) noexcept
 		// for the timer when its off
 		if(is_set(internal_timer,sound_bit) != sound_bit_old)
 		{
+			apu.sync_psg();
 			apu.psg.advance_sequencer(); // advance the sequencer
 		}
 	}
@@ -375,6 +353,7 @@ void Cpu::update_timers(u32 cycles) noexcept
 		internal_timer += cycles;
 		if(is_set(internal_timer,sound_bit) != sound_bit_old)
 		{
+			apu.sync_psg();
 			apu.psg.advance_sequencer(); // advance the sequencer
 		}
 	}
@@ -3,60 +3,62 @@
 namespace gameboy
 {
 
-void Cpu::save_state(std::ofstream &fp)
+void Cpu::save_state(StateWriter& writer) const
 {
-    file_write_var(fp,internal_timer);
-    file_write_var(fp,joypad_state);
-    file_write_var(fp,a);
-    file_write_var(fp,carry);
-    file_write_var(fp,half);
-    file_write_var(fp,negative);
-    file_write_var(fp,zero);
-    file_write_var(fp,bc);
-    file_write_var(fp,de);
-    file_write_var(fp,hl);
-    file_write_var(fp,sp);
-    file_write_var(fp,pc);
-    file_write_var(fp,instr_side_effect);
-    file_write_var(fp,interrupt_enable);
-    file_write_var(fp,is_cgb);
-    file_write_var(fp,is_double);
-    file_write_var(fp,serial_cyc);
-    file_write_var(fp,serial_cnt);
-    file_write_var(fp,interrupt_req);
-    file_write_var(fp,interrupt_fire);
-    file_write_var(fp,is_sgb);
+    state_write_var(writer,internal_timer);
+    state_write_var(writer,joypad_state);
+    state_write_var(writer,a);
+    state_write_var(writer,carry);
+    state_write_var(writer,half);
+    state_write_var(writer,negative);
+    state_write_var(writer,zero);
+    state_write_var(writer,bc);
+    state_write_var(writer,de);
+    state_write_var(writer,hl);
+    state_write_var(writer,sp);
+    state_write_var(writer,pc);
+    state_write_var(writer,instr_side_effect);
+    state_write_var(writer,interrupt_enable);
+    state_write_var(writer,is_cgb);
+    state_write_var(writer,is_double);
+    state_write_var(writer,serial_cyc);
+    state_write_var(writer,serial_cnt);
+    state_write_var(writer,interrupt_req);
+    state_write_var(writer,interrupt_fire);
+    state_write_var(writer,is_sgb);
+    state_write_var(writer,halt_bug);
 }
 
 
-dtr_res Cpu::load_state(std::ifstream &fp)
+dtr_res Cpu::load_state(StateReader& reader)
 {
-    dtr_res err = file_read_var(fp,internal_timer);
-    err |= file_read_var(fp,joypad_state);
-    err |= file_read_var(fp,a);
-    err |= file_read_var(fp,carry);
-    err |= file_read_var(fp,half);
-    err |= file_read_var(fp,negative);
-    err |= file_read_var(fp,zero);
-    err |= file_read_var(fp,bc);
-    err |= file_read_var(fp,de);
-    err |= file_read_var(fp,hl);
-    err |= file_read_var(fp,sp);
-    err |= file_read_var(fp,pc);
-    err |= file_read_var(fp,instr_side_effect);
+    dtr_res err = state_read_var(reader,internal_timer);
+    err |= state_read_var(reader,joypad_state);
+    err |= state_read_var(reader,a);
+    err |= state_read_var(reader,carry);
+    err |= state_read_var(reader,half);
+    err |= state_read_var(reader,negative);
+    err |= state_read_var(reader,zero);
+    err |= state_read_var(reader,bc);
+    err |= state_read_var(reader,de);
+    err |= state_read_var(reader,hl);
+    err |= state_read_var(reader,sp);
+    err |= state_read_var(reader,pc);
+    err |= state_read_var(reader,instr_side_effect);
     if(instr_side_effect > instr_state::di)
     {
         spdlog::error("load_state invalid instr state");
         return dtr_res::err;
     }
-    err |= file_read_var(fp,interrupt_enable);
-    err |= file_read_var(fp,is_cgb);
-    err |= file_read_var(fp,is_double);
-    err |= file_read_var(fp,serial_cyc);
-    err |= file_read_var(fp,serial_cnt);
-    err |= file_read_var(fp,interrupt_req);
-    err |= file_read_var(fp,interrupt_fire);
-    err |= file_read_var(fp,is_sgb);
+    err |= state_read_var(reader,interrupt_enable);
+    err |= state_read_var(reader,is_cgb);
+    err |= state_read_var(reader,is_double);
+    err |= state_read_var(reader,serial_cyc);
+    err |= state_read_var(reader,serial_cnt);
+    err |= state_read_var(reader,interrupt_req);
+    err |= state_read_var(reader,interrupt_fire);
+    err |= state_read_var(reader,is_sgb);
+    err |= state_read_var(reader,halt_bug);
     
     return err;
 }
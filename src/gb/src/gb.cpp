@@ -40,25 +40,85 @@ void GB::change_breakpoint_enable(bool enabled)
 	mem.change_breakpoint_enable(enabled);
 }
 
+void GB::write_state(StateWriter& writer) const
+{
+	state_write_header(writer,SAVE_STATE_VERSION);
+
+	cpu.save_state(writer);
+	mem.save_state(writer);
+	ppu.save_state(writer);
+	apu.save_state(writer);
+	scheduler.save_state(writer);
+
+	state_finish_header(writer);
+}
+
+size_t GB::save_state_size() const
+{
+	auto sizer = make_state_sizer();
+	write_state(sizer);
+
+	return sizer.offset;
+}
+
+// returns the amount of bytes written, zero if the buffer was too small
+size_t GB::save_state(u8* buf, size_t size) const
+{
+	auto writer = make_state_writer(buf,size);
+	write_state(writer);
+
+	if(!state_writer_valid(writer))
+	{
+		return 0;
+	}
+
+	return writer.offset;
+}
+
+dtr_res GB::load_state(const u8* buf, size_t size)
+{
+	auto reader = make_state_reader(buf,size);
+
+	dtr_res err = state_read_header(reader,SAVE_STATE_VERSION);
+
+	if(err == dtr_res::err)
+	{
+		return err;
+	}
+
+	err |= cpu.load_state(reader);
+	err |= mem.load_state(reader);
+	err |= ppu.load_state(reader);
+	err |= apu.load_state(reader);
+	err |= scheduler.load_state(reader);
+
+	if(err == dtr_res::err)
+	{
+		return err;
+	}
+
+	// memory pointers depend on banking, ppu and dma state
+	mem.rebuild_mem_table();
+
+	return dtr_res::ok;
+}
+
 // need to do alot more integrity checking on data in these :)
 void GB::save_state(std::string filename)
 {
 	std::cout << "save state: " << filename << "\n";
 
+	std::vector<u8> buf(save_state_size());
+	save_state(buf.data(),buf.size());
 
 	std::ofstream fp(filename,std::ios::binary);
 	if(!fp)
 	{
 		cpu.panic("Could not save state to file");
+		return;
 	}
 
-
-	cpu.save_state(fp);
-	mem.save_state(fp);
-	ppu.save_state(fp);
-	apu.save_state(fp);
-	scheduler.save_state(fp);
-
+	fp.write(reinterpret_cast<const char*>(buf.data()),buf.size());
 	fp.close();
 }
 
@@ -67,24 +127,15 @@ void GB::load_state(std::string filename)
 {
 	std::cout << "load state: " << filename << "\n";
 
-	dtr_res err = dtr_res::ok;
+	std::vector<u8> buf;
 
-	std::ifstream fp(filename,std::ios::binary);
-	if(!fp)
+	if(!read_bin(filename,buf))
 	{
 		cpu.panic("could not open save state file");
 		return;
 	}
 
-	err |= cpu.load_state(fp);
-	err |= mem.load_state(fp);
-	err |= ppu.load_state(fp);
-	err |= apu.load_state(fp);
-	err |= scheduler.load_state(fp);
-
-	fp.close();
-
-	if(!err)
+	if(load_state(buf.data(),buf.size()) == dtr_res::err)
 	{
 		cpu.panic("Could not load state");
 	}
@@ -213,4 +264,23 @@ void GB::run()
 	}
 }
 
+void GB::run_suppressed(bool video, bool audio)
+{
+	ppu.suppress_frame = !video;
+	apu.suppress_frame = !audio;
+
+	// dont let a speculative frame flush cart ram to disk
+	const bool throttle = throttle_emu;
+	if(!audio)
+	{
+		throttle_emu = false;
+	}
+
+	run();
+
+	throttle_emu = throttle;
+	ppu.suppress_frame = false;
+	apu.suppress_frame = false;
+}
+
 }
\ No newline at end of file
@@ -80,25 +80,18 @@ bool Memory::rom_sgb_enabled() const noexcept
 Memory::Memory(GB &gb) : cpu(gb.cpu), ppu(gb.ppu), 
 	apu(gb.apu), scheduler(gb.scheduler), debug(gb.debug)
 {
-	// reserve our underlying memory
-    cgb_wram_bank.resize(7);
+	// underlying memory is fixed size, just clear it
     for(auto &x: cgb_wram_bank)
     {
-        x.resize(0x1000);
 		std::fill(x.begin(),x.end(),0);
     }
 
-    wram.resize(0x1000);
 	std::fill(wram.begin(),wram.end(),0); 
-    oam.resize(0xa0);
-	std::fill(oam.begin(),oam.end(),0);
-    io.resize(0x100);
+	oam.resize(0xa0);
 	std::fill(io.begin(),io.end(),0);
 
-    vram.resize(0x2);
     for(auto &x: vram)
     {
-        x.resize(0x2000); 
 		std::fill(x.begin(),x.end(),0);
     }
 	rom.resize(0x8000);
@@ -294,7 +287,6 @@ void Memory::init(std::string rom_name, bool with_rom, bool use_bios)
 	}
 
     // init memory
-    vram.resize(0x2);
     for(auto &x: vram)
     {
 		std::fill(x.begin(),x.end(),0);
@@ -933,6 +925,8 @@ u8 Memory::read_io(u16 addr) const noexcept
 		case 0x38: case 0x39: case 0x3a: case 0x3b:
 		case 0x3c: case 0x3d: case 0x3e: case 0x3f:
 		{
+			// wave ram access depends on the current wave position
+			apu.sync_psg();
 			return apu.psg.read_wave_table(addr-0xff30);
 		}
 
@@ -1368,6 +1362,12 @@ void Memory::write_cart_ram_mbc2(u16 addr, u8 v) noexcept
 template<bool DEBUG_ENABLE>
 void Memory::write_io(u16 addr,u8 v) noexcept
 {
+	// psg channels are lazily caught up, bring them up to date before any sound reg changes
+	if((addr & 0xff) >= IO_NR10 && (addr & 0xff) <= 0x3f)
+	{
+		apu.sync_psg();
+	}
+
     switch(addr & 0xff)
     {
 
@@ -1994,11 +1994,6 @@ void Memory::write_io(u16 addr,u8 v) noexcept
 		case IO_NR14:
 		{
 			apu.psg.write_nr14(v);
-			// trigger causes freq reload update the scheduler
-			if(is_set(v,7))
-			{
-				apu.insert_chan1_period_event();
-			}
 			break;
 		}
 
@@ -2023,11 +2018,6 @@ void Memory::write_io(u16 addr,u8 v) noexcept
 		case IO_NR24:
 		{
 			apu.psg.write_nr24(v);
-			// trigger causes freq reload update the scheduler
-			if(is_set(v,7))
-			{
-				apu.insert_chan2_period_event();
-			}
 			break;
 		}
 
@@ -2060,11 +2050,6 @@ void Memory::write_io(u16 addr,u8 v) noexcept
 		case IO_NR34:
 		{
 			apu.psg.write_nr34(v);
-			// trigger causes freq reload update the scheduler
-			if(is_set(v,7))
-			{
-				apu.insert_chan3_period_event();
-			}
 			break;
 		}
 
@@ -2083,13 +2068,6 @@ void Memory::write_io(u16 addr,u8 v) noexcept
 		case IO_NR43:
 		{
 			apu.psg.write_nr43(v);
-
-			// incase we havent done any events due the scheduler being off reinsert noise
-			if(!scheduler.is_active(gameboy_event::c4_period_elapse))
-			{
-				noise_reload_period(apu.psg.channels[3],apu.psg.noise);
-				apu.insert_chan4_period_event();
-			}
 			break;
 		}
 
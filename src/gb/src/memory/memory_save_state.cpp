@@ -1,117 +1,115 @@
 #include <gb/memory.h>
+#include <gb/ppu.h>
 
 namespace gameboy
 {
 
-// TODO rebuild memory table on save state
-
 // save states
-void Memory::save_state(std::ofstream &fp)
+void Memory::save_state(StateWriter& writer) const
 {
-    file_write_var(fp,hdma_len);
-    file_write_var(fp,hdma_len_ticked);
-    file_write_var(fp,dma_src);
-    file_write_var(fp,dma_dst);
-    file_write_var(fp,hdma_active);
-
-    file_write_var(fp,enable_ram);
-    file_write_var(fp,cart_ram_bank);
-    file_write_var(fp,cart_rom_bank);
-    file_write_var(fp,rom_banking);
-
-    file_write_vec(fp,io);
-
-    for(auto &x: vram)
-    {
-        file_write_vec(fp,x);
-    }
-
-    file_write_vec(fp,oam);
-    file_write_vec(fp,wram);
-
-
-    for(auto &x: cgb_wram_bank)
-    {
-        file_write_vec(fp,x);
-    }
-
+    state_write_var(writer,hdma_len);
+    state_write_var(writer,hdma_len_ticked);
+    state_write_var(writer,dma_src);
+    state_write_var(writer,dma_dst);
+    state_write_var(writer,hdma_active);
+
+    state_write_var(writer,enable_ram);
+    state_write_var(writer,cart_ram_bank);
+    state_write_var(writer,cart_rom_bank);
+    state_write_var(writer,rom_banking);
+    state_write_var(writer,mbc1_bank2);
+
+    // fixed size banks are stored inline so these are single copies
+    state_write_var(writer,io);
+    state_write_var(writer,vram);
+    state_write_vec(writer,oam);
+    state_write_var(writer,wram);
+    state_write_var(writer,cgb_wram_bank);
 
     for(auto &x: cart_ram_banks)
     {
-        file_write_vec(fp,x);
+        state_write_vec(writer,x);
     }
 
-    file_write_var(fp,oam_dma_active);
-    file_write_var(fp,oam_dma_address);
-    file_write_var(fp,oam_dma_index);
-    file_write_var(fp,cgb_wram_bank_idx);
-    file_write_var(fp,vram_bank);
-    file_write_var(fp,ignore_oam_bug);
+    state_write_var(writer,oam_dma_active);
+    state_write_var(writer,oam_dma_address);
+    state_write_var(writer,oam_dma_index);
+    state_write_var(writer,cgb_wram_bank_idx);
+    state_write_var(writer,vram_bank);
+    state_write_var(writer,ignore_oam_bug);
 
-    file_write_vec(fp,sgb_pal);
-    file_write_vec(fp,sgb_packet);
-    file_write_var(fp,sgb_transfer_active);
-    file_write_var(fp,packet_count);
-    file_write_var(fp,packet_len);
-    file_write_var(fp,bit_count);
+    state_write_vec(writer,sgb_pal);
+    state_write_vec(writer,sgb_packet);
+    state_write_var(writer,sgb_transfer_active);
+    state_write_var(writer,packet_count);
+    state_write_var(writer,packet_len);
+    state_write_var(writer,bit_count);
 
 	// dont dump the memory table as its unecessary and unsafe
 	// same goes for the rom and info struct
-
 }
 
-dtr_res Memory::load_state(std::ifstream &fp)
+dtr_res Memory::load_state(StateReader& reader)
 {
-    dtr_res err = file_read_var(fp,hdma_len);
-    err |= file_read_var(fp,hdma_len_ticked);
-    err |= file_read_var(fp,dma_src);
-    err |= file_read_var(fp,dma_dst);
-    err |= file_read_var(fp,hdma_active);
-
-    err |= file_read_var(fp,enable_ram);
-    err |= file_read_var(fp,cart_ram_bank);
-    err |= file_read_var(fp,cart_rom_bank);
-    err |= file_read_var(fp,rom_banking);
-
-    err |= file_read_vec(fp,io);
-
-    for(auto &x: vram)
+    dtr_res err = state_read_var(reader,hdma_len);
+    err |= state_read_var(reader,hdma_len_ticked);
+    err |= state_read_var(reader,dma_src);
+    err |= state_read_var(reader,dma_dst);
+    err |= state_read_var(reader,hdma_active);
+
+    err |= state_read_var(reader,enable_ram);
+    err |= state_read_var(reader,cart_ram_bank);
+    err |= state_read_var(reader,cart_rom_bank);
+    err |= state_read_var(reader,rom_banking);
+    err |= state_read_var(reader,mbc1_bank2);
+
+    err |= state_read_var(reader,io);
+    err |= state_read_var(reader,vram);
+    err |= state_read_vec(reader,oam);
+    err |= state_read_var(reader,wram);
+    err |= state_read_var(reader,cgb_wram_bank);
+
+    // NOTE: the bank count comes from the rom loaded, not the state
+    for(auto &x: cart_ram_banks)
     {
-        err |= file_read_vec(fp,x);
+        err |= state_read_vec(reader,x);
     }
 
-    err |= file_read_vec(fp,oam);
-    err |= file_read_vec(fp,wram);
+    err |= state_read_var(reader,oam_dma_active);
+    err |= state_read_var(reader,oam_dma_address);
+    err |= state_read_var(reader,oam_dma_index);
+    err |= state_read_var(reader,cgb_wram_bank_idx);
+    err |= state_read_var(reader,vram_bank);
+    err |= state_read_var(reader,ignore_oam_bug);
 
+    err |= state_read_vec(reader,sgb_pal);
+    err |= state_read_vec(reader,sgb_packet);
+    err |= state_read_var(reader,sgb_transfer_active);
+    err |= state_read_var(reader,packet_count);
+    err |= state_read_var(reader,packet_len);
+    err |= state_read_var(reader,bit_count);
 
-    for(auto &x: cgb_wram_bank)
+    if(vram_bank > 1)
     {
-        err |= file_read_vec(fp,x);
+        spdlog::error("invalid vram bank");
+        return dtr_res::err;
     }
 
-
-    for(auto &x: cart_ram_banks)
+    if(cgb_wram_bank_idx < 0 || cgb_wram_bank_idx >= int(cgb_wram_bank.size()))
     {
-        err |= file_read_vec(fp,x);
+        spdlog::error("invalid wram bank");
+        return dtr_res::err;
     }
 
-    err |= file_read_var(fp,oam_dma_active);
-    err |= file_read_var(fp,oam_dma_address);
-    err |= file_read_var(fp,oam_dma_index);
-    err |= file_read_var(fp,cgb_wram_bank_idx);
-    err |= file_read_var(fp,vram_bank);
-    err |= file_read_var(fp,ignore_oam_bug);
-
-    err |= file_read_vec(fp,sgb_pal);
-    err |= file_read_vec(fp,sgb_packet);
-    err |= file_read_var(fp,sgb_transfer_active);
-    err |= file_read_var(fp,packet_count);
-    err |= file_read_var(fp,packet_len);
-    err |= file_read_var(fp,bit_count);
+    if(cart_ram_bank != CART_RAM_BANK_INVALID && cart_ram_bank >= cart_ram_banks.size())
+    {
+        spdlog::error("invalid cart ram bank");
+        return dtr_res::err;
+    }
 
-    if(vram_bank > 1)
+    if(cart_rom_bank * 0x4000 >= rom.size())
     {
-        spdlog::error("invalid vram bank");
+        spdlog::error("invalid cart rom bank");
         return dtr_res::err;
     }
 
@@ -120,4 +118,23 @@ dtr_res Memory::load_state(std::ifstream &fp)
     return err;
 }
 
-}
\ No newline at end of file
+// NOTE: this relies on the ppu state allready being loaded
+void Memory::rebuild_mem_table() noexcept
+{
+    init_mem_table();
+    init_banking_table();
+
+    page_table[0xd] = &cgb_wram_bank[cgb_wram_bank_idx][0];
+
+    if(ppu.get_mode() == ppu_mode::pixel_transfer)
+    {
+        lock_vram();
+    }
+
+    if(oam_dma_active)
+    {
+        oam_dma_enable();
+    }
+}
+
+}
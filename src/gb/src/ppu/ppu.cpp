@@ -441,7 +441,17 @@ void Ppu::update_graphics(u32 cycles) noexcept
 					new_vblank = true;
 
 					// swap the drawing buffer
-					std::swap(screen,rendered);
+					// hidden run ahead frames keep the last presented one
+					// and so does a frozen sgb screen, as nothing was drawn
+					if(!suppress_frame && mask_en != mask_mode::freeze)
+					{
+						std::swap(screen,rendered);
+
+						if(frame_sink)
+						{
+							frame_sink->submit_frame(rendered,SCREEN_WIDTH,SCREEN_HEIGHT);
+						}
+					}
 
 					// edge case oam stat interrupt is triggered here if enabled
 					if(is_set(status,5) && !signal)
@@ -4,64 +4,64 @@ namespace gameboy
 {
 
 // save states
-void Ppu::save_state(std::ofstream &fp)
+void Ppu::save_state(StateWriter& writer) const
 {
-    file_write_vec(fp,screen);
-    file_write_var(fp,current_line);
-    file_write_var(fp,mode);
-    file_write_var(fp,new_vblank);
-    file_write_var(fp,signal);
-    file_write_var(fp,scanline_counter);
-    file_write_var(fp,x_cord);
-    file_write_var(fp,bg_fifo);
-    file_write_var(fp,obj_fifo);
-    file_write_var(fp,fetcher);
-    file_write_var(fp,objects);
-    file_write_var(fp,tile_cord);
-    file_write_var(fp,no_sprites);
-    file_write_var(fp,cur_sprite);
-    file_write_var(fp,scx_cnt);
-    file_write_arr(fp,bg_pal,sizeof(bg_pal));
-    file_write_arr(fp,sp_pal,sizeof(sp_pal));
-    file_write_var(fp,sp_pal_idx);
-    file_write_var(fp,bg_pal_idx);
-    file_write_var(fp,window_y_line);
-    file_write_var(fp,window_x_line);
-    file_write_var(fp,window_x_triggered);
-    file_write_var(fp,window_y_triggered);
-    file_write_var(fp,pixel_transfer_end);
-    file_write_var(fp,emulate_pixel_fifo);
-    file_write_var(fp,early_line_zero);
-    file_write_var(fp,glitched_oam_mode);
-    file_write_var(fp,mask_en);
-    file_write_arr(fp,dmg_pal,sizeof(dmg_pal));
+    state_write_vec(writer,screen);
+    state_write_var(writer,current_line);
+    state_write_var(writer,mode);
+    state_write_var(writer,new_vblank);
+    state_write_var(writer,signal);
+    state_write_var(writer,scanline_counter);
+    state_write_var(writer,x_cord);
+    state_write_var(writer,bg_fifo);
+    state_write_var(writer,obj_fifo);
+    state_write_var(writer,fetcher);
+    state_write_var(writer,objects);
+    state_write_var(writer,tile_cord);
+    state_write_var(writer,no_sprites);
+    state_write_var(writer,cur_sprite);
+    state_write_var(writer,scx_cnt);
+    state_write_arr(writer,bg_pal,sizeof(bg_pal));
+    state_write_arr(writer,sp_pal,sizeof(sp_pal));
+    state_write_var(writer,sp_pal_idx);
+    state_write_var(writer,bg_pal_idx);
+    state_write_var(writer,window_y_line);
+    state_write_var(writer,window_x_line);
+    state_write_var(writer,window_x_triggered);
+    state_write_var(writer,window_y_triggered);
+    state_write_var(writer,pixel_transfer_end);
+    state_write_var(writer,emulate_pixel_fifo);
+    state_write_var(writer,early_line_zero);
+    state_write_var(writer,glitched_oam_mode);
+    state_write_var(writer,mask_en);
+    state_write_arr(writer,dmg_pal,sizeof(dmg_pal));
 }
 
-dtr_res Ppu::load_state(std::ifstream &fp)
+dtr_res Ppu::load_state(StateReader& reader)
 {
-    dtr_res err = file_read_vec(fp,screen);
-    err |= file_read_var(fp,current_line);
+    dtr_res err = state_read_vec(reader,screen);
+    err |= state_read_var(reader,current_line);
     if(current_line > 153)
     {
         spdlog::error("current line out of range!");
         return dtr_res::err;
     }
 
-    err |= file_read_var(fp,mode);
+    err |= state_read_var(reader,mode);
     if(static_cast<int>(mode) > 3 || static_cast<int>(mode) < 0)
     {
         spdlog::error("load_state invalid ppu mode!");
         return dtr_res::err;
     }
-    err |= file_read_var(fp,new_vblank);
-    err |= file_read_var(fp,signal);
-    err |= file_read_var(fp,scanline_counter);
-    err |= file_read_var(fp,x_cord);
+    err |= state_read_var(reader,new_vblank);
+    err |= state_read_var(reader,signal);
+    err |= state_read_var(reader,scanline_counter);
+    err |= state_read_var(reader,x_cord);
 
-    err |= file_read_var(fp,bg_fifo);
-    err |= file_read_var(fp,obj_fifo);
-    err |= file_read_var(fp,fetcher);
-    err |= file_read_var(fp,objects);
+    err |= state_read_var(reader,bg_fifo);
+    err |= state_read_var(reader,obj_fifo);
+    err |= state_read_var(reader,fetcher);
+    err |= state_read_var(reader,objects);
 
     if(fetcher.len > 8)
     {
@@ -100,15 +100,15 @@ dtr_res Ppu::load_state(std::ifstream &fp)
     }
 
 
-    err |= file_read_var(fp,tile_cord);
+    err |= state_read_var(reader,tile_cord);
     if(tile_cord >= 255) // can fetch past the screen width
     {
         spdlog::error("tile cord out of range!");
         return dtr_res::err;
     }
 
-    err |= file_read_var(fp,no_sprites);
-    err |= file_read_var(fp,cur_sprite);
+    err |= state_read_var(reader,no_sprites);
+    err |= state_read_var(reader,cur_sprite);
     if(no_sprites > 10)
     {
         spdlog::error("invalid number of sprites!");
@@ -120,21 +120,21 @@ dtr_res Ppu::load_state(std::ifstream &fp)
         spdlog::error("invalid current sprite");
         return dtr_res::err;
     }
-    err |= file_read_var(fp,scx_cnt);
-    err |= file_read_arr(fp,bg_pal,sizeof(bg_pal));
-    err |= file_read_arr(fp,sp_pal,sizeof(sp_pal));
-    err |= file_read_var(fp,sp_pal_idx);
-    err |= file_read_var(fp,bg_pal_idx);
-    err |= file_read_var(fp,window_y_line);
-    err |= file_read_var(fp,window_x_line);
-    err |= file_read_var(fp,window_x_triggered);
-    err |= file_read_var(fp,window_y_triggered);
-    err |= file_read_var(fp,pixel_transfer_end);
-    err |= file_read_var(fp,emulate_pixel_fifo);
-    err |= file_read_var(fp,early_line_zero);
-    err |= file_read_var(fp,glitched_oam_mode);
-    err |= file_read_var(fp,mask_en);
-    err |= file_read_arr(fp,dmg_pal,sizeof(dmg_pal));
+    err |= state_read_var(reader,scx_cnt);
+    err |= state_read_arr(reader,bg_pal,sizeof(bg_pal));
+    err |= state_read_arr(reader,sp_pal,sizeof(sp_pal));
+    err |= state_read_var(reader,sp_pal_idx);
+    err |= state_read_var(reader,bg_pal_idx);
+    err |= state_read_var(reader,window_y_line);
+    err |= state_read_var(reader,window_x_line);
+    err |= state_read_var(reader,window_x_triggered);
+    err |= state_read_var(reader,window_y_triggered);
+    err |= state_read_var(reader,pixel_transfer_end);
+    err |= state_read_var(reader,emulate_pixel_fifo);
+    err |= state_read_var(reader,early_line_zero);
+    err |= state_read_var(reader,glitched_oam_mode);
+    err |= state_read_var(reader,mask_en);
+    err |= state_read_arr(reader,dmg_pal,sizeof(dmg_pal));
 
     return err;
 }
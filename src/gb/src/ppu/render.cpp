@@ -504,6 +504,12 @@ void Ppu::render_scanline() noexcept
 	{
 		sprite_fetch(&scanline_fifo[scx_offset],false);
 	}
+
+	// nobody will see this frame so skip the colour conversion
+	if(suppress_frame)
+	{
+		return;
+	}
 	
     const u32 offset = (current_line*SCREEN_WIDTH);
     const bool is_cgb = cpu.is_cgb;
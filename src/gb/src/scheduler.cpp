@@ -52,42 +52,6 @@ void GameboyScheduler::service_event(const EventNode<gameboy_event> &node)
             break;
         }
 
-        case gameboy_event::c1_period_elapse:
-        {
-            if(square_tick_period(apu.psg.channels[0],cycles_to_tick >> is_double()))
-            {
-                apu.insert_chan1_period_event();
-            }
-            break;
-        }
-
-        case gameboy_event::c2_period_elapse:
-        {
-            if(square_tick_period(apu.psg.channels[1],cycles_to_tick >> is_double()))
-            {
-                apu.insert_chan2_period_event();
-            }
-            break;
-        }
-
-        case gameboy_event::c3_period_elapse:
-        {
-            if(wave_tick_period(apu.psg.wave,apu.psg.channels[2],cycles_to_tick >> is_double()))
-            {
-                apu.insert_chan3_period_event();
-            }
-            break;
-        }
-
-        case gameboy_event::c4_period_elapse:
-        {
-            if(noise_tick_period(apu.psg.noise,apu.psg.channels[3],cycles_to_tick >> is_double()))
-            {
-                apu.insert_chan4_period_event();
-            }
-            break;
-        }
-
         case gameboy_event::sample_push:
         {
             apu.push_samples(cycles_to_tick >> is_double());
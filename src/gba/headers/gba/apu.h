@@ -15,9 +15,15 @@ struct Apu
     Apu(GBA &gba);
 
     void init();
-    void tick(int cylces); 
+
+    // catch the psg channels up to the scheduler
+    // must be called before the psg is observed or modified
+    void sync_psg();
     void push_samples(int cycles);
 
+    // hand a finished block from the mixer to the audio buffer
+    void flush_mixer();
+
     void push_dma_a(int8_t x);
     void push_dma_b(int8_t x);
 
@@ -33,45 +39,12 @@ struct Apu
         scheduler.insert(event,false);
     }
 
-	void insert_chan1_period_event()
-	{
-		insert_period_event(psg.channels[0].period,gba_event::c1_period_elapse);
-	}
-
-	void insert_chan2_period_event()
-	{
-		insert_period_event(psg.channels[1].period,gba_event::c2_period_elapse);
-	}
-
-	void insert_chan3_period_event()
-	{
-		insert_period_event(psg.channels[2].period,gba_event::c3_period_elapse);
-	}
-
-	void insert_chan4_period_event()
-	{
-		insert_period_event(psg.channels[3].period,gba_event::c4_period_elapse);
-	}
-
-	void insert_period_event(int period, gba_event chan) noexcept
-	{
-		// create  a new event as the period has changed
-		// need to half the ammount if we are in double speed
-		const auto event = scheduler.create_event(period,chan);
-
-		// dont tick off the old event as 
-		// it will use the new value as we have just overwritten 
-		// the old internal counter
-		// this is not an event we are dropping and expecting to start later 
-
-		scheduler.insert(event,false);
-	}
-
-
     ApuIo apu_io;
 
     AudioBuffer audio_buffer;
     gameboy_psg::Psg psg;
+    gameboy_psg::Mixer mixer;
+    gameboy_psg::MixerConfig mixer_config;
 
     Mem &mem;
     Cpu &cpu;
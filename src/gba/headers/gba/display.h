@@ -1,5 +1,6 @@
 #pragma once
 #include <albion/lib.h>
+#include <albion/frame_sink.h>
 #include <gba/forward_def.h>
 #include <gba/disp_io.h>
 
@@ -8,6 +9,9 @@ namespace gameboyadvance
 static constexpr u32 SCREEN_WIDTH = 240;
 static constexpr u32 SCREEN_HEIGHT = 160;
 
+// 228 lines of 1232 cycles, a little under 60
+static constexpr f64 FRAME_RATE = f64(16 * 1024 * 1024) / (228 * 1232);
+
 enum class display_mode
 {
     visible,hblank,vblank
@@ -28,6 +32,10 @@ struct Display
     void render_map(int id, std::vector<u32> &map);
 
     std::vector<u32> screen;
+
+    // takes each screen at vblank when set, handing back a free one to draw the next into
+    FrameSink* frame_sink = nullptr;
+
     bool new_vblank = false;
     DispIo disp_io;
     display_mode mode = display_mode::visible;
@@ -11,10 +11,6 @@ namespace gameboyadvance
 enum class gba_event
 {
     sample_push,
-    c1_period_elapse,
-    c2_period_elapse,
-    c3_period_elapse,
-    c4_period_elapse,
     psg_sequencer,
     timer0,
     timer1,
@@ -23,9 +19,9 @@ enum class gba_event
     display
 };
 
-constexpr size_t EVENT_SIZE = 11;
+constexpr size_t EVENT_SIZE = 7;
 
-struct GBAScheduler final : public Scheduler<EVENT_SIZE,gba_event>
+struct GBAScheduler final : public Scheduler<EVENT_SIZE,gba_event,GBAScheduler>
 {
     GBAScheduler(GBA &gba);
 
@@ -38,7 +34,8 @@ struct GBAScheduler final : public Scheduler<EVENT_SIZE,gba_event>
     Mem &mem;
 
 protected:
-    void service_event(const EventNode<gba_event> & node) override;
+    friend Scheduler;
+    void service_event(const EventNode<gba_event> & node);
 };
 
 }
\ No newline at end of file
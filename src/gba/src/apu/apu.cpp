@@ -18,6 +18,7 @@ void Apu::init()
     dma_b_sample = 0;
 
     psg.init(gameboy_psg::psg_mode::gba,true);
+    mixer.init(gameboy_psg::psg_mode::gba,1.0f / 100.0f,AUDIO_BUFFER_SAMPLE_RATE,mixer_config);
 
     insert_new_sample_event();
     insert_sequencer_event();
@@ -27,54 +28,19 @@ void Apu::init()
 
 void Apu::disable_sound()
 {
+    sync_psg();
     psg.disable_sound();
-
-
-    // remove all our events for the apu until we renable it
-    scheduler.remove(gba_event::c1_period_elapse,false);
-    scheduler.remove(gba_event::c2_period_elapse,false);
-    scheduler.remove(gba_event::c3_period_elapse,false);
-    scheduler.remove(gba_event::c4_period_elapse,false);
-
-
 }
 
 void Apu::enable_sound()
 {
+    sync_psg();
     psg.enable_sound();
-
-
-    // renable our events in the scheduler
-    insert_chan1_period_event();
-    insert_chan2_period_event();
-    insert_chan3_period_event();
-    insert_chan4_period_event();
-
-
 }
 
-
-
-void Apu::tick(int cycles)
+void Apu::sync_psg()
 {
-
-    static uint32_t seq_cycles = 0;
-
-    seq_cycles += cycles;
-
-    if(seq_cycles >= (16 * 1024 * 1024) / 512)
-    {
-        psg.advance_sequencer();
-        seq_cycles = 0;
-    }
-
-
-    if(psg.sound_enabled)
-    {
-        psg.tick_periods(cycles);   
-    }
-
-    push_samples(cycles);
+    psg.sync(scheduler.get_timestamp(),0);
 }
 
 void Apu::insert_new_sample_event()
@@ -102,6 +68,7 @@ void Apu::push_samples(int cycles)
         insert_new_sample_event();
     }
 
+    sync_psg();
 
     if(!psg.sound_enabled) 
     { 
@@ -118,20 +85,8 @@ void Apu::push_samples(int cycles)
     // figure out how the volume and the bias works properly
 
 
-    float output[4];
-    for(int i = 0; i < 4; i++)
-    {
-        output[i] = static_cast<float>(psg.channels[i].output) / 100;
-    }
-
-
-    const auto sound_select = psg.read_nr51();
-    const auto nr50 = psg.read_nr50();
-
-    const f32 psg_left = gameboy_psg::mix_psg_channels(output,(nr50 >> 4) & 7,(sound_select >> 4) & 0xf,true);
-    const f32 psg_right =  gameboy_psg::mix_psg_channels(output,nr50 & 7,sound_select & 0xf,true);
-
-    f32 left = psg_left;
+    // the psg itself is mixed by the block mixer, we just add the dma channels on top
+    f32 left = 0.0f;
 
     if(apu_io.sound_cnt.enable_left_a)
     {
@@ -143,7 +98,7 @@ void Apu::push_samples(int cycles)
         left += f32(dma_b_sample) / 128.0f;
     }
 
-    f32 right = psg_right;
+    f32 right = 0.0f;
 
     if(apu_io.sound_cnt.enable_right_a)
     {
@@ -155,7 +110,20 @@ void Apu::push_samples(int cycles)
         right += f32(dma_b_sample) / 128.0f;
     }
 
-    push_sample(audio_buffer,left,right);
+    if(mixer.push(psg,left,right))
+    {
+        flush_mixer();
+    }
+}
+
+void Apu::flush_mixer()
+{
+    const u32 samples = mixer.mix();
+
+    for(u32 i = 0; i < samples; i++)
+    {
+        push_sample(audio_buffer,mixer.output[i * 2],mixer.output[(i * 2) + 1]);
+    }
 }
 
 
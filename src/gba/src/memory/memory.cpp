@@ -415,6 +415,12 @@ void Mem::write_io_regs(u32 addr,u8 v)
 
     addr &= IO_MASK;
 
+    // psg channels are lazily caught up, bring them up to date before any sound reg changes
+    if(addr >= IO_NR10 && addr <= 0x9f)
+    {
+        apu.sync_psg();
+    }
+
     switch(addr)
     {
 
@@ -780,11 +786,6 @@ void Mem::write_io_regs(u32 addr,u8 v)
 		case IO_NR14:
 		{
 			apu.psg.write_nr14(v);
-			// trigger causes freq reload update the scheduler
-			if(is_set(v,7))
-			{
-				apu.insert_chan1_period_event();
-			}
 			break;
 		}
 
@@ -809,11 +810,6 @@ void Mem::write_io_regs(u32 addr,u8 v)
 		case IO_NR24:
 		{
 			apu.psg.write_nr24(v);
-			// trigger causes freq reload update the scheduler
-			if(is_set(v,7))
-			{
-				apu.insert_chan2_period_event();
-			}
 			break;
 		}
 
@@ -845,11 +841,6 @@ void Mem::write_io_regs(u32 addr,u8 v)
 		case IO_NR34:
 		{
 			apu.psg.write_nr34(v);
-			// trigger causes freq reload update the scheduler
-			if(is_set(v,7))
-			{
-				apu.insert_chan3_period_event();
-			}
 			break;
 		}
 
@@ -868,13 +859,6 @@ void Mem::write_io_regs(u32 addr,u8 v)
 		case IO_NR43:
 		{
 			apu.psg.write_nr43(v);
-
-			// incase we havent done any events due the scheduler being off reinsert noise
-			if(!scheduler.is_active(gba_event::c4_period_elapse))
-			{
-				noise_reload_period(apu.psg.channels[3],apu.psg.noise);
-				apu.insert_chan4_period_event();
-			}
 			break;
 		}
 
@@ -1185,6 +1169,8 @@ u8 Mem::read_io_regs(u32 addr)
         case 0x98: case 0x99: case 0x9a: case 0x9b:
         case 0x9c: case 0x9d: case 0x9e: case 0x9f:
         {
+            // wave ram access depends on the current wave position
+            apu.sync_psg();
             return apu.psg.read_wave_table(addr-0x90);
         }
 
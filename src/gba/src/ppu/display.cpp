@@ -187,6 +187,11 @@ void Display::tick(int cycles)
                     disp_io.disp_stat.vblank = true;
                     new_vblank = true;
 
+                    if(frame_sink)
+                    {
+                        frame_sink->submit_frame(screen,SCREEN_WIDTH,SCREEN_HEIGHT);
+                    }
+
                     // if vblank irq enabled
                     if(disp_io.disp_stat.vblank_irq_enable)
                     {
@@ -860,6 +860,13 @@ void Display::render()
 
     std::fill(scanline.begin(),scanline.end(),dead_pixel);
 
+    // bitmap modes only draw where bg2 shows, the rest of the line is backdrop
+    // this has to go down first as the buffer holds an older screen, not the last line drawn here
+    if(render_mode >= 3)
+    {
+        std::fill_n(&screen[ly*SCREEN_WIDTH],SCREEN_WIDTH,convert_color(lose_bg.color));
+    }
+
     // ideally we would try to cull draws
     // that are not enabled in the window
     cache_window();
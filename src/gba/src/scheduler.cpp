@@ -33,44 +33,9 @@ void GBAScheduler::service_event(const EventNode<gba_event> &node)
         }
 
 
-        case gba_event::c1_period_elapse:
-        {
-            if(gameboy_psg::square_tick_period(apu.psg.channels[0],cycles_to_tick))
-            {
-                apu.insert_chan1_period_event();
-            }
-            break;
-        }
-
-        case gba_event::c2_period_elapse:
-        {
-            if(gameboy_psg::square_tick_period(apu.psg.channels[1],cycles_to_tick))
-            {
-                apu.insert_chan2_period_event();
-            }
-            break;
-        }
-
-        case gba_event::c3_period_elapse:
-        {
-            if(gameboy_psg::wave_tick_period(apu.psg.wave,apu.psg.channels[2],cycles_to_tick))
-            {
-                apu.insert_chan3_period_event();
-            }
-            break;
-        }
-
-        case gba_event::c4_period_elapse:
-        {
-            if(gameboy_psg::noise_tick_period(apu.psg.noise,apu.psg.channels[3],cycles_to_tick))
-            {
-                apu.insert_chan4_period_event();
-            }
-            break;
-        }
-
         case gba_event::psg_sequencer:
         {
+            apu.sync_psg();
             apu.psg.advance_sequencer();
             apu.insert_sequencer_event();
             break;
@@ -10,6 +10,7 @@
 #endif
 
 #include "test.cpp"
+#include "bench.cpp"
 #include "spdlog/spdlog.h"
 #include <cfenv>
 
@@ -17,14 +18,33 @@ int main(int argc, char *argv[])
 {  
     UNUSED(argc); UNUSED(argv);
   
-    if(argc == 2)
+    if(argc >= 2)
     {
         std::string arg(argv[1]);
         if(arg == "-t")
         {
             try
             {
-                run_tests();
+                run_tests(parse_test_options(argc,argv));
+            }
+
+            catch(std::exception &ex)
+            {
+                std::cout << ex.what();
+            }
+
+            return 0;
+        }
+    }
+
+    if(argc == 3)
+    {
+        std::string arg(argv[1]);
+        if(arg == "-b")
+        {
+            try
+            {
+                run_benchmarks(argv[2]);
             }
 
             catch(std::exception &ex)
@@ -56,6 +56,13 @@ void cycle_tick(N64 &n64, u32 cycles);
 void write_cop0(N64 &n64, u64 v, u64 reg);
 u64 read_cop0(N64& n64, u32 reg);
 
+// worked out from the current timestamp
+u32 read_count(N64& n64);
+u32 read_random(N64& n64);
+
+// value of random the given number of cycles on
+u32 random_after(u32 random, u32 wired, u64 cycles);
+
 
 void instr_unknown_opcode(N64 &n64, const Opcode &opcode);
 
@@ -109,14 +109,20 @@ struct Cop0
     u64 epc = 0;
     u64 error_epc = 0;
 
-    // count and compare
+    // count and random are never stepped, they are worked out from the cycles
+    // since they were last set, these are their values at those timestamps
     u32 count = 0;
+    u64 count_time = 0;
     u32 compare = 0;
 
     u8 wired = 0;
 
     // random register set to 31 on init
+    // it steps once a cpu cycle off the scheduler clock, not once per retired instr as the stepping interpreter did
+    // blocks and cached runs only tick time in batches, so an instr count is not kept anywhere
+    // only tlbwr uses it, as a free choice of entry, so all that matters is it stays inside wired to 31
     u32 random = 0b11111;
+    u64 random_time = 0;
 
     u32 prid = 0xB22;
     Config config;
@@ -1,6 +1,25 @@
+#ifndef __SSE2__
+#include <fenv.h>
+#endif
+
 namespace nintendo64
 {
 
+// cause, enable and flag bits
+static constexpr u32 COP1_INEXACT = 1 << 0;
+static constexpr u32 COP1_UNDERFLOW = 1 << 1;
+static constexpr u32 COP1_OVERFLOW = 1 << 2;
+static constexpr u32 COP1_DIV_ZERO = 1 << 3;
+static constexpr u32 COP1_INVALID = 1 << 4;
+static constexpr u32 COP1_UNIMPLEMENTED = 1 << 5;
+
+#ifdef __SSE2__
+// mxcsr with every host exception masked, the flags are read back instead
+static constexpr u32 HOST_FPU_DEFAULT = 0x1f80;
+#else
+static constexpr u32 HOST_FPU_DEFAULT = FE_TONEAREST;
+#endif
+
 struct Cop1
 {
     b32 fs = false;
@@ -10,8 +29,21 @@ struct Cop1
     u32 enable = 0;
     u32 rounding = 0;
 
-    // TODO: need to read on there operations a bit more
-    f64 regs[32] = {0.0};
+    // fcr31 rounding and flush as host fpu state, loaded while the core runs
+    u32 host_fpu = HOST_FPU_DEFAULT;
+
+    // raw bits, with fr clear an odd single lives in the top half of the even reg below it
+    u64 regs[32] = {0};
+};
+
+// swaps the guest rounding mode in on this thread, and puts the old one back on the way out
+// so other cores and threads never see it
+struct HostFpuScope
+{
+    HostFpuScope(const Cop1& cop1);
+    ~HostFpuScope();
+
+    u32 saved = 0;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <albion/lib.h>
+
+// cycles each instr is charged, looked up by opcode
+// the defaults are a cycle to fetch and a cycle to execute, plus a cycle for a memory access,
+// the latencies of the multiply / divide unit and uncached fetches can be added on top
+
+namespace nintendo64
+{
+
+struct CpiModel
+{
+    u32 fetch = 1;
+    u32 execute = 1;
+    u32 memory = 1;
+
+    // extra for every fetch from kseg1, where nothing comes out of the icache
+    u32 uncached_fetch = 0;
+
+    // extra before hi / lo are ready
+    u32 mult = 0;
+    u32 dmult = 0;
+    u32 div = 0;
+    u32 ddiv = 0;
+};
+
+// multiply / divide unit latencies from the vr4300 manual
+static constexpr CpiModel VR4300_CPI = {1,1,1,0,4,7,36,68};
+
+struct CpiTable;
+void build_cpi_table(CpiTable& table, const CpiModel& model);
+
+struct CpiTable
+{
+    CpiTable()
+    {
+        build_cpi_table(*this,CpiModel());
+    }
+
+    CpiModel model;
+
+    // by primary opcode, with special split out by funct
+    u8 primary[64] = {0};
+    u8 special[64] = {0};
+};
+
+// rebuilds the table, and throws away any code built with the old costs
+void set_cpi_model(N64& n64, const CpiModel& model);
+
+inline u32 instr_cycles(const CpiTable& table, u32 op)
+{
+    const u32 primary = op >> 26;
+    return primary == 0x00? table.special[op & 0x3f] : table.primary[primary];
+}
+
+// extra on top of instr_cycles for each fetch from this pc
+inline u32 fetch_cycles(const CpiTable& table, u64 pc)
+{
+    return (u32(pc >> 29) & 0b111) == 0b101? table.model.uncached_fetch : 0;
+}
+
+// nothing outside the cpu can see it, and it cannot see the time (exceptions included)
+// runs of these can be charged to the scheduler in one go
+inline b32 instr_cpu_only(u32 op)
+{
+    switch(op >> 26)
+    {
+        // special, regimm, j, jal, branches, alu immediates, lui
+        case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+        case 0x08: case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+        case 0x14: case 0x15: case 0x16: case 0x17:
+        case 0x18: case 0x19:
+        {
+            return true;
+        }
+
+        default: return false;
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <n64/cpu/instr_cache.h>
+#include <albion/lib.h>
+#include <memory>
+#include <exception>
+#include <atomic>
+
+// block based recompiler from mips to x86-64
+// guest state stays in Cpu so the interpreter can take over at any block boundary
+// blocks are keyed by physical page so writes and dma into code can throw them away
+
+namespace nintendo64
+{
+
+// returns the cycles not yet ticked when the block exits
+using BlockFunc = u32 (*)(N64* n64);
+
+struct Block
+{
+    BlockFunc func = nullptr;
+
+    // upper bound on the cycles the block can take
+    // so we never run past a scheduler event
+    u32 cycles = 0;
+};
+
+// first instr cannot be compiled, dont bother trying again until the page is invalidated
+static constexpr u32 BLOCK_INTERPRET = 0xffff'ffff;
+
+struct CodePage
+{
+    // the same code reached through kseg0 / kseg1, with a zero or sign extended pc,
+    // embeds different pcs so each gets its own blocks
+    Block block[4][CODE_PAGE_INSTRS];
+};
+
+// fastmem access that can fault, and where to send it when it does
+struct FaultSite
+{
+    // the host instr that does the access
+    u32 fault;
+
+    // start of the inline access, overwritten with a jmp to the slow path after the first fault
+    u32 patch;
+    u32 slow_path;
+};
+
+static constexpr u32 NO_FAULT = 0xffff'ffff;
+
+// one entry per 4KB page of the physical address space
+static constexpr u32 CODE_BITMAP_SIZE = 0x2000'0000 >> CODE_PAGE_SHIFT;
+
+// code_present bits, with any set inline stores to the page go down the slow path
+static constexpr u8 PAGE_HAS_CODE = 1 << 0;
+
+// scanned out by the vi, which needs to see every write
+static constexpr u8 PAGE_WATCHED = 1 << 1;
+
+struct Dynarec
+{
+    Dynarec();
+    ~Dynarec();
+
+    Dynarec(const Dynarec&) = delete;
+    Dynarec& operator=(const Dynarec&) = delete;
+
+    // off runs everything through the cached interpreter
+    b32 enabled = true;
+
+    // executable buffer, flushed in one go when it fills up
+    // it is never writable and executable at once, it is only opened up to write a block or a patch
+    u8* code = nullptr;
+    size_t code_size = 0;
+    size_t code_offset = 0;
+
+    std::vector<std::unique_ptr<CodePage>> pages;
+
+    // thrown by an interpreter handler inside a block, rethrown once it has exited
+    std::exception_ptr pending_exception = nullptr;
+
+    // in code order, so the fault handler can binary search it without allocating or locking
+    std::vector<FaultSite> fault_sites;
+
+    // fault site the handler sent to its slow path, patched once the block has exited
+    std::atomic<u32> pending_fault = NO_FAULT;
+
+    // PAGE_ bits for every physical page
+    // inline stores check this and go through the slow path so the page gets invalidated
+    std::vector<u8> code_present;
+};
+
+void reset_dynarec(Dynarec& dynarec);
+
+// turning it on does nothing when the host cannot run blocks
+void set_dynarec_enabled(N64& n64, b32 enabled);
+
+// run a compiled block at the current pc
+// returns false when the interpreter has to handle the next instr
+b32 run_block(N64& n64);
+
+inline void invalidate_dynarec(Dynarec& dynarec, u32 paddr)
+{
+    const u32 page = paddr >> CODE_PAGE_SHIFT;
+
+    if(page < CODE_PAGE_COUNT)
+    {
+        dynarec.pages[page].reset();
+        dynarec.code_present[page] &= ~PAGE_HAS_CODE;
+    }
+}
+
+}
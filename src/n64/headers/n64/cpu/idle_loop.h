@@ -0,0 +1,46 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <albion/lib.h>
+
+// idle loop skipping
+// a loop that stores nothing and only reads memory the scheduler events change
+// goes round identically until the next event, so whole trips can be ticked off at once
+// covers branches to self as well as polls on rdram, MI_INTR, VI_CURRENT and the status regs
+
+namespace nintendo64
+{
+
+// longest loop body looked at, including the delay slot
+static constexpr u32 IDLE_LOOP_MAX_INSTRS = 8;
+static constexpr u32 IDLE_LOOP_CACHE_SIZE = 64;
+
+struct IdleLoop
+{
+    // vaddr of the head, with the ops so a rewrite of the code can be spotted
+    u64 pc = 0;
+    u32 op[IDLE_LOOP_MAX_INSTRS] = {0};
+    u32 len = 0;
+
+    // false when the body was looked at and cannot be skipped
+    b32 idle = false;
+
+    // cycles one trip takes, from the cpi table
+    u32 cycles = 0;
+};
+
+struct IdleLoops
+{
+    IdleLoop cache[IDLE_LOOP_CACHE_SIZE];
+
+    b32 enabled = true;
+
+    u64 cycles_skipped = 0;
+};
+
+void reset_idle_loops(IdleLoops& idle_loops);
+
+// called after control lands back at or behind where it was, with the pc at a possible loop head
+// ticks off every whole trip round the loop that fits before the next event
+b32 skip_idle_loop(N64& n64);
+
+}
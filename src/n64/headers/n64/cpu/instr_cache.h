@@ -0,0 +1,99 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <n64/cpu.h>
+#include <albion/lib.h>
+#include <memory>
+#include <optional>
+
+// cached interpreter
+// whole physical pages are decoded once into handler + pre split opcode pairs
+// so a run of instrs skips the vaddr translation, the physical read and the table lookup
+
+namespace nintendo64
+{
+
+static constexpr u32 CODE_PAGE_SHIFT = 12;
+static constexpr u32 CODE_PAGE_SIZE = 1 << CODE_PAGE_SHIFT;
+static constexpr u32 CODE_PAGE_INSTRS = CODE_PAGE_SIZE / sizeof(u32);
+
+// rdram up to the end of sp imem
+static constexpr u32 CODE_REGION_END = 0x0400'2000;
+static constexpr u32 CODE_PAGE_COUNT = CODE_REGION_END >> CODE_PAGE_SHIFT;
+
+// physical addr of a pc that can run from a code cache
+// direct mapped kseg0 / kseg1 only, into rdram or sp memory
+inline std::optional<u32> code_paddr(u64 pc)
+{
+    // the pc only ever holds a 32 bit address, but may or may not be sign extended
+    const u32 upper = u32(pc >> 32);
+
+    if((upper != 0 && upper != 0xffff'ffff) || (pc & 3) != 0)
+    {
+        return std::nullopt;
+    }
+
+    const u32 segment = u32(pc >> 29) & 0b111;
+
+    if(segment != 0b100 && segment != 0b101)
+    {
+        return std::nullopt;
+    }
+
+    const u32 paddr = u32(pc) & 0x1FFF'FFFF;
+
+    if(paddr >= CODE_REGION_END || (paddr >= 0x0080'0000 && paddr < 0x0400'0000))
+    {
+        return std::nullopt;
+    }
+
+    return paddr;
+}
+
+struct DecodedInstr
+{
+    INSTR_FUNC handler = nullptr;
+    Opcode opcode;
+
+    // from the cpi table, not counting an uncached fetch
+    u32 cycles = 0;
+
+    // can be charged along with its neighbours instead of ticking the scheduler itself
+    b32 cpu_only = false;
+};
+
+struct DecodedPage
+{
+    DecodedInstr instr[CODE_PAGE_INSTRS];
+};
+
+struct InstrCache
+{
+    InstrCache()
+    {
+        pages.resize(CODE_PAGE_COUNT);
+    }
+
+    std::vector<std::unique_ptr<DecodedPage>> pages;
+
+    // bumped whenever a page is thrown away, so a run can tell its page has gone
+    u32 generation = 0;
+};
+
+void reset_instr_cache(InstrCache& cache);
+
+// run decoded instrs from the current pc until control leaves the page or an event is due
+// returns false when the interpreter has to handle the next instr
+b32 run_cached(N64& n64);
+
+inline void invalidate_instr_cache(InstrCache& cache, u32 paddr)
+{
+    const u32 page = paddr >> CODE_PAGE_SHIFT;
+
+    if(page < CODE_PAGE_COUNT && cache.pages[page])
+    {
+        cache.pages[page].reset();
+        cache.generation++;
+    }
+}
+
+}
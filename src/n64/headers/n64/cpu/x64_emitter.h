@@ -0,0 +1,380 @@
+#pragma once
+#include <albion/lib.h>
+
+// minimal x86-64 encoder for the dynarec
+// only covers the forms the recompiler actually emits
+// memory operands are always [base + disp32]
+
+namespace nintendo64
+{
+
+enum class x64_reg : u8
+{
+    rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi,
+    r8, r9, r10, r11, r12, r13, r14, r15,
+};
+
+enum class x64_cond : u8
+{
+    o = 0x0,
+    b = 0x2,
+    ae = 0x3,
+    e = 0x4,
+    ne = 0x5,
+    be = 0x6,
+    a = 0x7,
+    l = 0xc,
+    ge = 0xd,
+    le = 0xe,
+    g = 0xf,
+};
+
+// opcode extensions for the group 1 alu ops
+enum class x64_alu : u8
+{
+    add = 0,
+    or_ = 1,
+    and_ = 4,
+    sub = 5,
+    xor_ = 6,
+    cmp = 7,
+};
+
+enum class x64_shift : u8
+{
+    shl = 4,
+    shr = 5,
+    sar = 7,
+};
+
+#if defined(_WIN32)
+static constexpr x64_reg X64_ARG[4] = {x64_reg::rcx,x64_reg::rdx,x64_reg::r8,x64_reg::r9};
+#else
+static constexpr x64_reg X64_ARG[4] = {x64_reg::rdi,x64_reg::rsi,x64_reg::rdx,x64_reg::rcx};
+#endif
+
+struct X64Emitter
+{
+    u8* buf = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+
+    u8* current() const
+    {
+        return &buf[offset];
+    }
+
+    void emit8(u8 v)
+    {
+        buf[offset++] = v;
+    }
+
+    void emit32(u32 v)
+    {
+        memcpy(&buf[offset],&v,sizeof(v));
+        offset += sizeof(v);
+    }
+
+    void emit64(u64 v)
+    {
+        memcpy(&buf[offset],&v,sizeof(v));
+        offset += sizeof(v);
+    }
+
+    static u8 low(x64_reg r)
+    {
+        return u8(r) & 7;
+    }
+
+    static u8 high(x64_reg r)
+    {
+        return u8(r) >> 3;
+    }
+
+    // rex is only emitted when needed, force for byte regs above bl
+    void rex(bool w, x64_reg reg, x64_reg rm, bool force = false)
+    {
+        const u8 v = 0x40 | (w << 3) | (high(reg) << 2) | high(rm);
+
+        if(v != 0x40 || force)
+        {
+            emit8(v);
+        }
+    }
+
+    void modrm_reg(x64_reg reg, x64_reg rm)
+    {
+        emit8(0xc0 | (low(reg) << 3) | low(rm));
+    }
+
+    void modrm_mem(x64_reg reg, x64_reg base, s32 disp)
+    {
+        emit8(0x80 | (low(reg) << 3) | low(base));
+
+        // rsp and r12 need a sib byte
+        if(low(base) == 4)
+        {
+            emit8(0x24);
+        }
+
+        emit32(u32(disp));
+    }
+
+    // mov dst, src
+    void mov(x64_reg dst, x64_reg src)
+    {
+        rex(true,dst,src);
+        emit8(0x8b);
+        modrm_reg(dst,src);
+    }
+
+    // mov dst, [base + disp]
+    void load(x64_reg dst, x64_reg base, s32 disp)
+    {
+        rex(true,dst,base);
+        emit8(0x8b);
+        modrm_mem(dst,base,disp);
+    }
+
+    // mov [base + disp], src
+    void store(x64_reg base, s32 disp, x64_reg src)
+    {
+        rex(true,src,base);
+        emit8(0x89);
+        modrm_mem(src,base,disp);
+    }
+
+    // mov dst32, [base + disp], zero extended
+    void load32(x64_reg dst, x64_reg base, s32 disp)
+    {
+        rex(false,dst,base);
+        emit8(0x8b);
+        modrm_mem(dst,base,disp);
+    }
+
+    // movzx / movsx dst, byte [base + disp]
+    void load8(x64_reg dst, x64_reg base, s32 disp, bool sign)
+    {
+        rex(sign,dst,base);
+        emit8(0x0f);
+        emit8(sign? 0xbe : 0xb6);
+        modrm_mem(dst,base,disp);
+    }
+
+    // movzx / movsx dst, word [base + disp]
+    void load16(x64_reg dst, x64_reg base, s32 disp, bool sign)
+    {
+        rex(sign,dst,base);
+        emit8(0x0f);
+        emit8(sign? 0xbf : 0xb7);
+        modrm_mem(dst,base,disp);
+    }
+
+    // mov byte [base + disp], src8
+    void store8(x64_reg base, s32 disp, x64_reg src)
+    {
+        rex(false,src,base,u8(src) >= 4);
+        emit8(0x88);
+        modrm_mem(src,base,disp);
+    }
+
+    // mov word [base + disp], src16
+    void store16(x64_reg base, s32 disp, x64_reg src)
+    {
+        emit8(0x66);
+        rex(false,src,base);
+        emit8(0x89);
+        modrm_mem(src,base,disp);
+    }
+
+    // mov dword [base + disp], src32
+    void store32(x64_reg base, s32 disp, x64_reg src)
+    {
+        rex(false,src,base);
+        emit8(0x89);
+        modrm_mem(src,base,disp);
+    }
+
+    // mov dword [base + disp], imm
+    void store32_imm(x64_reg base, s32 disp, u32 imm)
+    {
+        rex(false,x64_reg::rax,base);
+        emit8(0xc7);
+        modrm_mem(x64_reg::rax,base,disp);
+        emit32(imm);
+    }
+
+    void mov_imm(x64_reg dst, u64 imm)
+    {
+        // zero extended
+        if(imm <= 0xffff'ffff)
+        {
+            rex(false,x64_reg::rax,dst);
+            emit8(0xb8 + low(dst));
+            emit32(u32(imm));
+        }
+
+        // sign extended
+        else if(s64(imm) == s64(s32(imm)))
+        {
+            rex(true,x64_reg::rax,dst);
+            emit8(0xc7);
+            modrm_reg(x64_reg::rax,dst);
+            emit32(u32(imm));
+        }
+
+        else
+        {
+            rex(true,x64_reg::rax,dst);
+            emit8(0xb8 + low(dst));
+            emit64(imm);
+        }
+    }
+
+    // op dst, src
+    void alu(x64_alu op, x64_reg dst, x64_reg src, bool wide = true)
+    {
+        rex(wide,dst,src);
+        emit8((u8(op) << 3) | 0x03);
+        modrm_reg(dst,src);
+    }
+
+    // op dst, sign extended imm32
+    void alu_imm(x64_alu op, x64_reg dst, s32 imm, bool wide = true)
+    {
+        rex(wide,x64_reg::rax,dst);
+        emit8(0x81);
+        modrm_reg(x64_reg(u8(op)),dst);
+        emit32(u32(imm));
+    }
+
+    void shift_imm(x64_shift op, x64_reg dst, u8 amount, bool wide = true)
+    {
+        rex(wide,x64_reg::rax,dst);
+        emit8(0xc1);
+        modrm_reg(x64_reg(u8(op)),dst);
+        emit8(amount);
+    }
+
+    // shift by cl
+    void shift_cl(x64_shift op, x64_reg dst, bool wide = true)
+    {
+        rex(wide,x64_reg::rax,dst);
+        emit8(0xd3);
+        modrm_reg(x64_reg(u8(op)),dst);
+    }
+
+    void not_(x64_reg dst)
+    {
+        rex(true,x64_reg::rax,dst);
+        emit8(0xf7);
+        modrm_reg(x64_reg(2),dst);
+    }
+
+    // movsxd dst, src32
+    void sign_extend32(x64_reg dst, x64_reg src)
+    {
+        rex(true,dst,src);
+        emit8(0x63);
+        modrm_reg(dst,src);
+    }
+
+    // test dst, imm32
+    void test_imm(x64_reg dst, u32 imm, bool wide = true)
+    {
+        rex(wide,x64_reg::rax,dst);
+        emit8(0xf7);
+        modrm_reg(x64_reg::rax,dst);
+        emit32(imm);
+    }
+
+    void test(x64_reg a, x64_reg b, bool wide = true)
+    {
+        rex(wide,b,a);
+        emit8(0x85);
+        modrm_reg(b,a);
+    }
+
+    // dst = cond? 1 : 0
+    void set(x64_cond cond, x64_reg dst)
+    {
+        rex(false,x64_reg::rax,dst,u8(dst) >= 4);
+        emit8(0x0f);
+        emit8(0x90 + u8(cond));
+        modrm_reg(x64_reg::rax,dst);
+
+        // movzx dst32, dst8
+        rex(false,dst,dst,u8(dst) >= 4);
+        emit8(0x0f);
+        emit8(0xb6);
+        modrm_reg(dst,dst);
+    }
+
+    void cmov(x64_cond cond, x64_reg dst, x64_reg src)
+    {
+        rex(true,dst,src);
+        emit8(0x0f);
+        emit8(0x40 + u8(cond));
+        modrm_reg(dst,src);
+    }
+
+    void push(x64_reg r)
+    {
+        rex(false,x64_reg::rax,r);
+        emit8(0x50 + low(r));
+    }
+
+    void pop(x64_reg r)
+    {
+        rex(false,x64_reg::rax,r);
+        emit8(0x58 + low(r));
+    }
+
+    void call(const void* func)
+    {
+        mov_imm(x64_reg::rax,u64(func));
+
+        // call rax
+        emit8(0xff);
+        emit8(0xd0);
+    }
+
+    void ret()
+    {
+        emit8(0xc3);
+    }
+
+    // forward jcc, returns the offset to patch
+    size_t jcc(x64_cond cond)
+    {
+        emit8(0x0f);
+        emit8(0x80 + u8(cond));
+        const size_t patch = offset;
+        emit32(0);
+        return patch;
+    }
+
+    // forward jmp, returns the offset to patch
+    size_t jmp()
+    {
+        emit8(0xe9);
+        const size_t patch = offset;
+        emit32(0);
+        return patch;
+    }
+
+    // point a jump at an offset in the buffer
+    void bind_to(size_t patch, size_t target)
+    {
+        const s32 rel = s32(s64(target) - s64(patch + sizeof(u32)));
+        memcpy(&buf[patch],&rel,sizeof(rel));
+    }
+
+    // point a forward jump at the current location
+    void bind(size_t patch)
+    {
+        bind_to(patch,offset);
+    }
+};
+
+}
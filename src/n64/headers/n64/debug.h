@@ -21,6 +21,8 @@ public:
 
     void disass_func(const std::vector<Token> &args);    
 
+    void tlb_cache(const std::vector<Token> &args);
+
 
 
 
@@ -58,7 +60,8 @@ private:
         {"log_trace",&N64Debug::log_trace},
         {"log_debug",&N64Debug::log_debug},
         {"log_info",&N64Debug::log_info},
-        {"disass_func",&N64Debug::disass_func}
+        {"disass_func",&N64Debug::disass_func},
+        {"tlb_cache",&N64Debug::tlb_cache},
     };
 
     N64 &n64;
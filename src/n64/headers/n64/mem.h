@@ -1,6 +1,7 @@
 #pragma once
 #include <n64/mem/mem_constants.h>
 #include <n64/mem/sp_regs.h>
+#include <n64/mem/dp_regs.h>
 #include <n64/mem/rdram_interface.h>
 #include <n64/mem/peripheral_interface.h>
 #include <n64/mem/video_interface.h>
@@ -9,20 +10,28 @@
 #include <n64/mem/audio_interface.h>
 #include <n64/mem/joybus.h>
 #include <n64/mem/tlb.h>
+#include <n64/mem/fastmem.h>
 
 namespace nintendo64
 {
 
-static constexpr u32 PAGE_SIZE = (1 * 1024 * 1024);
-static constexpr u64 MEMORY_SIZE = (u64(4) * 1024 * 1024 * 1024);
-static constexpr u64 PAGE_TABLE_SIZE = MEMORY_SIZE / PAGE_SIZE;
+// flat table of host pointers over the physical address space
+// null entries are mmio or unmapped and take the slow path
+static constexpr u32 PAGE_SHIFT = 12;
+static constexpr u32 PAGE_SIZE = 1 << PAGE_SHIFT;
+static constexpr u32 PAGE_MASK = PAGE_SIZE - 1;
+static constexpr u32 PHYSICAL_MEMORY_SIZE = 0x2000'0000;
+static constexpr u32 PAGE_TABLE_SIZE = PHYSICAL_MEMORY_SIZE / PAGE_SIZE;
 
 
 struct Mem
 {
     std::vector<u8> rom;
 
-    std::vector<u8> rd_ram;
+    // points into the fastmem mapping when there is one, else rd_ram_buffer
+    u8* rd_ram = nullptr;
+    std::vector<u8> rd_ram_buffer;
+    Fastmem fastmem;
 
     std::vector<u8> sp_dmem;
     std::vector<u8> sp_imem;
@@ -34,6 +43,7 @@ struct Mem
     RdramInterface ri;
 
     SpRegs sp_regs;
+    DpRegs dp_regs;
 
     PeripheralInterface pi;
     MipsInterface mi;
@@ -46,9 +56,19 @@ struct Mem
 
     std::vector<u8*> page_table_read;
     std::vector<u8*> page_table_write;
+
+    // the rsp is on its own thread, so sp mem has to take the slow path to sync with it
+    b32 sp_mem_shared = false;
 };
 
 void reset_mem(Mem &mem, const std::string &filename);
+void write_physical_table(Mem& mem);
+
+// copy between physical ranges for the dmas, straight memory goes a page at a time
+void dma_copy(N64& n64, u32 src, u32 dst, u32 len);
+
+// cpu cycles a pi transfer takes under the current domain timings
+u32 pi_dma_cycles(const PeripheralInterface& pi, u32 cart_addr, u32 len);
 
 
 template<typename access_type>
@@ -10,6 +10,11 @@ struct AudioInterface
 
     u32 freq = 0;
 
+    // host frames owed for the emulated time the dmas so far have covered,
+    // the remainder is in units of 1 / N64_CLOCK_CYCLES of a frame
+    u64 host_time = 0;
+    s64 frame_error = 0;
+
     // status
     b32 full = false;
     b32 busy = false;
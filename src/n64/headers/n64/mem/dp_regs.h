@@ -0,0 +1,16 @@
+namespace nintendo64
+{
+struct DpRegs
+{
+    // command list in rdram or dmem
+    u32 start = 0;
+    u32 end = 0;
+    u32 current = 0;
+
+    // status
+    b32 xbus_dmem_dma = false;
+    b32 freeze = false;
+    b32 flush = false;
+    b32 start_valid = false;
+};
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <albion/lib.h>
+
+// host view of the 32 bit guest address space for recompiled loads and stores
+// rdram is one shared memory object mapped through both kseg0 and kseg1,
+// the rom is mapped read only behind it, and everything else is left inaccessible
+// so an access needs no range checks, anything that is not plain memory faults
+// and the dynarec sends it down the slow path instead
+
+#if defined(__linux__) && defined(__x86_64__)
+#define N64_FASTMEM
+#endif
+
+namespace nintendo64
+{
+
+static constexpr u32 RD_RAM_SIZE = 8 * 1024 * 1024;
+static constexpr u64 FASTMEM_SIZE = u64(4) * 1024 * 1024 * 1024;
+
+struct Fastmem
+{
+    Fastmem();
+    ~Fastmem();
+
+    Fastmem(const Fastmem&) = delete;
+    Fastmem& operator=(const Fastmem&) = delete;
+
+    // start of the 4GB reservation, null when fastmem is unavailable
+    u8* base = nullptr;
+
+    // rdram as the rest of the core sees it, shares its pages with the views in base
+    u8* rd_ram = nullptr;
+
+    int rd_ram_fd = -1;
+    int rom_fd = -1;
+    size_t rom_size = 0;
+};
+
+// map the loaded (already byteswapped) rom behind kseg0 / kseg1
+void map_fastmem_rom(Fastmem& fastmem, const std::vector<u8>& rom);
+
+}
@@ -86,4 +86,14 @@ static constexpr u32 SP_RD_LEN = 0x0404'0008;
 static constexpr u32 SP_WR_LEN = 0x0404'000c;
 static constexpr u32 SP_DMA_BUSY = 0x0404'0018;
 static constexpr u32 SP_DMA_FULL = 0x0404'0014;
-static constexpr u32 SP_SEMAPHORE = 0x0404'001c;
\ No newline at end of file
+static constexpr u32 SP_SEMAPHORE = 0x0404'001c;
+
+// dp command
+static constexpr u32 DPC_START = 0x0410'0000;
+static constexpr u32 DPC_END = 0x0410'0004;
+static constexpr u32 DPC_CURRENT = 0x0410'0008;
+static constexpr u32 DPC_STATUS = 0x0410'000C;
+static constexpr u32 DPC_CLOCK = 0x0410'0010;
+static constexpr u32 DPC_BUFBUSY = 0x0410'0014;
+static constexpr u32 DPC_PIPEBUSY = 0x0410'0018;
+static constexpr u32 DPC_TMEM = 0x0410'001C;
\ No newline at end of file
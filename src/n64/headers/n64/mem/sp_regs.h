@@ -17,8 +17,8 @@ struct SpRegs
     b32 dmem_or_imem = false;
     u32 dram_addr = 0;
 
-    u32 pc = 0;
-    b32 halt = false;
+    // the pc lives in the rsp itself
+    b32 halt = true;
     b32 broke = false;
 
     SpDma write_dma;
@@ -32,8 +32,6 @@ struct SpRegs
 
     b32 io_full = false;
     b32 single_step = false;
-    b32 clear_intr_on_break = false;
-    b32 set_intr_on_break = false;
     b32 intr_on_break = false;
     u8 signal = 0;
 };
@@ -14,9 +14,34 @@ struct TLBEntry
     EntryLo entry_lo_zero;
 };
 
+// direct mapped cache of 4KB page translations under the current asid
+// saves the full entry scan on every mapped access
+static constexpr u32 TLB_CACHE_SIZE = 4096;
+
+struct TLBCacheEntry
+{
+    u32 vpage = 0;
+    u32 ppage = 0;
+    u32 generation = 0;
+    b32 dirty = false;
+};
+
+struct TLBCache
+{
+    TLBCacheEntry entry[TLB_CACHE_SIZE];
+
+    // entries from an older generation are dead, so a flush is just a bump
+    u32 generation = 1;
+    u32 asid = 0;
+
+    u64 hits = 0;
+    u64 misses = 0;
+};
+
 struct TLB
 {
     TLBEntry entry[TLB_SIZE];
+    TLBCache cache;
 };
 
 }
\ No newline at end of file
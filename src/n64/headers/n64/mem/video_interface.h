@@ -9,6 +9,7 @@ struct VideoInterface
     b8 divot = 0;
     b8 serrate = 0;
     u32 aa = 0;
+    b8 dither_filter = 0;
 
     u32 origin = 0;
     u32 width = 0;
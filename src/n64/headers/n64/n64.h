@@ -2,10 +2,15 @@
 #include <n64/cpu.h>
 #include <n64/mem.h>
 #include <n64/rdp.h>
+#include <n64/rsp.h>
 #include <n64/debug.h>
 #include <n64/scheduler.h>
+#include <n64/cpu/dynarec.h>
+#include <n64/cpu/idle_loop.h>
+#include <n64/cpu/cpi.h>
 #include <albion/lib.h>
 #include <albion/audio.h>
+#include <albion/resampler.h>
 #include <beyond_all_repair.h>
 #include <albion/input.h>
 
@@ -17,19 +22,53 @@ struct N64
     Cpu cpu;
     Mem mem;
     Rdp rdp;
+    Rsp rsp;
     N64Debug debug{*this};
     N64Scheduler scheduler{*this};
     beyond_all_repair::Program program;
+    Dynarec dynarec;
+    InstrCache instr_cache;
+    IdleLoops idle_loops;
+    CpiTable cpi;
 
     bool quit = false;
     bool size_change = false;
     b32 debug_enabled = false;
     AudioBuffer audio_buffer;
+    Resampler resampler;
 
-    // Has count event been serviced by cancelling
-    bool count_cancel = false;
+    // last so the thread is stopped before anything it uses goes away
+    RspWorker rsp_worker;
 };
 
+// called on every write into memory code can live in
+inline void invalidate_code(N64& n64, u32 paddr)
+{
+    invalidate_dynarec(n64.dynarec,paddr);
+    invalidate_instr_cache(n64.instr_cache,paddr);
+
+    // the vi has to convert its frame again
+    auto& scan_out = n64.rdp.scan_out;
+
+    if(paddr - scan_out.start < scan_out.end - scan_out.start)
+    {
+        scan_out.dirty = true;
+    }
+}
+
+inline void invalidate_code_range(N64& n64, u32 paddr, u32 len)
+{
+    if(!len)
+    {
+        return;
+    }
+
+    for(u32 page = paddr >> CODE_PAGE_SHIFT; page <= (paddr + len - 1) >> CODE_PAGE_SHIFT; page++)
+    {
+        invalidate_code(n64,page << CODE_PAGE_SHIFT);
+    }
+}
+
 static constexpr u32 N64_CLOCK_CYCLES = 93 * 1024 * 1024;
 static constexpr u32 N64_CLOCK_CYCLES_FRAME =  N64_CLOCK_CYCLES / 60;
 
@@ -37,6 +76,11 @@ static constexpr u32 N64_CLOCK_CYCLES_FRAME =  N64_CLOCK_CYCLES / 60;
 void reset(N64 &n64, const std::string &filename);
 void run(N64 &n64);
 
+// outside of run, for checking the faster paths against the interpreter
+// step_instr runs a single instr, step_block a whole block or cached run where it can
+void step_instr(N64& n64);
+void step_block(N64& n64);
+
 std::string disass_n64(N64& n64, Opcode opcode, u64 addr);
 void handle_input(N64& n64, Controller& controller);
 const char* reg_name(u32 idx);
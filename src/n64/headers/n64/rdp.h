@@ -1,26 +1,313 @@
 #pragma once
+#include <albion/thread_pool.h>
+#include <albion/frame_sink.h>
+#include <array>
+#include <memory>
 
 namespace nintendo64
 {
 
+// command side of the rdp
+// lists handed over through the dp regs are parsed on the cpu thread,
+// draws are queued with a snapshot of the state they use and rasterised in
+// horizontal bands across a worker pool whenever something has to see the result
+
+enum class rdp_cycle
+{
+    one,
+    two,
+    copy,
+    fill,
+};
+
+struct RdpTile
+{
+    u32 format = 0;
+    u32 size = 0;
+
+    // row stride and base in 64 bit tmem words
+    u32 line = 0;
+    u32 tmem_addr = 0;
+    u32 palette = 0;
+
+    b32 clamp_s = false;
+    b32 mirror_s = false;
+    u32 mask_s = 0;
+    u32 shift_s = 0;
+
+    b32 clamp_t = false;
+    b32 mirror_t = false;
+    u32 mask_t = 0;
+    u32 shift_t = 0;
+
+    // 10.2 fixed point
+    u32 sl = 0;
+    u32 tl = 0;
+    u32 sh = 0;
+    u32 th = 0;
+};
+
+struct RdpImage
+{
+    u32 addr = 0;
+    u32 width = 0;
+    u32 format = 0;
+    u32 size = 0;
+};
+
+struct RdpOtherModes
+{
+    rdp_cycle cycle_type = rdp_cycle::one;
+    b32 persp_tex = false;
+    b32 tlut_en = false;
+    b32 tlut_ia = false;
+
+    // blender mux selects per cycle
+    u32 blend_p[2] = {0};
+    u32 blend_a[2] = {0};
+    u32 blend_m[2] = {0};
+    u32 blend_b[2] = {0};
+
+    b32 force_blend = false;
+    b32 image_read = false;
+    b32 z_update = false;
+    b32 z_compare = false;
+    b32 z_source_prim = false;
+    b32 alpha_compare = false;
+};
+
+// mux selects per cycle, see the input tables in rdp_raster.cpp
+struct RdpCombiner
+{
+    u32 rgb_sub_a[2] = {0};
+    u32 rgb_sub_b[2] = {0};
+    u32 rgb_mul[2] = {0};
+    u32 rgb_add[2] = {0};
+
+    u32 alpha_sub_a[2] = {0};
+    u32 alpha_sub_b[2] = {0};
+    u32 alpha_mul[2] = {0};
+    u32 alpha_add[2] = {0};
+};
+
+// everything a draw reads when it is rasterised
+struct RdpState
+{
+    RdpOtherModes modes;
+    RdpCombiner combiner;
+
+    u32 fill_color = 0;
+    u32 fog_color = 0;
+    u32 blend_color = 0;
+    u32 prim_color = 0;
+    u32 env_color = 0;
+    u32 prim_lod_frac = 0;
+    u32 prim_z = 0;
+
+    RdpImage color_image;
+    RdpImage texture_image;
+    u32 z_addr = 0;
+
+    // 10.2 fixed point, the low edges are exclusive
+    u32 scissor_xh = 0;
+    u32 scissor_yh = 0;
+    u32 scissor_xl = 0;
+    u32 scissor_yl = 0;
+
+    RdpTile tiles[8];
+};
+
+enum class rdp_prim
+{
+    triangle,
+    fill_rect,
+    tex_rect,
+};
+
+// an attribute with its slope along x and down the major edge, s15.16
+struct RdpAttr
+{
+    s32 v = 0;
+    s32 dx = 0;
+    s32 de = 0;
+};
+
+enum rdp_attr
+{
+    attr_r,
+    attr_g,
+    attr_b,
+    attr_a,
+    attr_s,
+    attr_t,
+    attr_w,
+    attr_z,
+    ATTR_SIZE,
+};
+
+struct RdpPrimitive
+{
+    rdp_prim type = rdp_prim::triangle;
+
+    // index of the state and tmem snapshots it draws with
+    u32 state = 0;
+    u32 tmem = 0;
+    u32 tile = 0;
+
+    // triangles, y in s11.2 and x in s15.16
+    b32 left_major = false;
+    s32 yh = 0;
+    s32 ym = 0;
+    s32 yl = 0;
+    s32 xh = 0;
+    s32 xm = 0;
+    s32 xl = 0;
+    s32 dxhdy = 0;
+    s32 dxmdy = 0;
+    s32 dxldy = 0;
+
+    b32 shade = false;
+    b32 texture = false;
+    b32 zbuffer = false;
+    RdpAttr attr[ATTR_SIZE];
+
+    // rectangles, corners in 10.2, s and t in s10.5, slopes in s5.10
+    u32 rect_xh = 0;
+    u32 rect_yh = 0;
+    u32 rect_xl = 0;
+    u32 rect_yl = 0;
+    s32 s = 0;
+    s32 t = 0;
+    s32 dsdx = 0;
+    s32 dtdy = 0;
+    b32 flip = false;
+
+    // rows it can touch once clipped to the scissor
+    u32 y_start = 0;
+    u32 y_end = 0;
+};
+
+struct RdpCommands
+{
+    RdpState state;
+
+    // textures are held big endian in a linear layout
+    std::array<u8,0x1000> tmem{};
+
+    // snapshots for queued draws, a new one is only taken once something has changed
+    std::vector<RdpState> states;
+    std::vector<std::array<u8,0x1000>> tmem_snapshots;
+    b32 state_changed = true;
+    b32 tmem_changed = true;
+
+    std::vector<RdpPrimitive> queue;
+
+    // rdram the queued draws can write, loads from inside it have to flush first
+    u32 dirty_start = 0;
+    u32 dirty_end = 0;
+
+    // words of a command split across two lists
+    std::vector<u64> pending;
+
+    // created on the first flush big enough to split up
+    std::unique_ptr<ThreadPool> pool;
+    u32 threads = 0;
+};
+
+// vi settings a frame was converted with, a new frame is only needed if these or the rdram under it change
+struct ScanOutParams
+{
+    u32 origin = 0;
+    u32 width = 0;
+    u32 bpp = 0;
+    u32 x_offset = 0;
+    u32 y_offset = 0;
+    u32 x_scale = 0;
+    u32 y_scale = 0;
+    u32 aa = 0;
+    u32 frame_x = 0;
+    u32 frame_y = 0;
+    u32 screen_x = 0;
+    u32 screen_y = 0;
+    b32 dither_filter = false;
+    b32 scale = false;
+
+    bool operator==(const ScanOutParams& other) const = default;
+};
+
+struct ScanOut
+{
+    // optional passes after the framebuffer is converted
+    // the vi's dither filter, when the game has it turned on
+    b32 dither_filter = false;
+
+    // resample up to the vi's own output size, rather than showing the framebuffer as is
+    b32 scale = false;
+
+    // rdram being scanned out, rounded out to whole code pages
+    // any write in here (which all go through invalidate_code) means the frame has to be converted again
+    u32 start = 0;
+    u32 end = 0;
+    b32 dirty = true;
+
+    ScanOutParams params;
+
+    // intermediates for when more than one pass runs
+    std::vector<u32> frame;
+    std::vector<u32> filtered;
+    std::vector<u32> rows[2];
+};
+
 struct Rdp
 {
     u32 screen_x = 0;
     u32 screen_y = 0;
     std::vector<u32> screen;
 
+    // takes each screen scanned out when set, and hands back a free one for the next
+    FrameSink* frame_sink = nullptr;
+
+    // framebuffer area the vi reads, same as the screen unless it is being scaled
+    u32 frame_x = 0;
+    u32 frame_y = 0;
+
+    ScanOut scan_out;
+
     u32 ly = 0;
     u32 line_cycles = 0;
     u32 scan_lines = 525;
 
     bool frame_done;
+
+    RdpCommands commands;
 };
 
 
 
 void reset_rdp(N64 &n64);
+void reset_rdp_commands(RdpCommands& commands);
 void change_res(N64 &n64);
 
+void reset_scan_out(N64& n64);
+
+// pick the optional scan out passes, takes effect from the next frame
+void set_vi_filters(N64& n64, b32 dither_filter, b32 scale);
+
+// convert the vi's framebuffer into the screen, if anything under it has changed
+void render(N64& n64);
+
+// run the list between DPC_CURRENT and DPC_END
+void run_rdp_commands(N64& n64);
+
+// rasterise everything queued, anything reading the color or z image has to call this first
+void flush_rdp(N64& n64);
+
+// flush only if the queued draws can write somewhere in the rdram range
+void flush_if_dirty(N64& n64, u32 addr, u32 len);
+
+// zero keeps everything on the calling thread
+void set_rdp_threads(N64& n64, u32 threads);
+
 static constexpr u32 VIDEO_CLOCK = 48681812;
 
 }
\ No newline at end of file
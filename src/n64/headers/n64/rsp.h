@@ -0,0 +1,116 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <albion/lib.h>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+// reality signal processor
+// a cut down 32 bit mips core that runs microcode out of imem against dmem
+// plus a vector unit working on eight 16 bit lanes at a time
+
+namespace nintendo64
+{
+
+// lane 0 is element 0, ie the most significant half of the big endian register
+struct alignas(16) VReg
+{
+    u16 lane[8] = {0};
+};
+
+struct VectorUnit
+{
+    VReg regs[32];
+
+    // 48 bit accumulator per lane, split so each part is a vector of its own
+    VReg acc_hi;
+    VReg acc_md;
+    VReg acc_lo;
+
+    // flags are held as per lane masks of 0 or 0xffff
+    VReg vco_lo;
+    VReg vco_hi;
+    VReg vcc_lo;
+    VReg vcc_hi;
+    VReg vce;
+
+    // state carried between the parts of a double precision reciprocal
+    s16 div_in = 0;
+    s16 div_out = 0;
+    b32 div_dp = false;
+};
+
+struct Rsp
+{
+    u32 regs[32] = {0};
+
+    // byte offsets into imem
+    u32 pc = 0;
+    u32 pc_next = 4;
+
+    VectorUnit vu;
+
+    // cpu cycles not yet turned into rsp cycles, the rsp runs at 2/3 of the cpu clock
+    u32 cycle_remainder = 0;
+
+    // dmem stores since the cpu last dropped any code it had built from it
+    b32 dmem_dirty = false;
+};
+
+// optional host thread the rsp timeslices are handed to
+// the cpu posts one timeslice worth of cycles at a time, and only looks at
+// anything the rsp can change after waiting for it at a sync point,
+// so what the cpu sees only depends on emulated time and not on the host
+struct RspWorker
+{
+    RspWorker() = default;
+    ~RspWorker();
+
+    RspWorker(const RspWorker&) = delete;
+    RspWorker& operator=(const RspWorker&) = delete;
+
+    std::thread thread;
+
+    // single slot mailbox, the cpu bumps posted once budget is written
+    // and the worker bumps done once it has used it
+    std::atomic<u32> posted = 0;
+    std::atomic<u32> done = 0;
+    std::atomic<b32> quit = false;
+
+    u32 budget = 0;
+
+    // cycles left when the worker stopped at an op that has to run on the cpu thread
+    u32 remaining = 0;
+
+    // only touched by the cpu thread
+    b32 in_flight = false;
+
+    std::exception_ptr error;
+};
+
+// cpu cycles the rsp is left to run for before it catches up
+static constexpr u32 RSP_TIMESLICE = 1024;
+
+void reset_rsp(N64& n64);
+
+// called when the halt bit is cleared, schedules the first timeslice
+void start_rsp(N64& n64);
+
+// run the rsp for the rsp cycles that fit in a span of cpu cycles
+void run_rsp(N64& n64, u32 cpu_cycles);
+
+void rsp_event(N64& n64, u32 cpu_cycles);
+
+void write_rsp_pc(N64& n64, u32 v);
+
+// run one vector unit computational op
+void rsp_cop2(N64& n64, u32 op);
+
+// move the rsp on or off its own thread, lock step is the default
+void set_rsp_threaded(N64& n64, b32 threaded);
+
+// wait for the worker to finish its timeslice
+// anything the cpu does that the rsp could observe or change has to call this first
+void sync_rsp(N64& n64);
+
+}
@@ -164,31 +164,34 @@ b32 cop0_usable(N64& n64)
 }
 
 
-void insert_count_event(N64 &n64)
+// count goes up every other cycle from count_time
+u32 read_count(N64& n64)
 {
-    u64 cycles;
+    const auto& cop0 = n64.cpu.cop0;
+    return cop0.count + u32((n64.scheduler.get_timestamp() - cop0.count_time) >> 1);
+}
 
+void insert_count_event(N64 &n64)
+{
     auto& cop0 = n64.cpu.cop0;
 
-    const u64 count = cop0.count;
-    const u64 compare = cop0.compare;
+    const u64 elapsed = n64.scheduler.get_timestamp() - cop0.count_time;
 
-    
-    if(count < compare)
-    {
-        cycles = (compare - count);
-    }
+    // compare == count is a whole trip round the 32 bits away
+    u64 ticks = u32(cop0.compare - read_count(n64));
 
-    else
+    if(!ticks)
     {
-        cycles = (u32(0xffff'ffff) - count) + compare; 
+        ticks = u64(1) << 32;
     }
 
-    const auto event = n64.scheduler.create_event(cycles * 2,n64_event::count);
+    // part way through a tick, the next one comes a cycle early
+    const u64 cycles = (ticks * 2) - (elapsed & 1);
+
+    const auto event = n64.scheduler.create_event(cycles,n64_event::count);
     n64.scheduler.insert(event,false); 
 }
 
-
 void set_intr_cop0(N64& n64, u32 bit)
 {
     auto& cause = n64.cpu.cop0.cause;
@@ -209,21 +212,11 @@ void count_intr(N64 &n64)
     set_intr_cop0(n64,COUNT_BIT);
 }
 
-void count_event(N64& n64, u32 cycles)
+void count_event(N64& n64)
 {
-    auto& cop0 = n64.cpu.cop0;
-    cop0.count += cycles >> 1;
-
-    // Not due to an event cancelation it should have tripped
-    // Due to deffered checking it may have overrun a couple of cycles
-    if(!n64.count_cancel)
-    {
-        spdlog::debug("Count {:x} == {:x}",cop0.count,cop0.compare);
-        count_intr(n64);  
-        insert_count_event(n64); 
-    }
-
-    n64.count_cancel = false;
+    spdlog::debug("Count {:x} == {:x}",read_count(n64),n64.cpu.cop0.compare);
+    count_intr(n64);  
+    insert_count_event(n64); 
 }
 
 void mi_intr(N64& n64)
@@ -267,22 +260,17 @@ void write_cop0(N64 &n64, u64 v, u64 reg)
         // cycle counter (incremented every other cycle)
         case beyond_all_repair::COUNT:
         {
-            n64.count_cancel = true;
-            n64.scheduler.remove(n64_event::count,false);
             cop0.count = v;
+            cop0.count_time = n64.scheduler.get_timestamp();
 
             spdlog::trace("COP0 count {:x}", cop0.count);
             insert_count_event(n64);
-            n64.count_cancel = false;
             break;
         }
 
         // when this is == count trigger in interrupt
         case beyond_all_repair::COMPARE:
         {
-            n64.count_cancel = true;
-            n64.scheduler.remove(n64_event::count);
-            
             cop0.compare = v;
             insert_count_event(n64);
 
@@ -424,6 +412,7 @@ void write_cop0(N64 &n64, u64 v, u64 reg)
         {
             cop0.wired = v & 0b111111;
             cop0.random = 31;
+            cop0.random_time = n64.scheduler.get_timestamp();
             spdlog::trace("COP0 Wired wire {}, random {}",cop0.wired,cop0.random);
             break;
         }
@@ -517,7 +506,7 @@ u64 read_cop0(N64& n64, u32 reg)
     {
         case RANDOM:
         {
-            return cop0.random;
+            return read_random(n64);
         }
 
         case LLADDR:
@@ -595,12 +584,7 @@ u64 read_cop0(N64& n64, u32 reg)
 
         case COUNT:
         {
-            n64.count_cancel = true;
-            // read out count tick off all the cycles
-            n64.scheduler.remove(n64_event::count);
-            insert_count_event(n64);
-
-            return cop0.count;
+            return read_count(n64);
         }
 
         case EPC:
@@ -672,17 +656,28 @@ u64 read_cop0(N64& n64, u32 reg)
     }
 }
 
-void update_random(Cop0& cop0) 
+// random drops once a cycle from 31 until it hits wired, then wraps back to 31
+// anything outside that lap counts down through all 6 bits until it reaches wired
+u32 random_after(u32 random, u32 wired, u64 cycles)
 {
-    if(cop0.random == cop0.wired)
-    {
-        cop0.random = 31;
-    }
+    const u64 to_wired = (random - wired) & 63;
 
-    else
+    if(cycles <= to_wired)
     {
-        cop0.random = (cop0.random - 1) & 63;
+        return (random - cycles) & 63;
     }
+
+    // back at 31, then whole laps
+    cycles -= to_wired + 1;
+    const u64 lap = ((31 - wired) & 63) + 1;
+
+    return (31 - (cycles % lap)) & 63;
+}
+
+u32 read_random(N64& n64)
+{
+    const auto& cop0 = n64.cpu.cop0;
+    return random_after(cop0.random,cop0.wired,n64.scheduler.get_timestamp() - cop0.random_time);
 }
 
-}
\ No newline at end of file
+}
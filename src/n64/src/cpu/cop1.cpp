@@ -1,8 +1,123 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#else
 #include <fenv.h>
+#endif
 
 namespace nintendo64
 {
 
+#ifdef __SSE2__
+
+static constexpr u32 MXCSR_FLAGS = 0x3f;
+static constexpr u32 MXCSR_FLUSH = 1 << 15;
+
+u32 host_fpu_mode(u32 rounding, b32 fs)
+{
+    // mips goes nearest, zero, up, down, mxcsr goes nearest, down, up, zero
+    static constexpr u32 MXCSR_ROUND[4] = {0b00,0b11,0b10,0b01};
+
+    return HOST_FPU_DEFAULT | (MXCSR_ROUND[rounding] << 13) | (fs? MXCSR_FLUSH : 0);
+}
+
+u32 read_host_fpu()
+{
+    return _mm_getcsr();
+}
+
+void write_host_fpu(u32 v)
+{
+    _mm_setcsr(v);
+}
+
+// exceptions raised since the flags were last cleared, as cause bits
+// the flags are sticky, so they only need clearing when something was actually raised
+u32 host_fpu_cause()
+{
+    const u32 csr = _mm_getcsr();
+
+    if(!(csr & MXCSR_FLAGS))
+    {
+        return 0;
+    }
+
+    _mm_setcsr(csr & ~MXCSR_FLAGS);
+
+    // invalid, denormal, zero, overflow, underflow, precision
+    return (is_set(csr,0)? COP1_INVALID : 0) | (is_set(csr,2)? COP1_DIV_ZERO : 0) |
+        (is_set(csr,3)? COP1_OVERFLOW : 0) | (is_set(csr,4)? COP1_UNDERFLOW : 0) | (is_set(csr,5)? COP1_INEXACT : 0);
+}
+
+#else
+
+// no flush to zero through fenv
+u32 host_fpu_mode(u32 rounding, b32 fs)
+{
+    UNUSED(fs);
+
+    static constexpr int FE_ROUND[4] = {FE_TONEAREST,FE_TOWARDZERO,FE_UPWARD,FE_DOWNWARD};
+    return FE_ROUND[rounding];
+}
+
+u32 read_host_fpu()
+{
+    return fegetround();
+}
+
+void write_host_fpu(u32 v)
+{
+    fesetround(v);
+    feclearexcept(FE_ALL_EXCEPT);
+}
+
+u32 host_fpu_cause()
+{
+    const int except = fetestexcept(FE_ALL_EXCEPT);
+
+    if(!except)
+    {
+        return 0;
+    }
+
+    feclearexcept(FE_ALL_EXCEPT);
+
+    return (except & FE_INVALID? COP1_INVALID : 0) | (except & FE_DIVBYZERO? COP1_DIV_ZERO : 0) |
+        (except & FE_OVERFLOW? COP1_OVERFLOW : 0) | (except & FE_UNDERFLOW? COP1_UNDERFLOW : 0) | (except & FE_INEXACT? COP1_INEXACT : 0);
+}
+
+#endif
+
+// the compiler does not know float ops depend on the host fpu state
+// so anything that has to happen between two accesses to it gets pinned down with this
+template<typename T>
+void host_fpu_fence(T& v)
+{
+#if defined(__GNUC__) && defined(__SSE2__)
+    if constexpr(std::is_floating_point_v<T>)
+    {
+        asm volatile("" : "+x"(v));
+    }
+
+    else
+    {
+        asm volatile("" : "+r"(v));
+    }
+#else
+    UNUSED(v);
+#endif
+}
+
+HostFpuScope::HostFpuScope(const Cop1& cop1)
+{
+    saved = read_host_fpu();
+    write_host_fpu(cop1.host_fpu);
+}
+
+HostFpuScope::~HostFpuScope()
+{
+    write_host_fpu(saved);
+}
+
 b32 cop1_usable(N64& n64)
 {
     auto& status = n64.cpu.cop0.status;
@@ -20,15 +135,42 @@ void check_cop1_exception(N64& n64)
 {
     auto& cop1 = n64.cpu.cop1;
 
-    if((cop1.enable & cop1.cause) || is_set(cop1.cause,5))
+    if((cop1.enable & cop1.cause) || (cop1.cause & COP1_UNIMPLEMENTED))
+    {
+        standard_exception(n64,beyond_all_repair::FLOATING_POINT_EXCEPTION);
+    }
+}
+
+// takes the cause of the op that just ran from the host flags
+// returns false when it traps, in which case nothing gets written back
+b32 cop1_result(N64& n64, u32 cause)
+{
+    auto& cop1 = n64.cpu.cop1;
+    cop1.cause = cause;
+
+    if(!cause)
+    {
+        return true;
+    }
+
+    if(cause & cop1.enable)
     {
         standard_exception(n64,beyond_all_repair::FLOATING_POINT_EXCEPTION);
+        return false;
     }
+
+    cop1.flags |= cause;
+    return true;
+}
+
+b32 cop1_result(N64& n64)
+{
+    return cop1_result(n64,host_fpu_cause());
 }
 
 
 void write_cop1_control(N64& n64, u32 idx, u32 v)
-{ 
+{
     auto& cop1 = n64.cpu.cop1;
 
 
@@ -44,34 +186,9 @@ void write_cop1_control(N64& n64, u32 idx, u32 v)
         cop1.flags = (v >> 2) & 0b111'11;
         cop1.rounding = v & 0b11;
 
-        // use fe to set the correct round mode
-        switch(cop1.rounding)
-        {
-            case 0:
-            {
-                fesetround(FE_TONEAREST);
-                break;
-            }
-
-            case 1:
-            {
-                fesetround(FE_TOWARDZERO);
-                break;
-            }
-
-            case 2:
-            {
-                fesetround(FE_UPWARD);
-                break;
-            }
-
-            case 3:
-            {
-                fesetround(FE_DOWNWARD);
-                break;
-            }
-        }
-
+        // we are inside the core, so this goes straight onto the host
+        cop1.host_fpu = host_fpu_mode(cop1.rounding,cop1.fs);
+        write_host_fpu(cop1.host_fpu);
 
         check_cop1_exception(n64);
     }
@@ -84,13 +201,13 @@ u32 read_cop1_control(N64& n64, u32 idx)
     switch(idx)
     {
         case 31:
-        { 
-            return (cop1.fs << 24) | (cop1.c << 23) | (cop1.cause << 12) | 
+        {
+            return (cop1.fs << 24) | (cop1.c << 23) | (cop1.cause << 12) |
             (cop1.enable << 7) | (cop1.flags << 2) | cop1.rounding;
         }
 
         // revision register
-        case 0: 
+        case 0:
         {
             return 0xa00;
         }
@@ -99,25 +216,38 @@ u32 read_cop1_control(N64& n64, u32 idx)
     }
 }
 
-u32 calc_float_reg_idx(N64& n64, u32 reg)
+// with fr set there are 32 full regs, otherwise 16 even ones with the odd singles in their top half
+u32 read_cop1_s(N64& n64, u32 reg)
 {
-    auto& status = n64.cpu.cop0.status;
-    return reg >> (!status.fr);
+    const auto& regs = n64.cpu.cop1.regs;
+
+    if(n64.cpu.cop0.status.fr)
+    {
+        return u32(regs[reg]);
+    }
+
+    return u32(regs[reg & ~1] >> ((reg & 1) * 32));
 }
 
-f64 read_cop1_reg(N64& n64, u32 reg)
+void write_cop1_s(N64& n64, u32 reg, u32 v)
 {
-    const u32 idx = calc_float_reg_idx(n64,reg);
+    auto& regs = n64.cpu.cop1.regs;
+
+    const u32 idx = n64.cpu.cop0.status.fr? reg : reg & ~1;
+    const u32 shift = n64.cpu.cop0.status.fr? 0 : (reg & 1) * 32;
 
-    return n64.cpu.cop1.regs[idx];
+    regs[idx] = (regs[idx] & ~(u64(0xffff'ffff) << shift)) | (u64(v) << shift);
 }
 
-void write_cop1_reg(N64& n64, u32 reg, f64 v)
+u64 read_cop1_d(N64& n64, u32 reg)
 {
-    const u32 idx = calc_float_reg_idx(n64,reg);
+    return n64.cpu.cop1.regs[n64.cpu.cop0.status.fr? reg : reg & ~1];
+}
 
-    n64.cpu.cop1.regs[idx] = v;
+void write_cop1_d(N64& n64, u32 reg, u64 v)
+{
+    n64.cpu.cop1.regs[n64.cpu.cop0.status.fr? reg : reg & ~1] = v;
 }
 
 
-}
\ No newline at end of file
+}
@@ -41,6 +41,7 @@ void reset_cpu(N64 &n64)
     
 
     cop0.random = 0x0000001F;
+    cop0.random_time = n64.scheduler.get_timestamp();
     write_cop0(n64,0,beyond_all_repair::COUNT);
     write_cop0(n64,0,beyond_all_repair::COMPARE);
     write_cop0(n64,0xffff'ffff,beyond_all_repair::EPC);
@@ -57,10 +58,52 @@ void reset_cpu(N64 &n64)
 }
 
 
+void set_cpi_model(N64& n64, const CpiModel& model)
+{
+    build_cpi_table(n64.cpi,model);
+
+    // block, page and loop costs are worked out when they are built
+    reset_dynarec(n64.dynarec);
+    reset_instr_cache(n64.instr_cache);
+    reset_idle_loops(n64.idle_loops);
+}
+
+void build_cpi_table(CpiTable& table, const CpiModel& model)
+{
+    table.model = model;
+
+    const u32 base = model.fetch + model.execute;
+
+    for(u32 op = 0; op < 64; op++)
+    {
+        table.primary[op] = base;
+        table.special[op] = base;
+    }
+
+    // ldl, ldr, then loads, stores, ll / sc and the fpu loads and stores
+    static constexpr u32 MEMORY_OPS[] = 
+    {
+        0x1a, 0x1b,
+        0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+        0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e,
+        0x30, 0x31, 0x34, 0x35, 0x37, 0x38, 0x39, 0x3c, 0x3d, 0x3f,
+    };
+
+    for(const u32 op : MEMORY_OPS)
+    {
+        table.primary[op] = base + model.memory;
+    }
+
+    // mult, multu / dmult, dmultu / div, divu / ddiv, ddivu
+    table.special[0x18] = table.special[0x19] = base + model.mult;
+    table.special[0x1c] = table.special[0x1d] = base + model.dmult;
+    table.special[0x1a] = table.special[0x1b] = base + model.div;
+    table.special[0x1e] = table.special[0x1f] = base + model.ddiv;
+}
+
 void cycle_tick(N64 &n64, u32 cycles)
 {
     n64.scheduler.delay_tick(cycles);
-    update_random(n64.cpu.cop0);
 }
 
 
@@ -124,9 +167,7 @@ void step(N64 &n64)
     // $zero is hardwired to zero, make sure writes cant touch it
     n64.cpu.regs[beyond_all_repair::R0] = 0;
 
-    // assume 1 CPI
-    // TODO: i dont anything should have such sensitive timings yet..
-    cycle_tick(n64,1);
+    cycle_tick(n64,instr_cycles(n64.cpi,op) + fetch_cycles(n64.cpi,n64.cpu.pc_fetch));
 }
 
 void write_pc(N64 &n64, u64 pc)
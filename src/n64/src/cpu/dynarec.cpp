@@ -0,0 +1,1257 @@
+#include <n64/n64.h>
+#include <n64/cpu/x64_emitter.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define N64_DYNAREC_X64
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#endif
+
+#ifdef N64_FASTMEM
+#include <signal.h>
+#include <ucontext.h>
+#include <mutex>
+#endif
+
+namespace nintendo64
+{
+
+static constexpr size_t CODE_BUFFER_SIZE = 32 * 1024 * 1024;
+
+// never start compiling a block without this much room left
+static constexpr size_t MAX_BLOCK_BYTES = 64 * 1024;
+static constexpr u32 MAX_BLOCK_INSTRS = 128;
+
+Dynarec::Dynarec()
+{
+    pages.resize(CODE_PAGE_COUNT);
+    code_present.resize(CODE_BITMAP_SIZE);
+
+#ifdef N64_DYNAREC_X64
+#ifdef _WIN32
+    code = (u8*)VirtualAlloc(nullptr,CODE_BUFFER_SIZE,MEM_COMMIT | MEM_RESERVE,PAGE_EXECUTE_READ);
+#else
+    void* mem = mmap(nullptr,CODE_BUFFER_SIZE,PROT_READ | PROT_EXEC,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+    code = mem == MAP_FAILED? nullptr : (u8*)mem;
+#endif
+#endif
+
+    if(!code)
+    {
+        spdlog::warn("dynarec unavailable, falling back to the interpreter");
+        enabled = false;
+        return;
+    }
+
+    code_size = CODE_BUFFER_SIZE;
+}
+
+Dynarec::~Dynarec()
+{
+    if(!code)
+    {
+        return;
+    }
+
+#ifdef N64_DYNAREC_X64
+#ifdef _WIN32
+    VirtualFree(code,0,MEM_RELEASE);
+#else
+    munmap(code,code_size);
+#endif
+#endif
+}
+
+void reset_dynarec(Dynarec& dynarec)
+{
+    for(auto& page : dynarec.pages)
+    {
+        page.reset();
+    }
+
+    dynarec.code_offset = 0;
+    dynarec.pending_exception = nullptr;
+    dynarec.fault_sites.clear();
+    dynarec.pending_fault = NO_FAULT;
+
+    // code_present is left alone, the instr cache may still have pages in it
+    // and a stale bit only costs a single trip down the slow path
+}
+
+void set_dynarec_enabled(N64& n64, b32 enabled)
+{
+    n64.dynarec.enabled = enabled && n64.dynarec.code;
+}
+
+#ifdef N64_DYNAREC_X64
+
+static constexpr size_t HOST_PAGE_SIZE = 4096;
+
+// flip part of the code buffer between writable and executable, it is never both
+void protect_code(Dynarec& dynarec, size_t offset, size_t size, b32 writable)
+{
+    const size_t start = offset & ~(HOST_PAGE_SIZE - 1);
+    const size_t len = (offset + size) - start;
+
+#ifdef _WIN32
+    DWORD old;
+    VirtualProtect(dynarec.code + start,len,writable? PAGE_READWRITE : PAGE_EXECUTE_READ,&old);
+#else
+    mprotect(dynarec.code + start,len,writable? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC);
+#endif
+}
+
+enum class dynarec_instr
+{
+    // compiled inline
+    alu,
+    // compiled inline, takes the next instr as its delay slot
+    branch,
+    // call out to the interpreter handler
+    fallback,
+    // fallback that also ticks for its memory access
+    memory,
+    // load or store straight through the fastmem arena
+    fastmem,
+    // control flow the block cant handle, leave it to the interpreter
+    stop,
+};
+
+dynarec_instr classify_instr(u32 op, bool fastmem)
+{
+    switch(op >> 26)
+    {
+        // special
+        case 0x00:
+        {
+            switch(op & 0x3f)
+            {
+                case 0x00: case 0x02: case 0x03: // sll, srl, sra
+                case 0x04: case 0x06: case 0x07: // sllv, srlv, srav
+                case 0x21: case 0x23: // addu, subu
+                case 0x24: case 0x25: case 0x26: case 0x27: // and, or, xor, nor
+                case 0x2a: case 0x2b: // slt, sltu
+                case 0x2d: case 0x2f: // daddu, dsubu
+                case 0x38: case 0x3a: case 0x3b: // dsll, dsrl, dsra
+                case 0x3c: case 0x3e: case 0x3f: // dsll32, dsrl32, dsra32
+                {
+                    return dynarec_instr::alu;
+                }
+
+                case 0x08: case 0x09: return dynarec_instr::branch; // jr, jalr
+
+                default: return dynarec_instr::fallback;
+            }
+        }
+
+        // regimm branches
+        case 0x01: return dynarec_instr::stop;
+
+        case 0x02: case 0x03: // j, jal
+        case 0x04: case 0x05: case 0x06: case 0x07: // beq, bne, blez, bgtz
+        {
+            return dynarec_instr::branch;
+        }
+
+        case 0x09: case 0x0a: case 0x0b: // addiu, slti, sltiu
+        case 0x0c: case 0x0d: case 0x0e: case 0x0f: // andi, ori, xori, lui
+        case 0x19: // daddiu
+        {
+            return dynarec_instr::alu;
+        }
+
+        // cop0 can remap memory, return from exceptions and change the interrupt state
+        case 0x10: return dynarec_instr::stop;
+
+        // bc1x
+        case 0x11: return get_rs(op) == 0x08? dynarec_instr::stop : dynarec_instr::fallback;
+
+        // branch likely
+        case 0x14: case 0x15: case 0x16: case 0x17: return dynarec_instr::stop;
+
+        case 0x20: case 0x21: case 0x23: // lb, lh, lw
+        case 0x24: case 0x25: case 0x27: // lbu, lhu, lwu
+        case 0x28: case 0x29: case 0x2b: // sb, sh, sw
+        {
+            return fastmem? dynarec_instr::fastmem : dynarec_instr::memory;
+        }
+
+        default:
+        {
+            // loads and stores
+            return (op >> 26) >= 0x20? dynarec_instr::memory : dynarec_instr::fallback;
+        }
+    }
+}
+
+// interpreter fallback, called from compiled code
+// returns non zero when the block has to exit (exception or the pc moved)
+u32 dynarec_fallback(N64* n64_ptr, u64 pc, u32 op, u32 cycles)
+{
+    auto& n64 = *n64_ptr;
+    auto& cpu = n64.cpu;
+
+    cycle_tick(n64,cycles);
+
+    // match what step would have setup before calling the handler
+    cpu.pc_fetch = pc;
+    cpu.pc = pc + beyond_all_repair::MIPS_INSTR_SIZE;
+    cpu.pc_next = pc + (beyond_all_repair::MIPS_INSTR_SIZE * 2);
+
+    // c++ exceptions cannot unwind through generated code, rethrow them once we are out
+    try
+    {
+        const Opcode opcode = beyond_all_repair::make_opcode(op);
+        call_handler<false>(n64,opcode,beyond_all_repair::calc_base_table_offset(opcode));
+    }
+
+    catch(...)
+    {
+        n64.dynarec.pending_exception = std::current_exception();
+        return true;
+    }
+
+    cpu.regs[beyond_all_repair::R0] = 0;
+
+    return cpu.pc != pc + beyond_all_repair::MIPS_INSTR_SIZE || cpu.pc_next != pc + (beyond_all_repair::MIPS_INSTR_SIZE * 2);
+}
+
+struct BlockInstr
+{
+    u64 pc;
+    u32 op;
+    dynarec_instr type;
+};
+
+// callee saved on both abis so they survive calls out to the interpreter
+static constexpr x64_reg HOST_REGS[] = {x64_reg::rbx,x64_reg::rbp,x64_reg::r12,x64_reg::r13,x64_reg::r14};
+static constexpr u32 HOST_REG_COUNT = sizeof(HOST_REGS) / sizeof(HOST_REGS[0]);
+
+// r15 holds the N64 pointer for the life of the block
+static constexpr x64_reg STATE = x64_reg::r15;
+
+// stack space for the win64 shadow area, keeps rsp 16 byte aligned after the pushes
+static constexpr s32 FRAME_SIZE = 40;
+
+// out of line path for a fastmem access, runs the interpreter handler and leaves the block
+struct SlowPath
+{
+    BlockInstr instr;
+
+    // compiler state at the start of the access
+    u32 dirty;
+    u32 pending;
+
+    // offsets into the block
+    size_t fast_start;
+    size_t fault;
+
+    // alignment and code page checks
+    size_t jump[2];
+    u32 jump_count;
+};
+
+struct BlockCompiler
+{
+    X64Emitter emit;
+
+    s32 reg_offset = 0;
+    s32 pc_offset = 0;
+    s32 pc_next_offset = 0;
+
+    // guest reg -> index into HOST_REGS, -1 when it lives in memory
+    s32 host[32];
+    u32 dirty = 0;
+
+    // cycles since the scheduler was last ticked
+    u32 pending = 0;
+
+    // instr costs, plus the extra for each fetch when the block is uncached
+    const CpiTable* cpi = nullptr;
+    u32 fetch = 0;
+
+    // null when fastmem is unavailable
+    u8* fastmem_base = nullptr;
+    const u8* code_present = nullptr;
+
+    std::vector<SlowPath> slow_paths;
+
+    u32 cost(u32 op) const
+    {
+        return instr_cycles(*cpi,op) + fetch;
+    }
+
+    s32 guest_offset(u32 reg) const
+    {
+        return reg_offset + s32(reg * sizeof(u64));
+    }
+
+    void load_guest(x64_reg dst, u32 reg)
+    {
+        if(reg == 0)
+        {
+            emit.alu(x64_alu::xor_,dst,dst,false);
+        }
+
+        else if(host[reg] != -1)
+        {
+            emit.mov(dst,HOST_REGS[host[reg]]);
+        }
+
+        else
+        {
+            emit.load(dst,STATE,guest_offset(reg));
+        }
+    }
+
+    void store_guest(u32 reg, x64_reg src)
+    {
+        // $zero is hardwired
+        if(reg == 0)
+        {
+            return;
+        }
+
+        if(host[reg] != -1)
+        {
+            emit.mov(HOST_REGS[host[reg]],src);
+            dirty = set_bit(dirty,reg);
+        }
+
+        else
+        {
+            emit.store(STATE,guest_offset(reg),src);
+        }
+    }
+
+    void writeback()
+    {
+        for(u32 reg = 1; reg < 32; reg++)
+        {
+            if(is_set(dirty,reg))
+            {
+                emit.store(STATE,guest_offset(reg),HOST_REGS[host[reg]]);
+            }
+        }
+
+        dirty = 0;
+    }
+
+    void reload()
+    {
+        for(u32 reg = 1; reg < 32; reg++)
+        {
+            if(host[reg] != -1)
+            {
+                emit.load(HOST_REGS[host[reg]],STATE,guest_offset(reg));
+            }
+        }
+    }
+
+    void prologue()
+    {
+        emit.push(x64_reg::rbx);
+        emit.push(x64_reg::rbp);
+        emit.push(x64_reg::r12);
+        emit.push(x64_reg::r13);
+        emit.push(x64_reg::r14);
+        emit.push(x64_reg::r15);
+        emit.alu_imm(x64_alu::sub,x64_reg::rsp,FRAME_SIZE);
+
+        emit.mov(STATE,X64_ARG[0]);
+        reload();
+    }
+
+    // guest regs must already be written back
+    void exit(u32 cycles)
+    {
+        emit.mov_imm(x64_reg::rax,cycles);
+        emit.alu_imm(x64_alu::add,x64_reg::rsp,FRAME_SIZE);
+        emit.pop(x64_reg::r15);
+        emit.pop(x64_reg::r14);
+        emit.pop(x64_reg::r13);
+        emit.pop(x64_reg::r12);
+        emit.pop(x64_reg::rbp);
+        emit.pop(x64_reg::rbx);
+        emit.ret();
+    }
+
+    // pc in rax
+    void write_pc()
+    {
+        emit.store(STATE,pc_offset,x64_reg::rax);
+        emit.alu_imm(x64_alu::add,x64_reg::rax,beyond_all_repair::MIPS_INSTR_SIZE);
+        emit.store(STATE,pc_next_offset,x64_reg::rax);
+    }
+
+    // 32 bit result in rax, sign extend it into rd
+    void store_sign_extended(u32 reg)
+    {
+        emit.sign_extend32(x64_reg::rax,x64_reg::rax);
+        store_guest(reg,x64_reg::rax);
+    }
+
+    void compile_alu(u32 op);
+    void compile_fallback(const BlockInstr& instr);
+    void compile_fastmem(const BlockInstr& instr);
+    void compile_slow_paths(Dynarec& dynarec);
+    void compile_branch(const BlockInstr& instr, const BlockInstr& delay_slot);
+    void compile_end(u64 pc);
+};
+
+void BlockCompiler::compile_alu(u32 op)
+{
+    const u32 rs = get_rs(op);
+    const u32 rt = get_rt(op);
+    const u32 rd = get_rd(op);
+    const u8 sa = get_shamt(op);
+
+    const u32 imm = op & 0xffff;
+    const s32 simm = s16(imm);
+
+    pending += cost(op);
+
+    if((op >> 26) == 0x00)
+    {
+        // none of these have side effects, writing $zero is a nop
+        if(rd == 0)
+        {
+            return;
+        }
+
+        switch(op & 0x3f)
+        {
+            // sll
+            case 0x00:
+            {
+                load_guest(x64_reg::rax,rt);
+                emit.shift_imm(x64_shift::shl,x64_reg::rax,sa,false);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // srl
+            case 0x02:
+            {
+                load_guest(x64_reg::rax,rt);
+                emit.shift_imm(x64_shift::shr,x64_reg::rax,sa,false);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // sra, shifted as 64 bit then clamped
+            case 0x03:
+            {
+                load_guest(x64_reg::rax,rt);
+                emit.shift_imm(x64_shift::sar,x64_reg::rax,sa);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // sllv
+            case 0x04:
+            {
+                load_guest(x64_reg::rax,rt);
+                load_guest(x64_reg::rcx,rs);
+                emit.shift_cl(x64_shift::shl,x64_reg::rax,false);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // srlv
+            case 0x06:
+            {
+                load_guest(x64_reg::rax,rt);
+                load_guest(x64_reg::rcx,rs);
+                emit.shift_cl(x64_shift::shr,x64_reg::rax,false);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // srav
+            case 0x07:
+            {
+                load_guest(x64_reg::rax,rt);
+                load_guest(x64_reg::rcx,rs);
+                emit.alu_imm(x64_alu::and_,x64_reg::rcx,0b11111,false);
+                emit.shift_cl(x64_shift::sar,x64_reg::rax);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // addu
+            case 0x21:
+            {
+                load_guest(x64_reg::rax,rs);
+                load_guest(x64_reg::rcx,rt);
+                emit.alu(x64_alu::add,x64_reg::rax,x64_reg::rcx,false);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // subu
+            case 0x23:
+            {
+                load_guest(x64_reg::rax,rs);
+                load_guest(x64_reg::rcx,rt);
+                emit.alu(x64_alu::sub,x64_reg::rax,x64_reg::rcx,false);
+                store_sign_extended(rd);
+                break;
+            }
+
+            // and, or, xor, nor, daddu, dsubu
+            case 0x24: case 0x25: case 0x26: case 0x27: case 0x2d: case 0x2f:
+            {
+                static constexpr x64_alu ALU_OP[] = {x64_alu::and_,x64_alu::or_,x64_alu::xor_,x64_alu::or_};
+
+                const u32 funct = op & 0x3f;
+                const x64_alu alu_op = funct == 0x2d? x64_alu::add : funct == 0x2f? x64_alu::sub : ALU_OP[funct - 0x24];
+
+                load_guest(x64_reg::rax,rs);
+                load_guest(x64_reg::rcx,rt);
+                emit.alu(alu_op,x64_reg::rax,x64_reg::rcx);
+
+                if(funct == 0x27)
+                {
+                    emit.not_(x64_reg::rax);
+                }
+
+                store_guest(rd,x64_reg::rax);
+                break;
+            }
+
+            // slt, sltu
+            case 0x2a: case 0x2b:
+            {
+                load_guest(x64_reg::rax,rs);
+                load_guest(x64_reg::rcx,rt);
+                emit.alu(x64_alu::cmp,x64_reg::rax,x64_reg::rcx);
+                emit.set((op & 0x3f) == 0x2a? x64_cond::l : x64_cond::b,x64_reg::rax);
+                store_guest(rd,x64_reg::rax);
+                break;
+            }
+
+            // dsll, dsrl, dsra, dsll32, dsrl32, dsra32
+            case 0x38: case 0x3a: case 0x3b: case 0x3c: case 0x3e: case 0x3f:
+            {
+                static constexpr x64_shift SHIFT_OP[] = {x64_shift::shl,x64_shift::shl,x64_shift::shr,x64_shift::sar};
+
+                const u32 funct = op & 0x3f;
+                const u8 amount = sa + (funct >= 0x3c? 32 : 0);
+
+                load_guest(x64_reg::rax,rt);
+                emit.shift_imm(SHIFT_OP[funct & 3],x64_reg::rax,amount);
+                store_guest(rd,x64_reg::rax);
+                break;
+            }
+        }
+
+        return;
+    }
+
+    if(rt == 0)
+    {
+        return;
+    }
+
+    switch(op >> 26)
+    {
+        // addiu
+        case 0x09:
+        {
+            load_guest(x64_reg::rax,rs);
+            emit.alu_imm(x64_alu::add,x64_reg::rax,simm,false);
+            store_sign_extended(rt);
+            break;
+        }
+
+        // slti, sltiu (imm is sign extended for both)
+        case 0x0a: case 0x0b:
+        {
+            load_guest(x64_reg::rax,rs);
+            emit.alu_imm(x64_alu::cmp,x64_reg::rax,simm);
+            emit.set((op >> 26) == 0x0a? x64_cond::l : x64_cond::b,x64_reg::rax);
+            store_guest(rt,x64_reg::rax);
+            break;
+        }
+
+        // andi, ori, xori (imm is zero extended)
+        case 0x0c: case 0x0d: case 0x0e:
+        {
+            static constexpr x64_alu ALU_OP[] = {x64_alu::and_,x64_alu::or_,x64_alu::xor_};
+
+            load_guest(x64_reg::rax,rs);
+            emit.alu_imm(ALU_OP[(op >> 26) - 0x0c],x64_reg::rax,s32(imm));
+            store_guest(rt,x64_reg::rax);
+            break;
+        }
+
+        // lui
+        case 0x0f:
+        {
+            emit.mov_imm(x64_reg::rax,sign_extend_mips<s64,s32>(imm << 16));
+            store_guest(rt,x64_reg::rax);
+            break;
+        }
+
+        // daddiu
+        case 0x19:
+        {
+            load_guest(x64_reg::rax,rs);
+            emit.alu_imm(x64_alu::add,x64_reg::rax,simm);
+            store_guest(rt,x64_reg::rax);
+            break;
+        }
+    }
+}
+
+void BlockCompiler::compile_fallback(const BlockInstr& instr)
+{
+    // the handler sees and may modify any guest reg
+    writeback();
+
+    emit.mov(X64_ARG[0],STATE);
+    emit.mov_imm(X64_ARG[1],instr.pc);
+    emit.mov_imm(X64_ARG[2],instr.op);
+
+    // the handler may look at the time, so it has to be up to date with everything before it
+    emit.mov_imm(X64_ARG[3],pending);
+    emit.call((const void*)&dynarec_fallback);
+
+    reload();
+
+    emit.test(x64_reg::rax,x64_reg::rax,false);
+    const size_t patch = emit.jcc(x64_cond::e);
+    exit(cost(instr.op));
+    emit.bind(patch);
+
+    // this instr is charged once it has run
+    pending = cost(instr.op);
+}
+
+void BlockCompiler::compile_fastmem(const BlockInstr& instr)
+{
+    const u32 op = instr.op;
+    const u32 opcode = op >> 26;
+    const u32 rs = get_rs(op);
+    const u32 rt = get_rt(op);
+    const s32 simm = s16(op & 0xffff);
+
+    static constexpr u32 ACCESS_SIZE[8] = {1,2,0,4,1,2,0,4};
+    const u32 size = ACCESS_SIZE[opcode & 0b111];
+    const bool store = opcode >= 0x28;
+
+    SlowPath slow;
+    slow.instr = instr;
+    slow.dirty = dirty;
+    slow.pending = pending;
+    slow.fast_start = emit.offset;
+    slow.jump_count = 0;
+
+    pending += cost(op);
+
+    // only the low 32 bits of the vaddr take part in translation
+    load_guest(x64_reg::rax,rs);
+    emit.alu_imm(x64_alu::add,x64_reg::rax,simm,false);
+
+    // let the handler raise the address error
+    if(size > 1)
+    {
+        emit.test_imm(x64_reg::rax,size - 1,false);
+        slow.jump[slow.jump_count++] = emit.jcc(x64_cond::ne);
+    }
+
+    // writing over code has to go through invalidation
+    if(store)
+    {
+        emit.mov(x64_reg::rcx,x64_reg::rax);
+        emit.alu_imm(x64_alu::and_,x64_reg::rcx,0x1FFF'FFFF,false);
+        emit.shift_imm(x64_shift::shr,x64_reg::rcx,CODE_PAGE_SHIFT,false);
+        emit.mov_imm(x64_reg::rdx,u64(code_present));
+        emit.alu(x64_alu::add,x64_reg::rdx,x64_reg::rcx);
+        emit.load8(x64_reg::rcx,x64_reg::rdx,0,false);
+        emit.test(x64_reg::rcx,x64_reg::rcx,false);
+        slow.jump[slow.jump_count++] = emit.jcc(x64_cond::ne);
+    }
+
+    // memory is held as big endian words
+    if(size == 1)
+    {
+        emit.alu_imm(x64_alu::xor_,x64_reg::rax,3,false);
+    }
+
+    else if(size == 2)
+    {
+        emit.alu_imm(x64_alu::xor_,x64_reg::rax,2,false);
+    }
+
+    emit.mov_imm(x64_reg::rcx,u64(fastmem_base));
+    emit.alu(x64_alu::add,x64_reg::rax,x64_reg::rcx);
+
+    if(store)
+    {
+        load_guest(x64_reg::rcx,rt);
+    }
+
+    // anything other than rdram or rom faults here
+    slow.fault = emit.offset;
+
+    switch(opcode)
+    {
+        // lb, lbu
+        case 0x20: case 0x24: emit.load8(x64_reg::rax,x64_reg::rax,0,opcode == 0x20); break;
+
+        // lh, lhu
+        case 0x21: case 0x25: emit.load16(x64_reg::rax,x64_reg::rax,0,opcode == 0x21); break;
+
+        // lw
+        case 0x23:
+        {
+            emit.load32(x64_reg::rax,x64_reg::rax,0);
+            emit.sign_extend32(x64_reg::rax,x64_reg::rax);
+            break;
+        }
+
+        // lwu
+        case 0x27: emit.load32(x64_reg::rax,x64_reg::rax,0); break;
+
+        case 0x28: emit.store8(x64_reg::rax,0,x64_reg::rcx); break;
+        case 0x29: emit.store16(x64_reg::rax,0,x64_reg::rcx); break;
+        case 0x2b: emit.store32(x64_reg::rax,0,x64_reg::rcx); break;
+    }
+
+    if(!store)
+    {
+        store_guest(rt,x64_reg::rax);
+    }
+
+    slow_paths.push_back(slow);
+}
+
+// placed after the block so the inline path falls straight through
+void BlockCompiler::compile_slow_paths(Dynarec& dynarec)
+{
+    const u32 base = u32(emit.buf - dynarec.code);
+
+    for(const auto& slow : slow_paths)
+    {
+        const size_t start = emit.offset;
+
+        for(u32 i = 0; i < slow.jump_count; i++)
+        {
+            emit.bind_to(slow.jump[i],start);
+        }
+
+        // the interpreter redoes the whole access
+        dirty = slow.dirty;
+        writeback();
+
+        emit.mov(X64_ARG[0],STATE);
+        emit.mov_imm(X64_ARG[1],slow.instr.pc);
+        emit.mov_imm(X64_ARG[2],slow.instr.op);
+        emit.mov_imm(X64_ARG[3],slow.pending);
+        emit.call((const void*)&dynarec_fallback);
+
+        // the handler has already setup the pc, just the cost of the access is left
+        exit(cost(slow.instr.op));
+
+        // slow paths are in program order, and blocks only ever go after the last one
+        // so this keeps the sites sorted
+        dynarec.fault_sites.push_back({base + u32(slow.fault),base + u32(slow.fast_start),base + u32(start)});
+    }
+}
+
+void BlockCompiler::compile_branch(const BlockInstr& instr, const BlockInstr& delay_slot)
+{
+    const u32 op = instr.op;
+    const u32 rs = get_rs(op);
+    const u32 rt = get_rt(op);
+
+    // the interpreter sees the pc of the delay slot when it runs a branch
+    const u64 pc = instr.pc + beyond_all_repair::MIPS_INSTR_SIZE;
+    const u64 link = instr.pc + (beyond_all_repair::MIPS_INSTR_SIZE * 2);
+    const u64 branch_target = compute_branch_addr(pc,op & 0xffff);
+
+    bool conditional = false;
+    bool indirect = false;
+
+    pending += cost(op);
+
+    // condition and target are taken before the delay slot runs
+    // r8 holds an indirect target, r9 the condition
+    switch(op >> 26)
+    {
+        case 0x00:
+        {
+            indirect = true;
+            load_guest(x64_reg::r8,rs);
+
+            // jalr
+            if((op & 0x3f) == 0x09)
+            {
+                emit.mov_imm(x64_reg::rax,link);
+                store_guest(get_rd(op),x64_reg::rax);
+            }
+            break;
+        }
+
+        // jal
+        case 0x03:
+        {
+            emit.mov_imm(x64_reg::rax,link);
+            store_guest(beyond_all_repair::RA,x64_reg::rax);
+            break;
+        }
+
+        // beq, bne
+        case 0x04: case 0x05:
+        {
+            conditional = true;
+            load_guest(x64_reg::rax,rs);
+            load_guest(x64_reg::rcx,rt);
+            emit.alu(x64_alu::cmp,x64_reg::rax,x64_reg::rcx);
+            emit.set((op >> 26) == 0x04? x64_cond::e : x64_cond::ne,x64_reg::r9);
+            break;
+        }
+
+        // blez, bgtz
+        case 0x06: case 0x07:
+        {
+            conditional = true;
+            load_guest(x64_reg::rax,rs);
+            emit.alu_imm(x64_alu::cmp,x64_reg::rax,0);
+            emit.set((op >> 26) == 0x06? x64_cond::le : x64_cond::g,x64_reg::r9);
+            break;
+        }
+
+        // j
+        default: break;
+    }
+
+    compile_alu(delay_slot.op);
+
+    if(indirect)
+    {
+        emit.mov(x64_reg::rax,x64_reg::r8);
+    }
+
+    else if(conditional)
+    {
+        emit.mov_imm(x64_reg::rax,link);
+        emit.mov_imm(x64_reg::rcx,branch_target);
+        emit.test(x64_reg::r9,x64_reg::r9);
+        emit.cmov(x64_cond::ne,x64_reg::rax,x64_reg::rcx);
+    }
+
+    else
+    {
+        emit.mov_imm(x64_reg::rax,get_target(op,pc));
+    }
+
+    write_pc();
+    writeback();
+    exit(pending);
+}
+
+void BlockCompiler::compile_end(u64 pc)
+{
+    emit.mov_imm(x64_reg::rax,pc);
+    write_pc();
+    writeback();
+    exit(pending);
+}
+
+BlockFunc compile_block(N64& n64, u64 pc, u32 paddr, u32& cycles)
+{
+    auto& dynarec = n64.dynarec;
+    const bool fastmem = n64.mem.fastmem.base != nullptr;
+
+    // find the extent of the block, it never leaves the page
+    BlockInstr instrs[MAX_BLOCK_INSTRS];
+    u32 count = 0;
+    cycles = 0;
+
+    const u32 fetch = fetch_cycles(n64.cpi,pc);
+    bool branch = false;
+
+    while(count < MAX_BLOCK_INSTRS)
+    {
+        const u32 op = read_physical<u32>(n64,paddr);
+        const auto type = classify_instr(op,fastmem);
+
+        if(type == dynarec_instr::stop)
+        {
+            break;
+        }
+
+        if(type == dynarec_instr::branch)
+        {
+            const u32 slot_addr = paddr + beyond_all_repair::MIPS_INSTR_SIZE;
+
+            if(count + 2 > MAX_BLOCK_INSTRS || (slot_addr & 0xfff) == 0)
+            {
+                break;
+            }
+
+            // only take branches whose delay slot we can compile inline
+            const u32 slot = read_physical<u32>(n64,slot_addr);
+
+            if(classify_instr(slot,fastmem) != dynarec_instr::alu)
+            {
+                break;
+            }
+
+            instrs[count++] = {pc,op,type};
+            instrs[count++] = {pc + beyond_all_repair::MIPS_INSTR_SIZE,slot,dynarec_instr::alu};
+            cycles += instr_cycles(n64.cpi,op) + instr_cycles(n64.cpi,slot) + (fetch * 2);
+            branch = true;
+            break;
+        }
+
+        instrs[count++] = {pc,op,type};
+        cycles += instr_cycles(n64.cpi,op) + fetch;
+
+        pc += beyond_all_repair::MIPS_INSTR_SIZE;
+        paddr += beyond_all_repair::MIPS_INSTR_SIZE;
+
+        if((paddr & 0xfff) == 0)
+        {
+            break;
+        }
+    }
+
+    if(count == 0)
+    {
+        return nullptr;
+    }
+
+    // open up everything past the last block, however large this one turns out
+    const size_t free_offset = dynarec.code_offset;
+    const size_t free_size = dynarec.code_size - free_offset;
+    protect_code(dynarec,free_offset,free_size,true);
+
+    BlockCompiler compiler;
+    compiler.emit.buf = &dynarec.code[dynarec.code_offset];
+    compiler.emit.size = dynarec.code_size - dynarec.code_offset;
+
+    compiler.reg_offset = s32((u8*)&n64.cpu.regs[0] - (u8*)&n64);
+    compiler.pc_offset = s32((u8*)&n64.cpu.pc - (u8*)&n64);
+    compiler.pc_next_offset = s32((u8*)&n64.cpu.pc_next - (u8*)&n64);
+    compiler.fastmem_base = n64.mem.fastmem.base;
+    compiler.code_present = dynarec.code_present.data();
+    compiler.cpi = &n64.cpi;
+    compiler.fetch = fetch;
+
+    // give the most used guest regs in inline code a host reg
+    u32 uses[32] = {0};
+
+    for(u32 i = 0; i < count; i++)
+    {
+        const auto type = instrs[i].type;
+
+        if(type == dynarec_instr::alu || type == dynarec_instr::branch || type == dynarec_instr::fastmem)
+        {
+            const u32 op = instrs[i].op;
+
+            uses[get_rs(op)]++;
+            uses[get_rt(op)]++;
+
+            if((op >> 26) == 0x00)
+            {
+                uses[get_rd(op)]++;
+            }
+        }
+    }
+
+    for(u32 reg = 0; reg < 32; reg++)
+    {
+        compiler.host[reg] = -1;
+    }
+
+    for(u32 h = 0; h < HOST_REG_COUNT; h++)
+    {
+        u32 best = 0;
+
+        for(u32 reg = 1; reg < 32; reg++)
+        {
+            if(compiler.host[reg] == -1 && uses[reg] > uses[best])
+            {
+                best = reg;
+            }
+        }
+
+        // not worth the load and store
+        if(uses[best] < 2)
+        {
+            break;
+        }
+
+        compiler.host[best] = h;
+        uses[best] = 0;
+    }
+
+    compiler.prologue();
+
+    for(u32 i = 0; i < count; i++)
+    {
+        const auto& instr = instrs[i];
+
+        switch(instr.type)
+        {
+            case dynarec_instr::alu: compiler.compile_alu(instr.op); break;
+            case dynarec_instr::fastmem: compiler.compile_fastmem(instr); break;
+
+            case dynarec_instr::fallback:
+            case dynarec_instr::memory:
+            {
+                compiler.compile_fallback(instr);
+                break;
+            }
+
+            case dynarec_instr::branch:
+            {
+                compiler.compile_branch(instr,instrs[i + 1]);
+                i++;
+                break;
+            }
+
+            case dynarec_instr::stop: break;
+        }
+    }
+
+    if(!branch)
+    {
+        compiler.compile_end(instrs[count - 1].pc + beyond_all_repair::MIPS_INSTR_SIZE);
+    }
+
+    compiler.compile_slow_paths(dynarec);
+
+    const auto func = (BlockFunc)compiler.emit.buf;
+    dynarec.code_offset += compiler.emit.offset;
+
+    protect_code(dynarec,free_offset,free_size,false);
+
+    return func;
+}
+
+#ifdef N64_FASTMEM
+
+// dynarec running a block on this thread, if any
+thread_local Dynarec* fault_dynarec = nullptr;
+
+struct sigaction old_segv_action;
+
+// not ours, hand it to whatever was installed before us and stay installed
+void chain_segv(int sig, siginfo_t* info, void* context)
+{
+    if(old_segv_action.sa_flags & SA_SIGINFO)
+    {
+        old_segv_action.sa_sigaction(sig,info,context);
+        return;
+    }
+
+    if(old_segv_action.sa_handler != SIG_DFL && old_segv_action.sa_handler != SIG_IGN)
+    {
+        old_segv_action.sa_handler(sig);
+        return;
+    }
+
+    // the default action ends the process, so let the access fault again and take it
+    // an ignored segv would only spin on the same instr
+    struct sigaction action = {};
+    action.sa_handler = SIG_DFL;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV,&action,nullptr);
+}
+
+// a fastmem access hit something that is not plain memory, resume at its slow path
+// only plain reads and a lock free store in here, the sites are sorted up front so there is no map to search
+void fastmem_fault_handler(int sig, siginfo_t* info, void* context)
+{
+    auto* uc = (ucontext_t*)context;
+    Dynarec* dynarec = fault_dynarec;
+    const u8* rip = (const u8*)uc->uc_mcontext.gregs[REG_RIP];
+
+    if(dynarec && rip >= dynarec->code && rip < dynarec->code + dynarec->code_offset)
+    {
+        const u32 offset = u32(rip - dynarec->code);
+        const FaultSite* sites = dynarec->fault_sites.data();
+
+        u32 lo = 0;
+        u32 hi = u32(dynarec->fault_sites.size());
+
+        while(lo < hi)
+        {
+            const u32 mid = (lo + hi) / 2;
+
+            if(sites[mid].fault < offset)
+            {
+                lo = mid + 1;
+            }
+
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        if(lo < dynarec->fault_sites.size() && sites[lo].fault == offset)
+        {
+            // the code cannot be written from here, the slow path exits the block and run_block patches it
+            dynarec->pending_fault.store(lo,std::memory_order_relaxed);
+            uc->uc_mcontext.gregs[REG_RIP] = greg_t(dynarec->code + sites[lo].slow_path);
+            return;
+        }
+    }
+
+    chain_segv(sig,info,context);
+}
+
+// point an access that faulted at its slow path for good
+void patch_fault_site(Dynarec& dynarec)
+{
+    const u32 idx = dynarec.pending_fault.exchange(NO_FAULT,std::memory_order_relaxed);
+
+    if(idx >= dynarec.fault_sites.size())
+    {
+        return;
+    }
+
+    const FaultSite& site = dynarec.fault_sites[idx];
+
+    // a rel32 jmp
+    static constexpr size_t JMP_SIZE = 5;
+    protect_code(dynarec,site.patch,JMP_SIZE,true);
+
+    X64Emitter emit;
+    emit.buf = dynarec.code;
+    emit.size = dynarec.code_size;
+    emit.offset = site.patch;
+    emit.bind_to(emit.jmp(),site.slow_path);
+
+    protect_code(dynarec,site.patch,JMP_SIZE,false);
+}
+
+void install_fastmem_handler()
+{
+    static std::once_flag once;
+
+    std::call_once(once,[]()
+    {
+        struct sigaction action = {};
+        action.sa_sigaction = fastmem_fault_handler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+
+        sigaction(SIGSEGV,&action,&old_segv_action);
+    });
+}
+
+#endif
+
+b32 run_block(N64& n64)
+{
+    auto& cpu = n64.cpu;
+    auto& dynarec = n64.dynarec;
+
+    // the interpreter has to finish off a branch it started
+    if(!dynarec.enabled || cpu.branch_delay == branch_delay_state::start)
+    {
+        return false;
+    }
+
+    const u64 pc = cpu.pc;
+    const auto paddr_opt = code_paddr(pc);
+
+    if(!paddr_opt)
+    {
+        return false;
+    }
+
+    const u32 paddr = *paddr_opt;
+
+    // out of space, throw everything away and start again
+    if(dynarec.code_size - dynarec.code_offset < MAX_BLOCK_BYTES)
+    {
+        reset_dynarec(dynarec);
+    }
+
+    auto& page = dynarec.pages[paddr >> CODE_PAGE_SHIFT];
+
+    if(!page)
+    {
+        page = std::make_unique<CodePage>();
+        dynarec.code_present[paddr >> CODE_PAGE_SHIFT] |= PAGE_HAS_CODE;
+    }
+
+    // kseg0 / kseg1, zero / sign extended
+    const u32 variant = (u32(pc >> 29) & 1) | (u32(pc >> 62) & 2);
+    auto& block = page->block[variant][(paddr & 0xfff) >> 2];
+
+    if(!block.func)
+    {
+        if(block.cycles == BLOCK_INTERPRET)
+        {
+            return false;
+        }
+
+#ifdef N64_FASTMEM
+        if(n64.mem.fastmem.base)
+        {
+            install_fastmem_handler();
+        }
+#endif
+
+        block.func = compile_block(n64,pc,paddr,block.cycles);
+
+        if(!block.func)
+        {
+            block.cycles = BLOCK_INTERPRET;
+            return false;
+        }
+    }
+
+    // leave the last stretch before an event to the interpreter so events land on time
+    if(block.cycles > n64.scheduler.get_next_event_cycles())
+    {
+        return false;
+    }
+
+    cpu.branch_delay = branch_delay_state::end;
+
+#ifdef N64_FASTMEM
+    fault_dynarec = &dynarec;
+    const u32 cycles = block.func(&n64);
+    fault_dynarec = nullptr;
+
+    patch_fault_site(dynarec);
+#else
+    const u32 cycles = block.func(&n64);
+#endif
+
+    cycle_tick(n64,cycles);
+
+    if(dynarec.pending_exception)
+    {
+        std::rethrow_exception(std::exchange(dynarec.pending_exception,nullptr));
+    }
+
+    return true;
+}
+
+#else
+
+b32 run_block(N64& n64)
+{
+    UNUSED(n64);
+    return false;
+}
+
+#endif
+
+}
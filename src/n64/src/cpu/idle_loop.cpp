@@ -0,0 +1,386 @@
+#include <n64/n64.h>
+
+namespace nintendo64
+{
+
+void reset_idle_loops(IdleLoops& idle_loops)
+{
+    const b32 enabled = idle_loops.enabled;
+    idle_loops = {};
+    idle_loops.enabled = enabled;
+}
+
+// what one instr of a candidate loop does with the registers
+struct IdleOp
+{
+    b32 valid = false;
+    b32 branch = false;
+    b32 load = false;
+
+    // mask of the registers read, and the one written (0 for none)
+    u32 src = 0;
+    u32 dst = 0;
+};
+
+IdleOp decode_idle_op(u32 op)
+{
+    IdleOp out;
+
+    const u32 rs = (op >> 21) & 0x1f;
+    const u32 rt = (op >> 16) & 0x1f;
+    const u32 rd = (op >> 11) & 0x1f;
+
+    switch(op >> 26)
+    {
+        // special, anything that only moves registers about and cannot trap
+        case 0x00:
+        {
+            switch(op & 0x3f)
+            {
+                case 0x00: case 0x02: case 0x03: // sll, srl, sra
+                case 0x38: case 0x3a: case 0x3b: // dsll, dsrl, dsra
+                case 0x3c: case 0x3e: case 0x3f: // dsll32, dsrl32, dsra32
+                {
+                    out = {true,false,false,1u << rt,rd};
+                    break;
+                }
+
+                case 0x04: case 0x06: case 0x07: // sllv, srlv, srav
+                case 0x21: case 0x23: // addu, subu
+                case 0x24: case 0x25: case 0x26: case 0x27: // and, or, xor, nor
+                case 0x2a: case 0x2b: // slt, sltu
+                case 0x2d: case 0x2f: // daddu, dsubu
+                {
+                    out = {true,false,false,(1u << rs) | (1u << rt),rd};
+                    break;
+                }
+            }
+            break;
+        }
+
+        // regimm bltz, bgez, bltzl, bgezl
+        case 0x01:
+        {
+            if(rt <= 0x03)
+            {
+                out = {true,true,false,1u << rs,0};
+            }
+            break;
+        }
+
+        // j
+        case 0x02: out = {true,true,false,0,0}; break;
+
+        // beq, bne, beql, bnel
+        case 0x04: case 0x05: case 0x14: case 0x15:
+        {
+            out = {true,true,false,(1u << rs) | (1u << rt),0};
+            break;
+        }
+
+        // blez, bgtz, blezl, bgtzl
+        case 0x06: case 0x07: case 0x16: case 0x17:
+        {
+            out = {true,true,false,1u << rs,0};
+            break;
+        }
+
+        // addiu, slti, sltiu, andi, ori, xori, daddiu
+        case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x19:
+        {
+            out = {true,false,false,1u << rs,rt};
+            break;
+        }
+
+        // lui
+        case 0x0f: out = {true,false,false,0,rt}; break;
+
+        // lb, lh, lw, lbu, lhu, lwu, ld
+        case 0x20: case 0x21: case 0x23: case 0x24: case 0x25: case 0x27: case 0x37:
+        {
+            out = {true,false,true,1u << rs,rt};
+            break;
+        }
+    }
+
+    // $zero is never really written
+    if(out.dst == beyond_all_repair::R0)
+    {
+        out.dst = 0;
+    }
+
+    return out;
+}
+
+// a loop can only be skipped if it goes round the same way every time, so every register
+// it reads has to either be left alone by the loop, or be set earlier in the same trip
+void analyse_idle_loop(N64& n64, IdleLoop& loop, u64 pc, u32 paddr)
+{
+    loop = {};
+    loop.pc = pc;
+
+    u32 written = 0;
+    u32 cycles = 0;
+    s32 branch_at = -1;
+
+    for(u32 i = 0; i < IDLE_LOOP_MAX_INSTRS && paddr + (i * sizeof(u32)) < CODE_REGION_END; i++)
+    {
+        const u32 op = read_physical<u32>(n64,paddr + (i * sizeof(u32)));
+        loop.op[i] = op;
+        loop.len = i + 1;
+
+        const auto idle_op = decode_idle_op(op);
+
+        if(!idle_op.valid)
+        {
+            return;
+        }
+
+        cycles += instr_cycles(n64.cpi,op) + fetch_cycles(n64.cpi,pc);
+
+        const b32 delay_slot = branch_at != -1;
+
+        if(idle_op.branch)
+        {
+            const u64 branch_pc = pc + (i * sizeof(u32));
+            const u64 target = (op >> 26) == 0x02? get_target(op,branch_pc + 4) : compute_branch_addr(branch_pc + 4,op & 0xffff);
+
+            // has to close the loop, and cant sit in a delay slot
+            if(delay_slot || target != pc)
+            {
+                return;
+            }
+
+            branch_at = i;
+            continue;
+        }
+
+        written |= idle_op.dst? (1u << idle_op.dst) : 0;
+
+        if(delay_slot)
+        {
+            break;
+        }
+    }
+
+    if(branch_at == -1 || loop.len != u32(branch_at) + 2)
+    {
+        return;
+    }
+
+    u32 defined = 0;
+
+    for(u32 i = 0; i < loop.len; i++)
+    {
+        const auto idle_op = decode_idle_op(loop.op[i]);
+
+        if(idle_op.src & written & ~defined)
+        {
+            return;
+        }
+
+        defined |= idle_op.dst? (1u << idle_op.dst) : 0;
+    }
+
+    loop.idle = true;
+    loop.cycles = cycles;
+}
+
+// rdram and registers that only ever change in a scheduler event, and have no side effect on a read
+b32 idle_readable(u32 paddr)
+{
+    if(paddr < RD_RAM_SIZE)
+    {
+        return true;
+    }
+
+    switch(paddr)
+    {
+        case MI_MODE: case MI_VERSION: case MI_INTERRUPT: case MI_INTR_MASK:
+        case VI_CURRENT:
+        case SP_STATUS: case SP_DMA_BUSY: case SP_DMA_FULL:
+        case DPC_STATUS:
+        case AI_STATUS: case AI_LENGTH:
+        case PI_STATUS:
+        case SI_STATUS:
+        {
+            return true;
+        }
+
+        default: return false;
+    }
+}
+
+b32 idle_load(N64& n64, u32 op)
+{
+    auto& regs = n64.cpu.regs;
+
+    const u32 rt = (op >> 16) & 0x1f;
+    const u64 vaddr = regs[(op >> 21) & 0x1f] + sign_extend_mips<s64,s16>(op & 0xffff);
+
+    u32 size = sizeof(u32);
+
+    switch(op >> 26)
+    {
+        case 0x20: case 0x24: size = sizeof(u8); break;
+        case 0x21: case 0x25: size = sizeof(u16); break;
+        case 0x37: size = sizeof(u64); break;
+    }
+
+    // only direct mapped, so nothing here can fault
+    const u32 upper = u32(vaddr >> 32);
+    const u32 segment = u32(vaddr >> 29) & 0b111;
+
+    if((upper != 0 && upper != 0xffff'ffff) || (segment != 0b100 && segment != 0b101) || (vaddr & (size - 1)))
+    {
+        return false;
+    }
+
+    const u32 paddr = u32(vaddr) & 0x1FFF'FFFF;
+
+    if(!idle_readable(paddr))
+    {
+        return false;
+    }
+
+    u64 v = 0;
+
+    switch(op >> 26)
+    {
+        case 0x20: v = sign_extend_mips<s64,s8>(read_physical<u8>(n64,paddr)); break;
+        case 0x21: v = sign_extend_mips<s64,s16>(read_physical<u16>(n64,paddr)); break;
+        case 0x23: v = sign_extend_mips<s64,s32>(read_physical<u32>(n64,paddr)); break;
+        case 0x24: v = read_physical<u8>(n64,paddr); break;
+        case 0x25: v = read_physical<u16>(n64,paddr); break;
+        case 0x27: v = read_physical<u32>(n64,paddr); break;
+        case 0x37: v = read_physical<u64>(n64,paddr); break;
+    }
+
+    regs[rt] = v;
+    regs[beyond_all_repair::R0] = 0;
+
+    return true;
+}
+
+b32 idle_branch_taken(const Cpu& cpu, u32 op)
+{
+    const s64 rs = s64(cpu.regs[(op >> 21) & 0x1f]);
+    const s64 rt = s64(cpu.regs[(op >> 16) & 0x1f]);
+
+    switch(op >> 26)
+    {
+        case 0x01: return (op >> 16) & 1? rs >= 0 : rs < 0;
+        case 0x02: return true;
+        case 0x04: case 0x14: return rs == rt;
+        case 0x05: case 0x15: return rs != rt;
+        case 0x06: case 0x16: return rs <= 0;
+        case 0x07: case 0x17: return rs > 0;
+    }
+
+    return false;
+}
+
+// go round once for real against the registers, only keeping it if it comes back to the head
+b32 run_idle_trip(N64& n64, const IdleLoop& loop)
+{
+    auto& cpu = n64.cpu;
+
+    u64 saved[32];
+    memcpy(saved,cpu.regs,sizeof(saved));
+
+    b32 taken = false;
+
+    for(u32 i = 0; i < loop.len; i++)
+    {
+        const u32 op = loop.op[i];
+        const auto idle_op = decode_idle_op(op);
+
+        if(idle_op.branch)
+        {
+            taken = idle_branch_taken(cpu,op);
+
+            if(!taken)
+            {
+                break;
+            }
+        }
+
+        else if(idle_op.load)
+        {
+            if(!idle_load(n64,op))
+            {
+                taken = false;
+                break;
+            }
+        }
+
+        else
+        {
+            const Opcode opcode = beyond_all_repair::make_opcode(op);
+            decode_handler(opcode)(n64,opcode);
+            cpu.regs[beyond_all_repair::R0] = 0;
+        }
+    }
+
+    if(!taken)
+    {
+        memcpy(cpu.regs,saved,sizeof(saved));
+    }
+
+    return taken;
+}
+
+b32 skip_idle_loop(N64& n64)
+{
+    auto& cpu = n64.cpu;
+    auto& scheduler = n64.scheduler;
+
+    // the pc has to be a loop head, not the delay slot of a branch
+    if(!n64.idle_loops.enabled || cpu.branch_delay == branch_delay_state::start || scheduler.event_ready())
+    {
+        return false;
+    }
+
+    const auto paddr_opt = code_paddr(cpu.pc);
+
+    if(!paddr_opt)
+    {
+        return false;
+    }
+
+    const u32 paddr = *paddr_opt;
+    auto& loop = n64.idle_loops.cache[(paddr >> 2) & (IDLE_LOOP_CACHE_SIZE - 1)];
+
+    // anything cached for this pc is only good while the code under it is the same
+    b32 stale = loop.pc != cpu.pc || !loop.len;
+
+    for(u32 i = 0; i < loop.len && !stale; i++)
+    {
+        stale = read_physical<u32>(n64,paddr + (i * sizeof(u32))) != loop.op[i];
+    }
+
+    if(stale)
+    {
+        analyse_idle_loop(n64,loop,cpu.pc,paddr);
+    }
+
+    // whole trips only, so the pc sits where stepping would have it when the event fires
+    const u64 trips = std::min<u64>(scheduler.get_next_event_cycles(),0xffff'ffff) / std::max(1u,loop.cycles);
+
+    if(!loop.idle || !trips || !run_idle_trip(n64,loop))
+    {
+        return false;
+    }
+
+    const u32 cycles = u32(trips * loop.cycles);
+
+    // count and random follow the timestamp on their own
+    scheduler.delay_tick(cycles);
+
+    cpu.pc_fetch = cpu.pc + ((loop.len - 1) * sizeof(u32));
+    n64.idle_loops.cycles_skipped += cycles;
+
+    return true;
+}
+
+}
@@ -0,0 +1,147 @@
+#include <n64/n64.h>
+
+namespace nintendo64
+{
+
+void reset_instr_cache(InstrCache& cache)
+{
+    for(auto& page : cache.pages)
+    {
+        page.reset();
+    }
+
+    cache.generation++;
+}
+
+// resolve special and regimm up front, so the run loop calls the final handler
+INSTR_FUNC decode_handler(const Opcode& opcode)
+{
+    switch(opcode.op >> 26)
+    {
+        case 0x00: return INSTR_TABLE_NO_DEBUG[beyond_all_repair::SPECIAL_OFFSET + ((opcode.op >> beyond_all_repair::SPECIAL_SHIFT) & beyond_all_repair::FUNCT_MASK)];
+        case 0x01: return INSTR_TABLE_NO_DEBUG[beyond_all_repair::REGIMM_OFFSET + ((opcode.op >> beyond_all_repair::REGIMM_SHIFT) & beyond_all_repair::REGIMM_MASK)];
+
+        default: return INSTR_TABLE_NO_DEBUG[beyond_all_repair::calc_base_table_offset(opcode)];
+    }
+}
+
+void decode_page(N64& n64, DecodedPage& page, u32 paddr)
+{
+    const u32 base = paddr & ~(CODE_PAGE_SIZE - 1);
+
+    for(u32 i = 0; i < CODE_PAGE_INSTRS; i++)
+    {
+        const u32 op = read_physical<u32>(n64,base + (i * beyond_all_repair::MIPS_INSTR_SIZE));
+
+        auto& instr = page.instr[i];
+        instr.opcode = beyond_all_repair::make_opcode(op);
+        instr.handler = decode_handler(instr.opcode);
+        instr.cycles = instr_cycles(n64.cpi,op);
+        instr.cpu_only = instr_cpu_only(op);
+    }
+}
+
+b32 run_cached(N64& n64)
+{
+    auto& cpu = n64.cpu;
+    auto& cache = n64.instr_cache;
+
+    // the interpreter has to finish off a branch it started
+    if(cpu.branch_delay == branch_delay_state::start)
+    {
+        return false;
+    }
+
+    const auto paddr_opt = code_paddr(cpu.pc);
+
+    if(!paddr_opt)
+    {
+        return false;
+    }
+
+    const u32 paddr = *paddr_opt;
+    auto& page_ptr = cache.pages[paddr >> CODE_PAGE_SHIFT];
+
+    if(!page_ptr)
+    {
+        page_ptr = std::make_unique<DecodedPage>();
+        decode_page(n64,*page_ptr,paddr);
+        n64.dynarec.code_present[paddr >> CODE_PAGE_SHIFT] |= PAGE_HAS_CODE;
+    }
+
+    const DecodedPage& page = *page_ptr;
+    const u32 generation = cache.generation;
+
+    // vaddr of the start of the page, in whatever form the pc is in
+    const u64 base = cpu.pc - (paddr & (CODE_PAGE_SIZE - 1));
+
+    // with the dynarec active hand back after every branch so it can pick up the target
+    const b32 stop_on_branch = n64.dynarec.enabled;
+
+    // cycles run since the scheduler was last ticked, it only has to be told
+    // before an instr that could see the time, and once the run is over
+    const u32 fetch = fetch_cycles(n64.cpi,cpu.pc);
+    u64 budget = n64.scheduler.get_next_event_cycles();
+    u32 pending = 0;
+
+    u64 offset = cpu.pc - base;
+
+    while(offset < CODE_PAGE_SIZE && (offset & 3) == 0)
+    {
+        // a store from the handler can free the page, so the instr is copied out
+        // and the page is not touched again until the generation says it is still there
+        const DecodedInstr instr = page.instr[offset >> 2];
+
+        // same sequence as step, minus the translation and fetch
+        const branch_delay_state branch_delay_next[] =
+        {
+            branch_delay_state::during,
+            branch_delay_state::end,
+            branch_delay_state::end,
+        };
+
+        cpu.branch_delay = branch_delay_next[u32(cpu.branch_delay)];
+        cpu.pc_fetch = cpu.pc;
+
+        skip_instr(cpu);
+
+        if(!instr.cpu_only)
+        {
+            cycle_tick(n64,std::exchange(pending,0));
+        }
+
+        instr.handler(n64,instr.opcode);
+        cpu.regs[beyond_all_repair::R0] = 0;
+
+        pending += instr.cycles + fetch;
+
+        const b32 delay_slot = cpu.branch_delay == branch_delay_state::during;
+
+        // branched back on ourselves, might be spinning on an event
+        if(delay_slot && cpu.pc < cpu.pc_fetch)
+        {
+            cycle_tick(n64,std::exchange(pending,0));
+            skip_idle_loop(n64);
+        }
+
+        // the instr may have moved the next event
+        if(!instr.cpu_only || !pending)
+        {
+            budget = n64.scheduler.event_ready()? 0 : n64.scheduler.get_next_event_cycles();
+        }
+
+        // our page may have just been written over
+        if(pending >= budget || generation != cache.generation || (delay_slot && stop_on_branch))
+        {
+            break;
+        }
+
+        offset = cpu.pc - base;
+    }
+
+    cycle_tick(n64,pending);
+
+    return true;
+}
+
+}
@@ -155,6 +155,17 @@ void N64Debug::disass_func(const std::vector<Token> &args)
     print_func_disass(n64,target);
 }
 
+void N64Debug::tlb_cache(const std::vector<Token> &args)
+{
+    UNUSED(args);
+
+    const auto& cache = n64.mem.tlb.cache;
+    const u64 total = cache.hits + cache.misses;
+    const f64 rate = total? (f64(cache.hits) / f64(total)) * 100.0 : 0.0;
+
+    print_console("tlb cache: {} hits, {} misses ({:.2f}% hit rate), asid {:x}\n",cache.hits,cache.misses,rate,cache.asid);
+}
+
 void N64Debug::on_break()
 {
     // print_func_disass(n64,n64.cpu.pc_fetch);
@@ -258,9 +258,20 @@ void instr_beq(N64 &n64, const Opcode &opcode)
 
 void instr_cache(N64 &n64, const Opcode &opcode)
 {
-    UNUSED(n64); UNUSED(opcode);
+    // caches are not emulated, but an icache op means the code under it may have changed
+    // so drop anything built from it (only direct mapped addrs for now)
+    const u32 cache = opcode.rt & 0b11;
 
-    // ignore cache operations for now
+    if(cache == 0)
+    {
+        const auto vaddr = n64.cpu.regs[opcode.rs] + sign_extend_mips<s64,s16>(opcode.imm);
+        const auto paddr = code_paddr(vaddr & ~u64(3));
+
+        if(paddr)
+        {
+            invalidate_code(n64,*paddr);
+        }
+    }
 }
 
 template<const b32 debug>
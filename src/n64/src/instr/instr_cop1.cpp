@@ -88,9 +88,7 @@ void instr_lwc1(N64 &n64, const Opcode &opcode)
     const auto phys_addr = *phys_addr_opt;
 
     const u32 v = read_u32_physical<debug>(n64,phys_addr);
-    const f32 f = bit_cast_float(v);
-
-    write_cop1_reg(n64,ft,f);    
+    write_cop1_s(n64,ft,v);
 }
 
 template<const b32 debug>
@@ -118,9 +116,7 @@ void instr_ldc1(N64 &n64, const Opcode &opcode)
     const auto phys_addr = *phys_addr_opt;
 
     const u64 v = read_u64_physical<debug>(n64,phys_addr);
-    const f64 f = bit_cast_double(v);
-
-    write_cop1_reg(n64,ft,f);   
+    write_cop1_d(n64,ft,v);
 }
 
 template<const b32 debug>
@@ -148,9 +144,7 @@ void instr_swc1(N64 &n64, const Opcode &opcode)
     const auto phys_addr = *phys_addr_opt;
 
 
-    const f32 f = read_cop1_reg(n64,ft);
-    const s32 v = bit_cast_from_float(f);
-
+    const u32 v = read_cop1_s(n64,ft);
     write_u32_physical<debug>(n64,phys_addr,v);
 }
 
@@ -178,9 +172,7 @@ void instr_sdc1(N64 &n64, const Opcode &opcode)
     
     const auto phys_addr = *phys_addr_opt;
 
-    const f64 f = read_cop1_reg(n64,ft);
-    const s64 v = bit_cast_from_double(f);
-
+    const u64 v = read_cop1_d(n64,ft);
     write_u64_physical<debug>(n64,phys_addr,v);
 }
 
@@ -243,8 +235,7 @@ void instr_mtc1(N64& n64, const Opcode &opcode)
 
     const u32 fs = get_fs(opcode);
     
-    const f32 f = bit_cast_float(n64.cpu.regs[opcode.rt]);
-    write_cop1_reg(n64,fs,f);
+    write_cop1_s(n64,fs,u32(n64.cpu.regs[opcode.rt]));
 }
 
 void instr_mfc1(N64& n64, const Opcode& opcode)
@@ -257,7 +248,7 @@ void instr_mfc1(N64& n64, const Opcode& opcode)
 
     const u32 fs = get_fs(opcode);
 
-    const s32 w = bit_cast_from_float(read_cop1_reg(n64,fs));
+    const s32 w = read_cop1_s(n64,fs);
     n64.cpu.regs[opcode.rt] = sign_extend_type<s64,s32>(w);
 }
 
@@ -270,8 +261,7 @@ void instr_dmfc1(N64& n64, const Opcode &opcode)
     }
 
     const u32 fs = get_fs(opcode);
-    const s64 val = bit_cast_from_double(read_cop1_reg(n64, fs));
-    n64.cpu.regs[opcode.rt] = val;
+    n64.cpu.regs[opcode.rt] = read_cop1_d(n64,fs);
 }
 
 void instr_dmtc1(N64& n64, const Opcode &opcode)
@@ -283,9 +273,7 @@ void instr_dmtc1(N64& n64, const Opcode &opcode)
     }
 
     const u32 fs = get_fs(opcode);
-    const f64 val = bit_cast_double(n64.cpu.regs[opcode.rt]);
-
-    write_cop1_reg(n64, fs, val);
+    write_cop1_d(n64,fs,n64.cpu.regs[opcode.rt]);
 }
 
 }
\ No newline at end of file
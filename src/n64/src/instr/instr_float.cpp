@@ -1,209 +1,291 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace nintendo64
 {
 
-// TODO: handle floating point exceptions and restrictions
-// but we will just ignore them for now
+// the regs hold raw bits, and the host fpu runs in the guest rounding mode while the core does
+// so plain scalar ops round the same way, and leave any exceptions behind in the host flags
 
-template<typename FUNC>
-void instr_cvt(N64& n64, const Opcode& opcode, FUNC func)
+template<typename T>
+T read_cop1(N64& n64, u32 reg)
 {
-    const u32 fs = get_fs(opcode);
-    const u32 fd = get_fd(opcode);
+    if constexpr(std::is_same_v<T,f32>)
+    {
+        return bit_cast_float(read_cop1_s(n64,reg));
+    }
 
-    const f64 out = func(read_cop1_reg(n64,fs));
+    else if constexpr(std::is_same_v<T,f64>)
+    {
+        return bit_cast_double(read_cop1_d(n64,reg));
+    }
 
-    write_cop1_reg(n64,fd,out);    
+    else if constexpr(sizeof(T) == sizeof(u32))
+    {
+        return T(read_cop1_s(n64,reg));
+    }
+
+    else
+    {
+        return T(read_cop1_d(n64,reg));
+    }
 }
 
-void instr_cvt_d_w(N64& n64, const Opcode& opcode)
+template<typename T>
+void write_cop1(N64& n64, u32 reg, T v)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    if constexpr(std::is_same_v<T,f32>)
     {
-        const s32 word = bit_cast_from_float(in);
-        return f64(word);
-    });
+        write_cop1_s(n64,reg,bit_cast_from_float(v));
+    }
+
+    else if constexpr(std::is_same_v<T,f64>)
+    {
+        write_cop1_d(n64,reg,bit_cast_from_double(v));
+    }
+
+    else if constexpr(sizeof(T) == sizeof(u32))
+    {
+        write_cop1_s(n64,reg,u32(v));
+    }
+
+    else
+    {
+        write_cop1_d(n64,reg,u64(v));
+    }
 }
 
-void instr_cvt_d_l(N64& n64, const Opcode& opcode)
+// float to int in the current rounding mode, or towards zero, out of range and nan are invalid
+template<typename OUT, const b32 truncate, typename IN>
+OUT float_to_int(IN v)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+#ifdef __SSE2__
+    if constexpr(std::is_same_v<IN,f32>)
     {
-        const s64 l = bit_cast_from_double(in);
-        return f64(l);
-    });
+        const __m128 x = _mm_set_ss(v);
+
+        if constexpr(sizeof(OUT) == sizeof(s32))
+        {
+            return truncate? _mm_cvttss_si32(x) : _mm_cvtss_si32(x);
+        }
+
+        else
+        {
+            return truncate? _mm_cvttss_si64(x) : _mm_cvtss_si64(x);
+        }
+    }
+
+    else
+    {
+        const __m128d x = _mm_set_sd(v);
+
+        if constexpr(sizeof(OUT) == sizeof(s32))
+        {
+            return truncate? _mm_cvttsd_si32(x) : _mm_cvtsd_si32(x);
+        }
+
+        else
+        {
+            return truncate? _mm_cvttsd_si64(x) : _mm_cvtsd_si64(x);
+        }
+    }
+#else
+    const IN rounded = truncate? std::trunc(v) : std::nearbyint(v);
+
+    // hand back the same as sse would
+    if(!(rounded >= IN(std::numeric_limits<OUT>::min()) && rounded < -IN(std::numeric_limits<OUT>::min())))
+    {
+        feraiseexcept(FE_INVALID);
+        return std::numeric_limits<OUT>::min();
+    }
+
+    return OUT(rounded);
+#endif
 }
 
-void instr_cvt_d_s(N64& n64, const Opcode& opcode)
+// fd = func(fs, ft)
+template<typename T, typename FUNC>
+void float_op(N64& n64, const Opcode& opcode, FUNC func)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    T v1 = read_cop1<T>(n64,get_fs(opcode));
+    T v2 = read_cop1<T>(n64,get_ft(opcode));
+
+    // anything else on this thread can leave flags behind
+    host_fpu_cause();
+    host_fpu_fence(v1);
+    host_fpu_fence(v2);
+
+    T ans = func(v1,v2);
+    host_fpu_fence(ans);
+
+    if(cop1_result(n64))
     {
-        const f32 s = f32(in);
-        return f64(s);        
-    });
+        write_cop1<T>(n64,get_fd(opcode),ans);
+    }
 }
 
-
-void instr_cvt_l_d(N64& n64, const Opcode& opcode)
+// fd = func(fs), converting between formats
+template<typename OUT, typename IN, typename FUNC>
+void float_cvt(N64& n64, const Opcode& opcode, FUNC func)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    IN in = read_cop1<IN>(n64,get_fs(opcode));
+
+    host_fpu_cause();
+    host_fpu_fence(in);
+
+    OUT out = func(in);
+    host_fpu_fence(out);
+
+    if(cop1_result(n64))
     {
-        const s64 l = s64(in);
-        return bit_cast_double(l);        
-    });
+        write_cop1<OUT>(n64,get_fd(opcode),out);
+    }
 }
 
-
-void instr_cvt_l_s(N64& n64, const Opcode& opcode)
+template<typename OUT, typename IN>
+void float_cvt_int(N64& n64, const Opcode& opcode)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    float_cvt<OUT,IN>(n64,opcode,[](IN in)
     {
-        const f32 s = f32(in);
-        const s64 l = s64(s);
-
-        return bit_cast_double(l);
+        return float_to_int<OUT,false>(in);
     });
 }
 
-void instr_cvt_s_w(N64& n64, const Opcode& opcode)
+template<typename OUT, typename IN>
+void float_trunc(N64& n64, const Opcode& opcode)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    float_cvt<OUT,IN>(n64,opcode,[](IN in)
     {
-        const s32 word = bit_cast_from_float(in);
-        const f32 s = f32(word);
-
-        return s;
+        return float_to_int<OUT,true>(in);
     });
 }
 
-void instr_cvt_s_d(N64& n64, const Opcode& opcode)
+// round, ceil and floor pick their own mode instead of the one in fcr31
+template<typename OUT, typename IN>
+void float_round(N64& n64, const Opcode& opcode, u32 rounding)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    auto& cop1 = n64.cpu.cop1;
+
+    IN in = read_cop1<IN>(n64,get_fs(opcode));
+
+    write_host_fpu(host_fpu_mode(rounding,cop1.fs));
+    host_fpu_fence(in);
+
+    OUT out = float_to_int<OUT,false>(in);
+    host_fpu_fence(out);
+
+    const u32 cause = host_fpu_cause();
+    write_host_fpu(cop1.host_fpu);
+
+    if(cop1_result(n64,cause))
     {
-        return f32(in);
-    });
+        write_cop1<OUT>(n64,get_fd(opcode),out);
+    }
 }
 
-void instr_cvt_s_l(N64& n64, const Opcode& opcode)
+template<typename T>
+void float_mov(N64& n64, const Opcode& opcode)
+{
+    write_cop1<T>(n64,get_fd(opcode),read_cop1<T>(n64,get_fs(opcode)));
+}
+
+void instr_cvt_d_w(N64& n64, const Opcode& opcode)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    float_cvt<f64,s32>(n64,opcode,[](s32 in)
     {
-        const s64 l = bit_cast_from_double(in);
-        return f32(l);
+        return f64(in);
     });
 }
 
-void instr_cvt_w_d(N64& n64, const Opcode& opcode)
+void instr_cvt_d_l(N64& n64, const Opcode& opcode)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    float_cvt<f64,s64>(n64,opcode,[](s64 in)
     {
-        const s32 w = s32(in);
-
-        return f64(bit_cast_float(w));
+        return f64(in);
     });
 }
 
-void instr_cvt_w_s(N64& n64, const Opcode& opcode)
+void instr_cvt_d_s(N64& n64, const Opcode& opcode)
 {
-    instr_cvt(n64,opcode,[](f64 in)
+    float_cvt<f64,f32>(n64,opcode,[](f32 in)
     {
-        const f32 s = f32(in);
-        const s32 w = s32(s);
-
-        return f64(bit_cast_float(w));
+        return f64(in);
     });
 }
 
-template<typename FUNC>
-void instr_trunc(N64& n64, const Opcode& opcode, FUNC func)
+void instr_cvt_l_d(N64& n64, const Opcode& opcode)
 {
-    const u32 fs = get_fs(opcode);
-    const u32 fd = get_fd(opcode);
-
-    const f64 out = func(read_cop1_reg(n64,fs));
-
-    write_cop1_reg(n64,fd,out);    
+    float_cvt_int<s64,f64>(n64,opcode);
 }
 
-void instr_trunc_w_s(N64& n64, const Opcode& opcode)
+void instr_cvt_l_s(N64& n64, const Opcode& opcode)
 {
-    instr_trunc(n64,opcode,[](f64 in)
-    {
-        const f32 s = f32(in);
-        const s32 w = s32(s);
-
-        return bit_cast_float(w);
-    });
+    float_cvt_int<s64,f32>(n64,opcode);
 }
 
-void instr_trunc_w_d(N64& n64, const Opcode& opcode)
+void instr_cvt_s_w(N64& n64, const Opcode& opcode)
 {
-    instr_trunc(n64,opcode,[](f64 in)
+    float_cvt<f32,s32>(n64,opcode,[](s32 in)
     {
-        const s32 w = s32(in);
-
-        return bit_cast_float(w);
+        return f32(in);
     });
 }
 
-
-void instr_trunc_l_s(N64& n64, const Opcode& opcode)
+void instr_cvt_s_d(N64& n64, const Opcode& opcode)
 {
-    instr_trunc(n64,opcode,[](f64 in)
+    float_cvt<f32,f64>(n64,opcode,[](f64 in)
     {
-        const f32 s = f32(in);
-        const s64 l = s64(s);
-
-        return bit_cast_double(l);
+        return f32(in);
     });
 }
 
-
-void instr_trunc_l_d(N64& n64, const Opcode& opcode)
+void instr_cvt_s_l(N64& n64, const Opcode& opcode)
 {
-    instr_trunc(n64,opcode,[](f64 in)
+    float_cvt<f32,s64>(n64,opcode,[](s64 in)
     {
-        const s64 l = s64(in);
-
-        return bit_cast_double(l);
+        return f32(in);
     });
 }
 
-void instr_mov_s(N64& n64, const Opcode& opcode)
+void instr_cvt_w_d(N64& n64, const Opcode& opcode)
 {
-    const u32 fs = get_fs(opcode);
-    const u32 fd = get_fd(opcode);
-
-    const f32 s = f32(read_cop1_reg(n64,fs));
+    float_cvt_int<s32,f64>(n64,opcode);
+}
 
-    write_cop1_reg(n64,fd,s);    
+void instr_cvt_w_s(N64& n64, const Opcode& opcode)
+{
+    float_cvt_int<s32,f32>(n64,opcode);
 }
 
-template<typename FUNC>
-void float_s_op(N64& n64, const Opcode& opcode, FUNC func)
+void instr_trunc_w_s(N64& n64, const Opcode& opcode)
 {
-    const u32 fs = get_fs(opcode);
-    const u32 fd = get_fd(opcode);
-    const u32 ft = get_ft(opcode);
+    float_trunc<s32,f32>(n64,opcode);
+}
 
-    const f64 ans = func(f32(read_cop1_reg(n64,fs)),f32(read_cop1_reg(n64,ft)));
-    write_cop1_reg(n64,fd,ans);
+void instr_trunc_w_d(N64& n64, const Opcode& opcode)
+{
+    float_trunc<s32,f64>(n64,opcode);
 }
 
+void instr_trunc_l_s(N64& n64, const Opcode& opcode)
+{
+    float_trunc<s64,f32>(n64,opcode);
+}
 
-template<typename FUNC>
-void float_d_op(N64& n64, const Opcode& opcode, FUNC func)
+void instr_trunc_l_d(N64& n64, const Opcode& opcode)
 {
-    const u32 fs = get_fs(opcode);
-    const u32 fd = get_fd(opcode);
-    const u32 ft = get_ft(opcode);
+    float_trunc<s64,f64>(n64,opcode);
+}
 
-    const f64 ans = func(f64(read_cop1_reg(n64,fs)),f64(read_cop1_reg(n64,ft)));
-    write_cop1_reg(n64,fd,ans);
+void instr_mov_s(N64& n64, const Opcode& opcode)
+{
+    float_mov<u32>(n64,opcode);
 }
 
 void instr_div_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64,opcode,[](f32 v1, f32 v2)
+    float_op<f32>(n64,opcode,[](f32 v1, f32 v2)
     {
         return v1 / v2;
     });
@@ -211,7 +293,7 @@ void instr_div_s(N64& n64, const Opcode& opcode)
 
 void instr_add_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64,opcode,[](f32 v1, f32 v2)
+    float_op<f32>(n64,opcode,[](f32 v1, f32 v2)
     {
         return v1 + v2;
     });
@@ -219,7 +301,7 @@ void instr_add_s(N64& n64, const Opcode& opcode)
 
 void instr_sub_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64,opcode,[](f32 v1, f32 v2)
+    float_op<f32>(n64,opcode,[](f32 v1, f32 v2)
     {
         return v1 - v2;
     });
@@ -227,15 +309,15 @@ void instr_sub_s(N64& n64, const Opcode& opcode)
 
 void instr_mul_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64,opcode,[](f32 v1, f32 v2)
+    float_op<f32>(n64,opcode,[](f32 v1, f32 v2)
     {
         return v1 * v2;
-    });    
+    });
 }
 
 void instr_sqrt_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
+    float_op<f32>(n64,opcode,[](f32 f, f32 unused)
     {
         UNUSED(unused);
         return std::sqrt(f);
@@ -244,7 +326,7 @@ void instr_sqrt_s(N64& n64, const Opcode& opcode)
 
 void instr_abs_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
+    float_op<f32>(n64,opcode,[](f32 f, f32 unused)
     {
         UNUSED(unused);
         return std::abs(f);
@@ -253,7 +335,7 @@ void instr_abs_s(N64& n64, const Opcode& opcode)
 
 void instr_neg_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
+    float_op<f32>(n64,opcode,[](f32 f, f32 unused)
     {
         UNUSED(unused);
         return -f;
@@ -262,71 +344,45 @@ void instr_neg_s(N64& n64, const Opcode& opcode)
 
 void instr_round_l_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_double(long(std::nearbyint((f))));
-    });
+    float_round<s64,f32>(n64,opcode,0);
 }
 
 void instr_ceil_l_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_double(long(std::ceil(f)));
-    });
+    float_round<s64,f32>(n64,opcode,2);
 }
 
 void instr_floor_l_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_double(long(std::floor(f)));
-    });
+    float_round<s64,f32>(n64,opcode,3);
 }
 
 void instr_round_w_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_float(int(std::nearbyint(f )));
-    });
+    float_round<s32,f32>(n64,opcode,0);
 }
 
 void instr_ceil_w_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_float(int(std::ceil(f)));
-    });
+    float_round<s32,f32>(n64,opcode,2);
 }
 
 void instr_floor_w_s(N64& n64, const Opcode& opcode)
 {
-    float_s_op(n64, opcode, [](f32 f, f32 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_float(int(std::floor(f)));
-    });
+    float_round<s32,f32>(n64,opcode,3);
 }
 
-
 void instr_add_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64,opcode,[](f64 v1, f64 v2)
+    float_op<f64>(n64,opcode,[](f64 v1, f64 v2)
     {
         return v1 + v2;
     });
 }
 
-
 void instr_sub_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64,opcode,[](f64 v1, f64 v2)
+    float_op<f64>(n64,opcode,[](f64 v1, f64 v2)
     {
         return v1 - v2;
     });
@@ -334,7 +390,7 @@ void instr_sub_d(N64& n64, const Opcode& opcode)
 
 void instr_mul_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64,opcode,[](f64 v1, f64 v2)
+    float_op<f64>(n64,opcode,[](f64 v1, f64 v2)
     {
         return v1 * v2;
     });
@@ -342,7 +398,7 @@ void instr_mul_d(N64& n64, const Opcode& opcode)
 
 void instr_div_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64,opcode,[](f64 v1, f64 v2)
+    float_op<f64>(n64,opcode,[](f64 v1, f64 v2)
     {
         return v1 / v2;
     });
@@ -350,15 +406,12 @@ void instr_div_d(N64& n64, const Opcode& opcode)
 
 void instr_mov_d(N64& n64, const Opcode& opcode)
 {
-    const u32 fs = get_fs(opcode);
-    const u32 fd = get_fd(opcode);
-
-    write_cop1_reg(n64,fd,read_cop1_reg(n64,fs));    
+    float_mov<u64>(n64,opcode);
 }
 
 void instr_sqrt_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
+    float_op<f64>(n64,opcode,[](f64 f, f64 unused)
     {
         UNUSED(unused);
         return std::sqrt(f);
@@ -367,7 +420,7 @@ void instr_sqrt_d(N64& n64, const Opcode& opcode)
 
 void instr_abs_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
+    float_op<f64>(n64,opcode,[](f64 f, f64 unused)
     {
         UNUSED(unused);
         return std::abs(f);
@@ -376,364 +429,223 @@ void instr_abs_d(N64& n64, const Opcode& opcode)
 
 void instr_neg_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
+    float_op<f64>(n64,opcode,[](f64 f, f64 unused)
     {
         UNUSED(unused);
         return -f;
     });
 }
 
-void instr_roundl_d(N64& n64, const Opcode& opcode) {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_double(long(std::nearbyint(f))); // round to nearest, tiebreak towards the even number
-    });
+void instr_roundl_d(N64& n64, const Opcode& opcode)
+{
+    float_round<s64,f64>(n64,opcode,0);
 }
 
 void instr_ceil_l_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_double(long(std::ceil(f)));
-    });
+    float_round<s64,f64>(n64,opcode,2);
 }
 
 void instr_floor_l_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_double(long(std::floor(f)));
-    });
+    float_round<s64,f64>(n64,opcode,3);
 }
 
 void instr_round_w_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_float(int(std::nearbyint(f))); // truncate to float, round, cast up to double
-    });
+    float_round<s32,f64>(n64,opcode,0);
 }
 
-void instr_ceil_w_d(N64& n64, const Opcode& opcode) {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_float(int(std::ceil(f)));
-    });
+void instr_ceil_w_d(N64& n64, const Opcode& opcode)
+{
+    float_round<s32,f64>(n64,opcode,2);
 }
 
 void instr_floor_w_d(N64& n64, const Opcode& opcode)
 {
-    float_d_op(n64, opcode, [](f64 f, f64 unused)
-    {
-        UNUSED(unused);
-        return bit_cast_float(int(std::floor(f)));
-    });
+    float_round<s32,f64>(n64,opcode,3);
 }
 
 
 // table 7-11 for cond desc
-template<typename FUNC>
-void float_cond_s(N64& n64, const Opcode& opcode, FUNC func)
-{
-    const u32 fs = get_fs(opcode);
-    const u32 ft = get_ft(opcode);
-
-    const f32 v1 = f32(read_cop1_reg(n64,fs));
-    const f32 v2 = f32(read_cop1_reg(n64,ft));
-
-    // TODO: check inputs are valid
-
-    // write out result of comparison
-    n64.cpu.cop1.c = func(v1,v2);
-}
-
-template<typename FUNC>
-void float_cond_d(N64& n64, const Opcode& opcode, FUNC func)
+// the bottom 4 bits of the funct pick the result out of unordered, equal and less than
+// with the top one set any nan is invalid, signalling nans are not told apart from quiet ones
+template<typename T>
+void float_cond(N64& n64, const Opcode& opcode)
 {
-    const u32 fs = get_fs(opcode);
-    const u32 ft = get_ft(opcode);
+    const T v1 = read_cop1<T>(n64,get_fs(opcode));
+    const T v2 = read_cop1<T>(n64,get_ft(opcode));
 
-    const f64 v1 = f64(read_cop1_reg(n64,fs));
-    const f64 v2 = f64(read_cop1_reg(n64,ft));
+    const u32 cond = opcode.op & 0xf;
+    const b32 unordered = std::isnan(v1) || std::isnan(v2);
 
-    // TODO: check inputs are valid
+    if(!cop1_result(n64,unordered && is_set(cond,3)? COP1_INVALID : 0))
+    {
+        return;
+    }
 
     // write out result of comparison
-    n64.cpu.cop1.c = func(v1,v2);
+    n64.cpu.cop1.c = unordered? is_set(cond,0) : (is_set(cond,1) && v1 == v2) || (is_set(cond,2) && v1 < v2);
 }
 
 void instr_c_ole_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64,opcode,[](f32 v1, f32 v2)
-    {
-        return v1 <= v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ole_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64,opcode,[](f64 v1, f64 v2)
-    {
-        return v1 <= v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_olt_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64,opcode,[](f64 v1, f64 v2)
-    {
-        return v1 < v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_eq_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2) {
-        return v1 == v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_eq_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return v1 == v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_f_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        UNUSED(v1); UNUSED(v2);
-        return false;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_f_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        UNUSED(v1); UNUSED(v2);
-        return false;
-    });
-}
-
-bool isnan_f(f32 f) {
-    return std::isnan(f);
-}
-
-bool isnan_d(f64 f) {
-    return f == std::numeric_limits<double>::quiet_NaN();
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_un_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return isnan_d(v1) || isnan_d(v2);
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_un_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return isnan_f(v1) || isnan_f(v2);
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ueq_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || (v1 == v2);
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_ueq_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return (isnan_f(v1) || isnan_f(v2)) || (v1 == v2);
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_olt_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return v1 < v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ult_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || v1 < v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_ult_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return (isnan_f(v1) || isnan_f(v2)) || v1 < v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ule_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return (isnan_f(v1) || isnan_f(v2)) || (v1 < v2) || (v1 == v2);
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ule_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || (v1 < v2) || (v1 == v2);
-    });
+    float_cond<f64>(n64,opcode);
 }
 
-
-// TODO: these all exception on nan
 void instr_c_sf_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        UNUSED(v1); UNUSED(v2);
-        return false;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_ngle_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return isnan_d(v1) || isnan_d(v2);
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_seq_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return v1 == v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_ngl_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || v1 == v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_lt_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return v1 < v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_nge_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || v1 < v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_le_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return v1 < v2 || v1 == v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_ngt_d(N64& n64, const Opcode& opcode)
 {
-    float_cond_d(n64, opcode, [](f64 v1, f64 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || v1 < v2 || v1 == v2;
-    });
+    float_cond<f64>(n64,opcode);
 }
 
 void instr_c_sf_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-    UNUSED(v1); UNUSED(v2);
-       return false;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ngle_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-       return (isnan_d(v1) || isnan_d(v2));
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_seq_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return v1 == v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ngl_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || v1 == v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_lt_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return v1 < v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_nge_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return (isnan_d(v1) || isnan_d(v2)) || v1 < v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_le_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-        return v1 < v2 || v1 == v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_c_ngt_s(N64& n64, const Opcode& opcode)
 {
-    float_cond_s(n64, opcode, [](f32 v1, f32 v2)
-    {
-       return (isnan_d(v1) || isnan_d(v2)) || v1 < v2 || v1 == v2;
-    });
+    float_cond<f32>(n64,opcode);
 }
 
 void instr_bc1tl(N64& n64, const Opcode& opcode)
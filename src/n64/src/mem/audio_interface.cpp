@@ -1,21 +1,68 @@
 namespace nintendo64
 {
 
-void insert_audio_event(N64& n64)
-{
-    auto& ai = n64.mem.ai;
+// how far the stream may be pulled each dma to win back drift, 1 / 200 is well under audible pitch
+static constexpr s64 AI_MAX_CORRECTION = 200;
 
+u64 ai_dma_duration(const AudioInterface& ai)
+{
     const u64 samples = (ai.length * 8) / ai.bit_rate;
     const u64 cycle_per_sample = (N64_CLOCK_CYCLES / ai.freq);
-    const u64 duration = cycle_per_sample * samples; 
+    return cycle_per_sample * samples; 
+}
 
-    // spdlog::debug("Duration {} {} {} {}",ai.length,samples,cycle_per_sample,duration);
+void insert_audio_event(N64& n64, u64 duration)
+{
+    // spdlog::debug("Duration {} {}",n64.mem.ai.length,duration);
 
     // dont think this is the right value but roll with it for now
     const auto event = n64.scheduler.create_event(duration,n64_event::ai_dma);
     n64.scheduler.insert(event,false);    
 }
 
+// play the buffer out through the host at a rate locked to the emulated time the dma takes,
+// so the audio can never run ahead of or behind the video it was made alongside
+void stream_ai_samples(N64& n64, u64 duration)
+{
+    auto& ai = n64.mem.ai;
+
+    // 16 bit stereo, left in the top half of each word
+    const u32 frames = ai.length / sizeof(u32);
+
+    if(!frames || !duration)
+    {
+        return;
+    }
+
+    ai.host_time += duration * AUDIO_BUFFER_SAMPLE_RATE;
+    const s64 target = ai.host_time / N64_CLOCK_CYCLES;
+    ai.host_time %= N64_CLOCK_CYCLES;
+
+    // win back whatever the rounding of previous dmas has put us out by, a little at a time
+    const s64 limit = std::max<s64>(1,target / AI_MAX_CORRECTION);
+    const s64 want = std::max<s64>(1,target + std::clamp(ai.frame_error,-limit,limit));
+    ai.frame_error += target;
+
+    set_resampler_ratio(n64.resampler,f64(frames) / f64(want));
+
+    const u32 addr = ai.dram_addr & ~3;
+    u32 produced = 0;
+
+    flush_if_dirty(n64,addr,frames * sizeof(u32));
+
+    for(u32 i = 0; i < frames; i++)
+    {
+        const u32 v = handle_read<u32>(&n64.mem.rd_ram[(addr + (i * sizeof(u32))) & (RD_RAM_SIZE - 1)]);
+
+        const f32 left = f32(s16(v >> 16)) / 32768.0f;
+        const f32 right = f32(s16(v & 0xffff)) / 32768.0f;
+
+        produced += resample_frame(n64.resampler,n64.audio_buffer,left,right);
+    }
+
+    ai.frame_error -= produced;
+}
+
 void do_ai_dma(N64& n64)
 {
     auto& ai = n64.mem.ai;
@@ -24,9 +71,11 @@ void do_ai_dma(N64& n64)
     set_mi_interrupt(n64,AI_INTR_BIT);
     ai.busy = true;
 
-    // TODO: Actually do the transfer
+    const u64 duration = ai_dma_duration(ai);
+
+    stream_ai_samples(n64,duration);
 
-    insert_audio_event(n64);
+    insert_audio_event(n64,duration);
 }
 
 void audio_event(N64& n64)
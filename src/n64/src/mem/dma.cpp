@@ -0,0 +1,196 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace nintendo64
+{
+
+// shared copy for the pi, sp and si dmas
+// every memory is held with its guest bytes at host offset addr ^ 3,
+// so a run where both sides sit at the same offset into a word is a plain memcpy
+
+// rcp cycles to cpu cycles
+static constexpr u32 RCP_TO_CPU_NUM = 3;
+static constexpr u32 RCP_TO_CPU_DEN = 2;
+
+// rdram moves roughly 8 bytes an rcp cycle for the sp, plus a little setup a row
+static constexpr u32 SP_DMA_ROW_CYCLES = 8;
+
+// 64 bytes over the serial bus to the pif
+static constexpr u32 SI_DMA_CYCLES = 2304;
+
+// both sides two bytes into a word of each other, so each dst word is the
+// bottom half of one src word and the top half of the next
+void copy_halfword_shifted(u8* dst, u32 dst_off, const u8* src, u32 src_off, u32 words)
+{
+    u32 i = 0;
+
+#ifdef __SSE2__
+    for(; i + 4 <= words; i += 4)
+    {
+        const __m128i lo = _mm_loadu_si128((const __m128i*)&src[src_off + (i * sizeof(u32))]);
+        const __m128i hi = _mm_loadu_si128((const __m128i*)&src[src_off + ((i + 1) * sizeof(u32))]);
+
+        const __m128i v = _mm_or_si128(_mm_slli_epi32(lo,16),_mm_srli_epi32(hi,16));
+        _mm_storeu_si128((__m128i*)&dst[dst_off + (i * sizeof(u32))],v);
+    }
+#endif
+
+    for(; i < words; i++)
+    {
+        const u32 lo = handle_read<u32>(&src[src_off + (i * sizeof(u32))]);
+        const u32 hi = handle_read<u32>(&src[src_off + ((i + 1) * sizeof(u32))]);
+
+        handle_write<u32>(&dst[dst_off + (i * sizeof(u32))],(lo << 16) | (hi >> 16));
+    }
+}
+
+// copy a run of guest bytes between two host buffers
+// offsets are guest addresses relative to buffers that start on a word
+void copy_run(u8* dst, u32 dst_addr, const u8* src, u32 src_addr, u32 len)
+{
+    // line the destination up on a word
+    while(len && (dst_addr & 3))
+    {
+        dst[dst_addr ^ 3] = src[src_addr ^ 3];
+        dst_addr++;
+        src_addr++;
+        len--;
+    }
+
+    u32 words = len / sizeof(u32);
+
+    if((src_addr & 3) == 0)
+    {
+        memcpy(&dst[dst_addr],&src[src_addr],words * sizeof(u32));
+    }
+
+    else if((src_addr & 3) == 2)
+    {
+        // each word reads half of the next, which has to still be inside the run
+        if(words && len < (words * sizeof(u32)) + 2)
+        {
+            words--;
+        }
+
+        copy_halfword_shifted(dst,dst_addr,src,src_addr - 2,words);
+    }
+
+    else
+    {
+        words = 0;
+    }
+
+    for(u32 i = words * sizeof(u32); i < len; i++)
+    {
+        dst[(dst_addr + i) ^ 3] = src[(src_addr + i) ^ 3];
+    }
+}
+
+// anything not straight memory, in the widest accesses both sides allow
+void dma_copy_slow(N64& n64, u32 src, u32 dst, u32 len)
+{
+    const u32 align = src | dst | len;
+
+    if((align & 3) == 0)
+    {
+        for(u32 i = 0; i < len; i += sizeof(u32))
+        {
+            write_physical<u32>(n64,dst + i,read_physical<u32>(n64,src + i));
+        }
+    }
+
+    else if((align & 1) == 0)
+    {
+        for(u32 i = 0; i < len; i += sizeof(u16))
+        {
+            write_physical<u16>(n64,dst + i,read_physical<u16>(n64,src + i));
+        }
+    }
+
+    else
+    {
+        for(u32 i = 0; i < len; i++)
+        {
+            write_physical<u8>(n64,dst + i,read_physical<u8>(n64,src + i));
+        }
+    }
+}
+
+void dma_copy(N64& n64, u32 src, u32 dst, u32 len)
+{
+    const u32 dst_start = dst;
+    const u32 total = len;
+
+    auto& mem = n64.mem;
+
+    // queued draws have to land before the dma reads them, or write over it
+    if(src < RD_RAM_SIZE)
+    {
+        flush_if_dirty(n64,src,len);
+    }
+
+    if(dst < RD_RAM_SIZE)
+    {
+        flush_if_dirty(n64,dst,len);
+    }
+
+    while(len)
+    {
+        // page tables only go as far as a page, so split there on either side
+        const u32 run = std::min({len,PAGE_SIZE - (src & PAGE_MASK),PAGE_SIZE - (dst & PAGE_MASK)});
+
+        const u8* src_page = src < PHYSICAL_MEMORY_SIZE? mem.page_table_read[src >> PAGE_SHIFT] : nullptr;
+        u8* dst_page = dst < PHYSICAL_MEMORY_SIZE? mem.page_table_write[dst >> PAGE_SHIFT] : nullptr;
+
+        if(src_page && dst_page)
+        {
+            copy_run(dst_page,dst & PAGE_MASK,src_page,src & PAGE_MASK,run);
+        }
+
+        else
+        {
+            dma_copy_slow(n64,src,dst,run);
+        }
+
+        src += run;
+        dst += run;
+        len -= run;
+    }
+
+    invalidate_code_range(n64,dst_start,total);
+}
+
+// each page of the transfer pays the latency once, then every halfword pays a pulse and a release
+u32 pi_dma_cycles(const PeripheralInterface& pi, u32 cart_addr, u32 len)
+{
+    // domain 2 is the 64dd regs and sram, everything else is domain 1
+    const b32 dom2 = (cart_addr >= 0x0500'0000 && cart_addr < 0x0600'0000) ||
+        (cart_addr >= 0x0800'0000 && cart_addr < 0x1000'0000);
+
+    const u32 lat = dom2? pi.bsd_dom2_lat : pi.bsd_dom1_lat;
+    const u32 pwd = dom2? pi.bsd_dom2_pwd : pi.bsd_dom1_pwd;
+    const u32 pgs = dom2? pi.bsd_dom2_pgs : pi.bsd_dom1_pgs;
+    const u32 rls = dom2? pi.bsd_dom2_rls : pi.bsd_dom1_rls;
+
+    const u32 page_size = 1 << (pgs + 2);
+    const u64 pages = (len + page_size - 1) / page_size;
+    const u64 halfwords = (len + 1) / 2;
+
+    const u64 rcp_cycles = (pages * (lat + 1)) + (halfwords * ((pwd + 1) + (rls + 1)));
+
+    return u32(std::min<u64>((rcp_cycles * RCP_TO_CPU_NUM) / RCP_TO_CPU_DEN,0xffff'ffff));
+}
+
+u32 sp_dma_cycles(u32 rows, u32 len)
+{
+    const u32 rcp_cycles = rows * (SP_DMA_ROW_CYCLES + (len / sizeof(u64)));
+    return (rcp_cycles * RCP_TO_CPU_NUM) / RCP_TO_CPU_DEN;
+}
+
+u32 si_dma_cycles()
+{
+    return SI_DMA_CYCLES;
+}
+
+}
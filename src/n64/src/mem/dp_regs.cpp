@@ -0,0 +1,105 @@
+namespace nintendo64
+{
+
+void process_dp_commands(N64& n64)
+{
+    run_rdp_commands(n64);
+}
+
+void write_dp_regs(N64& n64, u64 addr ,u32 v)
+{
+    spdlog::trace("DP write [0x{:x}] = 0x{:x}",addr,v);
+    auto& dp = n64.mem.dp_regs;
+
+    switch(addr)
+    {
+        case DPC_START:
+        {
+            // ignored while a previous start has not been picked up
+            if(!dp.start_valid)
+            {
+                dp.start = v & 0x00ff'fff8;
+                dp.start_valid = true;
+            }
+            break;
+        }
+
+        case DPC_END:
+        {
+            dp.end = v & 0x00ff'fff8;
+
+            if(dp.start_valid)
+            {
+                dp.current = dp.start;
+                dp.start_valid = false;
+            }
+
+            if(!dp.freeze)
+            {
+                process_dp_commands(n64);
+            }
+            break;
+        }
+
+        case DPC_STATUS:
+        {
+            dp.xbus_dmem_dma = deset_if_set(dp.xbus_dmem_dma,v,0);
+            dp.xbus_dmem_dma = set_if_set(dp.xbus_dmem_dma,v,1);
+
+            dp.freeze = deset_if_set(dp.freeze,v,2);
+            dp.freeze = set_if_set(dp.freeze,v,3);
+
+            dp.flush = deset_if_set(dp.flush,v,4);
+            dp.flush = set_if_set(dp.flush,v,5);
+
+            // the counters are not emulated
+            break;
+        }
+
+        // read only
+        case DPC_CURRENT: case DPC_CLOCK: case DPC_BUFBUSY: case DPC_PIPEBUSY: case DPC_TMEM:
+        {
+            break;
+        }
+
+        default:
+        {
+            unimplemented("write_mem: dp regs: %08x : %08x\n",addr,v);
+            break;
+        }
+    }
+}
+
+u32 read_dp_regs(N64& n64, u64 addr)
+{
+    spdlog::trace("DP read [0x{:x}]",addr);
+    auto& dp = n64.mem.dp_regs;
+
+    // polling the rdp is how the cpu or rsp waits on it, so everything queued has to be in rdram by now
+    // the other sync the game can see is the dp interrupt, and sync full already flushes
+    flush_rdp(n64);
+
+    switch(addr)
+    {
+        case DPC_START: return dp.start;
+        case DPC_END: return dp.end;
+        case DPC_CURRENT: return dp.current;
+
+        case DPC_STATUS:
+        {
+            // command buffer always ready, as the list is consumed instantly
+            return dp.xbus_dmem_dma | dp.freeze << 1 | dp.flush << 2 |
+                true << 7 | dp.start_valid << 10;
+        }
+
+        case DPC_CLOCK: case DPC_BUFBUSY: case DPC_PIPEBUSY: case DPC_TMEM: return 0;
+
+        default:
+        {
+            unimplemented("read_mem: dp regs %8x\n",addr);
+            return 0;
+        }
+    }
+}
+
+}
@@ -0,0 +1,146 @@
+#include <n64/n64.h>
+
+#ifdef N64_FASTMEM
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace nintendo64
+{
+
+#ifdef N64_FASTMEM
+
+static constexpr u32 KSEG0 = 0x8000'0000;
+static constexpr u32 KSEG1 = 0xA000'0000;
+static constexpr u32 ROM_ADDR = 0x1000'0000;
+static constexpr u32 ROM_REGION_SIZE = 0x1FC0'0000 - ROM_ADDR;
+
+b32 map_view(u8* addr, size_t size, int prot, int fd)
+{
+    return mmap(addr,size,prot,MAP_SHARED | MAP_FIXED,fd,0) != MAP_FAILED;
+}
+
+// put a range back to inaccessible
+void unmap_view(u8* addr, size_t size)
+{
+    mmap(addr,size,PROT_NONE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE,-1,0);
+}
+
+Fastmem::Fastmem()
+{
+    void* reserve = mmap(nullptr,FASTMEM_SIZE,PROT_NONE,MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,-1,0);
+
+    if(reserve == MAP_FAILED)
+    {
+        spdlog::warn("fastmem: could not reserve guest address space");
+        return;
+    }
+
+    u8* region = (u8*)reserve;
+
+    rd_ram_fd = memfd_create("n64_rdram",MFD_CLOEXEC);
+
+    if(rd_ram_fd < 0 || ftruncate(rd_ram_fd,RD_RAM_SIZE) != 0)
+    {
+        spdlog::warn("fastmem: could not create rdram backing");
+        munmap(region,FASTMEM_SIZE);
+        return;
+    }
+
+    void* view = mmap(nullptr,RD_RAM_SIZE,PROT_READ | PROT_WRITE,MAP_SHARED,rd_ram_fd,0);
+
+    if(view == MAP_FAILED || !map_view(&region[KSEG0],RD_RAM_SIZE,PROT_READ | PROT_WRITE,rd_ram_fd) ||
+        !map_view(&region[KSEG1],RD_RAM_SIZE,PROT_READ | PROT_WRITE,rd_ram_fd))
+    {
+        spdlog::warn("fastmem: could not map rdram");
+
+        if(view != MAP_FAILED)
+        {
+            munmap(view,RD_RAM_SIZE);
+        }
+
+        munmap(region,FASTMEM_SIZE);
+        close(rd_ram_fd);
+        rd_ram_fd = -1;
+        return;
+    }
+
+    rd_ram = (u8*)view;
+    base = region;
+}
+
+Fastmem::~Fastmem()
+{
+    if(!base)
+    {
+        return;
+    }
+
+    // takes every view inside the reservation with it
+    munmap(base,FASTMEM_SIZE);
+    munmap(rd_ram,RD_RAM_SIZE);
+    close(rd_ram_fd);
+
+    if(rom_fd >= 0)
+    {
+        close(rom_fd);
+    }
+}
+
+void map_fastmem_rom(Fastmem& fastmem, const std::vector<u8>& rom)
+{
+    if(!fastmem.base)
+    {
+        return;
+    }
+
+    if(fastmem.rom_fd >= 0)
+    {
+        unmap_view(&fastmem.base[KSEG0 + ROM_ADDR],fastmem.rom_size);
+        unmap_view(&fastmem.base[KSEG1 + ROM_ADDR],fastmem.rom_size);
+        close(fastmem.rom_fd);
+        fastmem.rom_fd = -1;
+    }
+
+    // past this the slow path handles the mirroring
+    fastmem.rom_size = std::min(rom.size(),size_t(ROM_REGION_SIZE)) & ~size_t(PAGE_MASK);
+
+    const int fd = memfd_create("n64_rom",MFD_CLOEXEC);
+
+    if(fd < 0 || ftruncate(fd,fastmem.rom_size) != 0 ||
+        pwrite(fd,rom.data(),fastmem.rom_size,0) != ssize_t(fastmem.rom_size))
+    {
+        spdlog::warn("fastmem: could not map rom, rom accesses will take the slow path");
+
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        return;
+    }
+
+    map_view(&fastmem.base[KSEG0 + ROM_ADDR],fastmem.rom_size,PROT_READ,fd);
+    map_view(&fastmem.base[KSEG1 + ROM_ADDR],fastmem.rom_size,PROT_READ,fd);
+    fastmem.rom_fd = fd;
+}
+
+#else
+
+Fastmem::Fastmem()
+{
+
+}
+
+Fastmem::~Fastmem()
+{
+
+}
+
+void map_fastmem_rom(Fastmem& fastmem, const std::vector<u8>& rom)
+{
+    UNUSED(fastmem); UNUSED(rom);
+}
+
+#endif
+
+}
@@ -8,6 +8,17 @@ access_type read_physical(N64 &n64, u32 addr)
 {
     addr &= ~(sizeof(access_type) - 1);
 
+    // rdram, sp mem and rom are straight memory
+    if(addr < PHYSICAL_MEMORY_SIZE)
+    {
+        const u8* page = n64.mem.page_table_read[addr >> PAGE_SHIFT];
+
+        if(page)
+        {
+            return handle_read_n64<access_type>(page,addr & PAGE_MASK);
+        }
+    }
+
     // just do something naive for now so we can get roms running
     if(addr < 0x00800000)
     {
@@ -27,11 +38,13 @@ access_type read_physical(N64 &n64, u32 addr)
 
     else if(addr < 0x04001000)
     {
+        sync_rsp(n64);
         return handle_read_n64<access_type>(n64.mem.sp_dmem,addr & 0xfff);
     }
 
     else if(addr < 0x04002000)
     {
+        sync_rsp(n64);
         return handle_read_n64<access_type>(n64.mem.sp_imem,addr & 0xfff);
     }
 
@@ -45,11 +58,17 @@ access_type read_physical(N64 &n64, u32 addr)
     else if(addr < 0x0500'0000)
     {
         const u32 idx = (addr >> 20) & 0xf;
+
+        // sp, dp and mi regs can all be changed by the rsp
+        if(idx <= 1 || idx == 3)
+        {
+            sync_rsp(n64);
+        }
         
         switch(idx)
         {
             case 0: return read_sp_regs(n64,addr); 
-            case 1: unimplemented("read_mem: dp command regs"); return 0;
+            case 1: return read_dp_regs(n64,addr);
             case 2: unimplemented("read_mem: dp span regs"); return 0;
             case 3: return read_mi(n64,addr); 
             case 4: return read_vi(n64,addr); 
@@ -116,10 +135,24 @@ void write_physical(N64 &n64, u32 addr, access_type v)
 {
     addr &= ~(sizeof(access_type) - 1);
 
+    // only memory code can run from is mapped writeable
+    if(addr < PHYSICAL_MEMORY_SIZE)
+    {
+        u8* page = n64.mem.page_table_write[addr >> PAGE_SHIFT];
+
+        if(page)
+        {
+            handle_write_n64<access_type>(page,addr & PAGE_MASK,v);
+            invalidate_code(n64,addr);
+            return;
+        }
+    }
+
     // just do something naive for now so we can get roms running
     if(addr < 0x0080'0000)
     {
         handle_write_n64<access_type>(n64.mem.rd_ram,addr,v);
+        invalidate_code(n64,addr);
     }
 
     // UNUSED
@@ -134,12 +167,16 @@ void write_physical(N64 &n64, u32 addr, access_type v)
 
     else if(addr < 0x0400'1000)
     {
+        sync_rsp(n64);
         handle_write_n64<access_type>(n64.mem.sp_dmem,addr & 0xfff,v);
+        invalidate_code(n64,addr);
     }
 
     else if(addr < 0x0400'2000)
     {
+        sync_rsp(n64);
         handle_write_n64<access_type>(n64.mem.sp_imem,addr & 0xfff,v);
+        invalidate_code(n64,addr);
     }
 
     // UNUSED
@@ -151,11 +188,17 @@ void write_physical(N64 &n64, u32 addr, access_type v)
     else if(addr < 0x0500'0000)
     {
         const u32 idx = (addr >> 20) & 0xf;
+
+        // sp, dp and mi regs can all be changed by the rsp
+        if(idx <= 1 || idx == 3)
+        {
+            sync_rsp(n64);
+        }
         
         switch(idx)
         {
             case 0: write_sp_regs(n64,addr,v); break;
-            case 1: unimplemented("write_mem: dp command regs"); break;
+            case 1: write_dp_regs(n64,addr,v); break;
             case 2: unimplemented("write_mem: dp span regs"); break;
             case 3: write_mi(n64,addr,v); break;
             case 4: write_vi(n64,addr,v); break;
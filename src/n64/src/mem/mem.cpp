@@ -77,21 +77,41 @@ void handle_write_n64(std::vector<u8> &buf, u32 addr, access_type v)
 void do_pi_dma(N64 &n64, u32 src, u32 dst, u32 len);
 
 
-void write_physical_table(Mem& mem,const u32 offset)
+void map_physical_pages(Mem& mem, u32 addr, u8* buf, u32 size, b32 writeable)
 {
-    const u32 RDRAM_SIZE = 0x0080'0000 / PAGE_SIZE;
-    for(u32 i = 0; i < RDRAM_SIZE; i++)
+    for(u32 offset = 0; offset < size; offset += PAGE_SIZE)
     {
-        mem.page_table_read[offset + i] = &mem.rd_ram[i * PAGE_SIZE];
-        mem.page_table_write[offset + i] = &mem.rd_ram[i * PAGE_SIZE];
-    } 
+        const u32 page = (addr + offset) >> PAGE_SHIFT;
 
-    const u32 ROM_OFFSET = (0x1000'0000 / PAGE_SIZE);
-    const u32 ROM_SIZE = (0x1FC0'0000 - 0x1000'0000) / PAGE_SIZE;
+        mem.page_table_read[page] = &buf[offset];
+        mem.page_table_write[page] = writeable? &buf[offset] : nullptr;
+    }
+}
+
+void write_physical_table(Mem& mem)
+{
+    std::fill(mem.page_table_read.begin(),mem.page_table_read.end(),nullptr);
+    std::fill(mem.page_table_write.begin(),mem.page_table_write.end(),nullptr);
 
-    for(u32 i = 0; i < ROM_SIZE; i++)
+    map_physical_pages(mem,0x0000'0000,mem.rd_ram,RD_RAM_SIZE,true);
+    if(!mem.sp_mem_shared)
     {
-        mem.page_table_read[ROM_OFFSET + offset + i] = &mem.rom[i * PAGE_SIZE];
+        map_physical_pages(mem,0x0400'0000,mem.sp_dmem.data(),mem.sp_dmem.size(),true);
+        map_physical_pages(mem,0x0400'1000,mem.sp_imem.data(),mem.sp_imem.size(),true);
+    }
+
+    // rom mirrors through the whole cart domain, same wrapping as the slow path
+    // a page the rom ends part way through is left to the slow path, so a read cannot run off the end
+    const u32 rom_mask = mem.rom.size() - 1;
+
+    for(u32 addr = 0x1000'0000; addr < 0x1FC0'0000; addr += PAGE_SIZE)
+    {
+        const u32 offset = addr & rom_mask;
+
+        if(offset + PAGE_SIZE <= mem.rom.size())
+        {
+            mem.page_table_read[addr >> PAGE_SHIFT] = &mem.rom[offset];
+        }
     }
 }
 
@@ -123,8 +143,18 @@ void reset_mem(Mem &mem, const std::string &filename)
 
     // init memory
     // 8mb rd ram
-    mem.rd_ram.resize(8 * 1024 * 1024);
-    memset(&mem.rd_ram[0],0,mem.rd_ram.size());
+    if(mem.fastmem.rd_ram)
+    {
+        mem.rd_ram = mem.fastmem.rd_ram;
+    }
+
+    else
+    {
+        mem.rd_ram_buffer.resize(RD_RAM_SIZE);
+        mem.rd_ram = mem.rd_ram_buffer.data();
+    }
+
+    memset(mem.rd_ram,0,RD_RAM_SIZE);
 
     mem.sp_dmem.resize(0x1000);
 
@@ -168,14 +198,24 @@ void reset_mem(Mem &mem, const std::string &filename)
     }
 
 
+    map_fastmem_rom(mem.fastmem,mem.rom);
+
     // hle pif rom
     memcpy(mem.sp_dmem.data(),mem.rom.data(),0x1000);
 
     mem.ri = {};
     mem.pi = {};
+
+    // the ipl sets domain 1 timing up from the first word of the header
+    const u32 header = handle_read<u32>(mem.rom,0x0);
+    mem.pi.bsd_dom1_lat = (header >> 0) & 0xff;
+    mem.pi.bsd_dom1_pwd = (header >> 8) & 0xff;
+    mem.pi.bsd_dom1_pgs = (header >> 16) & 0xf;
+    mem.pi.bsd_dom1_rls = (header >> 20) & 0b11;
     mem.mi = {};
     mem.vi = {};
     mem.sp_regs = {};
+    mem.dp_regs = {};
     mem.si = {};
     mem.ai = {};
     mem.joybus.enabled = false;
@@ -183,17 +223,7 @@ void reset_mem(Mem &mem, const std::string &filename)
     // setup the page table
     mem.page_table_read.resize(PAGE_TABLE_SIZE);
     mem.page_table_write.resize(PAGE_TABLE_SIZE);
-
-    for(u32 i = 0; i < PAGE_TABLE_SIZE; i++)
-    {
-        mem.page_table_read[i] = nullptr;
-        mem.page_table_write[i] = nullptr;
-    }
-
-
-    // TODO: This page table should just work over physical addresses.
-    write_physical_table(mem,0x8000'0000 / PAGE_SIZE);
-    write_physical_table(mem,0xA000'0000 / PAGE_SIZE);
+    write_physical_table(mem);
 }
 
 // TODO: Get rid of this function when everything has been swapped over
@@ -246,8 +276,8 @@ void write_physical_debug(N64 &n64, u32 addr, access_type v)
         }
     }
 
+    // the access is part of the instr cost, whatever ran the instr charges for it
     write_physical<access_type>(n64,addr,v);
-    cycle_tick(n64,1);
 }
 
 
@@ -279,8 +309,6 @@ access_type read_physical_debug(N64 &n64, u32 addr)
         }
     }
 
-    cycle_tick(n64,1);
-
     return v;
 }
 
@@ -335,11 +363,14 @@ void write_u64_physical(N64 &n64,u32 addr,u64 v)
 }
 
 #include "mem/mips_interface.cpp"
+#include "mem/dma.cpp"
 #include "mem/rdram.cpp"
 #include "mem/sp_regs.cpp"
+#include "mem/dp_regs.cpp"
 #include "mem/video_interface.cpp"
 #include "mem/peripheral_interface.cpp"
 #include "mem/pif.cpp"
 #include "mem/serial_interface.cpp"
 #include "mem/audio_interface.cpp"
-#include "mem/tlb.cpp"
\ No newline at end of file
+#include "mem/tlb.cpp"
+#include "mem/fastmem.cpp"
\ No newline at end of file
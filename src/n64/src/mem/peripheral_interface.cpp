@@ -10,7 +10,6 @@ void pi_dma_finished(N64& n64)
     set_mi_interrupt(n64,PI_INTR_BIT);
 }
 
-// TODO: handle dma domains properly
 void do_pi_dma(N64 &n64, u32 src, u32 dst, u32 len)
 {
     spdlog::trace("pi dma from {:x} to {:x} len {:x}\n",src,dst,len);
@@ -24,18 +23,10 @@ void do_pi_dma(N64 &n64, u32 src, u32 dst, u32 len)
 
     pi.busy = true;
 
-    // for now just do it naviely with a read and write
-    // and optimise it with memcpy later
-    // len aligned to 16 bit
-    for(u32 i = 0; i < len; i += 2)
-    {
-        const u16 v = read_physical<u16>(n64,src + i);
-        write_physical<u16>(n64,dst+i,v);
-    }
-
+    // the data moves straight away, only the end of the transfer is timed
+    dma_copy(n64,src,dst,len);
 
-    // TODO: what should the timings on this be?
-    const auto event = n64.scheduler.create_event(20,n64_event::pi_dma);
+    const auto event = n64.scheduler.create_event(pi_dma_cycles(pi,src,len),n64_event::pi_dma);
     n64.scheduler.insert(event,false);  
 }
 
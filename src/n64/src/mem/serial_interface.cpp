@@ -3,8 +3,7 @@ namespace nintendo64
 
 void insert_si_event(N64& n64)
 {
-    // how long does this take?
-    const auto event = n64.scheduler.create_event(16,n64_event::si_dma);
+    const auto event = n64.scheduler.create_event(si_dma_cycles(),n64_event::si_dma);
     n64.scheduler.insert(event,false);    
 }
 
@@ -28,11 +27,7 @@ void do_si_dma(N64& n64, u64 src, u64 dst)
 
     spdlog::trace("si dma of 256 bytes from {:x} to {:x}\n",src,dst);
 
-    for(u32 i = 0; i < 64; i += 4)
-    {
-        const u32 data = read_physical<u32>(n64,src + i);
-        write_physical<u32>(n64,dst+i,data);
-    }
+    dma_copy(n64,src,dst,64);
 
     n64.mem.si.dma_busy = true;
 
@@ -1,65 +1,94 @@
 namespace nintendo64
 {
 
-void insert_sp_dma_event(N64& n64)
+void insert_sp_dma_event(N64& n64, u32 cycles)
 {
-    // How long should this take?
-    const auto event = n64.scheduler.create_event(20,n64_event::sp_dma);
+    const auto event = n64.scheduler.create_event(cycles,n64_event::sp_dma);
     n64.scheduler.insert(event,false);    
 }
 
-void do_sp_dma(N64& n64, b32 to_rdram)
+// one row of a transfer, split where it wraps around sp mem
+void sp_dma_row(N64& n64, u8* sp_mem, u32 mem_addr, u32 dram_addr, u32 len, b32 to_rdram)
 {
-    auto& sp = n64.mem.sp_regs;
-
-    sp.dma_busy = true;
-
-    u8* sp_mem = sp.dmem_or_imem? n64.mem.sp_dmem.data() : n64.mem.sp_imem.data();
-
-    if(to_rdram)
+    while(len)
     {
-        auto& reg = sp.write_dma;
+        const u32 offset = mem_addr & 0xfff;
+        const u32 run = std::min(len,0x1000 - offset);
 
-        u32 dst = sp.dram_addr;
-        u32 src = sp.mem_addr; 
-
-        for(u32 c = 0; c < reg.count; c++)
+        if(dram_addr + run <= RD_RAM_SIZE)
         {
-            for(u32 i = 0; i < reg.len; i++)
+            if(to_rdram)
             {
-                write_physical<u8>(n64,dst + i, sp_mem[(src + i) & 0xfff]);
+                copy_run(n64.mem.rd_ram,dram_addr,sp_mem,offset,run);
+                invalidate_code_range(n64,dram_addr,run);
             }
 
-            src += reg.skip;
-            dst += reg.skip;
+            else
+            {
+                copy_run(sp_mem,offset,n64.mem.rd_ram,dram_addr,run);
+            }
         }
-    }
 
-    else
-    {
-        auto& reg = sp.read_dma;
-
-        u32 dst = sp.dram_addr;
-        u32 src = sp.mem_addr; 
-
-        for(u32 c = 0; c < reg.count; c++)
+        // off the end of rdram, let the slow path deal with it
+        else
         {
-            for(u32 i = 0; i < reg.len; i++)
+            for(u32 i = 0; i < run; i += sizeof(u32))
             {
-                sp_mem[(src + i) & 0xfff] = read_physical<u8>(n64,dst + i);
+                if(to_rdram)
+                {
+                    write_physical<u32>(n64,dram_addr + i,handle_read<u32>(&sp_mem[offset + i]));
+                }
+
+                else
+                {
+                    handle_write<u32>(&sp_mem[offset + i],read_physical<u32>(n64,dram_addr + i));
+                }
             }
-
-            src += reg.skip;
-            dst += reg.skip;
         }
+
+        mem_addr += run;
+        dram_addr += run;
+        len -= run;
+    }
+}
+
+void do_sp_dma(N64& n64, b32 to_rdram)
+{
+    auto& sp = n64.mem.sp_regs;
+
+    sp.dma_busy = true;
+
+    u8* sp_mem = sp.dmem_or_imem? n64.mem.sp_imem.data() : n64.mem.sp_dmem.data();
+    const auto& reg = to_rdram? sp.write_dma : sp.read_dma;
+
+    u32 dram_addr = sp.dram_addr;
+    u32 mem_addr = sp.mem_addr; 
+
+    // queued draws have to land before the rsp reads them, or write over it
+    flush_if_dirty(n64,dram_addr,reg.count * (reg.len + reg.skip));
+
+    for(u32 c = 0; c < reg.count; c++)
+    {
+        sp_dma_row(n64,sp_mem,mem_addr,dram_addr,reg.len,to_rdram);
+
+        mem_addr += reg.len;
+        dram_addr += reg.len + reg.skip;
+    }
+
+    if(!to_rdram)
+    {
+        invalidate_code(n64,sp.dmem_or_imem? 0x0400'1000 : 0x0400'0000);
     }
 
     // add a end event
-    insert_sp_dma_event(n64);
+    insert_sp_dma_event(n64,sp_dma_cycles(reg.count,reg.len));
 }
 
 void sp_dma_finished(N64& n64)
 {
+    // the rsp can see the busy flag and the next transfer lands in its memory
+    sync_rsp(n64);
+
     auto& sp = n64.mem.sp_regs;
 
     // dma over
@@ -77,9 +106,10 @@ void sp_dma_finished(N64& n64)
 
 void write_sp_dma(N64& n64, SpDma& reg, u32 v, b32 to_rdram)
 {
-    reg.len = v & 0xfff;
-    reg.count = (v >> 12) & 0xff;
-    reg.skip = (v >> 20) & 0xfff;
+    // length and count are stored minus one, transfers are in 8 byte units
+    reg.len = ((v & 0xfff) | 7) + 1;
+    reg.count = ((v >> 12) & 0xff) + 1;
+    reg.skip = (v >> 20) & 0xff8;
 
     auto& sp = n64.mem.sp_regs;
 
@@ -97,7 +127,7 @@ void write_sp_dma(N64& n64, SpDma& reg, u32 v, b32 to_rdram)
 
 u32 read_sp_dma(SpDma& reg)
 {
-    return reg.len | reg.count << 12 | reg.skip << 20;
+    return (reg.len - 1) | (reg.count - 1) << 12 | reg.skip << 20;
 }
 
 void write_sp_regs(N64& n64, u64 addr ,u32 v)
@@ -109,15 +139,22 @@ void write_sp_regs(N64& n64, u64 addr ,u32 v)
     {
         case SP_PC: 
         {
-            sp.pc = v & 0xfff;
+            write_rsp_pc(n64,v);
             break;
         }
 
         case SP_STATUS:
         {
+            const b32 halted = sp.halt;
+
             sp.halt = deset_if_set(sp.halt,v,0);
             sp.halt = set_if_set(sp.halt,v,1);
 
+            if(halted && !sp.halt)
+            {
+                start_rsp(n64);
+            }
+
             sp.broke = deset_if_set(sp.broke,v,2);
 
             if(is_set(v,3))
@@ -133,21 +170,14 @@ void write_sp_regs(N64& n64, u64 addr ,u32 v)
             sp.single_step = deset_if_set(sp.single_step,v,5);
             sp.single_step = set_if_set(sp.single_step,v,6);
 
-            sp.clear_intr_on_break = is_set(v,7);
-            sp.set_intr_on_break = is_set(v,8);
+            sp.intr_on_break = deset_if_set(sp.intr_on_break,v,7);
+            sp.intr_on_break = set_if_set(sp.intr_on_break,v,8);
 
-            // handle signal sets
+            // each signal has a clear then a set bit
             for(u32 i = 0; i < 8; i++)
             {
-                const u32 idx = ((i + 9) * 2);
-                sp.signal = set_bitset_if_set(sp.signal,v,idx,i);
-            }
-
-            // handle signal clear
-            for(u32 i = 0; i < 8; i++)
-            {
-                const u32 idx = ((i + 10) * 2);
-                sp.signal = deset_bitset_if_set(sp.signal,v,idx,i);
+                sp.signal = deset_bitset_if_set(sp.signal,v,9 + (i * 2),i);
+                sp.signal = set_bitset_if_set(sp.signal,v,10 + (i * 2),i);
             }
             break;
         }
@@ -206,7 +236,7 @@ u32 read_sp_regs(N64& n64, u64 addr)
     {
         case SP_PC:
         {
-            return sp.pc;
+            return n64.rsp.pc;
         }
 
         case SP_MEM_ADDR:
@@ -238,8 +268,10 @@ u32 read_sp_regs(N64& n64, u64 addr)
 
         case SP_SEMAPHORE: 
         {
+            // reading takes it
+            const b32 taken = sp.semaphore;
             sp.semaphore = true;
-            return 0;
+            return taken;
         }
 
         case SP_DMA_BUSY:
@@ -24,7 +24,26 @@ void set_tlb_exception_regs(N64& n64, u32 full_vpn, u32 region)
 
 }
 
-std::optional<u64> translate_vaddr(N64& n64, u64 addr, tlb_access access) {
+void flush_tlb_cache(TLBCache& cache)
+{
+    cache.generation++;
+
+    // wrapped, old entries could look live again
+    if(cache.generation == 0)
+    {
+        for(auto& entry : cache.entry)
+        {
+            entry.generation = 0;
+        }
+
+        cache.generation = 1;
+    }
+}
+
+std::optional<u64> translate_vaddr_tlb(N64& n64, u64 addr, tlb_access access);
+
+// kept small so the direct mapped case inlines into every load and store
+inline std::optional<u64> translate_vaddr(N64& n64, u64 addr, tlb_access access) {
     const u16 tlb_set = 0b11'11'00'00'11111111;
     const u32 idx = (addr & 0xf000'0000) >> 28;
 
@@ -36,9 +55,34 @@ std::optional<u64> translate_vaddr(N64& n64, u64 addr, tlb_access access) {
         return addr & 0x1FFF'FFFF;
     }
 
+    return translate_vaddr_tlb(n64,addr,access);
+}
+
+std::optional<u64> translate_vaddr_tlb(N64& n64, u64 addr, tlb_access access) {
     // TLB mapped
     auto& cop0 = n64.cpu.cop0;
     auto& tlb = n64.mem.tlb;
+    auto& cache = tlb.cache;
+
+    // cached translations are only good for the asid they were made under
+    if(cache.asid != cop0.entry_hi.asid)
+    {
+        flush_tlb_cache(cache);
+        cache.asid = cop0.entry_hi.asid;
+    }
+
+    // only the low 32 bits take part in the match
+    const u32 vpage = u32(addr) >> 12;
+    auto& cached = cache.entry[vpage & (TLB_CACHE_SIZE - 1)];
+
+    // writes to a clean page take the slow path so they still raise TLBM
+    if(cached.generation == cache.generation && cached.vpage == vpage && (access == tlb_access::read || cached.dirty))
+    {
+        cache.hits++;
+        return (u64(cached.ppage) << 12) | (addr & 0xfff);
+    }
+
+    cache.misses++;
 
     // For 32 bit mode, 64 bit is just full at 27 bits
     const u64 vpn2_mode_mask = 0x0007'ffff;
@@ -84,6 +128,13 @@ std::optional<u64> translate_vaddr(N64& n64, u64 addr, tlb_access access) {
             const u32 page_offset = addr & (page_mask | 0xfff);
             const u32 translated_addr = ((entry_lo.pfn << 12) & ~page_mask) | page_offset;
             spdlog::trace("Translated addr to {:x} from {:x} ({:x})",translated_addr,addr,page_mask);
+
+            // pages are at least 4KB and aligned, so this holds for the whole vpage
+            cached.vpage = vpage;
+            cached.ppage = translated_addr >> 12;
+            cached.generation = cache.generation;
+            cached.dirty = entry_lo.d;
+
             return translated_addr;
         }
     }
@@ -146,6 +197,8 @@ void write_tlb(N64& n64, u32 idx)
 
     tlb.entry[idx].entry_lo_zero.g = g;
     tlb.entry[idx].entry_lo_one.g = g;
+
+    flush_tlb_cache(tlb.cache);
 }
 
 
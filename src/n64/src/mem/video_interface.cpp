@@ -16,6 +16,7 @@ void write_vi(N64& n64, u64 addr ,u32 v)
             vi.divot = is_set(v,4);
             vi.serrate = is_set(v,6);
             vi.aa = (v >> 8) & 0b11;
+            vi.dither_filter = is_set(v,16);
 
             spdlog::trace("Video Interface Control: {} bpp, {}{}{}{}, {} anti-aliasing", vi.bpp, vi.gamma_dither ? "Gamma Dither Enable, " : "", vi.gamma ? "Gamma Enable, " : "", vi.divot ? "Divot Enable, " : "", vi.serrate ? "Serrate, " : "", vi.aa);
 
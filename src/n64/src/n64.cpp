@@ -11,8 +11,15 @@
 #include "instr/instr.cpp"
 #include "instr/mips_lut.cpp"
 #include "rcp/rdp.cpp"
+#include "rcp/rdp_raster.cpp"
+#include "rcp/rdp_commands.cpp"
+#include "rcp/scan_out.cpp"
+#include "rcp/rsp.cpp"
 #include "debug.cpp"
 #include "scheduler.cpp"
+#include "cpu/dynarec.cpp"
+#include "cpu/instr_cache.cpp"
+#include "cpu/idle_loop.cpp"
 
 namespace nintendo64
 {
@@ -59,16 +66,27 @@ const char* reg_name(u32 idx)
 
 void reset(N64 &n64, const std::string &filename)
 {
+    // nothing can still be running against the old state
+    sync_rsp(n64);
+
     reset_mem(n64.mem,filename);
     reset_cpu(n64);
     reset_rdp(n64);
+    reset_rsp(n64);
+    reset_dynarec(n64.dynarec);
+    reset_instr_cache(n64.instr_cache);
+    reset_idle_loops(n64.idle_loops);
     n64.size_change = false;
 
     // initializer external disassembler
     n64.program = beyond_all_repair::make_program(0xA4000040,false,&read_func,&n64);
 
+    // keep whatever the frontend is playing through
+    Playback* playback = n64.audio_buffer.playback;
     n64.audio_buffer = make_audio_buffer();
     reset_audio_buffer(n64.audio_buffer);
+    n64.audio_buffer.playback = playback;
+    reset_resampler(n64.resampler);
 
     spdlog::info("N64 Emulation Core initialized.");
 }
@@ -91,6 +109,27 @@ void run_internal(N64 &n64)
                     return;
                 }
             }
+
+            else
+            {
+                const u64 pc = n64.cpu.pc;
+
+                // hot code runs recompiled, then from pre decoded pages
+                // the full interpreter picks up anything neither will take
+                if(!run_block(n64) && !run_cached(n64))
+                {
+                    step<debug>(n64);
+                }
+
+                // coming back round to where we were is the only way into an idle loop
+                if(n64.cpu.pc <= pc)
+                {
+                    skip_idle_loop(n64);
+                }
+
+                continue;
+            }
+
             step<debug>(n64);
         }
         n64.scheduler.service_events();
@@ -101,8 +140,36 @@ void run_internal(N64 &n64)
 }
 
 
+// service whatever is due between steps, as the run loop does between runs
+void step_events(N64& n64)
+{
+    if(n64.scheduler.event_ready())
+    {
+        n64.scheduler.service_events();
+    }
+}
+
+void step_instr(N64& n64)
+{
+    step_events(n64);
+    step<false>(n64);
+}
+
+void step_block(N64& n64)
+{
+    step_events(n64);
+
+    if(!run_block(n64) && !run_cached(n64))
+    {
+        step<false>(n64);
+    }
+}
+
 void run(N64& n64)
 {
+    // the guest rounding mode only holds while we are in here
+    const HostFpuScope host_fpu(n64.cpu.cop1);
+
     if(n64.debug_enabled)
     {
         run_internal<true>(n64);
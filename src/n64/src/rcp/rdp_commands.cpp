@@ -0,0 +1,700 @@
+#include <n64/n64.h>
+
+// rdp command list processing
+// state and tmem changes are applied as they are parsed, draws are queued
+// and rasterised together in flush_rdp
+
+namespace nintendo64
+{
+
+// draws held before a flush is forced
+static constexpr u32 RDP_QUEUE_LIMIT = 4096;
+
+// less rows than this is not worth handing to the pool
+static constexpr u32 RDP_MIN_SPLIT_ROWS = 32;
+static constexpr u32 RDP_MIN_BAND_ROWS = 8;
+
+static constexpr u32 RDP_DEFAULT_THREADS = 4;
+
+void reset_rdp_commands(RdpCommands& commands)
+{
+    commands.state = RdpState {};
+    commands.tmem.fill(0);
+
+    commands.states.clear();
+    commands.tmem_snapshots.clear();
+    commands.state_changed = true;
+    commands.tmem_changed = true;
+
+    commands.queue.clear();
+    commands.pending.clear();
+
+    commands.dirty_start = 0;
+    commands.dirty_end = 0;
+
+    if(!commands.threads && !commands.pool)
+    {
+        commands.threads = std::min(RDP_DEFAULT_THREADS,std::thread::hardware_concurrency());
+    }
+}
+
+void set_rdp_threads(N64& n64, u32 threads)
+{
+    auto& commands = n64.rdp.commands;
+
+    flush_rdp(n64);
+
+    commands.threads = threads;
+    commands.pool.reset();
+}
+
+void render_bands(N64& n64, u32 y_start, u32 y_end)
+{
+    auto& commands = n64.rdp.commands;
+    u8* ram = n64.mem.rd_ram;
+
+    const u32 rows = y_end - y_start;
+
+    if(commands.threads <= 1 || rows < RDP_MIN_SPLIT_ROWS)
+    {
+        render_band(ram,commands,y_start,y_end);
+        return;
+    }
+
+    if(!commands.pool)
+    {
+        commands.pool = std::make_unique<ThreadPool>(commands.threads);
+    }
+
+    // a few bands a worker so stealing can even out busy rows
+    const u32 bands = std::min(rows / RDP_MIN_BAND_ROWS,commands.threads * 4);
+    const u32 band_rows = (rows + bands - 1) / bands;
+
+    for(u32 y = y_start; y < y_end; y += band_rows)
+    {
+        const u32 band_end = std::min(y + band_rows,y_end);
+
+        commands.pool->submit([ram,&commands,y,band_end](u32 worker)
+        {
+            UNUSED(worker);
+            render_band(ram,commands,y,band_end);
+        });
+    }
+
+    commands.pool->wait();
+}
+
+void flush_rdp(N64& n64)
+{
+    auto& commands = n64.rdp.commands;
+
+    if(commands.queue.empty())
+    {
+        return;
+    }
+
+    u32 y_start = 0xffff'ffff;
+    u32 y_end = 0;
+
+    for(const auto& prim : commands.queue)
+    {
+        y_start = std::min(y_start,prim.y_start);
+        y_end = std::max(y_end,prim.y_end);
+    }
+
+    render_bands(n64,y_start,y_end);
+
+    // draws can land on code, let the cpu drop anything it built from there
+    invalidate_code_range(n64,commands.dirty_start,commands.dirty_end - commands.dirty_start);
+
+    commands.queue.clear();
+    commands.states.clear();
+    commands.tmem_snapshots.clear();
+    commands.state_changed = true;
+    commands.tmem_changed = true;
+
+    commands.dirty_start = 0;
+    commands.dirty_end = 0;
+}
+
+// rdram a row range of an image covers
+void mark_dirty(RdpCommands& commands, u32 addr, u32 width, u32 size, u32 y_start, u32 y_end)
+{
+    const u32 start = (addr + (((y_start * width) << size) >> 1)) & RD_RAM_MASK;
+    const u32 end = std::min(RD_RAM_SIZE,start + ((((y_end - y_start) * width) << size) >> 1));
+
+    if(commands.dirty_start == commands.dirty_end)
+    {
+        commands.dirty_start = start;
+        commands.dirty_end = end;
+    }
+
+    else
+    {
+        commands.dirty_start = std::min(commands.dirty_start,start);
+        commands.dirty_end = std::max(commands.dirty_end,end);
+    }
+}
+
+// y range has to be filled in, anything clipped away entirely is dropped
+void queue_primitive(N64& n64, RdpPrimitive& prim)
+{
+    auto& commands = n64.rdp.commands;
+    const auto& state = commands.state;
+
+    prim.y_start = std::max(prim.y_start,state.scissor_yh >> 2);
+    prim.y_end = std::min(prim.y_end,state.scissor_yl >> 2);
+
+    if(prim.y_start >= prim.y_end)
+    {
+        return;
+    }
+
+    if(commands.state_changed)
+    {
+        commands.states.push_back(state);
+        commands.state_changed = false;
+    }
+
+    if(commands.tmem_changed)
+    {
+        commands.tmem_snapshots.push_back(commands.tmem);
+        commands.tmem_changed = false;
+    }
+
+    prim.state = commands.states.size() - 1;
+    prim.tmem = commands.tmem_snapshots.size() - 1;
+
+    const auto& image = state.color_image;
+    mark_dirty(commands,image.addr,image.width,image.size,prim.y_start,prim.y_end);
+
+    if(state.modes.z_update)
+    {
+        mark_dirty(commands,state.z_addr,image.width,IMAGE_SIZE_16,prim.y_start,prim.y_end);
+    }
+
+    commands.queue.push_back(prim);
+
+    if(commands.queue.size() >= RDP_QUEUE_LIMIT)
+    {
+        flush_rdp(n64);
+    }
+}
+
+s32 sign_extend_coord(u64 v)
+{
+    return s32(u32(v & 0x3fff) << 18) >> 18;
+}
+
+// shade and texture blocks are eight words, the integer parts of the values then
+// their x slopes, the fractions of both, then the same again for the edge and y slopes
+void decode_attrs(RdpPrimitive& prim, const u64* words, u32 first, u32 count)
+{
+    const auto fixed = [](u64 hi, u64 lo, u32 channel)
+    {
+        const u32 shift = 48 - (channel * 16);
+        return s32(u32(((hi >> shift) & 0xffff) << 16) | u32((lo >> shift) & 0xffff));
+    };
+
+    for(u32 i = 0; i < count; i++)
+    {
+        auto& attr = prim.attr[first + i];
+        attr.v = fixed(words[0],words[2],i);
+        attr.dx = fixed(words[1],words[3],i);
+        attr.de = fixed(words[4],words[6],i);
+    }
+}
+
+void triangle_command(N64& n64, const u64* words)
+{
+    const u64 w0 = words[0];
+    const u32 cmd = (w0 >> 56) & 0x3f;
+
+    RdpPrimitive prim;
+    prim.type = rdp_prim::triangle;
+    prim.left_major = is_set(w0,55);
+    prim.tile = (w0 >> 48) & 7;
+
+    prim.yl = sign_extend_coord(w0 >> 32);
+    prim.ym = sign_extend_coord(w0 >> 16);
+    prim.yh = sign_extend_coord(w0);
+
+    prim.xl = s32(words[1] >> 32);
+    prim.dxldy = s32(words[1]);
+    prim.xh = s32(words[2] >> 32);
+    prim.dxhdy = s32(words[2]);
+    prim.xm = s32(words[3] >> 32);
+    prim.dxmdy = s32(words[3]);
+
+    prim.shade = is_set(cmd,2);
+    prim.texture = is_set(cmd,1);
+    prim.zbuffer = is_set(cmd,0);
+
+    u32 idx = 4;
+
+    if(prim.shade)
+    {
+        decode_attrs(prim,&words[idx],attr_r,4);
+        idx += 8;
+    }
+
+    if(prim.texture)
+    {
+        decode_attrs(prim,&words[idx],attr_s,3);
+        idx += 8;
+    }
+
+    if(prim.zbuffer)
+    {
+        auto& z = prim.attr[attr_z];
+        z.v = s32(words[idx] >> 32);
+        z.dx = s32(words[idx]);
+        z.de = s32(words[idx + 1] >> 32);
+    }
+
+    prim.y_start = std::max(prim.yh >> 2,0);
+    prim.y_end = std::max((prim.yl >> 2) + 1,0);
+
+    queue_primitive(n64,prim);
+}
+
+void rect_command(N64& n64, rdp_prim type, u64 w0)
+{
+    const auto cycle = n64.rdp.commands.state.modes.cycle_type;
+
+    RdpPrimitive prim;
+    prim.type = type;
+    prim.rect_xl = (w0 >> 44) & 0xfff;
+    prim.rect_yl = (w0 >> 32) & 0xfff;
+    prim.tile = (w0 >> 24) & 7;
+    prim.rect_xh = (w0 >> 12) & 0xfff;
+    prim.rect_yh = (w0 >> 0) & 0xfff;
+
+    // fill and copy include the far edge
+    prim.y_start = prim.rect_yh >> 2;
+    prim.y_end = (prim.rect_yl >> 2) + (cycle == rdp_cycle::fill || cycle == rdp_cycle::copy);
+
+    queue_primitive(n64,prim);
+}
+
+void tex_rect_command(N64& n64, const u64* words, b32 flip)
+{
+    const auto cycle = n64.rdp.commands.state.modes.cycle_type;
+    const u64 w0 = words[0];
+    const u64 w1 = words[1];
+
+    RdpPrimitive prim;
+    prim.type = rdp_prim::tex_rect;
+    prim.rect_xl = (w0 >> 44) & 0xfff;
+    prim.rect_yl = (w0 >> 32) & 0xfff;
+    prim.tile = (w0 >> 24) & 7;
+    prim.rect_xh = (w0 >> 12) & 0xfff;
+    prim.rect_yh = (w0 >> 0) & 0xfff;
+
+    prim.s = s16(w1 >> 48);
+    prim.t = s16(w1 >> 32);
+    prim.dsdx = s16(w1 >> 16);
+    prim.dtdy = s16(w1 >> 0);
+    prim.flip = flip;
+
+    prim.y_start = prim.rect_yh >> 2;
+    prim.y_end = (prim.rect_yl >> 2) + (cycle == rdp_cycle::copy);
+
+    queue_primitive(n64,prim);
+}
+
+// loads
+
+// pending draws might still write what is about to be read
+void flush_if_dirty(N64& n64, u32 addr, u32 len)
+{
+    const auto& commands = n64.rdp.commands;
+    addr &= RD_RAM_MASK;
+
+    if(addr < commands.dirty_end && addr + len > commands.dirty_start)
+    {
+        flush_rdp(n64);
+    }
+}
+
+u8 read_texture_byte(N64& n64, u32 addr)
+{
+    return handle_read_n64<u8>(n64.mem.rd_ram,addr & RD_RAM_MASK);
+}
+
+RdpTile& load_tile_size(RdpCommands& commands, u64 w)
+{
+    auto& tile = commands.state.tiles[(w >> 24) & 7];
+    tile.sl = (w >> 44) & 0xfff;
+    tile.tl = (w >> 32) & 0xfff;
+    tile.sh = (w >> 12) & 0xfff;
+    tile.th = (w >> 0) & 0xfff;
+
+    return tile;
+}
+
+void load_tile(N64& n64, u64 w)
+{
+    auto& commands = n64.rdp.commands;
+    const auto& image = commands.state.texture_image;
+    const auto& tile = load_tile_size(commands,w);
+
+    const u32 s_start = tile.sl >> 2;
+    const u32 t_start = tile.tl >> 2;
+    const u32 s_end = tile.sh >> 2;
+    const u32 t_end = tile.th >> 2;
+
+    if(s_end < s_start || t_end < t_start)
+    {
+        return;
+    }
+
+    const u32 row_bytes = ((s_end - s_start + 1) << image.size) >> 1;
+    const u32 stride = tile.line * 8 * (tile.size == IMAGE_SIZE_32? 2 : 1);
+
+    flush_if_dirty(n64,image.addr + (((t_start * image.width) << image.size) >> 1),
+        ((((t_end - t_start + 1) * image.width) << image.size) >> 1));
+
+    for(u32 t = t_start; t <= t_end; t++)
+    {
+        const u32 src = image.addr + ((((t * image.width) + s_start) << image.size) >> 1);
+        const u32 dst = (tile.tmem_addr * 8) + ((t - t_start) * stride);
+
+        for(u32 i = 0; i < row_bytes; i++)
+        {
+            commands.tmem[(dst + i) & 0xfff] = read_texture_byte(n64,src + i);
+        }
+    }
+
+    commands.tmem_changed = true;
+}
+
+void load_block(N64& n64, u64 w)
+{
+    auto& commands = n64.rdp.commands;
+    const auto& image = commands.state.texture_image;
+
+    // th holds dxt, the odd line swizzle it drives is not needed with a linear tmem
+    const auto& tile = load_tile_size(commands,w);
+
+    const u32 s_start = tile.sl;
+    const u32 s_end = tile.sh;
+
+    if(s_end < s_start)
+    {
+        return;
+    }
+
+    const u32 bytes = std::min(0x1000u,((s_end - s_start + 1) << image.size) >> 1);
+    const u32 src = image.addr + (((((tile.tl) * image.width) + s_start) << image.size) >> 1);
+    const u32 dst = tile.tmem_addr * 8;
+
+    flush_if_dirty(n64,src,bytes);
+
+    for(u32 i = 0; i < bytes; i++)
+    {
+        commands.tmem[(dst + i) & 0xfff] = read_texture_byte(n64,src + i);
+    }
+
+    commands.tmem_changed = true;
+}
+
+void load_tlut(N64& n64, u64 w)
+{
+    auto& commands = n64.rdp.commands;
+    const auto& image = commands.state.texture_image;
+    const auto& tile = load_tile_size(commands,w);
+
+    const u32 start = tile.sl >> 2;
+    const u32 end = tile.sh >> 2;
+
+    if(end < start)
+    {
+        return;
+    }
+
+    const u32 entries = std::min(256u,end - start + 1);
+    const u32 src = image.addr + (((tile.tl >> 2) * image.width) + start) * sizeof(u16);
+    const u32 dst = tile.tmem_addr * 8;
+
+    flush_if_dirty(n64,src,entries * sizeof(u16));
+
+    for(u32 i = 0; i < entries; i++)
+    {
+        commands.tmem[(dst + (i * 8) + 0) & 0xfff] = read_texture_byte(n64,src + (i * 2) + 0);
+        commands.tmem[(dst + (i * 8) + 1) & 0xfff] = read_texture_byte(n64,src + (i * 2) + 1);
+    }
+
+    commands.tmem_changed = true;
+}
+
+// state
+
+void set_other_modes(RdpOtherModes& modes, u64 w)
+{
+    modes.cycle_type = rdp_cycle((w >> 52) & 3);
+    modes.persp_tex = is_set(w,51);
+    modes.tlut_en = is_set(w,47);
+    modes.tlut_ia = is_set(w,46);
+
+    for(u32 i = 0; i < 2; i++)
+    {
+        const u32 shift = 2 - (i * 2);
+
+        modes.blend_p[i] = (w >> (28 + shift)) & 3;
+        modes.blend_a[i] = (w >> (24 + shift)) & 3;
+        modes.blend_m[i] = (w >> (20 + shift)) & 3;
+        modes.blend_b[i] = (w >> (16 + shift)) & 3;
+    }
+
+    modes.force_blend = is_set(w,14);
+    modes.image_read = is_set(w,6);
+    modes.z_update = is_set(w,5);
+    modes.z_compare = is_set(w,4);
+    modes.z_source_prim = is_set(w,2);
+    modes.alpha_compare = is_set(w,0);
+}
+
+void set_combine(RdpCombiner& cc, u64 w)
+{
+    cc.rgb_sub_a[0] = (w >> 52) & 0xf;
+    cc.rgb_mul[0] = (w >> 47) & 0x1f;
+    cc.alpha_sub_a[0] = (w >> 44) & 0x7;
+    cc.alpha_mul[0] = (w >> 41) & 0x7;
+    cc.rgb_sub_a[1] = (w >> 37) & 0xf;
+    cc.rgb_mul[1] = (w >> 32) & 0x1f;
+
+    cc.rgb_sub_b[0] = (w >> 28) & 0xf;
+    cc.rgb_sub_b[1] = (w >> 24) & 0xf;
+    cc.alpha_sub_a[1] = (w >> 21) & 0x7;
+    cc.alpha_mul[1] = (w >> 18) & 0x7;
+    cc.rgb_add[0] = (w >> 15) & 0x7;
+    cc.alpha_sub_b[0] = (w >> 12) & 0x7;
+    cc.alpha_add[0] = (w >> 9) & 0x7;
+    cc.rgb_add[1] = (w >> 6) & 0x7;
+    cc.alpha_sub_b[1] = (w >> 3) & 0x7;
+    cc.alpha_add[1] = (w >> 0) & 0x7;
+}
+
+void set_tile(RdpTile& tile, u64 w)
+{
+    tile.format = (w >> 53) & 7;
+    tile.size = (w >> 51) & 3;
+    tile.line = (w >> 41) & 0x1ff;
+    tile.tmem_addr = (w >> 32) & 0x1ff;
+    tile.palette = (w >> 20) & 0xf;
+
+    tile.clamp_t = is_set(w,19);
+    tile.mirror_t = is_set(w,18);
+    tile.mask_t = (w >> 14) & 0xf;
+    tile.shift_t = (w >> 10) & 0xf;
+
+    tile.clamp_s = is_set(w,9);
+    tile.mirror_s = is_set(w,8);
+    tile.mask_s = (w >> 4) & 0xf;
+    tile.shift_s = (w >> 0) & 0xf;
+}
+
+RdpImage decode_image(u64 w)
+{
+    RdpImage image;
+    image.format = (w >> 53) & 7;
+    image.size = (w >> 51) & 3;
+    image.width = ((w >> 32) & 0x3ff) + 1;
+    image.addr = w & 0x03ff'ffff;
+
+    return image;
+}
+
+// words each command takes, triangles carry extra blocks for shade, texture and z
+u32 command_words(u32 cmd)
+{
+    if(cmd >= 0x08 && cmd <= 0x0f)
+    {
+        return 4 + (is_set(cmd,2)? 8 : 0) + (is_set(cmd,1)? 8 : 0) + (is_set(cmd,0)? 2 : 0);
+    }
+
+    if(cmd == 0x24 || cmd == 0x25)
+    {
+        return 2;
+    }
+
+    return 1;
+}
+
+void execute_command(N64& n64, const u64* words)
+{
+    auto& commands = n64.rdp.commands;
+    auto& state = commands.state;
+
+    const u64 w = words[0];
+    const u32 cmd = (w >> 56) & 0x3f;
+
+    spdlog::trace("RDP command {:x} : {:016x}",cmd,w);
+
+    if(cmd >= 0x08 && cmd <= 0x0f)
+    {
+        triangle_command(n64,words);
+        return;
+    }
+
+    switch(cmd)
+    {
+        // nop and the syncs only order things we do in order anyway
+        case 0x00: case 0x26: case 0x27: case 0x28: break;
+
+        case 0x24: tex_rect_command(n64,words,false); break;
+        case 0x25: tex_rect_command(n64,words,true); break;
+
+        // sync full
+        case 0x29:
+        {
+            flush_rdp(n64);
+            set_mi_interrupt(n64,DP_INTR_BIT);
+            break;
+        }
+
+        // key and yuv conversion are not emulated
+        case 0x2a: case 0x2b: case 0x2c: break;
+
+        case 0x2d:
+        {
+            state.scissor_xh = (w >> 44) & 0xfff;
+            state.scissor_yh = (w >> 32) & 0xfff;
+            state.scissor_xl = (w >> 12) & 0xfff;
+            state.scissor_yl = (w >> 0) & 0xfff;
+            commands.state_changed = true;
+            break;
+        }
+
+        case 0x2e:
+        {
+            state.prim_z = (w >> 16) & 0x7fff;
+            commands.state_changed = true;
+            break;
+        }
+
+        case 0x2f:
+        {
+            set_other_modes(state.modes,w);
+            commands.state_changed = true;
+            break;
+        }
+
+        case 0x30: load_tlut(n64,w); commands.state_changed = true; break;
+
+        case 0x32:
+        {
+            load_tile_size(commands,w);
+            commands.state_changed = true;
+            break;
+        }
+
+        case 0x33: load_block(n64,w); commands.state_changed = true; break;
+        case 0x34: load_tile(n64,w); commands.state_changed = true; break;
+
+        case 0x35:
+        {
+            set_tile(state.tiles[(w >> 24) & 7],w);
+            commands.state_changed = true;
+            break;
+        }
+
+        case 0x36: rect_command(n64,rdp_prim::fill_rect,w); break;
+
+        case 0x37: state.fill_color = u32(w); commands.state_changed = true; break;
+        case 0x38: state.fog_color = u32(w); commands.state_changed = true; break;
+        case 0x39: state.blend_color = u32(w); commands.state_changed = true; break;
+
+        case 0x3a:
+        {
+            state.prim_color = u32(w);
+            state.prim_lod_frac = (w >> 32) & 0xff;
+            commands.state_changed = true;
+            break;
+        }
+
+        case 0x3b: state.env_color = u32(w); commands.state_changed = true; break;
+
+        case 0x3c:
+        {
+            set_combine(state.combiner,w);
+            commands.state_changed = true;
+            break;
+        }
+
+        case 0x3d:
+        {
+            state.texture_image = decode_image(w);
+            commands.state_changed = true;
+            break;
+        }
+
+        // queued draws all target the same images so bands never overlap in memory
+        case 0x3e:
+        {
+            const u32 addr = w & 0x03ff'ffff;
+
+            if(addr != state.z_addr)
+            {
+                flush_rdp(n64);
+                state.z_addr = addr;
+                commands.state_changed = true;
+            }
+            break;
+        }
+
+        case 0x3f:
+        {
+            const auto image = decode_image(w);
+
+            if(image.addr != state.color_image.addr || image.width != state.color_image.width ||
+                image.size != state.color_image.size || image.format != state.color_image.format)
+            {
+                flush_rdp(n64);
+                state.color_image = image;
+                commands.state_changed = true;
+            }
+            break;
+        }
+
+        default:
+        {
+            spdlog::trace("RDP: unknown command {:x}",cmd);
+            break;
+        }
+    }
+}
+
+u64 read_command_word(N64& n64, u32 addr)
+{
+    if(n64.mem.dp_regs.xbus_dmem_dma)
+    {
+        return handle_read_n64<u64>(n64.mem.sp_dmem,addr & 0xff8);
+    }
+
+    return handle_read_n64<u64>(n64.mem.rd_ram,addr & (RD_RAM_MASK & ~7));
+}
+
+void run_rdp_commands(N64& n64)
+{
+    auto& dp = n64.mem.dp_regs;
+    auto& commands = n64.rdp.commands;
+
+    while(dp.current < dp.end)
+    {
+        commands.pending.push_back(read_command_word(n64,dp.current));
+        dp.current += sizeof(u64);
+
+        // commands can be split across two lists
+        const u32 cmd = (commands.pending[0] >> 56) & 0x3f;
+
+        if(commands.pending.size() == command_words(cmd))
+        {
+            execute_command(n64,commands.pending.data());
+            commands.pending.clear();
+        }
+    }
+}
+
+}
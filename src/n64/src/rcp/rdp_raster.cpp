@@ -0,0 +1,860 @@
+#include <n64/n64.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// pixel pipeline for queued rdp draws
+// everything in here runs on the band workers, so it may only read the
+// snapshots it is handed and write the rows of its own band
+
+// NOTE: this is not cycle or bit accurate, the main simplifications are
+// every pixel is treated as fully covered (no anti aliasing or coverage values)
+// textures are point sampled with no lod, detail or sharpen
+// z is held linearly rather than in the hardware floating point format
+// dithering, noise, chroma key and yuv conversion are not emulated
+
+namespace nintendo64
+{
+
+struct Rgba
+{
+    s32 r = 0;
+    s32 g = 0;
+    s32 b = 0;
+    s32 a = 0;
+};
+
+static constexpr u32 RD_RAM_MASK = RD_RAM_SIZE - 1;
+
+// color image formats, anything else is treated as 8 bit
+static constexpr u32 IMAGE_SIZE_16 = 2;
+static constexpr u32 IMAGE_SIZE_32 = 3;
+
+Rgba unpack_rgba32(u32 v)
+{
+    return Rgba {s32(v >> 24),s32((v >> 16) & 0xff),s32((v >> 8) & 0xff),s32(v & 0xff)};
+}
+
+Rgba unpack_rgba16(u16 v)
+{
+    const s32 r = (v >> 11) & 0x1f;
+    const s32 g = (v >> 6) & 0x1f;
+    const s32 b = (v >> 1) & 0x1f;
+
+    return Rgba {r << 3 | r >> 2,g << 3 | g >> 2,b << 3 | b >> 2,(v & 1)? 0xff : 0};
+}
+
+Rgba unpack_ia16(u16 v)
+{
+    const s32 i = v >> 8;
+    return Rgba {i,i,i,v & 0xff};
+}
+
+u16 pack_rgba16(const Rgba& c)
+{
+    return ((c.r >> 3) << 11) | ((c.g >> 3) << 6) | ((c.b >> 3) << 1) | (c.a >= 0x80);
+}
+
+u32 pack_rgba32(const Rgba& c)
+{
+    return u32(c.r) << 24 | u32(c.g) << 16 | u32(c.b) << 8 | u32(c.a);
+}
+
+s32 clamp_color(s32 v)
+{
+    return std::clamp(v,0,0xff);
+}
+
+// 16 bit pixels pair up in the word swapped u32s rdram is held in,
+// so a run of either size comes down to storing one 32 bit pattern
+void fill_words(u8* ram, u32 addr, u32 words, u32 pattern)
+{
+    u32 i = 0;
+
+    // the run might wrap, keep that on the slow path
+    if(addr + words * sizeof(u32) <= RD_RAM_SIZE)
+    {
+#ifdef __SSE2__
+        const __m128i v = _mm_set1_epi32(s32(pattern));
+
+        for(; i + 4 <= words; i += 4)
+        {
+            _mm_storeu_si128((__m128i*)&ram[addr + i * sizeof(u32)],v);
+        }
+#endif
+
+        for(; i < words; i++)
+        {
+            memcpy(&ram[addr + i * sizeof(u32)],&pattern,sizeof(u32));
+        }
+
+        return;
+    }
+
+    for(; i < words; i++)
+    {
+        handle_write_n64<u32>(ram,(addr + i * sizeof(u32)) & RD_RAM_MASK,pattern);
+    }
+}
+
+// 16 bit patterns hold the even pixel in the top half
+void fill_span(u8* ram, const RdpImage& image, u32 addr, u32 count, u32 pattern)
+{
+    switch(image.size)
+    {
+        case IMAGE_SIZE_16:
+        {
+            // an odd start pixel sits in the low half of its word
+            if((addr & 2) && count)
+            {
+                handle_write_n64<u16>(ram,addr & RD_RAM_MASK,u16(pattern));
+                addr += sizeof(u16);
+                count--;
+            }
+
+            fill_words(ram,addr & RD_RAM_MASK,count / 2,pattern);
+
+            if(count & 1)
+            {
+                handle_write_n64<u16>(ram,(addr + (count & ~1) * sizeof(u16)) & RD_RAM_MASK,u16(pattern >> 16));
+            }
+            break;
+        }
+
+        case IMAGE_SIZE_32:
+        {
+            fill_words(ram,addr & RD_RAM_MASK,count,pattern);
+            break;
+        }
+
+        default:
+        {
+            for(u32 i = 0; i < count; i++)
+            {
+                const u32 a = addr + i;
+                handle_write_n64<u8>(ram,a & RD_RAM_MASK,u8(pattern >> ((3 - (a & 3)) * 8)));
+            }
+            break;
+        }
+    }
+}
+
+u32 pixel_addr(const RdpImage& image, u32 x, u32 y)
+{
+    return image.addr + ((((y * image.width) + x) << image.size) >> 1);
+}
+
+Rgba read_pixel(const u8* ram, const RdpImage& image, u32 addr)
+{
+    switch(image.size)
+    {
+        case IMAGE_SIZE_16: return unpack_rgba16(handle_read_n64<u16>(ram,addr & RD_RAM_MASK));
+        case IMAGE_SIZE_32: return unpack_rgba32(handle_read_n64<u32>(ram,addr & RD_RAM_MASK));
+
+        default:
+        {
+            const s32 i = handle_read_n64<u8>(ram,addr & RD_RAM_MASK);
+            return Rgba {i,i,i,i};
+        }
+    }
+}
+
+void write_pixel(u8* ram, const RdpImage& image, u32 addr, const Rgba& c)
+{
+    switch(image.size)
+    {
+        case IMAGE_SIZE_16: handle_write_n64<u16>(ram,addr & RD_RAM_MASK,pack_rgba16(c)); break;
+        case IMAGE_SIZE_32: handle_write_n64<u32>(ram,addr & RD_RAM_MASK,pack_rgba32(c)); break;
+        default: handle_write_n64<u8>(ram,addr & RD_RAM_MASK,u8(c.r)); break;
+    }
+}
+
+// pattern that fills a span with one pixel
+u32 span_pattern(const RdpImage& image, const Rgba& c)
+{
+    switch(image.size)
+    {
+        case IMAGE_SIZE_16:
+        {
+            const u32 v = pack_rgba16(c);
+            return v << 16 | v;
+        }
+
+        case IMAGE_SIZE_32: return pack_rgba32(c);
+        default: return u32(c.r) * 0x0101'0101;
+    }
+}
+
+// texturing
+
+// tlut entries are spread 8 bytes apart over the top half of tmem
+Rgba lookup_tlut(const RdpState& state, const u8* tmem, u32 idx)
+{
+    const u32 addr = 0x800 + (idx & 0xff) * 8;
+    const u16 v = (tmem[addr] << 8) | tmem[addr + 1];
+
+    return state.modes.tlut_ia? unpack_ia16(v) : unpack_rgba16(v);
+}
+
+Rgba fetch_texel(const RdpState& state, const RdpTile& tile, const u8* tmem, u32 s, u32 t)
+{
+    // 32 bit texels take twice the line, as on hardware each half lives in its own bank
+    const u32 stride = tile.line * 8 * (tile.size == IMAGE_SIZE_32? 2 : 1);
+    const u32 base = tile.tmem_addr * 8 + t * stride;
+
+    switch(tile.size)
+    {
+        case 0:
+        {
+            const u8 v = tmem[(base + (s >> 1)) & 0xfff];
+            const u32 texel = (s & 1)? v & 0xf : v >> 4;
+
+            if(state.modes.tlut_en)
+            {
+                return lookup_tlut(state,tmem,(tile.palette << 4) | texel);
+            }
+
+            // ia
+            if(tile.format == 3)
+            {
+                s32 i = texel >> 1;
+                i = (i << 5) | (i << 2) | (i >> 1);
+                return Rgba {i,i,i,(texel & 1)? 0xff : 0};
+            }
+
+            const s32 i = texel * 0x11;
+            return Rgba {i,i,i,i};
+        }
+
+        case 1:
+        {
+            const u8 v = tmem[(base + s) & 0xfff];
+
+            if(state.modes.tlut_en)
+            {
+                return lookup_tlut(state,tmem,v);
+            }
+
+            if(tile.format == 3)
+            {
+                const s32 i = (v >> 4) * 0x11;
+                return Rgba {i,i,i,(v & 0xf) * 0x11};
+            }
+
+            return Rgba {v,v,v,v};
+        }
+
+        case 2:
+        {
+            const u32 addr = (base + s * 2) & 0xffe;
+            const u16 v = (tmem[addr] << 8) | tmem[addr + 1];
+
+            return tile.format == 3? unpack_ia16(v) : unpack_rgba16(v);
+        }
+
+        default:
+        {
+            const u32 addr = (base + s * 4) & 0xffc;
+            return Rgba {tmem[addr],tmem[addr + 1],tmem[addr + 2],tmem[addr + 3]};
+        }
+    }
+}
+
+// s10.5 coordinate to a texel inside the tile
+u32 wrap_texel(s32 c, u32 lo, u32 hi, u32 shift, u32 mask, b32 clamp, b32 mirror)
+{
+    if(shift < 11)
+    {
+        c >>= shift;
+    }
+
+    else
+    {
+        c <<= (16 - shift);
+    }
+
+    c -= s32(lo << 3);
+
+    s32 texel = c >> 5;
+
+    if(clamp || !mask)
+    {
+        texel = std::clamp(texel,0,std::max(0,(s32(hi) - s32(lo)) >> 2));
+    }
+
+    if(mask)
+    {
+        if(mirror && ((texel >> mask) & 1))
+        {
+            texel = ~texel;
+        }
+
+        texel &= (1 << mask) - 1;
+    }
+
+    return u32(texel);
+}
+
+Rgba sample_tile(const RdpState& state, const u8* tmem, u32 tile_idx, s32 s, s32 t)
+{
+    const auto& tile = state.tiles[tile_idx & 7];
+
+    const u32 ss = wrap_texel(s,tile.sl,tile.sh,tile.shift_s,tile.mask_s,tile.clamp_s,tile.mirror_s);
+    const u32 tt = wrap_texel(t,tile.tl,tile.th,tile.shift_t,tile.mask_t,tile.clamp_t,tile.mirror_t);
+
+    return fetch_texel(state,tile,tmem,ss,tt);
+}
+
+// color combiner
+// each cycle computes (a - b) * c + d per channel from the selected inputs
+
+struct CombineInputs
+{
+    Rgba combined;
+    Rgba tex0;
+    Rgba tex1;
+    Rgba prim;
+    Rgba shade;
+    Rgba env;
+    s32 prim_lod_frac = 0;
+};
+
+// the inputs every rgb mux has in common
+Rgba combiner_color(const CombineInputs& in, u32 sel)
+{
+    switch(sel)
+    {
+        case 0: return in.combined;
+        case 1: return in.tex0;
+        case 2: return in.tex1;
+        case 3: return in.prim;
+        case 4: return in.shade;
+        case 5: return in.env;
+        default: return Rgba {};
+    }
+}
+
+Rgba combiner_rgb_sub_a(const CombineInputs& in, u32 sel)
+{
+    switch(sel)
+    {
+        case 6: return Rgba {0xff,0xff,0xff,0xff};
+
+        // noise
+        case 7: return Rgba {0x80,0x80,0x80,0x80};
+
+        default: return combiner_color(in,sel);
+    }
+}
+
+Rgba combiner_rgb_add(const CombineInputs& in, u32 sel)
+{
+    return sel == 6? Rgba {0xff,0xff,0xff,0xff} : combiner_color(in,sel);
+}
+
+s32 combiner_rgb_mul(const CombineInputs& in, u32 sel, u32 channel)
+{
+    const auto broadcast = [channel](const Rgba& c)
+    {
+        return channel == 0? c.r : channel == 1? c.g : c.b;
+    };
+
+    switch(sel)
+    {
+        case 7: return in.combined.a;
+        case 8: return in.tex0.a;
+        case 9: return in.tex1.a;
+        case 10: return in.prim.a;
+        case 11: return in.shade.a;
+        case 12: return in.env.a;
+        case 14: return in.prim_lod_frac;
+
+        // key scale, lod frac and k5
+        case 6: case 13: case 15: return 0;
+
+        default: return broadcast(combiner_color(in,sel));
+    }
+}
+
+s32 combiner_alpha(const CombineInputs& in, u32 sel)
+{
+    switch(sel)
+    {
+        case 6: return 0xff;
+        case 7: return 0;
+        default: return combiner_color(in,sel).a;
+    }
+}
+
+s32 combiner_alpha_mul(const CombineInputs& in, u32 sel)
+{
+    switch(sel)
+    {
+        case 6: return in.prim_lod_frac;
+
+        // lod frac
+        case 0: case 7: return 0;
+
+        default: return combiner_color(in,sel).a;
+    }
+}
+
+s32 combine_channel(s32 a, s32 b, s32 c, s32 d)
+{
+    // make 0xff a full 1.0
+    c += c >> 7;
+    return clamp_color((((a - b) * c) + (d << 8) + 0x80) >> 8);
+}
+
+Rgba combine_cycle(const RdpCombiner& cc, u32 cycle, const CombineInputs& in)
+{
+    const Rgba a = combiner_rgb_sub_a(in,cc.rgb_sub_a[cycle]);
+
+    // key center and k4 are not emulated
+    const Rgba b = combiner_color(in,cc.rgb_sub_b[cycle]);
+    const Rgba d = combiner_rgb_add(in,cc.rgb_add[cycle]);
+
+    Rgba out;
+    out.r = combine_channel(a.r,b.r,combiner_rgb_mul(in,cc.rgb_mul[cycle],0),d.r);
+    out.g = combine_channel(a.g,b.g,combiner_rgb_mul(in,cc.rgb_mul[cycle],1),d.g);
+    out.b = combine_channel(a.b,b.b,combiner_rgb_mul(in,cc.rgb_mul[cycle],2),d.b);
+
+    out.a = combine_channel(combiner_alpha(in,cc.alpha_sub_a[cycle]),combiner_alpha(in,cc.alpha_sub_b[cycle]),
+        combiner_alpha_mul(in,cc.alpha_mul[cycle]),combiner_alpha(in,cc.alpha_add[cycle]));
+
+    return out;
+}
+
+// in one cycle mode only the second cycle of the combiner is used
+Rgba run_combiner(const RdpState& state, CombineInputs& in)
+{
+    if(state.modes.cycle_type == rdp_cycle::two)
+    {
+        in.combined = combine_cycle(state.combiner,0,in);
+    }
+
+    return combine_cycle(state.combiner,1,in);
+}
+
+// blender
+
+Rgba blender_color(const RdpState& state, u32 sel, const Rgba& pixel, const Rgba& mem)
+{
+    switch(sel)
+    {
+        case 0: return pixel;
+        case 1: return mem;
+        case 2: return unpack_rgba32(state.blend_color);
+        default: return unpack_rgba32(state.fog_color);
+    }
+}
+
+s32 blender_alpha_a(const RdpState& state, u32 sel, s32 pixel_alpha, s32 shade_alpha)
+{
+    switch(sel)
+    {
+        case 0: return pixel_alpha;
+        case 1: return s32(state.fog_color & 0xff);
+        case 2: return shade_alpha;
+        default: return 0;
+    }
+}
+
+s32 blender_alpha_b(u32 sel, s32 a)
+{
+    switch(sel)
+    {
+        case 0: return 0xff - a;
+
+        // memory coverage, always full
+        case 1: case 2: return 0xff;
+        default: return 0;
+    }
+}
+
+// without force blend a fully covered pixel just takes the first input,
+// only the last cycle checks it though
+Rgba blend_cycle(const RdpState& state, u32 cycle, b32 last, const Rgba& pixel, s32 pixel_alpha, s32 shade_alpha, const Rgba& mem)
+{
+    const auto& modes = state.modes;
+    const Rgba p = blender_color(state,modes.blend_p[cycle],pixel,mem);
+
+    if(last && !modes.force_blend)
+    {
+        return p;
+    }
+
+    const Rgba m = blender_color(state,modes.blend_m[cycle],pixel,mem);
+    const s32 a = blender_alpha_a(state,modes.blend_a[cycle],pixel_alpha,shade_alpha);
+    const s32 b = blender_alpha_b(modes.blend_b[cycle],a);
+
+    // (p * a + m * b) / 0xff
+    const auto mix = [a,b](s32 x, s32 y)
+    {
+        return clamp_color((((x * a) + (y * b)) * 257 + 0x8000) >> 16);
+    };
+
+    return Rgba {mix(p.r,m.r),mix(p.g,m.g),mix(p.b,m.b),pixel.a};
+}
+
+b32 blender_reads_memory(const RdpOtherModes& modes)
+{
+    return modes.image_read || modes.blend_p[0] == 1 || modes.blend_m[0] == 1 ||
+        (modes.cycle_type == rdp_cycle::two && (modes.blend_p[1] == 1 || modes.blend_m[1] == 1));
+}
+
+// z buffer
+// 18 bit depth, memory keeps the top 14 bits with the delta z bits left clear
+
+u32 to_depth(s32 z)
+{
+    return u32(std::clamp(z >> 13,0,0x3ffff));
+}
+
+u32 z_addr(const RdpState& state, u32 x, u32 y)
+{
+    return state.z_addr + ((y * state.color_image.width) + x) * sizeof(u16);
+}
+
+// everything a draw needs while it runs
+struct RasterCtx
+{
+    u8* ram = nullptr;
+    const RdpState* state = nullptr;
+    const u8* tmem = nullptr;
+    const RdpPrimitive* prim = nullptr;
+
+    b32 textured = false;
+    b32 read_memory = false;
+};
+
+struct Pixel
+{
+    Rgba shade;
+    s32 s = 0;
+    s32 t = 0;
+    u32 z = 0;
+};
+
+// one or two cycle pixel
+void shade_pixel(const RasterCtx& ctx, u32 x, u32 y, const Pixel& px)
+{
+    const auto& state = *ctx.state;
+    const auto& modes = state.modes;
+
+    const u32 z = modes.z_source_prim? (state.prim_z << 3) : px.z;
+    const u32 za = z_addr(state,x,y) & RD_RAM_MASK;
+
+    if(modes.z_compare)
+    {
+        const u32 mem_z = handle_read_n64<u16>(ctx.ram,za);
+
+        if((z >> 4) > (mem_z >> 2))
+        {
+            return;
+        }
+    }
+
+    CombineInputs in;
+    in.shade = px.shade;
+    in.prim = unpack_rgba32(state.prim_color);
+    in.env = unpack_rgba32(state.env_color);
+    in.prim_lod_frac = s32(state.prim_lod_frac);
+
+    if(ctx.textured)
+    {
+        in.tex0 = sample_tile(state,ctx.tmem,ctx.prim->tile,px.s,px.t);
+
+        if(modes.cycle_type == rdp_cycle::two)
+        {
+            in.tex1 = sample_tile(state,ctx.tmem,ctx.prim->tile + 1,px.s,px.t);
+        }
+    }
+
+    const Rgba combined = run_combiner(state,in);
+
+    // TODO: dithered threshold
+    if(modes.alpha_compare && combined.a < s32(state.blend_color & 0xff))
+    {
+        return;
+    }
+
+    const u32 addr = pixel_addr(state.color_image,x,y);
+    const Rgba mem = ctx.read_memory? read_pixel(ctx.ram,state.color_image,addr) : Rgba {};
+
+    Rgba out;
+
+    if(modes.cycle_type == rdp_cycle::two)
+    {
+        const Rgba first = blend_cycle(state,0,false,combined,combined.a,px.shade.a,mem);
+        out = blend_cycle(state,1,true,first,combined.a,px.shade.a,mem);
+    }
+
+    else
+    {
+        out = blend_cycle(state,0,true,combined,combined.a,px.shade.a,mem);
+    }
+
+    // the coverage bit is always set, only alpha is kept for 32 bit images
+    out.a = state.color_image.size == IMAGE_SIZE_16? 0xff : combined.a;
+    write_pixel(ctx.ram,state.color_image,addr,out);
+
+    if(modes.z_update)
+    {
+        handle_write_n64<u16>(ctx.ram,za,u16((z >> 4) << 2));
+    }
+}
+
+// one cycle draws that come out the same color on every pixel can be filled a span at a time
+// ie nothing per pixel reaches the combiner and the blender just passes a constant through
+b32 flat_color(const RasterCtx& ctx, Rgba& out)
+{
+    const auto& state = *ctx.state;
+    const auto& modes = state.modes;
+    const auto& cc = state.combiner;
+
+    if(modes.cycle_type != rdp_cycle::one || modes.z_compare || modes.z_update || modes.alpha_compare ||
+        modes.force_blend || modes.blend_p[0] == 1)
+    {
+        return false;
+    }
+
+    const auto varies = [](u32 sel)
+    {
+        return sel == 0 || sel == 1 || sel == 2 || sel == 4;
+    };
+
+    const u32 mul = cc.rgb_mul[1];
+
+    if(varies(cc.rgb_sub_a[1]) || cc.rgb_sub_a[1] == 7 || varies(cc.rgb_sub_b[1]) || varies(cc.rgb_add[1]) ||
+        varies(mul) || mul == 7 || mul == 8 || mul == 9 || mul == 11 || varies(cc.alpha_sub_a[1]) ||
+        varies(cc.alpha_sub_b[1]) || varies(cc.alpha_add[1]) || (cc.alpha_mul[1] >= 1 && cc.alpha_mul[1] <= 4 && cc.alpha_mul[1] != 3))
+    {
+        return false;
+    }
+
+    CombineInputs in;
+    in.prim = unpack_rgba32(state.prim_color);
+    in.env = unpack_rgba32(state.env_color);
+    in.prim_lod_frac = s32(state.prim_lod_frac);
+
+    const Rgba combined = run_combiner(state,in);
+    out = blend_cycle(state,0,true,combined,combined.a,0,Rgba {});
+    out.a = state.color_image.size == IMAGE_SIZE_16? 0xff : combined.a;
+
+    return true;
+}
+
+struct Span
+{
+    s32 x_start = 0;
+    s32 x_end = 0;
+};
+
+Span clip_span(const RdpState& state, s32 x_start, s32 x_end)
+{
+    return Span {std::max(x_start,s32(state.scissor_xh >> 2)),std::min(x_end,s32(state.scissor_xl >> 2))};
+}
+
+void draw_triangle(const RasterCtx& ctx, u32 y_start, u32 y_end)
+{
+    const auto& prim = *ctx.prim;
+    const auto& state = *ctx.state;
+
+    // xh and xm are given for the scanline yh falls on
+    const s32 top = prim.yh >> 2;
+
+    // fill mode writes the fill color whatever the triangle carries
+    const b32 fill = state.modes.cycle_type == rdp_cycle::fill;
+
+    Rgba flat;
+    const b32 is_flat = fill || (!prim.shade && !prim.texture && flat_color(ctx,flat));
+    const u32 pattern = fill? state.fill_color : span_pattern(state.color_image,flat);
+
+    for(s32 y = s32(std::max(y_start,prim.y_start)); y < s32(std::min(y_end,prim.y_end)); y++)
+    {
+        // sample each row at its centre
+        const s32 sub = (y * 4) + 2;
+
+        if(sub < prim.yh || sub >= prim.yl)
+        {
+            continue;
+        }
+
+        const s64 dy = (s64(y - top) << 16) + 0x8000;
+        const s32 x_major = prim.xh + s32((s64(prim.dxhdy) * dy) >> 16);
+
+        const s32 x_minor = sub < prim.ym? prim.xm + s32((s64(prim.dxmdy) * dy) >> 16) :
+            prim.xl + s32((s64(prim.dxldy) * (s64(sub - prim.ym) << 14)) >> 16);
+
+        const s32 left = prim.left_major? x_major : x_minor;
+        const s32 right = prim.left_major? x_minor : x_major;
+
+        if(left >= right)
+        {
+            continue;
+        }
+
+        // pixels whose centre is inside the edges
+        const auto span = clip_span(state,(left + 0x7fff) >> 16,(right + 0x7fff) >> 16);
+
+        if(span.x_start >= span.x_end)
+        {
+            continue;
+        }
+
+        if(is_flat)
+        {
+            fill_span(ctx.ram,state.color_image,pixel_addr(state.color_image,span.x_start,y),span.x_end - span.x_start,pattern);
+            continue;
+        }
+
+        // step every attribute to the first pixel, from there it is one dx a pixel
+        s32 v[ATTR_SIZE];
+        const s64 dx = (s64(span.x_start) << 16) + 0x8000 - x_major;
+
+        for(u32 i = 0; i < ATTR_SIZE; i++)
+        {
+            const auto& attr = prim.attr[i];
+            v[i] = attr.v + s32((s64(attr.de) * dy) >> 16) + s32((s64(attr.dx) * dx) >> 16);
+        }
+
+        for(s32 x = span.x_start; x < span.x_end; x++)
+        {
+            Pixel px;
+            px.shade = Rgba {clamp_color(v[attr_r] >> 16),clamp_color(v[attr_g] >> 16),clamp_color(v[attr_b] >> 16),clamp_color(v[attr_a] >> 16)};
+            px.z = to_depth(v[attr_z]);
+
+            px.s = v[attr_s] >> 16;
+            px.t = v[attr_t] >> 16;
+
+            if(state.modes.persp_tex)
+            {
+                const s64 w = std::max(1,v[attr_w] >> 16);
+                px.s = s32((s64(px.s) << 15) / w);
+                px.t = s32((s64(px.t) << 15) / w);
+            }
+
+            shade_pixel(ctx,x,y,px);
+
+            for(u32 i = 0; i < ATTR_SIZE; i++)
+            {
+                v[i] += prim.attr[i].dx;
+            }
+        }
+    }
+}
+
+void draw_fill_rect(const RasterCtx& ctx, u32 y_start, u32 y_end)
+{
+    const auto& prim = *ctx.prim;
+    const auto& state = *ctx.state;
+    const auto cycle = state.modes.cycle_type;
+
+    // fill and copy include the far edge
+    const s32 x_end = s32(prim.rect_xl >> 2) + (cycle == rdp_cycle::fill || cycle == rdp_cycle::copy);
+    const auto span = clip_span(state,prim.rect_xh >> 2,x_end);
+
+    if(span.x_start >= span.x_end)
+    {
+        return;
+    }
+
+    Rgba flat;
+    const b32 is_flat = cycle == rdp_cycle::fill || flat_color(ctx,flat);
+    const u32 pattern = cycle == rdp_cycle::fill? state.fill_color : span_pattern(state.color_image,flat);
+
+    for(u32 y = std::max(y_start,prim.y_start); y < std::min(y_end,prim.y_end); y++)
+    {
+        if(is_flat)
+        {
+            fill_span(ctx.ram,state.color_image,pixel_addr(state.color_image,span.x_start,y),span.x_end - span.x_start,pattern);
+            continue;
+        }
+
+        for(s32 x = span.x_start; x < span.x_end; x++)
+        {
+            shade_pixel(ctx,x,y,Pixel {});
+        }
+    }
+}
+
+void draw_tex_rect(const RasterCtx& ctx, u32 y_start, u32 y_end)
+{
+    const auto& prim = *ctx.prim;
+    const auto& state = *ctx.state;
+    const b32 copy = state.modes.cycle_type == rdp_cycle::copy;
+
+    const s32 x_origin = prim.rect_xh >> 2;
+    const s32 y_origin = prim.rect_yh >> 2;
+
+    const auto span = clip_span(state,x_origin,s32(prim.rect_xl >> 2) + copy);
+
+    if(span.x_start >= span.x_end)
+    {
+        return;
+    }
+
+    // copy mode moves four pixels a cycle, so the slope is given four times over
+    const s32 dsdx = copy? prim.dsdx >> 2 : prim.dsdx;
+
+    for(u32 y = std::max(y_start,prim.y_start); y < std::min(y_end,prim.y_end); y++)
+    {
+        // s10.10 so the s5.10 slopes can be added straight on
+        const s32 row = (prim.t << 5) + prim.dtdy * (s32(y) - y_origin);
+        s32 col = (prim.s << 5) + dsdx * (span.x_start - x_origin);
+
+        for(s32 x = span.x_start; x < span.x_end; x++, col += dsdx)
+        {
+            Pixel px;
+            px.s = (prim.flip? row : col) >> 5;
+            px.t = (prim.flip? col : row) >> 5;
+
+            if(!copy)
+            {
+                shade_pixel(ctx,x,y,px);
+                continue;
+            }
+
+            const Rgba texel = sample_tile(state,ctx.tmem,prim.tile,px.s,px.t);
+
+            if(state.modes.alpha_compare && texel.a == 0)
+            {
+                continue;
+            }
+
+            write_pixel(ctx.ram,state.color_image,pixel_addr(state.color_image,x,y),texel);
+        }
+    }
+}
+
+// draw every queued primitive that touches rows [y_start, y_end)
+// bands never share a row so they can be run in any order
+void render_band(u8* ram, const RdpCommands& commands, u32 y_start, u32 y_end)
+{
+    for(const auto& prim : commands.queue)
+    {
+        if(prim.y_end <= y_start || prim.y_start >= y_end)
+        {
+            continue;
+        }
+
+        RasterCtx ctx;
+        ctx.ram = ram;
+        ctx.state = &commands.states[prim.state];
+        ctx.tmem = commands.tmem_snapshots[prim.tmem].data();
+        ctx.prim = &prim;
+        ctx.textured = prim.type == rdp_prim::tex_rect || prim.texture;
+        ctx.read_memory = blender_reads_memory(ctx.state->modes);
+
+        switch(prim.type)
+        {
+            case rdp_prim::triangle: draw_triangle(ctx,y_start,y_end); break;
+            case rdp_prim::fill_rect: draw_fill_rect(ctx,y_start,y_end); break;
+            case rdp_prim::tex_rect: draw_tex_rect(ctx,y_start,y_end); break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,542 @@
+#include <n64/n64.h>
+
+namespace nintendo64
+{
+
+void rsp_lwc2(N64& n64, u32 op);
+void rsp_swc2(N64& n64, u32 op);
+u32 rsp_mfc2(N64& n64, u32 op);
+void rsp_mtc2(N64& n64, u32 op, u32 v);
+u32 rsp_cfc2(N64& n64, u32 op);
+void rsp_ctc2(N64& n64, u32 op, u32 v);
+
+void reset_rsp(N64& n64)
+{
+    n64.rsp = {};
+}
+
+void start_rsp(N64& n64)
+{
+    if(!n64.scheduler.is_active(n64_event::rsp))
+    {
+        const auto event = n64.scheduler.create_event(RSP_TIMESLICE,n64_event::rsp);
+        n64.scheduler.insert(event,false);
+    }
+}
+
+void write_rsp_pc(N64& n64, u32 v)
+{
+    auto& rsp = n64.rsp;
+
+    rsp.pc = v & 0xffc;
+    rsp.pc_next = (rsp.pc + 4) & 0xffc;
+}
+
+// dmem is held word swapped like the rest of memory
+// the rsp can access it at any alignment and addresses wrap at 4KB
+u8 rsp_read8(N64& n64, u32 addr)
+{
+    return n64.mem.sp_dmem[(addr & 0xfff) ^ 3];
+}
+
+void rsp_write8(N64& n64, u32 addr, u8 v)
+{
+    n64.mem.sp_dmem[(addr & 0xfff) ^ 3] = v;
+}
+
+u16 rsp_read16(N64& n64, u32 addr)
+{
+    return (rsp_read8(n64,addr) << 8) | rsp_read8(n64,addr + 1);
+}
+
+void rsp_write16(N64& n64, u32 addr, u16 v)
+{
+    rsp_write8(n64,addr,v >> 8);
+    rsp_write8(n64,addr + 1,v);
+}
+
+u32 rsp_read32(N64& n64, u32 addr)
+{
+    if((addr & 3) == 0)
+    {
+        return handle_read<u32>(&n64.mem.sp_dmem[addr & 0xfff]);
+    }
+
+    return (rsp_read16(n64,addr) << 16) | rsp_read16(n64,addr + 2);
+}
+
+void rsp_write32(N64& n64, u32 addr, u32 v)
+{
+    if((addr & 3) == 0)
+    {
+        handle_write<u32>(&n64.mem.sp_dmem[addr & 0xfff],v);
+        return;
+    }
+
+    rsp_write16(n64,addr,v >> 16);
+    rsp_write16(n64,addr + 2,v);
+}
+
+// the cpu can run out of dmem, so make sure it does not see stale code
+// the code caches belong to the cpu thread, so this is only noted until the rsp stops
+void rsp_dmem_written(N64& n64)
+{
+    n64.rsp.dmem_dirty = true;
+}
+
+void flush_rsp_writes(N64& n64)
+{
+    if(n64.rsp.dmem_dirty)
+    {
+        invalidate_code(n64,0x0400'0000);
+        n64.rsp.dmem_dirty = false;
+    }
+}
+
+// 0 - 7 are the sp regs, 8 - 15 the dp command regs
+u32 read_rsp_cop0(N64& n64, u32 reg)
+{
+    if(reg < 8)
+    {
+        return read_sp_regs(n64,SP_MEM_ADDR + (reg * sizeof(u32)));
+    }
+
+    return read_dp_regs(n64,DPC_START + ((reg & 7) * sizeof(u32)));
+}
+
+void write_rsp_cop0(N64& n64, u32 reg, u32 v)
+{
+    if(reg < 8)
+    {
+        write_sp_regs(n64,SP_MEM_ADDR + (reg * sizeof(u32)),v);
+    }
+
+    else
+    {
+        write_dp_regs(n64,DPC_START + ((reg & 7) * sizeof(u32)),v);
+    }
+}
+
+void rsp_break(N64& n64)
+{
+    auto& sp = n64.mem.sp_regs;
+
+    sp.halt = true;
+    sp.broke = true;
+
+    if(sp.intr_on_break)
+    {
+        set_mi_interrupt(n64,SP_INTR_BIT);
+    }
+}
+
+// pc already points at the delay slot
+void rsp_branch(Rsp& rsp, b32 cond, u32 op)
+{
+    if(cond)
+    {
+        rsp.pc_next = (rsp.pc + (sign_extend_mips<s32,s16>(op & 0xffff) << 2)) & 0xffc;
+    }
+}
+
+[[noreturn]] void rsp_unknown_opcode(N64& n64, u32 op)
+{
+    const auto err = fmt::format("[rsp {:03x}] unknown opcode {:08x}\n",(n64.rsp.pc - 4) & 0xffc,op);
+    throw std::runtime_error(err);
+}
+
+void rsp_special(N64& n64, u32 op)
+{
+    auto& rsp = n64.rsp;
+    auto& regs = rsp.regs;
+
+    const u32 rs = get_rs(op);
+    const u32 rt = get_rt(op);
+    const u32 rd = get_rd(op);
+    const u32 sa = get_shamt(op);
+
+    switch(op & 0x3f)
+    {
+        case 0x00: regs[rd] = regs[rt] << sa; break;
+        case 0x02: regs[rd] = regs[rt] >> sa; break;
+        case 0x03: regs[rd] = u32(s32(regs[rt]) >> sa); break;
+        case 0x04: regs[rd] = regs[rt] << (regs[rs] & 0x1f); break;
+        case 0x06: regs[rd] = regs[rt] >> (regs[rs] & 0x1f); break;
+        case 0x07: regs[rd] = u32(s32(regs[rt]) >> (regs[rs] & 0x1f)); break;
+
+        // jr
+        case 0x08: rsp.pc_next = regs[rs] & 0xffc; break;
+
+        // jalr
+        case 0x09:
+        {
+            const u32 target = regs[rs] & 0xffc;
+            regs[rd] = (rsp.pc + 4) & 0xffc;
+            rsp.pc_next = target;
+            break;
+        }
+
+        case 0x0d: rsp_break(n64); break;
+
+        // there is no overflow exception on the rsp
+        case 0x20: case 0x21: regs[rd] = regs[rs] + regs[rt]; break;
+        case 0x22: case 0x23: regs[rd] = regs[rs] - regs[rt]; break;
+
+        case 0x24: regs[rd] = regs[rs] & regs[rt]; break;
+        case 0x25: regs[rd] = regs[rs] | regs[rt]; break;
+        case 0x26: regs[rd] = regs[rs] ^ regs[rt]; break;
+        case 0x27: regs[rd] = ~(regs[rs] | regs[rt]); break;
+
+        case 0x2a: regs[rd] = s32(regs[rs]) < s32(regs[rt]); break;
+        case 0x2b: regs[rd] = regs[rs] < regs[rt]; break;
+
+        default: rsp_unknown_opcode(n64,op);
+    }
+}
+
+void rsp_regimm(N64& n64, u32 op)
+{
+    auto& rsp = n64.rsp;
+    auto& regs = rsp.regs;
+
+    const s32 v = s32(regs[get_rs(op)]);
+    const u32 kind = get_rt(op);
+
+    switch(kind)
+    {
+        // bltz, bgez, bltzal, bgezal
+        case 0x00: case 0x01: case 0x10: case 0x11:
+        {
+            const b32 cond = (kind & 1)? v >= 0 : v < 0;
+
+            // link is written taken or not
+            if(kind & 0x10)
+            {
+                regs[beyond_all_repair::RA] = (rsp.pc + 4) & 0xffc;
+            }
+
+            rsp_branch(rsp,cond,op);
+            break;
+        }
+
+        default: rsp_unknown_opcode(n64,op);
+    }
+}
+
+void rsp_cop0(N64& n64, u32 op)
+{
+    auto& regs = n64.rsp.regs;
+
+    switch(get_rs(op))
+    {
+        case 0x00: regs[get_rt(op)] = read_rsp_cop0(n64,get_rd(op)); break;
+        case 0x04: write_rsp_cop0(n64,get_rd(op),regs[get_rt(op)]); break;
+
+        default: rsp_unknown_opcode(n64,op);
+    }
+}
+
+void rsp_cop2_transfer(N64& n64, u32 op)
+{
+    auto& regs = n64.rsp.regs;
+    const u32 rt = get_rt(op);
+
+    // computational ops have the top bit of rs set
+    if(is_set(op,25))
+    {
+        rsp_cop2(n64,op);
+        return;
+    }
+
+    switch(get_rs(op))
+    {
+        case 0x00: regs[rt] = rsp_mfc2(n64,op); break;
+        case 0x02: regs[rt] = rsp_cfc2(n64,op); break;
+        case 0x04: rsp_mtc2(n64,op,regs[rt]); break;
+        case 0x06: rsp_ctc2(n64,op,regs[rt]); break;
+
+        default: rsp_unknown_opcode(n64,op);
+    }
+}
+
+void execute_rsp(N64& n64, u32 op)
+{
+    auto& rsp = n64.rsp;
+    auto& regs = rsp.regs;
+
+    const u32 rs = get_rs(op);
+    const u32 rt = get_rt(op);
+    const u32 imm = op & 0xffff;
+    const u32 simm = sign_extend_mips<s32,s16>(imm);
+
+    const u32 addr = regs[rs] + simm;
+
+    switch(op >> 26)
+    {
+        case 0x00: rsp_special(n64,op); break;
+        case 0x01: rsp_regimm(n64,op); break;
+
+        // j
+        case 0x02: rsp.pc_next = (op << 2) & 0xffc; break;
+
+        // jal
+        case 0x03:
+        {
+            regs[beyond_all_repair::RA] = (rsp.pc + 4) & 0xffc;
+            rsp.pc_next = (op << 2) & 0xffc;
+            break;
+        }
+
+        case 0x04: rsp_branch(rsp,regs[rs] == regs[rt],op); break;
+        case 0x05: rsp_branch(rsp,regs[rs] != regs[rt],op); break;
+        case 0x06: rsp_branch(rsp,s32(regs[rs]) <= 0,op); break;
+        case 0x07: rsp_branch(rsp,s32(regs[rs]) > 0,op); break;
+
+        case 0x08: case 0x09: regs[rt] = regs[rs] + simm; break;
+        case 0x0a: regs[rt] = s32(regs[rs]) < s32(simm); break;
+        case 0x0b: regs[rt] = regs[rs] < simm; break;
+        case 0x0c: regs[rt] = regs[rs] & imm; break;
+        case 0x0d: regs[rt] = regs[rs] | imm; break;
+        case 0x0e: regs[rt] = regs[rs] ^ imm; break;
+        case 0x0f: regs[rt] = imm << 16; break;
+
+        case 0x10: rsp_cop0(n64,op); break;
+        case 0x12: rsp_cop2_transfer(n64,op); break;
+
+        case 0x20: regs[rt] = sign_extend_mips<s32,s8>(rsp_read8(n64,addr)); break;
+        case 0x21: regs[rt] = sign_extend_mips<s32,s16>(rsp_read16(n64,addr)); break;
+        case 0x23: case 0x27: regs[rt] = rsp_read32(n64,addr); break;
+        case 0x24: regs[rt] = rsp_read8(n64,addr); break;
+        case 0x25: regs[rt] = rsp_read16(n64,addr); break;
+
+        case 0x28: rsp_write8(n64,addr,regs[rt]); rsp_dmem_written(n64); break;
+        case 0x29: rsp_write16(n64,addr,regs[rt]); rsp_dmem_written(n64); break;
+        case 0x2b: rsp_write32(n64,addr,regs[rt]); rsp_dmem_written(n64); break;
+
+        case 0x32: rsp_lwc2(n64,op); break;
+        case 0x3a: rsp_swc2(n64,op); rsp_dmem_written(n64); break;
+
+        default: rsp_unknown_opcode(n64,op);
+    }
+}
+
+void step_rsp(N64& n64, u32 op)
+{
+    auto& rsp = n64.rsp;
+
+    rsp.pc = rsp.pc_next;
+    rsp.pc_next = (rsp.pc_next + 4) & 0xffc;
+
+    execute_rsp(n64,op);
+    rsp.regs[0] = 0;
+}
+
+// writes to the sp / dp regs can start dmas, halt or kick the rdp and break can raise an interrupt
+// none of that is safe off the cpu thread, reads of the regs are fine
+b32 rsp_sync_op(u32 op)
+{
+    const u32 kind = op >> 26;
+
+    return (kind == 0x10 && get_rs(op) == 0x04) || (kind == 0x00 && (op & 0x3f) == 0x0d);
+}
+
+// one instr a cycle, it can halt itself at any point
+// on the worker this stops short of any op that has to run on the cpu thread
+// and hands back the cycles it did not get to
+template<const b32 WORKER>
+u32 run_rsp_cycles(N64& n64, u32 cycles)
+{
+    auto& rsp = n64.rsp;
+    auto& sp = n64.mem.sp_regs;
+
+    while(cycles != 0 && !sp.halt)
+    {
+        const u32 op = handle_read<u32>(&n64.mem.sp_imem[rsp.pc]);
+
+        if constexpr(WORKER)
+        {
+            if(rsp_sync_op(op))
+            {
+                return cycles;
+            }
+        }
+
+        step_rsp(n64,op);
+        cycles--;
+    }
+
+    return 0;
+}
+
+u32 rsp_cycles(Rsp& rsp, u32 cpu_cycles)
+{
+    const u32 total = (cpu_cycles * 2) + rsp.cycle_remainder;
+    rsp.cycle_remainder = total % 3;
+
+    return total / 3;
+}
+
+void run_rsp(N64& n64, u32 cpu_cycles)
+{
+    run_rsp_cycles<false>(n64,rsp_cycles(n64.rsp,cpu_cycles));
+    flush_rsp_writes(n64);
+}
+
+void rsp_worker_main(N64& n64)
+{
+    auto& worker = n64.rsp_worker;
+    u32 seen = 0;
+
+    for(;;)
+    {
+        worker.posted.wait(seen,std::memory_order_acquire);
+        seen = worker.posted.load(std::memory_order_acquire);
+
+        if(worker.quit.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        try
+        {
+            worker.remaining = run_rsp_cycles<true>(n64,worker.budget);
+        }
+
+        // handed back to the cpu thread at the next sync
+        catch(...)
+        {
+            worker.error = std::current_exception();
+            worker.remaining = 0;
+        }
+
+        worker.done.store(seen,std::memory_order_release);
+        worker.done.notify_one();
+    }
+}
+
+void post_rsp(N64& n64, u32 cycles)
+{
+    auto& worker = n64.rsp_worker;
+
+    worker.budget = cycles;
+    worker.in_flight = true;
+
+    worker.posted.fetch_add(1,std::memory_order_release);
+    worker.posted.notify_one();
+}
+
+void sync_rsp(N64& n64)
+{
+    auto& worker = n64.rsp_worker;
+
+    if(!worker.in_flight)
+    {
+        return;
+    }
+
+    const u32 posted = worker.posted.load(std::memory_order_relaxed);
+    u32 done = worker.done.load(std::memory_order_acquire);
+
+    while(done != posted)
+    {
+        worker.done.wait(done,std::memory_order_acquire);
+        done = worker.done.load(std::memory_order_acquire);
+    }
+
+    worker.in_flight = false;
+
+    if(worker.error)
+    {
+        const auto error = worker.error;
+        worker.error = nullptr;
+        std::rethrow_exception(error);
+    }
+
+    // finish off the timeslice from where the worker had to stop
+    run_rsp_cycles<false>(n64,worker.remaining);
+    flush_rsp_writes(n64);
+}
+
+void stop_rsp_worker(RspWorker& worker)
+{
+    if(!worker.thread.joinable())
+    {
+        return;
+    }
+
+    worker.quit.store(true,std::memory_order_release);
+    worker.posted.fetch_add(1,std::memory_order_release);
+    worker.posted.notify_one();
+
+    worker.thread.join();
+
+    worker.quit = false;
+    worker.posted = 0;
+    worker.done = 0;
+    worker.in_flight = false;
+}
+
+RspWorker::~RspWorker()
+{
+    stop_rsp_worker(*this);
+}
+
+void set_rsp_threaded(N64& n64, b32 threaded)
+{
+    auto& worker = n64.rsp_worker;
+
+    if(worker.thread.joinable() == bool(threaded))
+    {
+        return;
+    }
+
+    sync_rsp(n64);
+
+    if(threaded)
+    {
+        worker.thread = std::thread([&n64]()
+        {
+            rsp_worker_main(n64);
+        });
+    }
+
+    else
+    {
+        stop_rsp_worker(worker);
+    }
+
+    // sp mem is only direct while nothing else can be writing it
+    n64.mem.sp_mem_shared = threaded;
+    write_physical_table(n64.mem);
+}
+
+void rsp_event(N64& n64, u32 cpu_cycles)
+{
+    // the last timeslice has to be done before the next can go out
+    sync_rsp(n64);
+
+    // the debugger wants the rsp exactly where the cpu left it
+    if(n64.rsp_worker.thread.joinable() && !n64.debug_enabled)
+    {
+        const u32 cycles = rsp_cycles(n64.rsp,cpu_cycles);
+
+        if(!n64.mem.sp_regs.halt && cycles != 0)
+        {
+            post_rsp(n64,cycles);
+        }
+    }
+
+    else
+    {
+        run_rsp(n64,cpu_cycles);
+    }
+
+    if(!n64.mem.sp_regs.halt)
+    {
+        start_rsp(n64);
+    }
+}
+
+}
+
+#include "rcp/rsp_vector.cpp"
@@ -0,0 +1,1255 @@
+#include <n64/n64.h>
+#include <bit>
+#include <cmath>
+
+// the vector ops are written once against a handful of 8 x 16 bit lane helpers
+// with sse4.1 each helper is a single instruction, otherwise they fall back to plain loops
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define RSP_VECTOR_SSE
+#include <smmintrin.h>
+#endif
+
+namespace nintendo64
+{
+
+// lanes each element specifier broadcasts into the eight lanes
+static constexpr u8 ELEMENT_SELECT[16][8] =
+{
+    // whole vector
+    {0,1,2,3,4,5,6,7},
+    {0,1,2,3,4,5,6,7},
+
+    // quarters
+    {0,0,2,2,4,4,6,6},
+    {1,1,3,3,5,5,7,7},
+
+    // halves
+    {0,0,0,0,4,4,4,4},
+    {1,1,1,1,5,5,5,5},
+    {2,2,2,2,6,6,6,6},
+    {3,3,3,3,7,7,7,7},
+
+    // single element
+    {0,0,0,0,0,0,0,0},
+    {1,1,1,1,1,1,1,1},
+    {2,2,2,2,2,2,2,2},
+    {3,3,3,3,3,3,3,3},
+    {4,4,4,4,4,4,4,4},
+    {5,5,5,5,5,5,5,5},
+    {6,6,6,6,6,6,6,6},
+    {7,7,7,7,7,7,7,7},
+};
+
+#ifdef RSP_VECTOR_SSE
+
+using v128 = __m128i;
+
+struct alignas(16) ShuffleMask
+{
+    u8 byte[16];
+};
+
+static constexpr auto ELEMENT_SHUFFLE = []()
+{
+    std::array<ShuffleMask,16> mask = {};
+
+    for(u32 e = 0; e < 16; e++)
+    {
+        for(u32 i = 0; i < 8; i++)
+        {
+            mask[e].byte[(i * 2) + 0] = (ELEMENT_SELECT[e][i] * 2) + 0;
+            mask[e].byte[(i * 2) + 1] = (ELEMENT_SELECT[e][i] * 2) + 1;
+        }
+    }
+
+    return mask;
+}();
+
+inline v128 v_load(const VReg& r) { return _mm_load_si128((const __m128i*)r.lane); }
+inline void v_store(VReg& r, v128 v) { _mm_store_si128((__m128i*)r.lane,v); }
+
+inline v128 v_zero() { return _mm_setzero_si128(); }
+inline v128 v_set(u16 v) { return _mm_set1_epi16(s16(v)); }
+inline v128 v_ones() { return _mm_set1_epi16(-1); }
+
+inline v128 v_add(v128 a, v128 b) { return _mm_add_epi16(a,b); }
+inline v128 v_sub(v128 a, v128 b) { return _mm_sub_epi16(a,b); }
+inline v128 v_adds(v128 a, v128 b) { return _mm_adds_epi16(a,b); }
+inline v128 v_subs(v128 a, v128 b) { return _mm_subs_epi16(a,b); }
+inline v128 v_addus(v128 a, v128 b) { return _mm_adds_epu16(a,b); }
+inline v128 v_subus(v128 a, v128 b) { return _mm_subs_epu16(a,b); }
+
+inline v128 v_and(v128 a, v128 b) { return _mm_and_si128(a,b); }
+inline v128 v_or(v128 a, v128 b) { return _mm_or_si128(a,b); }
+inline v128 v_xor(v128 a, v128 b) { return _mm_xor_si128(a,b); }
+inline v128 v_andnot(v128 a, v128 b) { return _mm_andnot_si128(a,b); }
+inline v128 v_not(v128 a) { return _mm_xor_si128(a,v_ones()); }
+
+inline v128 v_cmpeq(v128 a, v128 b) { return _mm_cmpeq_epi16(a,b); }
+inline v128 v_cmpgt(v128 a, v128 b) { return _mm_cmpgt_epi16(a,b); }
+
+inline v128 v_min(v128 a, v128 b) { return _mm_min_epi16(a,b); }
+inline v128 v_max(v128 a, v128 b) { return _mm_max_epi16(a,b); }
+inline v128 v_minu(v128 a, v128 b) { return _mm_min_epu16(a,b); }
+
+// all ones in negative lanes
+inline v128 v_sign(v128 a) { return _mm_srai_epi16(a,15); }
+inline v128 v_msb(v128 a) { return _mm_srli_epi16(a,15); }
+inline v128 v_shl1(v128 a) { return _mm_slli_epi16(a,1); }
+
+inline v128 v_mullo(v128 a, v128 b) { return _mm_mullo_epi16(a,b); }
+inline v128 v_mulhi(v128 a, v128 b) { return _mm_mulhi_epi16(a,b); }
+inline v128 v_mulhiu(v128 a, v128 b) { return _mm_mulhi_epu16(a,b); }
+
+// mask? a : b
+inline v128 v_select(v128 mask, v128 a, v128 b) { return _mm_blendv_epi8(b,a,mask); }
+
+// hi:md as a signed 32 bit value clamped to 16 bits
+inline v128 v_clamp_signed(v128 hi, v128 md)
+{
+    return _mm_packs_epi32(_mm_unpacklo_epi16(md,hi),_mm_unpackhi_epi16(md,hi));
+}
+
+inline v128 v_element(v128 v, u32 e)
+{
+    return _mm_shuffle_epi8(v,_mm_load_si128((const __m128i*)ELEMENT_SHUFFLE[e].byte));
+}
+
+// 16 bytes of word swapped memory <-> a big endian register
+inline v128 v_load_mem(const u8* mem)
+{
+    const v128 v = _mm_loadu_si128((const __m128i*)mem);
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v,0xb1),0xb1);
+}
+
+inline void v_store_mem(u8* mem, v128 v)
+{
+    _mm_storeu_si128((__m128i*)mem,_mm_shufflehi_epi16(_mm_shufflelo_epi16(v,0xb1),0xb1));
+}
+
+#else
+
+struct v128
+{
+    u16 lane[8];
+};
+
+template<typename FUNC>
+inline v128 v_map(v128 a, v128 b, FUNC func)
+{
+    v128 r;
+
+    for(u32 i = 0; i < 8; i++)
+    {
+        r.lane[i] = u16(func(a.lane[i],b.lane[i]));
+    }
+
+    return r;
+}
+
+inline s32 clamp16(s32 v) { return std::clamp(v,-32768,32767); }
+
+inline v128 v_load(const VReg& r) { v128 v; memcpy(v.lane,r.lane,sizeof(v.lane)); return v; }
+inline void v_store(VReg& r, v128 v) { memcpy(r.lane,v.lane,sizeof(r.lane)); }
+
+inline v128 v_set(u16 v) { v128 r; for(auto& l : r.lane) { l = v; } return r; }
+inline v128 v_zero() { return v_set(0); }
+inline v128 v_ones() { return v_set(0xffff); }
+
+inline v128 v_add(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return x + y; }); }
+inline v128 v_sub(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return x - y; }); }
+inline v128 v_adds(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return clamp16(s16(x) + s16(y)); }); }
+inline v128 v_subs(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return clamp16(s16(x) - s16(y)); }); }
+inline v128 v_addus(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return std::min(u32(x) + y,u32(0xffff)); }); }
+inline v128 v_subus(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return x > y? x - y : 0; }); }
+
+inline v128 v_and(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return x & y; }); }
+inline v128 v_or(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return x | y; }); }
+inline v128 v_xor(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return x ^ y; }); }
+inline v128 v_andnot(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return ~x & y; }); }
+inline v128 v_not(v128 a) { return v_xor(a,v_ones()); }
+
+inline v128 v_cmpeq(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return x == y? 0xffff : 0; }); }
+inline v128 v_cmpgt(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return s16(x) > s16(y)? 0xffff : 0; }); }
+
+inline v128 v_min(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return std::min(s16(x),s16(y)); }); }
+inline v128 v_max(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return std::max(s16(x),s16(y)); }); }
+inline v128 v_minu(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return std::min(x,y); }); }
+
+inline v128 v_sign(v128 a) { return v_map(a,a,[](u16 x, u16) { return s16(x) < 0? 0xffff : 0; }); }
+inline v128 v_msb(v128 a) { return v_map(a,a,[](u16 x, u16) { return x >> 15; }); }
+inline v128 v_shl1(v128 a) { return v_map(a,a,[](u16 x, u16) { return x << 1; }); }
+
+inline v128 v_mullo(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return s32(s16(x)) * s16(y); }); }
+inline v128 v_mulhi(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return (s32(s16(x)) * s16(y)) >> 16; }); }
+inline v128 v_mulhiu(v128 a, v128 b) { return v_map(a,b,[](u16 x, u16 y) { return (u32(x) * y) >> 16; }); }
+
+inline v128 v_select(v128 mask, v128 a, v128 b)
+{
+    return v_or(v_and(mask,a),v_andnot(mask,b));
+}
+
+inline v128 v_clamp_signed(v128 hi, v128 md)
+{
+    return v_map(hi,md,[](u16 x, u16 y) { return clamp16(s32((u32(x) << 16) | y)); });
+}
+
+inline v128 v_element(v128 v, u32 e)
+{
+    v128 r;
+
+    for(u32 i = 0; i < 8; i++)
+    {
+        r.lane[i] = v.lane[ELEMENT_SELECT[e][i]];
+    }
+
+    return r;
+}
+
+inline v128 v_load_mem(const u8* mem)
+{
+    v128 v;
+
+    for(u32 i = 0; i < 8; i++)
+    {
+        v.lane[i] = handle_read<u16>(&mem[(i * 2) ^ 2]);
+    }
+
+    return v;
+}
+
+inline void v_store_mem(u8* mem, v128 v)
+{
+    for(u32 i = 0; i < 8; i++)
+    {
+        handle_write<u16>(&mem[(i * 2) ^ 2],v.lane[i]);
+    }
+}
+
+#endif
+
+// byte b of a register in big endian order
+inline u8 vreg_byte(const VReg& r, u32 b)
+{
+    return ((const u8*)r.lane)[(b & 15) ^ 1];
+}
+
+inline void set_vreg_byte(VReg& r, u32 b, u8 v)
+{
+    ((u8*)r.lane)[(b & 15) ^ 1] = v;
+}
+
+// 48 bit accumulator / product, one 16 bit slice per vector
+struct Acc
+{
+    v128 hi;
+    v128 md;
+    v128 lo;
+};
+
+Acc read_acc(const VectorUnit& vu)
+{
+    return {v_load(vu.acc_hi),v_load(vu.acc_md),v_load(vu.acc_lo)};
+}
+
+void write_acc(VectorUnit& vu, const Acc& acc)
+{
+    v_store(vu.acc_hi,acc.hi);
+    v_store(vu.acc_md,acc.md);
+    v_store(vu.acc_lo,acc.lo);
+}
+
+Acc acc_add(const Acc& acc, const Acc& p)
+{
+    const v128 lo = v_add(acc.lo,p.lo);
+    const v128 carry_lo = v_not(v_cmpeq(v_minu(lo,p.lo),p.lo));
+
+    const v128 md = v_add(acc.md,p.md);
+    const v128 carry_md = v_not(v_cmpeq(v_minu(md,p.md),p.md));
+
+    // a carry out of lo ripples straight through a md of 0xffff
+    const v128 ripple = v_and(carry_lo,v_cmpeq(md,v_ones()));
+
+    return {v_sub(v_sub(v_add(acc.hi,p.hi),carry_md),ripple),v_sub(md,carry_lo),lo};
+}
+
+// result is taken from md, clamped on the whole of hi:md
+v128 clamp_signed(const Acc& acc)
+{
+    return v_clamp_signed(acc.hi,acc.md);
+}
+
+// 0 when negative, 0xffff past 0x7fff
+v128 clamp_unsigned(const Acc& acc)
+{
+    const v128 md = v_andnot(v_sign(acc.hi),v_or(acc.md,v_sign(acc.md)));
+    return v_or(v_cmpgt(acc.hi,v_zero()),md);
+}
+
+// result is taken from lo, it only fits when hi is a sign extension of md
+v128 clamp_low(const Acc& acc)
+{
+    const v128 in_range = v_cmpeq(acc.hi,v_sign(acc.md));
+    return v_select(in_range,acc.lo,v_not(v_sign(acc.hi)));
+}
+
+// signed fraction, 2 * vs * vt, optionally rounded
+Acc product_frac(v128 vs, v128 vt, b32 round)
+{
+    const v128 lo = v_mullo(vs,vt);
+    const v128 hi = v_mulhi(vs,vt);
+
+    const v128 lo2 = v_shl1(lo);
+    const v128 md2 = v_or(v_shl1(hi),v_msb(lo));
+    const v128 hi2 = v_sign(hi);
+
+    if(!round)
+    {
+        return {hi2,md2,lo2};
+    }
+
+    // + 0x8000
+    const v128 carry = v_sign(lo2);
+    const v128 ripple = v_and(carry,v_cmpeq(md2,v_ones()));
+
+    return {v_sub(hi2,ripple),v_sub(md2,carry),v_add(lo2,v_set(0x8000))};
+}
+
+// signed vs * unsigned vt
+Acc product_mixed(v128 s, v128 u)
+{
+    const v128 md = v_sub(v_mulhiu(s,u),v_and(v_sign(s),u));
+    return {v_sign(md),md,v_mullo(s,u)};
+}
+
+Acc product_high(v128 vs, v128 vt)
+{
+    return {v_mulhi(vs,vt),v_mullo(vs,vt),v_zero()};
+}
+
+Acc product_low(v128 vs, v128 vt)
+{
+    return {v_zero(),v_zero(),v_mulhiu(vs,vt)};
+}
+
+v128 vu_multiply(VectorUnit& vu, u32 funct, v128 vs, v128 vt)
+{
+    // the mac forms accumulate into what is already there
+    const b32 accumulate = is_set(funct,3);
+
+    Acc product;
+
+    switch(funct & 7)
+    {
+        case 0: case 1: product = product_frac(vs,vt,!accumulate); break;
+        case 4: product = product_low(vs,vt); break;
+        case 5: product = product_mixed(vs,vt); break;
+        case 6: product = product_mixed(vt,vs); break;
+        case 7: product = product_high(vs,vt); break;
+
+        default: return v_zero();
+    }
+
+    const Acc acc = accumulate? acc_add(read_acc(vu),product) : product;
+    write_acc(vu,acc);
+
+    switch(funct & 7)
+    {
+        case 1: return clamp_unsigned(acc);
+        case 4: case 6: return clamp_low(acc);
+        default: return clamp_signed(acc);
+    }
+}
+
+// vmulq, vmacq, vrndp and vrndn only turn up in mpeg microcode, so just do them a lane at a time
+s32 acc_lane(const VectorUnit& vu, u32 i)
+{
+    return s32((u32(vu.acc_hi.lane[i]) << 16) | vu.acc_md.lane[i]);
+}
+
+v128 vu_quantize(VectorUnit& vu, u32 funct, v128 vs, v128 vt)
+{
+    VReg s;
+    VReg t;
+    VReg result;
+
+    v_store(s,vs);
+    v_store(t,vt);
+
+    for(u32 i = 0; i < 8; i++)
+    {
+        s32 product = 0;
+
+        // vmulq
+        if(funct == 0x03)
+        {
+            product = s32(s16(s.lane[i])) * s16(t.lane[i]);
+
+            if(product < 0)
+            {
+                product += 31;
+            }
+
+            vu.acc_lo.lane[i] = 0;
+        }
+
+        // vmacq
+        else
+        {
+            product = acc_lane(vu,i);
+
+            if(!is_set(product,5))
+            {
+                if(product < 0)
+                {
+                    product += 32;
+                }
+
+                else if(product >= 32)
+                {
+                    product -= 32;
+                }
+            }
+        }
+
+        vu.acc_hi.lane[i] = u16(product >> 16);
+        vu.acc_md.lane[i] = u16(product);
+        result.lane[i] = u16(std::clamp(product >> 1,-32768,32767) & ~15);
+    }
+
+    return v_load(result);
+}
+
+v128 vu_round(VectorUnit& vu, u32 funct, u32 vs_idx, v128 vt)
+{
+    VReg t;
+    v_store(t,vt);
+
+    for(u32 i = 0; i < 8; i++)
+    {
+        s64 product = s16(t.lane[i]);
+
+        // the vs field picks which half of the accumulator to round
+        if(vs_idx & 1)
+        {
+            product <<= 16;
+        }
+
+        s64 acc = (s64(acc_lane(vu,i)) << 16) | vu.acc_lo.lane[i];
+
+        const b32 round = funct == 0x0a? acc < 0 : acc >= 0;
+
+        if(round)
+        {
+            // back to 48 bits
+            acc = ((acc + product) << 16) >> 16;
+        }
+
+        vu.acc_hi.lane[i] = u16(acc >> 32);
+        vu.acc_md.lane[i] = u16(acc >> 16);
+        vu.acc_lo.lane[i] = u16(acc);
+    }
+
+    return clamp_signed(read_acc(vu));
+}
+
+v128 vu_add(VectorUnit& vu, v128 vs, v128 vt)
+{
+    const v128 carry = v_load(vu.vco_lo);
+
+    // adding the carry to the smaller input means it can only saturate when the real sum does
+    const v128 lo = v_subs(v_min(vs,vt),carry);
+    const v128 result = v_adds(lo,v_max(vs,vt));
+
+    v_store(vu.acc_lo,v_sub(v_add(vs,vt),carry));
+    v_store(vu.vco_lo,v_zero());
+    v_store(vu.vco_hi,v_zero());
+
+    return result;
+}
+
+v128 vu_sub(VectorUnit& vu, v128 vs, v128 vt)
+{
+    const v128 carry = v_load(vu.vco_lo);
+
+    const v128 diff = v_sub(vt,carry);
+    const v128 sat_diff = v_subs(vt,carry);
+    const v128 result = v_subs(vs,sat_diff);
+
+    // vt + carry saturated at 0x7fff, take the missing one off
+    const v128 overflow = v_cmpgt(sat_diff,diff);
+
+    v_store(vu.acc_lo,v_sub(vs,diff));
+    v_store(vu.vco_lo,v_zero());
+    v_store(vu.vco_hi,v_zero());
+
+    return v_adds(result,overflow);
+}
+
+v128 vu_abs(VectorUnit& vu, v128 vs, v128 vt)
+{
+    const v128 sign = v_sign(vs);
+    const v128 value = v_xor(v_andnot(v_cmpeq(vs,v_zero()),vt),sign);
+
+    // -0x8000 stays put in the accumulator, but saturates in the result
+    v_store(vu.acc_lo,v_sub(value,sign));
+    return v_subs(value,sign);
+}
+
+v128 vu_addc(VectorUnit& vu, v128 vs, v128 vt)
+{
+    const v128 sum = v_add(vs,vt);
+
+    v_store(vu.acc_lo,sum);
+    v_store(vu.vco_lo,v_not(v_cmpeq(v_addus(vs,vt),sum)));
+    v_store(vu.vco_hi,v_zero());
+
+    return sum;
+}
+
+v128 vu_subc(VectorUnit& vu, v128 vs, v128 vt)
+{
+    const v128 diff = v_sub(vs,vt);
+    const v128 equal = v_cmpeq(vs,vt);
+
+    v_store(vu.acc_lo,diff);
+    v_store(vu.vco_lo,v_andnot(equal,v_cmpeq(v_subus(vs,vt),v_zero())));
+    v_store(vu.vco_hi,v_not(equal));
+
+    return diff;
+}
+
+v128 vu_select(VectorUnit& vu, u32 funct, v128 vs, v128 vt)
+{
+    const v128 equal = v_cmpeq(vs,vt);
+    const v128 vco_lo = v_load(vu.vco_lo);
+    const v128 vco_hi = v_load(vu.vco_hi);
+    const v128 both = v_and(vco_lo,vco_hi);
+
+    v128 cond;
+
+    switch(funct)
+    {
+        // vlt
+        case 0x20: cond = v_or(v_cmpgt(vt,vs),v_and(equal,both)); break;
+
+        // veq
+        case 0x21: cond = v_andnot(vco_hi,equal); break;
+
+        // vne
+        case 0x22: cond = v_or(v_not(equal),vco_hi); break;
+
+        // vge
+        default: cond = v_or(v_cmpgt(vs,vt),v_andnot(both,equal)); break;
+    }
+
+    const v128 result = v_select(cond,vs,vt);
+
+    v_store(vu.acc_lo,result);
+    v_store(vu.vcc_lo,cond);
+    v_store(vu.vcc_hi,v_zero());
+    v_store(vu.vco_lo,v_zero());
+    v_store(vu.vco_hi,v_zero());
+
+    return result;
+}
+
+v128 vu_clip_high(VectorUnit& vu, v128 vs, v128 vt)
+{
+    // inputs of differing sign are compared against -vt, these sums cannot overflow
+    const v128 sign = v_sign(v_xor(vs,vt));
+    const v128 sum = v_add(vs,vt);
+    const v128 diff = v_sub(vs,vt);
+    const v128 vt_neg = v_sign(vt);
+
+    const v128 le = v_cmpgt(v_set(1),sum);
+    const v128 ge = v_not(v_sign(diff));
+
+    const v128 result = v_select(sign,sum,diff);
+    const v128 sum_ones = v_cmpeq(sum,v_ones());
+    const v128 neq = v_not(v_or(v_cmpeq(result,v_zero()),sum_ones));
+
+    const v128 vcc_lo = v_select(sign,le,vt_neg);
+    const v128 vcc_hi = v_select(sign,vt_neg,ge);
+
+    const v128 neg_vt = v_sub(v_zero(),vt);
+    const v128 out = v_select(sign,v_select(le,neg_vt,vs),v_select(ge,vt,vs));
+
+    v_store(vu.acc_lo,out);
+    v_store(vu.vcc_lo,vcc_lo);
+    v_store(vu.vcc_hi,vcc_hi);
+    v_store(vu.vco_lo,sign);
+    v_store(vu.vco_hi,neq);
+    v_store(vu.vce,v_and(sign,sum_ones));
+
+    return out;
+}
+
+v128 vu_clip_low(VectorUnit& vu, v128 vs, v128 vt)
+{
+    const v128 vco_lo = v_load(vu.vco_lo);
+    const v128 vco_hi = v_load(vu.vco_hi);
+    const v128 vce = v_load(vu.vce);
+    v128 vcc_lo = v_load(vu.vcc_lo);
+    v128 vcc_hi = v_load(vu.vcc_hi);
+
+    // unsigned sum against zero, with the carry out deciding the edge case
+    const v128 sum = v_add(vs,vt);
+    const v128 carry = v_not(v_cmpeq(v_addus(vs,vt),sum));
+    const v128 sum_zero = v_cmpeq(sum,v_zero());
+
+    const v128 le = v_select(vce,v_or(sum_zero,v_not(carry)),v_andnot(carry,sum_zero));
+    const v128 ge = v_cmpeq(v_subus(vt,vs),v_zero());
+
+    // lanes flagged as not equal keep the result of the last vch
+    vcc_lo = v_select(vco_lo,v_select(vco_hi,vcc_lo,le),vcc_lo);
+    vcc_hi = v_select(vco_lo,vcc_hi,v_select(vco_hi,vcc_hi,ge));
+
+    const v128 neg_vt = v_sub(v_zero(),vt);
+    const v128 out = v_select(vco_lo,v_select(vcc_lo,neg_vt,vs),v_select(vcc_hi,vt,vs));
+
+    v_store(vu.acc_lo,out);
+    v_store(vu.vcc_lo,vcc_lo);
+    v_store(vu.vcc_hi,vcc_hi);
+    v_store(vu.vco_lo,v_zero());
+    v_store(vu.vco_hi,v_zero());
+    v_store(vu.vce,v_zero());
+
+    return out;
+}
+
+v128 vu_clip_ones(VectorUnit& vu, v128 vs, v128 vt)
+{
+    // like vch, but against the ones complement of vt
+    const v128 sign = v_sign(v_xor(vs,vt));
+    const v128 vt_neg = v_sign(vt);
+
+    const v128 le = v_sign(v_add(vs,vt));
+    const v128 ge = v_not(v_sign(v_sub(vs,vt)));
+
+    const v128 out = v_select(sign,v_select(le,v_not(vt),vs),v_select(ge,vt,vs));
+
+    v_store(vu.acc_lo,out);
+    v_store(vu.vcc_lo,v_select(sign,le,vt_neg));
+    v_store(vu.vcc_hi,v_select(sign,vt_neg,ge));
+    v_store(vu.vco_lo,v_zero());
+    v_store(vu.vco_hi,v_zero());
+    v_store(vu.vce,v_zero());
+
+    return out;
+}
+
+v128 vu_merge(VectorUnit& vu, v128 vs, v128 vt)
+{
+    const v128 result = v_select(v_load(vu.vcc_lo),vs,vt);
+
+    v_store(vu.acc_lo,result);
+    v_store(vu.vco_lo,v_zero());
+    v_store(vu.vco_hi,v_zero());
+
+    return result;
+}
+
+v128 vu_logical(VectorUnit& vu, u32 funct, v128 vs, v128 vt)
+{
+    v128 result;
+
+    switch(funct)
+    {
+        case 0x28: result = v_and(vs,vt); break;
+        case 0x29: result = v_not(v_and(vs,vt)); break;
+        case 0x2a: result = v_or(vs,vt); break;
+        case 0x2b: result = v_not(v_or(vs,vt)); break;
+        case 0x2c: result = v_xor(vs,vt); break;
+        default: result = v_not(v_xor(vs,vt)); break;
+    }
+
+    v_store(vu.acc_lo,result);
+    return result;
+}
+
+// the accumulator can be read out but not written
+v128 vu_sar(VectorUnit& vu, u32 e)
+{
+    switch(e)
+    {
+        case 8: return v_load(vu.acc_hi);
+        case 9: return v_load(vu.acc_md);
+        case 10: return v_load(vu.acc_lo);
+
+        default: return v_zero();
+    }
+}
+
+struct DivTables
+{
+    u16 rcp[512];
+    u16 rsq[512];
+};
+
+const DivTables& div_tables()
+{
+    static const DivTables tables = []()
+    {
+        DivTables t;
+
+        for(u32 i = 0; i < 512; i++)
+        {
+            // 1 / (1 + i / 512) with the leading one implied, 1.0 itself saturates
+            const u64 rcp = (((u64(1) << 34) / (i + 512)) + 1) >> 8;
+            t.rcp[i] = u16(std::min(rcp,u64(0x1ffff)));
+
+            // largest b where b < 1 / sqrt(a), odd entries are for an odd exponent
+            const u64 limit = u64(1) << 44;
+            const u64 a = (i + 512) >> (i & 1);
+            u64 b = u64(std::sqrt(f64(limit) / f64(a)));
+
+            while(a * b * b >= limit)
+            {
+                b--;
+            }
+
+            while(a * (b + 1) * (b + 1) < limit)
+            {
+                b++;
+            }
+
+            t.rsq[i] = u16(b >> 1);
+        }
+
+        return t;
+    }();
+
+    return tables;
+}
+
+u32 rsp_divide(s32 input, b32 sqrt)
+{
+    const s32 mask = input >> 31;
+    s32 data = input ^ mask;
+
+    // negative inputs past 16 bits are only ones complemented
+    if(input > -32768)
+    {
+        data -= mask;
+    }
+
+    if(data == 0)
+    {
+        return 0x7fff'ffff;
+    }
+
+    if(input == -32768)
+    {
+        return 0xffff'0000;
+    }
+
+    const auto& tables = div_tables();
+
+    const u32 shift = std::countl_zero(u32(data));
+    const u32 index = ((u64(data) << shift) & 0x7fc0'0000) >> 22;
+
+    if(sqrt)
+    {
+        const u32 result = (0x10000 | tables.rsq[(index & 0x1fe) | (shift & 1)]) << 14;
+        return (result >> ((31 - shift) >> 1)) ^ mask;
+    }
+
+    const u32 result = (0x10000 | tables.rcp[index]) << 14;
+    return (result >> (31 - shift)) ^ mask;
+}
+
+// vrcp, vrcpl, vrcph, vmov, vrsq, vrsql, vrsqh
+// these work on a single lane, the vs field selects the destination element
+void vu_single_lane(VectorUnit& vu, u32 funct, u32 e, u32 de, u32 vt_idx, u32 vd_idx)
+{
+    const VReg vt = vu.regs[vt_idx];
+    const v128 vte = v_element(v_load(vt),e);
+    const u16 input = vt.lane[e & 7];
+
+    VReg& vd = vu.regs[vd_idx & 0x1f];
+    const u32 lane = de & 7;
+
+    switch(funct)
+    {
+        // vmov
+        case 0x33:
+        {
+            VReg src;
+            v_store(src,vte);
+            vd.lane[lane] = src.lane[lane];
+            break;
+        }
+
+        // vrcph, vrsqh
+        case 0x32: case 0x36:
+        {
+            vu.div_in = s16(input);
+            vu.div_dp = true;
+            vd.lane[lane] = u16(vu.div_out);
+            break;
+        }
+
+        // vrcp, vrcpl, vrsq, vrsql
+        default:
+        {
+            const b32 low = funct == 0x31 || funct == 0x35;
+            const b32 sqrt = funct >= 0x34;
+
+            const s32 data = low && vu.div_dp? s32((u32(u16(vu.div_in)) << 16) | input) : s16(input);
+            const u32 result = rsp_divide(data,sqrt);
+
+            vu.div_out = s16(result >> 16);
+            vu.div_dp = false;
+            vd.lane[lane] = u16(result);
+            break;
+        }
+    }
+
+    v_store(vu.acc_lo,vte);
+}
+
+void rsp_cop2(N64& n64, u32 op)
+{
+    auto& vu = n64.rsp.vu;
+
+    const u32 funct = op & 0x3f;
+    const u32 e = (op >> 21) & 0xf;
+    const u32 vt_idx = (op >> 16) & 0x1f;
+    const u32 vs_idx = (op >> 11) & 0x1f;
+    const u32 vd_idx = (op >> 6) & 0x1f;
+
+    if(funct >= 0x30 && funct <= 0x36)
+    {
+        vu_single_lane(vu,funct,e,vs_idx,vt_idx,vd_idx);
+        return;
+    }
+
+    const v128 vs = v_load(vu.regs[vs_idx]);
+    const v128 vt = v_element(v_load(vu.regs[vt_idx]),e);
+
+    v128 result;
+
+    switch(funct)
+    {
+        case 0x00: case 0x01: case 0x04: case 0x05: case 0x06: case 0x07:
+        case 0x08: case 0x09: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+        {
+            result = vu_multiply(vu,funct,vs,vt);
+            break;
+        }
+
+        case 0x02: case 0x0a: result = vu_round(vu,funct,vs_idx,vt); break;
+        case 0x03: case 0x0b: result = vu_quantize(vu,funct,vs,vt); break;
+
+        case 0x10: result = vu_add(vu,vs,vt); break;
+        case 0x11: result = vu_sub(vu,vs,vt); break;
+        case 0x13: result = vu_abs(vu,vs,vt); break;
+        case 0x14: result = vu_addc(vu,vs,vt); break;
+        case 0x15: result = vu_subc(vu,vs,vt); break;
+
+        case 0x1d: result = vu_sar(vu,e); break;
+
+        case 0x20: case 0x21: case 0x22: case 0x23: result = vu_select(vu,funct,vs,vt); break;
+
+        case 0x24: result = vu_clip_low(vu,vs,vt); break;
+        case 0x25: result = vu_clip_high(vu,vs,vt); break;
+        case 0x26: result = vu_clip_ones(vu,vs,vt); break;
+        case 0x27: result = vu_merge(vu,vs,vt); break;
+
+        case 0x28: case 0x29: case 0x2a: case 0x2b: case 0x2c: case 0x2d:
+        {
+            result = vu_logical(vu,funct,vs,vt);
+            break;
+        }
+
+        // vnop, vnull
+        case 0x37: case 0x3f: return;
+
+        // everything left over sums into the accumulator and writes zero
+        default:
+        {
+            v_store(vu.acc_lo,v_add(vs,vt));
+            result = v_zero();
+            break;
+        }
+    }
+
+    v_store(vu.regs[vd_idx],result);
+}
+
+// element in the register and the scale of the offset per load / store kind
+static constexpr u32 VECTOR_MEM_SHIFT[12] = {0,1,2,3,4,4,3,3,4,4,4,4};
+
+u32 vector_mem_addr(N64& n64, u32 op, u32 kind)
+{
+    // signed 7 bit offset
+    const s32 offset = s32(op << 25) >> 25;
+    return n64.rsp.regs[get_rs(op)] + (offset << VECTOR_MEM_SHIFT[kind]);
+}
+
+void rsp_lwc2(N64& n64, u32 op)
+{
+    auto& vu = n64.rsp.vu;
+
+    const u32 vt_idx = get_rt(op);
+    const u32 kind = (op >> 11) & 0x1f;
+    const u32 e = (op >> 7) & 0xf;
+
+    if(kind >= 12)
+    {
+        rsp_unknown_opcode(n64,op);
+    }
+
+    u32 addr = vector_mem_addr(n64,op,kind);
+    VReg& vt = vu.regs[vt_idx];
+
+    switch(kind)
+    {
+        // lbv, lsv, llv, ldv
+        case 0x00: case 0x01: case 0x02: case 0x03:
+        {
+            const u32 end = std::min(e + (1 << kind),u32(16));
+
+            for(u32 b = e; b < end; b++)
+            {
+                set_vreg_byte(vt,b,rsp_read8(n64,addr++));
+            }
+            break;
+        }
+
+        // lqv, up to the end of the 16 byte block
+        case 0x04:
+        {
+            if(e == 0 && (addr & 15) == 0)
+            {
+                v_store(vt,v_load_mem(&n64.mem.sp_dmem[addr & 0xfff]));
+                break;
+            }
+
+            const u32 end = std::min(e + 16 - (addr & 15),u32(16));
+
+            for(u32 b = e; b < end; b++)
+            {
+                set_vreg_byte(vt,b,rsp_read8(n64,addr++));
+            }
+            break;
+        }
+
+        // lrv, the part of the block before the address
+        case 0x05:
+        {
+            const u32 start = 16 - (addr & 15) + e;
+            addr &= ~15;
+
+            for(u32 b = start; b < 16; b++)
+            {
+                set_vreg_byte(vt,b,rsp_read8(n64,addr++));
+            }
+            break;
+        }
+
+        // lpv, luv, lhv, packed bytes into the top of each lane
+        case 0x06: case 0x07: case 0x08:
+        {
+            const u32 index = (addr & 7) - e;
+            const u32 stride = kind == 0x08? 2 : 1;
+            const u32 shift = kind == 0x06? 8 : 7;
+            addr &= ~7;
+
+            for(u32 i = 0; i < 8; i++)
+            {
+                vt.lane[i] = rsp_read8(n64,addr + ((index + (i * stride)) & 15)) << shift;
+            }
+            break;
+        }
+
+        // lfv, every fourth byte into half the register
+        case 0x09:
+        {
+            const u32 index = (addr & 7) - e;
+            addr &= ~7;
+
+            VReg tmp;
+
+            for(u32 i = 0; i < 4; i++)
+            {
+                tmp.lane[i + 0] = rsp_read8(n64,addr + ((index + (i * 4) + 0) & 15)) << 7;
+                tmp.lane[i + 4] = rsp_read8(n64,addr + ((index + (i * 4) + 8) & 15)) << 7;
+            }
+
+            const u32 end = std::min(e + 8,u32(16));
+
+            for(u32 b = e; b < end; b++)
+            {
+                set_vreg_byte(vt,b,vreg_byte(tmp,b));
+            }
+            break;
+        }
+
+        // lwv is not present on hardware
+        case 0x0a: break;
+
+        // ltv, a transposed load across a group of 8 registers
+        case 0x0b:
+        {
+            const u32 begin = addr & ~7;
+            addr = begin + ((e + (addr & 8)) & 15);
+
+            const u32 group = vt_idx & ~7;
+            u32 offset = e >> 1;
+
+            for(u32 i = 0; i < 8; i++)
+            {
+                VReg& reg = vu.regs[group + offset];
+
+                for(u32 b = 0; b < 2; b++)
+                {
+                    set_vreg_byte(reg,(i * 2) + b,rsp_read8(n64,addr++));
+
+                    if(addr == begin + 16)
+                    {
+                        addr = begin;
+                    }
+                }
+
+                offset = (offset + 1) & 7;
+            }
+            break;
+        }
+    }
+}
+
+void rsp_swc2(N64& n64, u32 op)
+{
+    auto& vu = n64.rsp.vu;
+
+    const u32 vt_idx = get_rt(op);
+    const u32 kind = (op >> 11) & 0x1f;
+    const u32 e = (op >> 7) & 0xf;
+
+    if(kind >= 12)
+    {
+        rsp_unknown_opcode(n64,op);
+    }
+
+    u32 addr = vector_mem_addr(n64,op,kind);
+    const VReg& vt = vu.regs[vt_idx];
+
+    switch(kind)
+    {
+        // sbv, ssv, slv, sdv
+        case 0x00: case 0x01: case 0x02: case 0x03:
+        {
+            for(u32 i = 0; i < (1u << kind); i++)
+            {
+                rsp_write8(n64,addr + i,vreg_byte(vt,e + i));
+            }
+            break;
+        }
+
+        // sqv
+        case 0x04:
+        {
+            if(e == 0 && (addr & 15) == 0)
+            {
+                v_store_mem(&n64.mem.sp_dmem[addr & 0xfff],v_load(vt));
+                break;
+            }
+
+            const u32 len = 16 - (addr & 15);
+
+            for(u32 i = 0; i < len; i++)
+            {
+                rsp_write8(n64,addr + i,vreg_byte(vt,e + i));
+            }
+            break;
+        }
+
+        // srv
+        case 0x05:
+        {
+            const u32 len = addr & 15;
+            const u32 base = 16 - len;
+            addr &= ~15;
+
+            for(u32 i = 0; i < len; i++)
+            {
+                rsp_write8(n64,addr + i,vreg_byte(vt,e + i + base));
+            }
+            break;
+        }
+
+        // spv, suv, the top of each lane as a byte
+        case 0x06: case 0x07:
+        {
+            // past the first half of the element range they swap over
+            const u32 packed = kind == 0x06? 0 : 8;
+
+            for(u32 i = 0; i < 8; i++)
+            {
+                const u32 b = e + i;
+                const u32 lane = b & 7;
+
+                if(((b & 15) < 8) == (packed == 0))
+                {
+                    rsp_write8(n64,addr + i,vreg_byte(vt,lane << 1));
+                }
+
+                else
+                {
+                    rsp_write8(n64,addr + i,u8(vt.lane[lane] >> 7));
+                }
+            }
+            break;
+        }
+
+        // shv
+        case 0x08:
+        {
+            const u32 index = addr & 7;
+            addr &= ~7;
+
+            for(u32 i = 0; i < 8; i++)
+            {
+                const u32 b = e + (i * 2);
+                const u8 v = (vreg_byte(vt,b) << 1) | (vreg_byte(vt,b + 1) >> 7);
+                rsp_write8(n64,addr + ((index + (i * 2)) & 15),v);
+            }
+            break;
+        }
+
+        // sfv, only a few element specifiers pick anything sensible
+        case 0x09:
+        {
+            static constexpr s8 SFV_LANES[16][4] =
+            {
+                {0,1,2,3}, {6,7,4,5}, {-1,-1,-1,-1}, {-1,-1,-1,-1},
+                {1,2,3,0}, {7,4,5,6}, {-1,-1,-1,-1}, {-1,-1,-1,-1},
+                {4,5,6,7}, {-1,-1,-1,-1}, {-1,-1,-1,-1}, {3,0,1,2},
+                {5,6,7,4}, {-1,-1,-1,-1}, {-1,-1,-1,-1}, {0,1,2,3},
+            };
+
+            const u32 index = addr & 7;
+            addr &= ~7;
+
+            for(u32 i = 0; i < 4; i++)
+            {
+                const s8 lane = SFV_LANES[e][i];
+                const u8 v = lane < 0? 0 : u8(vt.lane[lane] >> 7);
+                rsp_write8(n64,addr + ((index + (i * 4)) & 15),v);
+            }
+            break;
+        }
+
+        // swv, the whole register rotated into the 16 byte block
+        case 0x0a:
+        {
+            const u32 index = addr & 7;
+            addr &= ~7;
+
+            for(u32 i = 0; i < 16; i++)
+            {
+                rsp_write8(n64,addr + ((index + i) & 15),vreg_byte(vt,e + i));
+            }
+            break;
+        }
+
+        // stv, a transposed store across a group of 8 registers
+        case 0x0b:
+        {
+            const u32 group = vt_idx & ~7;
+            u32 element = 16 - (e & ~1);
+            u32 index = (addr & 7) - (e & ~1);
+            addr &= ~7;
+
+            for(u32 r = group; r < group + 8; r++)
+            {
+                for(u32 b = 0; b < 2; b++)
+                {
+                    rsp_write8(n64,addr + (index++ & 15),vreg_byte(vu.regs[r],element++));
+                }
+            }
+            break;
+        }
+    }
+}
+
+// transfers between the scalar and vector unit, e is a byte index
+u32 rsp_mfc2(N64& n64, u32 op)
+{
+    const VReg& vs = n64.rsp.vu.regs[get_rd(op)];
+    const u32 e = (op >> 7) & 0xf;
+
+    const u16 v = (vreg_byte(vs,e) << 8) | vreg_byte(vs,e + 1);
+    return sign_extend_mips<s32,s16>(v);
+}
+
+void rsp_mtc2(N64& n64, u32 op, u32 v)
+{
+    VReg& vs = n64.rsp.vu.regs[get_rd(op)];
+    const u32 e = (op >> 7) & 0xf;
+
+    set_vreg_byte(vs,e,v >> 8);
+
+    if(e != 15)
+    {
+        set_vreg_byte(vs,e + 1,v);
+    }
+}
+
+// lane n of each mask lands in bit n, the hi mask in the upper byte
+u32 pack_flags(const VReg& lo, const VReg& hi)
+{
+    u32 v = 0;
+
+    for(u32 i = 0; i < 8; i++)
+    {
+        v |= (lo.lane[i] & 1) << i;
+        v |= (hi.lane[i] & 1) << (i + 8);
+    }
+
+    return v;
+}
+
+void unpack_flags(VReg& lo, VReg& hi, u32 v)
+{
+    for(u32 i = 0; i < 8; i++)
+    {
+        lo.lane[i] = is_set(v,i)? 0xffff : 0;
+        hi.lane[i] = is_set(v,i + 8)? 0xffff : 0;
+    }
+}
+
+u32 rsp_cfc2(N64& n64, u32 op)
+{
+    auto& vu = n64.rsp.vu;
+
+    switch(get_rd(op) & 3)
+    {
+        case 0: return sign_extend_mips<s32,s16>(pack_flags(vu.vco_lo,vu.vco_hi));
+        case 1: return sign_extend_mips<s32,s16>(pack_flags(vu.vcc_lo,vu.vcc_hi));
+        default: return pack_flags(vu.vce,vu.vce) & 0xff;
+    }
+}
+
+void rsp_ctc2(N64& n64, u32 op, u32 v)
+{
+    auto& vu = n64.rsp.vu;
+
+    switch(get_rd(op) & 3)
+    {
+        case 0: unpack_flags(vu.vco_lo,vu.vco_hi,v); break;
+        case 1: unpack_flags(vu.vcc_lo,vu.vcc_hi,v); break;
+
+        default:
+        {
+            VReg unused;
+            unpack_flags(vu.vce,unused,v & 0xff);
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,608 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// vi scan out
+// the framebuffer is converted a row at a time, then optionally run through the dither filter
+// and scaled up to the vi output, each pass is its own loop over the whole frame
+
+namespace nintendo64
+{
+
+/* TODO: understand how this works ourselves
+u32 blend(const u32 v1, const u32 v2)
+{
+
+}
+*/
+
+
+using ColorLut = std::array<u32,65536>;
+constexpr ColorLut pop_color_lut()
+{
+	ColorLut lut{};
+
+	for(u32 c = 0; c < lut.size(); c++)
+	{
+        // rgba 5551
+    /*
+        
+        r    g   g   b   a
+        <5 | 3>, <2 | 5 | 1> 
+
+        
+    */
+
+    /*
+        // bswap          
+        g    b   a   r   g
+        <2 | 5 | 1>, <5 | 3>
+    */
+
+    /*
+        5   3   2   5   1
+        r | g | g | b | a 
+    */
+
+		u32 R = (c >> 11) & 0x1f;
+		u32 G = (((c >> 8) & 0b111) << 2) | (((c >> 6) & 0b11) << 0);
+		u32 B = (c >> 1) & 0x1f;
+        const b32 A = (c >> 0) & 0x1;
+
+        R |= R << 3;
+        B |= B << 3;
+        G |= G << 3;
+
+		// default to standard colors until we add proper correction
+		lut[c] =  B << 16 |  G << 8 | R << 0;
+
+        if(A)
+        {
+            lut[c] |= 0xff00'0000;
+        }
+	}
+
+	return lut;
+}
+
+static constexpr ColorLut COL_LUT = pop_color_lut();
+
+
+inline u32 convert_color(u16 color)
+{
+	return COL_LUT[color];
+}
+
+// one row of rgba 5551 out of rdram
+void scan_out_row_16(const u8* ram, u32 addr, u32* dst, u32 count)
+{
+    u32 x = 0;
+
+#ifdef __SSE2__
+    // rdram is held as words, so runs have to start on one
+    if((addr & 2) && count)
+    {
+        dst[x++] = convert_color(handle_read_n64<u16>(ram,addr & RD_RAM_MASK));
+    }
+
+    const __m128i mask5 = _mm_set1_epi16(0x1f);
+    const __m128i alpha = _mm_set1_epi16(s16(0xff00));
+
+    for(; x + 8 <= count; x += 8)
+    {
+        const u32 offset = (addr + (x * sizeof(u16))) & RD_RAM_MASK;
+
+        if(offset + 16 > RD_RAM_SIZE)
+        {
+            break;
+        }
+
+        __m128i v = _mm_loadu_si128((const __m128i*)&ram[offset]);
+
+        // put each pair of pixels back in order
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v,0xb1),0xb1);
+
+        const __m128i r = _mm_and_si128(_mm_srli_epi16(v,11),mask5);
+        const __m128i g = _mm_and_si128(_mm_srli_epi16(v,6),mask5);
+        const __m128i b = _mm_and_si128(_mm_srli_epi16(v,1),mask5);
+
+        // widened the same way as the lut
+        const __m128i r8 = _mm_or_si128(r,_mm_slli_epi16(r,3));
+        const __m128i g8 = _mm_or_si128(g,_mm_slli_epi16(g,3));
+        const __m128i b8 = _mm_or_si128(b,_mm_slli_epi16(b,3));
+        const __m128i a8 = _mm_and_si128(_mm_srai_epi16(_mm_slli_epi16(v,15),15),alpha);
+
+        // low and high halves of the abgr words
+        const __m128i lo = _mm_or_si128(r8,_mm_slli_epi16(g8,8));
+        const __m128i hi = _mm_or_si128(b8,a8);
+
+        _mm_storeu_si128((__m128i*)&dst[x],_mm_unpacklo_epi16(lo,hi));
+        _mm_storeu_si128((__m128i*)&dst[x + 4],_mm_unpackhi_epi16(lo,hi));
+    }
+#endif
+
+    for(; x < count; x++)
+    {
+        const auto v = handle_read_n64<u16>(ram,(addr + (x * sizeof(u16))) & RD_RAM_MASK);
+        dst[x] = convert_color(v);
+    }
+}
+
+#ifdef __SSE2__
+inline __m128i bswap_epi32(__m128i v)
+{
+    // bytes in each half, then the halves
+    v = _mm_or_si128(_mm_slli_epi16(v,8),_mm_srli_epi16(v,8));
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v,0xb1),0xb1);
+}
+#endif
+
+// one row of rgba 8888 out of rdram
+void scan_out_row_32(const u8* ram, u32 addr, u32* dst, u32 count)
+{
+    u32 x = 0;
+
+#ifdef __SSE2__
+    for(; x + 8 <= count; x += 8)
+    {
+        const u32 offset = (addr + (x * sizeof(u32))) & RD_RAM_MASK;
+
+        if(offset + 32 > RD_RAM_SIZE)
+        {
+            break;
+        }
+
+        const __m128i v0 = _mm_loadu_si128((const __m128i*)&ram[offset]);
+        const __m128i v1 = _mm_loadu_si128((const __m128i*)&ram[offset + 16]);
+
+        _mm_storeu_si128((__m128i*)&dst[x],bswap_epi32(v0));
+        _mm_storeu_si128((__m128i*)&dst[x + 4],bswap_epi32(v1));
+    }
+#endif
+
+    for(; x < count; x++)
+    {
+        const auto v = handle_read_n64<u32>(ram,(addr + (x * sizeof(u32))) & RD_RAM_MASK);
+
+        // convert to ABGR
+        dst[x] = bswap(v);
+    }
+}
+
+u32 dither_filter_pixel(const u32* src, u32 width, u32 x, u32 y)
+{
+    const u32 c = src[(y * width) + x];
+    u32 out = c & 0xff00'0000;
+
+    for(u32 shift = 0; shift < 24; shift += 8)
+    {
+        const s32 c8 = (c >> shift) & 0xff;
+        s32 v = c8;
+
+        for(u32 ny = y - 1; ny <= y + 1; ny++)
+        {
+            for(u32 nx = x - 1; nx <= x + 1; nx++)
+            {
+                const s32 n8 = (src[(ny * width) + nx] >> shift) & 0xff;
+                v += ((n8 >> 3) > (c8 >> 3)) - ((n8 >> 3) < (c8 >> 3));
+            }
+        }
+
+        out |= u32(v) << shift;
+    }
+
+    return out;
+}
+
+// the vi's dither filter, each channel is nudged a step towards every neighbour that is above or below it
+// at 5 bits, which evens the rdp's dither back out while leaving flat areas alone
+// a channel at either end of the range has nothing past it to be nudged towards, so this never clamps
+void dither_filter_pass(const u32* src, u32* dst, u32 width, u32 height)
+{
+    if(width < 3 || height < 3)
+    {
+        std::copy(src,src + (width * height),dst);
+        return;
+    }
+
+    // edges go through untouched
+    std::copy(src,src + width,dst);
+    std::copy(src + ((height - 1) * width),src + (height * width),dst + ((height - 1) * width));
+
+    for(u32 y = 1; y < height - 1; y++)
+    {
+        const u32* row = &src[y * width];
+        u32* out = &dst[y * width];
+
+        out[0] = row[0];
+        out[width - 1] = row[width - 1];
+
+        u32 x = 1;
+
+#ifdef __SSE2__
+        const __m128i mask5 = _mm_set1_epi8(0x1f);
+        const __m128i rgb = _mm_set1_epi32(0x00ff'ffff);
+
+        for(; x + 4 < width; x += 4)
+        {
+            const __m128i c = _mm_loadu_si128((const __m128i*)&row[x]);
+            const __m128i c5 = _mm_and_si128(_mm_srli_epi16(c,3),mask5);
+
+            __m128i above = _mm_setzero_si128();
+            __m128i below = _mm_setzero_si128();
+
+            for(s32 dy = -1; dy <= 1; dy++)
+            {
+                for(s32 dx = -1; dx <= 1; dx++)
+                {
+                    const __m128i n = _mm_loadu_si128((const __m128i*)&row[(dy * s32(width)) + s32(x) + dx]);
+                    const __m128i n5 = _mm_and_si128(_mm_srli_epi16(n,3),mask5);
+
+                    // compares are all ones, so subtracting counts them
+                    above = _mm_sub_epi8(above,_mm_cmpgt_epi8(n5,c5));
+                    below = _mm_sub_epi8(below,_mm_cmpgt_epi8(c5,n5));
+                }
+            }
+
+            above = _mm_and_si128(above,rgb);
+            below = _mm_and_si128(below,rgb);
+
+            _mm_storeu_si128((__m128i*)&out[x],_mm_subs_epu8(_mm_adds_epu8(c,above),below));
+        }
+#endif
+
+        for(; x < width - 1; x++)
+        {
+            out[x] = dither_filter_pixel(src,width,x,y);
+        }
+    }
+}
+
+u32 lerp_pixel(u32 a, u32 b, u32 weight)
+{
+    u32 out = 0;
+
+    for(u32 shift = 0; shift < 32; shift += 8)
+    {
+        const s32 ca = (a >> shift) & 0xff;
+        const s32 cb = (b >> shift) & 0xff;
+
+        out |= u32(ca + (((cb - ca) * s32(weight)) >> 5)) << shift;
+    }
+
+    return out;
+}
+
+#ifdef __SSE2__
+// a + (b - a) * weight / 32 on every channel of 4 pixels
+// weights are in 16 bit lanes, once per channel, two pixels in each half
+inline __m128i lerp_pixels(__m128i a, __m128i b, __m128i weight_lo, __m128i weight_hi)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    const __m128i a_lo = _mm_unpacklo_epi8(a,zero);
+    const __m128i a_hi = _mm_unpackhi_epi8(a,zero);
+    const __m128i b_lo = _mm_unpacklo_epi8(b,zero);
+    const __m128i b_hi = _mm_unpackhi_epi8(b,zero);
+
+    const __m128i lo = _mm_add_epi16(a_lo,_mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b_lo,a_lo),weight_lo),5));
+    const __m128i hi = _mm_add_epi16(a_hi,_mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(b_hi,a_hi),weight_hi),5));
+
+    return _mm_packus_epi16(lo,hi);
+}
+#endif
+
+// steps through the source row x_scale / 1024 pixels at a time
+void scale_row(const u32* src, u32 src_width, u32* dst, u32 dst_width, u32 x_scale, b32 filter)
+{
+    const auto sample = [&](u32 x, u32& i, u32& j, u32& weight)
+    {
+        const u32 pos = x * x_scale;
+
+        i = std::min(pos >> 10,src_width - 1);
+        j = std::min(i + 1,src_width - 1);
+        weight = filter? (pos >> 5) & 0x1f : 0;
+    };
+
+    u32 x = 0;
+
+#ifdef __SSE2__
+    for(; x + 4 <= dst_width; x += 4)
+    {
+        u32 i[4];
+        u32 j[4];
+        u32 w[4];
+
+        for(u32 k = 0; k < 4; k++)
+        {
+            sample(x + k,i[k],j[k],w[k]);
+        }
+
+        const __m128i a = _mm_setr_epi32(src[i[0]],src[i[1]],src[i[2]],src[i[3]]);
+        const __m128i b = _mm_setr_epi32(src[j[0]],src[j[1]],src[j[2]],src[j[3]]);
+
+        const __m128i weight_lo = _mm_setr_epi16(w[0],w[0],w[0],w[0],w[1],w[1],w[1],w[1]);
+        const __m128i weight_hi = _mm_setr_epi16(w[2],w[2],w[2],w[2],w[3],w[3],w[3],w[3]);
+
+        _mm_storeu_si128((__m128i*)&dst[x],lerp_pixels(a,b,weight_lo,weight_hi));
+    }
+#endif
+
+    for(; x < dst_width; x++)
+    {
+        u32 i;
+        u32 j;
+        u32 w;
+        sample(x,i,j,w);
+
+        dst[x] = lerp_pixel(src[i],src[j],w);
+    }
+}
+
+void blend_rows(const u32* a, const u32* b, u32* dst, u32 width, u32 weight)
+{
+    if(!weight)
+    {
+        std::copy(a,a + width,dst);
+        return;
+    }
+
+    u32 x = 0;
+
+#ifdef __SSE2__
+    const __m128i w = _mm_set1_epi16(weight);
+
+    for(; x + 4 <= width; x += 4)
+    {
+        const __m128i va = _mm_loadu_si128((const __m128i*)&a[x]);
+        const __m128i vb = _mm_loadu_si128((const __m128i*)&b[x]);
+
+        _mm_storeu_si128((__m128i*)&dst[x],lerp_pixels(va,vb,w,w));
+    }
+#endif
+
+    for(; x < width; x++)
+    {
+        dst[x] = lerp_pixel(a[x],b[x],weight);
+    }
+}
+
+// resample up to the vi output, filtering between neighbours with 5 bits of weight like the vi
+// unless the aa mode says to just replicate pixels
+void scale_pass(ScanOut& scan_out, const ScanOutParams& params, const u32* src, u32* dst)
+{
+    const u32 src_width = params.frame_x;
+    const u32 src_height = params.frame_y;
+    const u32 dst_width = params.screen_x;
+    const b32 filter = params.aa != 3;
+
+    auto& rows = scan_out.rows;
+    rows[0].resize(dst_width);
+    rows[1].resize(dst_width);
+
+    // source rows currently scaled into rows
+    u32 cached[2] = {0xffff'ffff,0xffff'ffff};
+
+    for(u32 y = 0; y < params.screen_y; y++)
+    {
+        const u32 pos = y * params.y_scale;
+
+        const u32 r0 = std::min(pos >> 10,src_height - 1);
+        const u32 r1 = std::min(r0 + 1,src_height - 1);
+        const u32 weight = filter? (pos >> 5) & 0x1f : 0;
+
+        // stepping down usually moves the pair on by one, or not at all
+        if(cached[0] != r0)
+        {
+            if(cached[1] == r0)
+            {
+                std::swap(rows[0],rows[1]);
+                std::swap(cached[0],cached[1]);
+            }
+
+            else
+            {
+                scale_row(&src[r0 * src_width],src_width,rows[0].data(),dst_width,params.x_scale,filter);
+                cached[0] = r0;
+            }
+        }
+
+        if(weight && cached[1] != r1)
+        {
+            scale_row(&src[r1 * src_width],src_width,rows[1].data(),dst_width,params.x_scale,filter);
+            cached[1] = r1;
+        }
+
+        blend_rows(rows[0].data(),rows[1].data(),&dst[y * dst_width],dst_width,weight);
+    }
+}
+
+// rdram the vi reads goes in as watched pages, so stores to it from compiled code come through invalidate_code
+void set_scan_out_range(N64& n64, u32 start, u32 end)
+{
+    auto& scan_out = n64.rdp.scan_out;
+    auto& present = n64.dynarec.code_present;
+
+    if(start == scan_out.start && end == scan_out.end)
+    {
+        return;
+    }
+
+    for(u32 page = scan_out.start >> CODE_PAGE_SHIFT; page < scan_out.end >> CODE_PAGE_SHIFT; page++)
+    {
+        present[page] &= ~PAGE_WATCHED;
+    }
+
+    for(u32 page = start >> CODE_PAGE_SHIFT; page < end >> CODE_PAGE_SHIFT; page++)
+    {
+        present[page] |= PAGE_WATCHED;
+    }
+
+    scan_out.start = start;
+    scan_out.end = end;
+    scan_out.dirty = true;
+}
+
+void watch_scan_out(N64& n64, const ScanOutParams& params)
+{
+    if((params.bpp != 2 && params.bpp != 3) || !params.frame_x || !params.frame_y)
+    {
+        set_scan_out_range(n64,0,0);
+        return;
+    }
+
+    const u32 size = params.bpp == 3? sizeof(u32) : sizeof(u16);
+
+    const u64 first = params.origin + (u64((params.y_offset * params.width) + params.x_offset) * size);
+    const u64 last = params.origin + (u64(((params.y_offset + params.frame_y - 1) * params.width) + params.x_offset + params.frame_x) * size);
+
+    // reads wrap round the end of rdram, so just watch the lot
+    if(last > RD_RAM_SIZE)
+    {
+        set_scan_out_range(n64,0,RD_RAM_SIZE);
+        return;
+    }
+
+    const u32 start = u32(first) & ~(CODE_PAGE_SIZE - 1);
+    const u32 end = (u32(last) + CODE_PAGE_SIZE - 1) & ~(CODE_PAGE_SIZE - 1);
+
+    set_scan_out_range(n64,start,end);
+}
+
+void reset_scan_out(N64& n64)
+{
+    auto& scan_out = n64.rdp.scan_out;
+
+    set_scan_out_range(n64,0,0);
+
+    scan_out.params = {};
+    scan_out.dirty = true;
+}
+
+void set_vi_filters(N64& n64, b32 dither_filter, b32 scale)
+{
+    auto& scan_out = n64.rdp.scan_out;
+
+    scan_out.dither_filter = dither_filter;
+    scan_out.scale = scale;
+
+    // output size goes with the scaling
+    change_res(n64);
+}
+
+// only a redrawn screen goes out, a skipped one leaves the last on display
+void submit_screen(Rdp& rdp)
+{
+    if(rdp.frame_sink)
+    {
+        rdp.frame_sink->submit_frame(rdp.screen,rdp.screen_x,rdp.screen_y);
+    }
+}
+
+void render(N64 &n64)
+{
+    auto& vi = n64.mem.vi;
+    auto& rdp = n64.rdp;
+    auto& scan_out = rdp.scan_out;
+
+    // scan out has to see every draw handed over so far
+    flush_rdp(n64);
+
+    ScanOutParams params;
+    params.origin = vi.origin;
+    params.width = vi.width;
+    params.bpp = vi.bpp;
+    params.x_offset = vi.x_offset >> 10;
+    params.y_offset = vi.y_offset >> 10;
+    params.x_scale = vi.x_scale;
+    params.y_scale = vi.y_scale;
+    params.aa = vi.aa;
+    params.frame_x = rdp.frame_x;
+    params.frame_y = rdp.frame_y;
+    params.screen_x = rdp.screen_x;
+    params.screen_y = rdp.screen_y;
+    params.dither_filter = scan_out.dither_filter && vi.dither_filter && vi.bpp == 2;
+    params.scale = scan_out.scale;
+
+    watch_scan_out(n64,params);
+
+    // nothing the last frame came from has changed
+    if(!scan_out.dirty && params == scan_out.params)
+    {
+        return;
+    }
+
+    scan_out.dirty = false;
+    scan_out.params = params;
+
+    if(vi.bpp != 2 && vi.bpp != 3)
+    {
+        // blank
+        if(vi.bpp == 0)
+        {
+            std::fill(rdp.screen.begin(),rdp.screen.end(),0xff000000);
+            submit_screen(rdp);
+            return;
+        }
+
+        printf("unhandled bpp mode %x\n",vi.bpp); exit(1);
+    }
+
+    const u32 frame_x = params.frame_x;
+    const u32 frame_y = params.frame_y;
+
+    if(!frame_x || !frame_y)
+    {
+        return;
+    }
+
+    // only go via the intermediates when there is another pass after
+    auto& frame = params.dither_filter || params.scale? scan_out.frame : rdp.screen;
+    frame.resize(frame_x * frame_y);
+
+    const u32 size = vi.bpp == 3? sizeof(u32) : sizeof(u16);
+    const u8* ram = n64.mem.rd_ram;
+
+    for(u32 y = 0; y < frame_y; y++)
+    {
+        const u32 addr = params.origin + ((((y + params.y_offset) * params.width) + params.x_offset) * size);
+        u32* dst = &frame[y * frame_x];
+
+        if(vi.bpp == 2)
+        {
+            scan_out_row_16(ram,addr,dst,frame_x);
+        }
+
+        // 8bpp
+        // what format is this in?
+        else
+        {
+            scan_out_row_32(ram,addr,dst,frame_x);
+        }
+    }
+
+    const u32* src = frame.data();
+
+    if(params.dither_filter)
+    {
+        auto& filtered = params.scale? scan_out.filtered : rdp.screen;
+        filtered.resize(frame_x * frame_y);
+
+        dither_filter_pass(src,filtered.data(),frame_x,frame_y);
+        src = filtered.data();
+    }
+
+    if(params.scale)
+    {
+        if(!params.screen_x || !params.screen_y)
+        {
+            return;
+        }
+
+        scale_pass(scan_out,params,src,rdp.screen.data());
+    }
+
+    submit_screen(rdp);
+}
+
+}
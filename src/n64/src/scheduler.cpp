@@ -23,7 +23,7 @@ void N64Scheduler::service_event(const EventNode<n64_event> & node)
 
         case n64_event::count:
         {
-            count_event(n64,cycles_to_tick);
+            count_event(n64);
             break;
         }
 
@@ -50,6 +50,12 @@ void N64Scheduler::service_event(const EventNode<n64_event> & node)
             sp_dma_finished(n64);
             break;
         }
+
+        case n64_event::rsp:
+        {
+            rsp_event(n64,cycles_to_tick);
+            break;
+        }
     }
 }
 
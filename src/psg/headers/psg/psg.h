@@ -1,5 +1,6 @@
 #pragma once
 #include <albion/lib.h>
+#include <albion/save_state.h>
 
 namespace gameboy_psg
 {
@@ -58,9 +59,14 @@ void length_trigger(Channel &c);
 void write_lengthc(Channel &c, u8 v);
 void length_write(Channel &c, u8 v, u8 seq_step);
 
+// channels are not ticked per period, instead they are caught up in closed form
+// when they are about to be observed or modified
+u32 catch_up_period(Channel &c, s32 reload, u32 cycles);
+
 f32 mix_psg_channels(const f32 *output,u32 volume_level,u32 enable_set,bool enable);
 
 // freq
+s32 freq_period(const Channel &c);
 void freq_reload_period(Channel &c);
 void freq_trigger(Channel &c);
 void freq_write_higher(Channel &c, u8 v);
@@ -76,7 +82,7 @@ static constexpr int dac_masks[] = {248,248,128,248};
 
 
 // square
-bool square_tick_period(Channel &c,u32 cycles);
+void square_catch_up(Channel &c,u32 cycles);
 void duty_trigger(Channel &c);
 void write_cur_duty(Channel &c, u8 v);
 
@@ -109,8 +115,10 @@ struct Noise
 void init_noise(Noise &noise);
 void noise_write(Noise &n,u8 v);
 void noise_trigger(Noise &n);
+s32 noise_period(const Channel &c,const Noise &n);
 void noise_reload_period(Channel &c,Noise &n);
-bool noise_tick_period(Noise &n,Channel &c, u32 cycles);
+u16 noise_lfsr_jump(u16 shift_reg, bool counter_width, u32 steps);
+void noise_catch_up(Noise &n,Channel &c, u32 cycles);
 
 struct Wave
 {
@@ -123,7 +131,7 @@ struct Wave
 void init_wave(Wave &w, psg_mode mode);
 void wave_write_vol(Channel &c, u8 v);
 void wave_vol_trigger(Channel &c);
-bool wave_tick_period(Wave &w, Channel &c, u32 cycles);
+void wave_catch_up(Wave &w, Channel &c, u32 cycles);
 void wave_trigger(Channel &c);
 
 
@@ -135,11 +143,15 @@ struct Psg
 	void reset_sequencer() noexcept;
 	void advance_sequencer() noexcept;
 	void tick_periods(u32 cycles) noexcept;
+
+	// bring the channels up to the callers clock
+	// shift is how many times faster the callers clock runs than the psg (cgb double speed)
+	void sync(u64 time, u32 shift) noexcept;
 	void enable_sound() noexcept;
 	void disable_sound() noexcept;
 
-	void save_state(std::ofstream &fp);
-	dtr_res load_state(std::ifstream &fp);
+	void save_state(StateWriter& writer) const;
+	dtr_res load_state(StateReader& reader);
 
 	bool chan_enabled(int chan) const noexcept
 	{
@@ -251,6 +263,9 @@ struct Psg
 
 	int sequencer_step = 0;
 
+	// clock the channels were last caught up to
+	u64 timestamp = 0;
+
 	// backing regs
 
 	// nr1x
@@ -285,4 +300,65 @@ struct Psg
 	u8 nr52;
 };
 
+
+// output stage
+// channel amplitudes are buffered per sample and panned, mixed and filtered a block at a time
+// so the per sample cost on the emulation side is just a few stores
+struct MixerConfig
+{
+	// model of the capacitor on the output that removes the dc offset of the channels
+	bool high_pass = true;
+
+	// smooth the point sampled output before the host gets it
+	bool low_pass = true;
+	f32 low_pass_cutoff = 15000.0f;
+};
+
+struct Mixer
+{
+	static constexpr u32 BLOCK_SIZE = 256;
+
+	// scale converts a channel amplitude (0 - 15) into the range of the core
+	void init(psg_mode mode, f32 scale, u32 sample_rate, const MixerConfig &config) noexcept;
+
+	// record the current channel output along with any extra signal the core wants mixed in (gba dma)
+	// returns true when the block is full and mix must be called
+	bool push(const Psg &psg, f32 extra_left = 0.0f, f32 extra_right = 0.0f) noexcept;
+
+	// render everything pushed so far into output as interleaved stereo
+	// returns the number of stereo samples
+	u32 mix() noexcept;
+
+	alignas(16) f32 output[BLOCK_SIZE * 2];
+
+private:
+	void render() noexcept;
+	void update_gain(u8 nr50, u8 nr51) noexcept;
+
+	// soa so the panning vectorises across the block
+	alignas(16) f32 amplitude[4][BLOCK_SIZE];
+	alignas(16) f32 extra[2][BLOCK_SIZE];
+
+	// samples pushed, and how many of them are already in output
+	u32 len = 0;
+	u32 rendered = 0;
+
+	// per channel left / right gain for the current nr50 / nr51
+	f32 gain[2][4] = {};
+	u8 nr50 = 0;
+	u8 nr51 = 0;
+
+	f32 scale = 1.0f;
+
+	// high pass
+	bool high_pass = false;
+	f32 charge = 0.0f;
+	f32 capacitor[2] = {};
+
+	// low pass
+	bool low_pass = false;
+	f32 alpha = 0.0f;
+	f32 smoothed[2] = {};
+};
+
 }
\ No newline at end of file
@@ -114,6 +114,24 @@ void length_write(Channel &c, u8 v, u8 seq_step)
     c.length_enabled = is_set(v,6);    
 }
 
+// advance the period counter, returning how many times it elapsed
+// any overshoot is carried into the reloaded period
+u32 catch_up_period(Channel &c, s32 reload, u32 cycles)
+{
+    const s64 remain = s64(c.period) - s64(cycles);
+
+    if(remain > 0)
+    {
+        c.period = remain;
+        return 0;
+    }
+
+    const u64 over = -remain;
+    c.period = reload - s32(over % reload);
+
+    return 1 + (over / reload);
+}
+
 f32 mix_psg_channels(const f32 *output,u32 volume_level,u32 enable_set,bool enable)
 {
     if(!enable)
@@ -13,9 +13,14 @@ void freq_write_higher(Channel &c, u8 v)
     c.freq = (c.freq & 0xff) | ((v & 0x7) << 8);
 }
 
+s32 freq_period(const Channel &c)
+{
+    return (2048 - c.freq)*c.period_scale*c.period_factor;
+}
+
 void freq_reload_period(Channel &c)
 {
-    c.period = (2048 - c.freq)*c.period_scale*c.period_factor;
+    c.period = freq_period(c);
 }
 
 void freq_trigger(Channel &c)
@@ -0,0 +1,142 @@
+#include <psg/psg.h>
+#include <cmath>
+#include <bit>
+#include <numbers>
+
+namespace gameboy_psg
+{
+
+void Mixer::init(psg_mode mode, f32 scale, u32 sample_rate, const MixerConfig &config) noexcept
+{
+    *this = {};
+
+    this->scale = scale;
+
+    // charge factors are per 4mhz clock, the gba psg runs off the same amp as the cgb
+    static constexpr u32 PSG_CLOCK = 4 * 1024 * 1024;
+    const f64 charge_base = mode == psg_mode::dmg? 0.999958 : 0.998943;
+
+    high_pass = config.high_pass;
+    charge = f32(std::pow(charge_base,f64(PSG_CLOCK) / sample_rate));
+
+    // past nyquist there is nothing for the filter to do
+    low_pass = config.low_pass && config.low_pass_cutoff < f32(sample_rate) / 2.0f;
+    alpha = f32(1.0 - std::exp((-2.0 * std::numbers::pi * config.low_pass_cutoff) / sample_rate));
+
+    update_gain(0,0);
+}
+
+void Mixer::update_gain(u8 nr50, u8 nr51) noexcept
+{
+    this->nr50 = nr50;
+    this->nr51 = nr51;
+
+    // same response as mix_psg_channels
+    // the enabled channels are averaged and then scaled by the master volume
+    for(u32 side = 0; side < 2; side++)
+    {
+        // left is the upper nibble of both regs
+        const u32 shift = side == 0? 4 : 0;
+        const u32 enable_set = (nr51 >> shift) & 0xf;
+        const u32 volume_level = (nr50 >> shift) & 7;
+
+        const u32 enabled = std::popcount(enable_set);
+        const f32 volume = (16 * (volume_level + 1)) / 256.0f;
+        const f32 level = enabled? (scale * volume) / f32(enabled) : 0.0f;
+
+        for(u32 c = 0; c < 4; c++)
+        {
+            gain[side][c] = is_set(enable_set,c)? level : 0.0f;
+        }
+    }
+}
+
+bool Mixer::push(const Psg &psg, f32 extra_left, f32 extra_right) noexcept
+{
+    // panning changed, everything up to now has to go out with the old gains
+    if(psg.nr50 != nr50 || psg.nr51 != nr51)
+    {
+        render();
+        update_gain(psg.nr50,psg.nr51);
+    }
+
+    for(u32 c = 0; c < 4; c++)
+    {
+        amplitude[c][len] = f32(psg.channels[c].output);
+    }
+
+    extra[0][len] = extra_left;
+    extra[1][len] = extra_right;
+
+    len++;
+
+    return len == BLOCK_SIZE;
+}
+
+void Mixer::render() noexcept
+{
+    const u32 start = rendered;
+    const u32 count = len - rendered;
+
+    if(!count)
+    {
+        return;
+    }
+
+    // pan and scale, written so the compiler can do several samples per multiply
+    for(u32 side = 0; side < 2; side++)
+    {
+        const f32 g0 = gain[side][0];
+        const f32 g1 = gain[side][1];
+        const f32 g2 = gain[side][2];
+        const f32 g3 = gain[side][3];
+
+        f32* out = &extra[side][start];
+
+        for(u32 i = 0; i < count; i++)
+        {
+            const u32 s = start + i;
+            out[i] += (amplitude[0][s] * g0 + amplitude[1][s] * g1) + (amplitude[2][s] * g2 + amplitude[3][s] * g3);
+        }
+    }
+
+    // the filters carry state sample to sample so just run them in order
+    for(u32 i = 0; i < count; i++)
+    {
+        for(u32 side = 0; side < 2; side++)
+        {
+            f32 v = extra[side][start + i];
+
+            if(high_pass)
+            {
+                const f32 in = v;
+                v = in - capacitor[side];
+                capacitor[side] = in - (v * charge);
+            }
+
+            if(low_pass)
+            {
+                smoothed[side] += alpha * (v - smoothed[side]);
+                v = smoothed[side];
+            }
+
+            output[((start + i) * 2) + side] = v;
+        }
+    }
+
+    rendered = len;
+}
+
+u32 Mixer::mix() noexcept
+{
+    render();
+
+    const u32 samples = len;
+
+    len = 0;
+    rendered = 0;
+
+    return samples;
+}
+
+}
@@ -23,49 +23,139 @@ void noise_trigger(Noise &n)
 //http://gbdev.gg8.se/wiki/articles/Gameboy_sound_hardware#Noise_Channel
 static constexpr u32 divisors[8] = { 8, 16, 32, 48, 64, 80, 96, 112 };
 
-void noise_reload_period(Channel &c,Noise &n)
+s32 noise_period(const Channel &c,const Noise &n)
 {
 	// "The noise channel's frequency timer period is set by a base divisor shifted left some number of bits. "
-	c.period = (divisors[n.divisor_idx] << n.clock_shift) * c.period_factor;	
+	return (divisors[n.divisor_idx] << n.clock_shift) * c.period_factor;
 }
 
-bool noise_tick_period(Noise &n,Channel &c, u32 cycles)
+void noise_reload_period(Channel &c,Noise &n)
 {
-	c.period -= cycles; // polynomial counter
+	c.period = noise_period(c,n);
+}
 
-	if(c.period <= 0)
+constexpr u16 lfsr_step(u16 shift_reg, bool counter_width)
+{
+	// bottom two bits xored and reg shifted right
+	const u16 result = (shift_reg ^ (shift_reg >> 1)) & 0x1;
+	shift_reg >>= 1;
+
+	// result placed in high bit (15 bit reg)
+	shift_reg |= (result << 14);
+
+	if(counter_width) // in width mode
 	{
-		noise_reload_period(c,n);
+		// also put result in bit 6
+		shift_reg = (shift_reg & ~(1 << 6)) | (result << 6);
+	}
 
-		// bottom two bits xored and reg shifted right
-		int result = n.shift_reg & 0x1;
-		n.shift_reg >>= 1;
-		result ^= n.shift_reg & 0x1;
+	return shift_reg;
+}
+
+// the lfsr is linear over GF(2) so N steps is just a 15x15 bit matrix
+// we store M^(2^k) for every power as nibble lookup tables
+// so stepping any number of times is at most 32 * 4 lookups
+static constexpr u32 LFSR_BITS = 15;
+static constexpr u32 LFSR_POWERS = 32;
+static constexpr u32 LFSR_NIBBLES = 4;
+
+using LfsrJumpTable = std::array<std::array<std::array<std::array<u16,16>,LFSR_NIBBLES>,LFSR_POWERS>,2>;
 
-		// result placed in high bit (15 bit reg)
-		n.shift_reg |=  (result << 14);
+constexpr u16 lfsr_apply(const std::array<u16,LFSR_BITS>& columns, u16 shift_reg)
+{
+	u16 out = 0;
 
-		if(n.counter_width) // in width mode
+	for(u32 i = 0; i < LFSR_BITS; i++)
+	{
+		if((shift_reg >> i) & 1)
 		{
-			// also put result in bit 6
-			n.shift_reg = deset_bit(n.shift_reg,6);
-			n.shift_reg |= result << 6;
-		} 
-
-		// if lsb NOT SET
-		// put output
-		if(c.enabled && c.dac_on && !is_set(n.shift_reg,0))
+			out ^= columns[i];
+		}
+	}
+
+	return out;
+}
+
+constexpr LfsrJumpTable make_lfsr_jump_table()
+{
+	LfsrJumpTable table = {};
+
+	for(u32 width = 0; width < 2; width++)
+	{
+		// single step matrix, column i is where bit i ends up
+		std::array<u16,LFSR_BITS> columns = {};
+
+		for(u32 i = 0; i < LFSR_BITS; i++)
 		{
-			c.output = c.volume;
+			columns[i] = lfsr_step(1 << i,width);
 		}
-	
-		else 
+
+		for(u32 k = 0; k < LFSR_POWERS; k++)
 		{
-			c.output = 0;
+			for(u32 nibble = 0; nibble < LFSR_NIBBLES; nibble++)
+			{
+				for(u32 v = 0; v < 16; v++)
+				{
+					table[width][k][nibble][v] = lfsr_apply(columns,(v << (nibble * 4)) & 0x7fff);
+				}
+			}
+
+			// square the matrix for the next power
+			std::array<u16,LFSR_BITS> squared = {};
+
+			for(u32 i = 0; i < LFSR_BITS; i++)
+			{
+				squared[i] = lfsr_apply(columns,columns[i]);
+			}
+
+			columns = squared;
 		}
-		return true;
 	}
-	return false;
+
+	return table;
+}
+
+static constexpr LfsrJumpTable LFSR_JUMP_TABLE = make_lfsr_jump_table();
+
+u16 noise_lfsr_jump(u16 shift_reg, bool counter_width, u32 steps)
+{
+	const auto& table = LFSR_JUMP_TABLE[counter_width];
+
+	for(u32 k = 0; steps; k++, steps >>= 1)
+	{
+		if(steps & 1)
+		{
+			shift_reg = table[k][0][(shift_reg >> 0) & 0xf] ^ table[k][1][(shift_reg >> 4) & 0xf] ^
+				table[k][2][(shift_reg >> 8) & 0xf] ^ table[k][3][(shift_reg >> 12) & 0xf];
+		}
+	}
+
+	return shift_reg;
+}
+
+void noise_catch_up(Noise &n,Channel &c, u32 cycles)
+{
+	// polynomial counter
+	const u32 ticks = catch_up_period(c,noise_period(c,n),cycles);
+
+	if(!ticks)
+	{
+		return;
+	}
+
+	n.shift_reg = noise_lfsr_jump(n.shift_reg,n.counter_width,ticks);
+
+	// if lsb NOT SET
+	// put output
+	if(c.enabled && c.dac_on && !is_set(n.shift_reg,0))
+	{
+		c.output = c.volume;
+	}
+
+	else 
+	{
+		c.output = 0;
+	}
 }
 
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ Psg::Psg()
 void Psg::init(psg_mode mode, bool use_bios)
 {
     this->mode = mode;
+    timestamp = 0;
     
 
 
@@ -153,10 +154,30 @@ void Psg::clock_envelopes() noexcept
 
 void Psg::tick_periods(u32 cycles) noexcept
 {
-    square_tick_period(channels[0],cycles);
-    square_tick_period(channels[1],cycles);
-    wave_tick_period(wave,channels[2],cycles);
-    noise_tick_period(noise,channels[3],cycles);    
+    square_catch_up(channels[0],cycles);
+    square_catch_up(channels[1],cycles);
+    wave_catch_up(wave,channels[2],cycles);
+    noise_catch_up(noise,channels[3],cycles);    
+}
+
+void Psg::sync(u64 time, u32 shift) noexcept
+{
+    // clock was reset under us
+    if(time < timestamp)
+    {
+        timestamp = time;
+        return;
+    }
+
+    // keep any cycles that dont make up a full psg cycle for next time
+    const u64 cycles = (time - timestamp) >> shift;
+    timestamp += cycles << shift;
+
+    // channels dont advance while the sound is off
+    if(sound_enabled && cycles)
+    {
+        tick_periods(cycles);
+    }
 }
 
 void Psg::enable_sound() noexcept
@@ -654,48 +675,48 @@ u8 Psg::read_wave_table(int idx) const noexcept
     }    
 }
 
-void channel_save_state(Channel &c, std::ofstream &fp)
+void channel_save_state(const Channel &c, StateWriter& writer)
 {
-	file_write_var(fp,c);
+	state_write_var(writer,c);
 }
 
-void sweep_save_state(Sweep &s, std::ofstream &fp)
+void sweep_save_state(const Sweep &s, StateWriter& writer)
 {
-	file_write_var(fp,s);
+	state_write_var(writer,s);
 }
 
-void wave_save_state(Wave &w, std::ofstream &fp)
+void wave_save_state(const Wave &w, StateWriter& writer)
 {
-	file_write_var(fp,w);
+	state_write_var(writer,w);
 }
 
-void noise_save_state(Noise &n, std::ofstream &fp)
+void noise_save_state(const Noise &n, StateWriter& writer)
 {
-	file_write_var(fp,n);
+	state_write_var(writer,n);
 }
 
-dtr_res channel_load_state(Channel &c, std::ifstream &fp)
+dtr_res channel_load_state(Channel &c, StateReader& reader)
 {
-	const auto res = file_read_var(fp,c);
+	const auto res = state_read_var(reader,c);
     c.duty_idx &= 7;
     c.cur_duty &= 3;
 
     return res;
 }
 
-dtr_res sweep_load_state(Sweep &s, std::ifstream &fp)
+dtr_res sweep_load_state(Sweep &s, StateReader& reader)
 {
-	return file_read_var(fp,s);
+	return state_read_var(reader,s);
 }
 
-dtr_res wave_load_state(Wave &w, std::ifstream &fp)
+dtr_res wave_load_state(Wave &w, StateReader& reader)
 {
-	return file_read_var(fp,w);
+	return state_read_var(reader,w);
 }
 
-dtr_res noise_load_state(Noise &n, std::ifstream &fp)
+dtr_res noise_load_state(Noise &n, StateReader& reader)
 {
-	const auto res = file_read_var(fp,n);
+	const auto res = state_read_var(reader,n);
     n.divisor_idx &= 7;
     return res;
 }
@@ -703,110 +724,112 @@ dtr_res noise_load_state(Noise &n, std::ifstream &fp)
 
 
 
-void Psg::save_state(std::ofstream &fp)
+void Psg::save_state(StateWriter& writer) const
 {
-	file_write_var(fp,mode);
+	state_write_var(writer,mode);
 
 
-	file_write_var(fp,sound_enabled);
+	state_write_var(writer,sound_enabled);
 
-	file_write_var(fp,sequencer_step);
+	state_write_var(writer,sequencer_step);
+	state_write_var(writer,timestamp);
 
 	// backing regs
 
 	// nr1x
-	file_write_var(fp,nr10);
-	file_write_var(fp,nr11);
-    file_write_var(fp,nr12);
-	file_write_var(fp,nr13);
-	file_write_var(fp,nr14);
+	state_write_var(writer,nr10);
+	state_write_var(writer,nr11);
+    state_write_var(writer,nr12);
+	state_write_var(writer,nr13);
+	state_write_var(writer,nr14);
 
 	// nr2x
-    file_write_var(fp,nr21);
-	file_write_var(fp,nr22);
-	file_write_var(fp,nr23);
-	file_write_var(fp,nr24);
+    state_write_var(writer,nr21);
+	state_write_var(writer,nr22);
+	state_write_var(writer,nr23);
+	state_write_var(writer,nr24);
 
 	// nr3x
-	file_write_var(fp,nr30);
-	file_write_var(fp,nr31);
-	file_write_var(fp,nr32);
-	file_write_var(fp,nr33);
-	file_write_var(fp,nr34);
+	state_write_var(writer,nr30);
+	state_write_var(writer,nr31);
+	state_write_var(writer,nr32);
+	state_write_var(writer,nr33);
+	state_write_var(writer,nr34);
 
 	// nr4x
-	file_write_var(fp,nr41);
-	file_write_var(fp,nr42);
-	file_write_var(fp,nr43);
-	file_write_var(fp,nr44);	
+	state_write_var(writer,nr41);
+	state_write_var(writer,nr42);
+	state_write_var(writer,nr43);
+	state_write_var(writer,nr44);	
 
 	// nr5x
-	file_write_var(fp,nr50);
-	file_write_var(fp,nr51);
-	file_write_var(fp,nr52);
+	state_write_var(writer,nr50);
+	state_write_var(writer,nr51);
+	state_write_var(writer,nr52);
 
     // save channel data
     for(int i = 0; i < 4; i++)
     {
-        channel_save_state(channels[i],fp);
+        channel_save_state(channels[i],writer);
     }
 
-    wave_save_state(wave,fp);
-    noise_save_state(noise,fp);
-    sweep_save_state(sweep,fp);
+    wave_save_state(wave,writer);
+    noise_save_state(noise,writer);
+    sweep_save_state(sweep,writer);
 }
 
-dtr_res Psg::load_state(std::ifstream &fp)
+dtr_res Psg::load_state(StateReader& reader)
 {
-	dtr_res err = file_read_var(fp,mode);
+	dtr_res err = state_read_var(reader,mode);
 
 
-	err |= file_read_var(fp,sound_enabled);
+	err |= state_read_var(reader,sound_enabled);
 
-	err |= file_read_var(fp,sequencer_step);
+	err |= state_read_var(reader,sequencer_step);
+	err |= state_read_var(reader,timestamp);
 
 	// backing regs
 
 	// nr1x
-	err |= file_read_var(fp,nr10);
-	err |= file_read_var(fp,nr11);
-    err |= file_read_var(fp,nr12);
-	err |= file_read_var(fp,nr13);
-	err |= file_read_var(fp,nr14);
+	err |= state_read_var(reader,nr10);
+	err |= state_read_var(reader,nr11);
+    err |= state_read_var(reader,nr12);
+	err |= state_read_var(reader,nr13);
+	err |= state_read_var(reader,nr14);
 
 	// nr2x
-    err |= file_read_var(fp,nr21);
-	err |= file_read_var(fp,nr22);
-	err |= file_read_var(fp,nr23);
-	err |= file_read_var(fp,nr24);
+    err |= state_read_var(reader,nr21);
+	err |= state_read_var(reader,nr22);
+	err |= state_read_var(reader,nr23);
+	err |= state_read_var(reader,nr24);
 
 	// nr3x
-	err |= file_read_var(fp,nr30);
-	err |= file_read_var(fp,nr31);
-	err |= file_read_var(fp,nr32);
-	err |= file_read_var(fp,nr33);
-	err |= file_read_var(fp,nr34);
+	err |= state_read_var(reader,nr30);
+	err |= state_read_var(reader,nr31);
+	err |= state_read_var(reader,nr32);
+	err |= state_read_var(reader,nr33);
+	err |= state_read_var(reader,nr34);
 
 	// nr4x
-	err |= file_read_var(fp,nr41);
-	err |= file_read_var(fp,nr42);
-	err |= file_read_var(fp,nr43);
-	err |= file_read_var(fp,nr44);	
+	err |= state_read_var(reader,nr41);
+	err |= state_read_var(reader,nr42);
+	err |= state_read_var(reader,nr43);
+	err |= state_read_var(reader,nr44);	
 
 	// nr5x
-	err |= file_read_var(fp,nr50);
-	err |= file_read_var(fp,nr51);
-	err |= file_read_var(fp,nr52);
+	err |= state_read_var(reader,nr50);
+	err |= state_read_var(reader,nr51);
+	err |= state_read_var(reader,nr52);
 
     // load in channel data
     for(int i = 0; i < 4; i++)
     {
-        err |= channel_load_state(channels[i],fp);
+        err |= channel_load_state(channels[i],reader);
     }
 
-    err |= wave_load_state(wave,fp);
-    err |= noise_load_state(noise,fp);
-    err |= sweep_load_state(sweep,fp);
+    err |= wave_load_state(wave,reader);
+    err |= noise_load_state(noise,reader);
+    err |= sweep_load_state(sweep,reader);
 
     return err;
 }
@@ -12,28 +12,26 @@ static constexpr int duty[4][8] =
 };
 
 
-bool square_tick_period(Channel &c,u32 cycles)
+void square_catch_up(Channel &c,u32 cycles)
 {
+	const u32 ticks = catch_up_period(c,freq_period(c),cycles);
 
-	c.period -= cycles;
-
-	if(c.period <= 0)
+	if(!ticks)
 	{
-		// advance the duty
-		c.duty_idx = (c.duty_idx + 1) & 0x7;
-		freq_reload_period(c);
+		return;
+	}
 
-		// if channel and dac is enabled
-		// output is volume else nothing
-		c.output = (c.enabled && c.dac_on)? c.volume : 0;
+	// advance the duty
+	c.duty_idx = (c.duty_idx + ticks) & 0x7;
 
+	// if channel and dac is enabled
+	// output is volume else nothing
+	c.output = (c.enabled && c.dac_on)? c.volume : 0;
 
-		// if the duty is on a low posistion there is no output
-		// (vol is multiplied by duty but its only on or off)
-		c.output *= duty[c.cur_duty][c.duty_idx];
-		return true;
-	}
-	return false;
+
+	// if the duty is on a low posistion there is no output
+	// (vol is multiplied by duty but its only on or off)
+	c.output *= duty[c.cur_duty][c.duty_idx];
 }
 
 void duty_trigger(Channel &c)
@@ -44,75 +44,71 @@ void wave_write_vol(Channel &c, u8 v)
     c.volume = c.volume_load;
 }
 
-bool wave_tick_period(Wave &w, Channel &c, u32 cycles)
+void wave_catch_up(Wave &w, Channel &c, u32 cycles)
 {
-	// handle wave ticking (square 3)	
-	c.period -= cycles;
-		
-	// reload timer and goto the next sample in the wave table
-	if(c.period <= 0)
+	// period (2048-frequency)*2 (in cpu cycles)
+	const u32 ticks = catch_up_period(c,freq_period(c),cycles);
+
+	if(!ticks)
 	{
-		// duty is the wave table index for wave channel 
-		
-		// check by here for the 2nd bank
-		if(w.dimension)
+		return;
+	}
+
+	// duty is the wave table index for wave channel 
+
+	// every time the index overflows we switch to the other bank
+	if(w.dimension)
+	{
+		const u32 wraps = (c.duty_idx + ticks) / 0x20;
+
+		if(wraps & 1)
 		{
-			// about to overflow switch to over bank
-			if(c.duty_idx == 0x1f)
-			{
-				w.bank_idx = !w.bank_idx;
-			}
+			w.bank_idx = !w.bank_idx;
 		}
+	}
+
+	c.duty_idx = (c.duty_idx + ticks) & 0x1f; 
 
-		c.duty_idx  = (c.duty_idx + 1) & 0x1f; 
+	// dac is enabled
+	if(c.dac_on && c.enabled)
+	{
+		int pos = c.duty_idx / 2;
 
-		// dac is enabled
-		if(c.dac_on && c.enabled)
+		u8 byte;
+		if(w.mode != psg_mode::gba)
 		{
-			int pos = c.duty_idx / 2;
-
-			u8 byte;
-			if(w.mode != psg_mode::gba)
-			{
-				byte = w.table[0][pos];
-			}
-
-			else
-			{
-				byte = w.table[w.bank_idx][pos];
-			}
-				
-			if(!is_set(c.duty_idx,0)) // access the high nibble first
-			{
-				byte >>= 4;
-			}
-				
-			byte &= 0xf;
-				
-			if(c.volume)
-			{
-				byte >>= c.volume - 1;
-			}
-				
-			else
-			{
-				byte = 0;
-			}
-
-			c.output = byte;
+			byte = w.table[0][pos];
+		}
+
+		else
+		{
+			byte = w.table[w.bank_idx][pos];
+		}
+			
+		if(!is_set(c.duty_idx,0)) // access the high nibble first
+		{
+			byte >>= 4;
+		}
+			
+		byte &= 0xf;
+			
+		if(c.volume)
+		{
+			byte >>= c.volume - 1;
 		}
 			
 		else
-		{ 
-			c.output = 0;
+		{
+			byte = 0;
 		}
 
-		// reload the timer
-		// period (2048-frequency)*2 (in cpu cycles)
-		freq_reload_period(c);
-		return true;			
+		c.output = byte;
+	}
+		
+	else
+	{ 
+		c.output = 0;
 	}
-	return false;
 }
 
 
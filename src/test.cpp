@@ -1,93 +1,124 @@
 #include <destoer/destoer.h>
 #include <albion/lib.h>
+#include <albion/thread_pool.h>
 
-#ifdef GB_ENABLED
-#include <gb/gb.h>
+// headless regression runner
+// every test is a job on a work stealing pool, each worker reuses its own emulator instance
+// timeouts are in emulated frames so results dont depend on how loaded the machine is
+// and the frames per second of each test doubles as a performance regression check
+
+enum class test_status
+{
+    pass,
+    fail,
+    timeout,
+    aborted,
+};
+
+const char* test_status_name(test_status status)
+{
+    switch(status)
+    {
+        case test_status::pass: return "pass";
+        case test_status::fail: return "fail";
+        case test_status::timeout: return "timeout";
+        case test_status::aborted: return "aborted";
+    }
+
+    return "unknown";
+}
+
+struct TestResult
+{
+    std::string suite;
+    std::string name;
+    test_status status = test_status::aborted;
+    std::string message;
+
+    u64 frames = 0;
+    f64 seconds = 0.0;
+
+    f64 fps() const
+    {
+        return seconds > 0.0? f64(frames) / seconds : 0.0;
+    }
+};
+
+struct TestJob
+{
+    std::string suite;
+    std::string name;
+    std::function<void(u32 worker, TestResult& result)> run;
+};
 
-// gameboy test running
-void gb_run_test_helper(const std::vector<std::string> &tests, int seconds)
+struct TestOptions
 {
+    // 0 picks the hardware thread count
+    u32 threads = 0;
+    std::string junit_path;
+    std::string json_path;
+};
 
-    int fail = 0;
-    int pass = 0;
-    int aborted = 0;
-    int timeout = 0;
+#ifdef GB_ENABLED
+#include <gb/gb.h>
 
-    gameboy::GB gb;
+// 10 emulated seconds
+static constexpr u32 GB_TEST_TIMEOUT_FRAMES = 60 * 10;
 
-    for(const auto &x: tests)
+void gb_add_tests(std::vector<TestJob>& jobs, std::vector<std::unique_ptr<gameboy::GB>>& instances, 
+    const std::string& suite, const std::vector<std::string>& tests, u32 timeout_frames)
+{
+    for(const auto& rom : tests)
     {
-        
-        try
+        jobs.push_back({suite,rom,[&instances,rom,timeout_frames](u32 worker, TestResult& result)
         {
-            gb.reset(x);
-            gb.throttle_emu = false;
+            // only this worker ever touches its slot
+            if(!instances[worker])
+            {
+                instances[worker] = std::make_unique<gameboy::GB>();
+            }
 
+            auto& gb = *instances[worker];
 
-            auto start = std::chrono::system_clock::now();
+            gb.reset(rom);
+            gb.throttle_emu = false;
+            gb.apu.audio_buffer.playback = nullptr;
 
-            // add a timer timeout if required
-            for(;;)
+            while(result.frames < timeout_frames)
             {
                 gb.run();
-
+                result.frames++;
 
                 if(gb.mem.test_result == emu_test::fail)
                 {
-                    std::cout << fmt::format("{}: fail\n",x);
-                    fail++;
-                    break;
+                    result.status = test_status::fail;
+                    return;
                 }
 
                 else if(gb.mem.test_result == emu_test::pass)
                 {
-                    // we are passing so many compared to fails at this point
-                    // it doesnt make sense to print them
-                    //std::cout << fmt::format("{}: pass\n",x);
-                    pass++;
-                    break;
-                }
-
-                auto current = std::chrono::system_clock::now();
-
-                // if the test takes longer than 5 seconds time it out
-                if(std::chrono::duration_cast<std::chrono::seconds>(current - start).count() > seconds)
-                {
-                    std::cout << fmt::format("{}: timeout\n",x);
-                    timeout++;
-                    break;
+                    result.status = test_status::pass;
+                    return;
                 }
             }
-        }
 
-        catch(std::exception &ex)
-        {
-            std::cout << fmt::format("{}: aborted {}\n",x,ex.what());
-            aborted++;
-        }
+            result.status = test_status::timeout;
+        }});
     }
-
-    printf("total: %zd\n",tests.size());
-    printf("pass: %d\n",pass);
-    printf("fail: %d\n",fail);
-    printf("abort: %d\n",aborted);
-    printf("timeout: %d\n",timeout);    
 }
 
-void gb_run_tests()
+void gb_add_suites(std::vector<TestJob>& jobs, std::vector<std::unique_ptr<gameboy::GB>>& instances)
 {
-    puts("gekkio_tests:");
-    auto start = std::chrono::system_clock::now();
     const auto [tree,error] = read_dir_tree("mooneye-gb_hwtests");
-    gb_run_test_helper(filter_ext(tree,"gb"),10);
-    auto current = std::chrono::system_clock::now();
-    auto count = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(current - start).count()) / 1000.0;
-    printf("total time taken %f\n",count);
+    gb_add_tests(jobs,instances,"gekkio_tests",filter_ext(tree,"gb"),GB_TEST_TIMEOUT_FRAMES);
 }
 #endif
 
 #ifdef N64_ENABLED
 #include <n64/n64.h>
+#include <random>
+#include <filesystem>
+#include <fstream>
 
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -303,27 +334,28 @@ static constexpr Test EXCEPTION_TESTS[] =
 
 static constexpr u32 EXCEPTION_TEST_SIZE = sizeof(EXCEPTION_TESTS) / sizeof(Test);
 
-std::pair<std::vector<std::string>,std::vector<std::string>> run_test_list(const std::string suite_name, const std::string base_path,
-    const Test test_list[],u32 test_size)
+void n64_add_tests(std::vector<TestJob>& jobs, std::vector<std::unique_ptr<nintendo64::N64>>& instances, 
+    const std::string suite_name, const std::string base_path, const Test test_list[],u32 test_size)
 {
-    spdlog::info("n64 tests ({}): {}\n",suite_name,base_path);
-    
-    std::vector<std::string> pass_list;
-    std::vector<std::string> fail_list;
-
     for(u32 t = 0; t < test_size; t++)
     {
-        try
+        const Test& test = test_list[t];
+
+        jobs.push_back({suite_name,test.name,[&instances,&test,base_path](u32 worker, TestResult& result)
         {
-            auto& test = test_list[t];
-            spdlog::info("start test: {}\n",test.name);
+            // only this worker ever touches its slot
+            if(!instances[worker])
+            {
+                instances[worker] = std::make_unique<nintendo64::N64>();
+            }
 
-            nintendo64::N64 n64;
+            auto& n64 = *instances[worker];
             nintendo64::reset(n64,fmt::format("{}/{}",base_path,test.rom_path));
 
             for(int f = 0; f < test.frames; f++) 
             {
                 nintendo64::run(n64);
+                result.frames++;
             }
 
             std::vector<u32> screen_check;
@@ -334,139 +366,1433 @@ std::pair<std::vector<std::string>,std::vector<std::string>> run_test_list(const
 
             const b32 error = read_test_image(image_name,screen_check);
             
-            // Cannot find file -> auto set the image
             if(error)
             {
-                spdlog::error("cannot find reference image\n");
-                return std::pair{pass_list,fail_list};
+                result.status = test_status::aborted;
+                result.message = fmt::format("cannot find reference image {}",image_name);
+                return;
             }
 
-            // Can find file -> compare the images
-            else 
-            {
-                b32 pass = true;
+            result.status = test_status::pass;
 
-                // compare image and ignore alpha channel
-                if(screen_check.size() == n64.rdp.screen.size())
+            // compare image and ignore alpha channel
+            if(screen_check.size() == n64.rdp.screen.size())
+            {
+                for(u32 i = 0; i < screen_check.size(); i++)
                 {
-                    for(u32 i = 0; i < screen_check.size(); i++)
+                    const u32 v1 = (screen_check[i] & 0x00ff'ffff);
+                    const u32 v2 = (n64.rdp.screen[i] & 0x00ff'ffff);
+                    if(v1 != v2)
                     {
-                        const u32 v1 = (screen_check[i] & 0x00ff'ffff);
-                        const u32 v2 = (n64.rdp.screen[i] & 0x00ff'ffff);
-                        if(v1 != v2)
-                        {
-                            spdlog::info("images differ at: {}, {:x} != {:x}\n",i,v1,v2);
-                            pass = false;
-                            break;
-                        }
+                        result.message = fmt::format("images differ at: {}, {:x} != {:x}",i,v1,v2);
+                        result.status = test_status::fail;
+                        break;
                     }
                 }
+            }
 
-                else
-                {
-                    spdlog::info("images differ in size: {} : {}\n",screen_check.size(),n64.rdp.screen.size());
-                    pass = false;
-                }
+            else
+            {
+                result.message = fmt::format("images differ in size: {} : {}",screen_check.size(),n64.rdp.screen.size());
+                result.status = test_status::fail;
+            }
+
+            if(result.status == test_status::fail)
+            {
+                write_test_image(fmt::format("fail/{}.png",test.name),n64.rdp.screen,n64.rdp.screen_x,n64.rdp.screen_y);
+            }
+        }});
+    }
+}
 
-                
-                spdlog::info("{}: {}\n",test.rom_path,pass? "PASS" : "FAIL");
+// random alu, memory and forward branch programs, run on the dynarec and on the plain interpreter
+// the two have to agree on the pc, registers, time and random at every block boundary, and on memory at the end
+static constexpr u32 DYNAREC_DIFF_JOBS = 8;
+static constexpr u32 DYNAREC_DIFF_PROGRAMS = 32;
+static constexpr u32 DYNAREC_DIFF_INSTRS = 192;
 
-                if(!pass)
-                {
-                    fail_list.push_back(test.rom_path);
-                    write_test_image(fmt::format("fail/{}.png",test.name),n64.rdp.screen,n64.rdp.screen_x,n64.rdp.screen_y);
-                }
+static constexpr u32 DIFF_CODE = 0x0000'1000;
+static constexpr u32 DIFF_DATA = 0x0001'0000;
 
-                else 
-                {
-                    pass_list.push_back(test.rom_path);
-                }
-            }
+// bases the programs address memory through, never written
+// data through kseg0 and kseg1, the unused end of the code page, and the mi for an access fastmem cannot take
+static constexpr u32 DIFF_DATA_REG = 16;
+static constexpr u32 DIFF_UNCACHED_REG = 17;
+static constexpr u32 DIFF_CODE_REG = 18;
+static constexpr u32 DIFF_MI_REG = 19;
+
+u32 diff_special(u32 rs, u32 rt, u32 rd, u32 sa, u32 funct)
+{
+    return (rs << 21) | (rt << 16) | (rd << 11) | (sa << 6) | funct;
+}
+
+u32 diff_imm(u32 op, u32 rs, u32 rt, u32 imm)
+{
+    return (op << 26) | (rs << 21) | (rt << 16) | (imm & 0xffff);
+}
+
+u32 diff_dst(std::mt19937& rng)
+{
+    // skip the base regs
+    const u32 reg = 1 + (rng() % 27);
+    return reg >= DIFF_DATA_REG? reg + 4 : reg;
+}
+
+u32 diff_alu(std::mt19937& rng)
+{
+    static constexpr u32 FUNCT[] = 
+    {
+        0x00, 0x02, 0x03, 0x04, 0x06, 0x07, 0x21, 0x23, 0x24, 0x25, 0x26, 0x27, 0x2a, 0x2b, 
+        0x2d, 0x2f, 0x38, 0x3a, 0x3b, 0x3c, 0x3e, 0x3f,
+    };
+
+    // addiu, slti, sltiu, andi, ori, xori, lui, daddiu
+    static constexpr u32 IMM_OP[] = {0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x19};
+
+    const u32 rs = rng() % 32;
+    const u32 rt = rng() % 32;
+
+    if(rng() & 1)
+    {
+        return diff_special(rs,rt,diff_dst(rng),rng() % 32,FUNCT[rng() % std::size(FUNCT)]);
+    }
+
+    return diff_imm(IMM_OP[rng() % std::size(IMM_OP)],rs,diff_dst(rng),rng());
+}
+
+u32 diff_memory(std::mt19937& rng)
+{
+    // lb, lh, lw, lbu, lhu, lwu, ld
+    static constexpr u32 LOAD_OP[] = {0x20, 0x21, 0x23, 0x24, 0x25, 0x27, 0x37};
+    static constexpr u32 LOAD_SIZE[] = {1, 2, 4, 1, 2, 4, 8};
+
+    // sb, sh, sw, sd
+    static constexpr u32 STORE_OP[] = {0x28, 0x29, 0x2b, 0x3f};
+    static constexpr u32 STORE_SIZE[] = {1, 2, 4, 8};
+
+    const u32 kind = rng() % 8;
+
+    // mi version
+    if(kind == 0)
+    {
+        return diff_imm(0x23,DIFF_MI_REG,diff_dst(rng),0x4);
+    }
+
+    const u32 base = kind == 1? DIFF_CODE_REG : (kind == 2? DIFF_UNCACHED_REG : DIFF_DATA_REG);
+    const u32 offset = rng() % 0x800;
+
+    if(rng() & 1)
+    {
+        const u32 idx = rng() % std::size(LOAD_OP);
+        return diff_imm(LOAD_OP[idx],base,diff_dst(rng),offset & ~(LOAD_SIZE[idx] - 1));
+    }
+
+    const u32 idx = rng() % std::size(STORE_OP);
+    return diff_imm(STORE_OP[idx],base,rng() % 32,offset & ~(STORE_SIZE[idx] - 1));
+}
+
+std::vector<u32> diff_program(std::mt19937& rng)
+{
+    std::vector<u32> program;
+
+    while(program.size() < DYNAREC_DIFF_INSTRS)
+    {
+        const u32 idx = u32(program.size());
+        const u32 kind = rng() % 16;
+
+        // forward branch or jump, and its delay slot, which has to come before the end
+        if(kind < 2 && idx + 2 < DYNAREC_DIFF_INSTRS)
+        {
+            const u32 target = std::min<u32>(idx + 2 + (rng() % 8),DYNAREC_DIFF_INSTRS);
+
+            // beq, bne, blez, bgtz
+            static constexpr u32 BRANCH_OP[] = {0x04, 0x05, 0x06, 0x07};
+            const u32 op = BRANCH_OP[rng() % std::size(BRANCH_OP)];
+
+            program.push_back(kind == 0? (0x02 << 26) | (((DIFF_CODE + (target * 4)) >> 2) & 0x03ff'ffff) :
+                diff_imm(op,rng() % 32,op >= 0x06? 0 : rng() % 32,target - (idx + 1)));
+
+            program.push_back(diff_alu(rng));
+        }
+
+        // mult / multu then mfhi / mflo, these go through the interpreter handlers
+        else if(kind == 2)
+        {
+            program.push_back(diff_special(rng() % 32,rng() % 32,0,0,0x18 + (rng() & 1)));
+            program.push_back(diff_special(0,0,diff_dst(rng),0,(rng() & 1)? 0x10 : 0x12));
         }
 
-        catch(std::exception &ex)
+        else if(kind < 7)
+        {
+            program.push_back(diff_memory(rng));
+        }
+
+        else
         {
-            spdlog::error("{}: \n",ex.what());
-            fail_list.push_back(test_list[t].rom_path);
+            program.push_back(diff_alu(rng));
         }
     }
-    
-    return std::pair{pass_list,fail_list};
+
+    program.resize(DYNAREC_DIFF_INSTRS);
+
+    // spin at the end
+    program.push_back((0x02 << 26) | (((DIFF_CODE + (DYNAREC_DIFF_INSTRS * 4)) >> 2) & 0x03ff'ffff));
+    program.push_back(0);
+
+    return program;
 }
 
-void print_test_result(const std::string& suite_name, const std::vector<std::string> test_list, bool pass)
+void diff_setup(nintendo64::N64& n64, const std::string& rom, const std::vector<u32>& program, u32 seed)
 {
-    if(test_list.size() == 0)
+    nintendo64::reset(n64,rom);
+
+    std::mt19937 rng(seed);
+    auto& cpu = n64.cpu;
+
+    for(u32 i = 1; i < 32; i++)
     {
-        return;
+        cpu.regs[i] = (u64(rng()) << 32) | rng();
+    }
+
+    cpu.regs[DIFF_DATA_REG] = 0xffff'ffff'8000'0000 | DIFF_DATA;
+    cpu.regs[DIFF_UNCACHED_REG] = 0xffff'ffff'a000'0000 | DIFF_DATA;
+    cpu.regs[DIFF_CODE_REG] = 0xffff'ffff'8000'0000 | (DIFF_CODE + 0x800);
+    cpu.regs[DIFF_MI_REG] = 0xffff'ffff'a430'0000;
+
+    // words are held in host order
+    memcpy(&n64.mem.rd_ram[DIFF_CODE],program.data(),program.size() * sizeof(u32));
+
+    for(u32 i = 0; i < 0x800; i += sizeof(u32))
+    {
+        const u32 v = rng();
+        memcpy(&n64.mem.rd_ram[DIFF_DATA + i],&v,sizeof(v));
+    }
+
+    cpu.pc = 0xffff'ffff'8000'0000 | DIFF_CODE;
+    cpu.pc_fetch = cpu.pc;
+    cpu.pc_next = cpu.pc + 4;
+    cpu.branch_delay = nintendo64::branch_delay_state::end;
+}
+
+// empty when they match
+std::string diff_state(nintendo64::N64& jit, nintendo64::N64& ref)
+{
+    const auto& a = jit.cpu;
+    const auto& b = ref.cpu;
+
+    if(jit.scheduler.get_timestamp() != ref.scheduler.get_timestamp())
+    {
+        return fmt::format("time {} != {}",jit.scheduler.get_timestamp(),ref.scheduler.get_timestamp());
+    }
+
+    if(a.pc != b.pc || a.pc_next != b.pc_next || a.branch_delay != b.branch_delay)
+    {
+        return fmt::format("pc {:x}:{:x} != {:x}:{:x}",a.pc,a.pc_next,b.pc,b.pc_next);
     }
 
-    const std::string result = pass? "PASS" : "FAIL";
+    for(u32 i = 0; i < 32; i++)
+    {
+        if(a.regs[i] != b.regs[i])
+        {
+            return fmt::format("{} {:x} != {:x}",nintendo64::reg_name(i),a.regs[i],b.regs[i]);
+        }
+    }
 
-    if(pass)
+    if(a.hi != b.hi || a.lo != b.lo)
     {
-        spdlog::info("---------- {} {} ({}) ------- ",result,suite_name,test_list.size());
+        return fmt::format("hi / lo {:x}:{:x} != {:x}:{:x}",a.hi,a.lo,b.hi,b.lo);
     }
 
-    else
+    if(nintendo64::read_random(jit) != nintendo64::read_random(ref))
     {
-        spdlog::error("---------- {} {} ({}) ------- ",result,suite_name,test_list.size());
+        return fmt::format("random {} != {}",nintendo64::read_random(jit),nintendo64::read_random(ref));
     }
 
-    for(auto& name : test_list)
+    return "";
+}
+
+// run the program through on both, lining the interpreter up with the end of every dynarec step
+std::string diff_run(nintendo64::N64& jit, nintendo64::N64& ref)
+{
+    const u64 end = 0xffff'ffff'8000'0000 | (DIFF_CODE + (DYNAREC_DIFF_INSTRS * 4));
+
+    // a few times the program length covers every path through it
+    for(u32 i = 0; i < DYNAREC_DIFF_INSTRS * 4 && jit.cpu.pc != end; i++)
     {
-        if(pass)
+        const u64 pc = jit.cpu.pc;
+        nintendo64::step_block(jit);
+
+        while(ref.scheduler.get_timestamp() < jit.scheduler.get_timestamp())
         {
-            spdlog::info("{}: {}",result,name);
+            nintendo64::step_instr(ref);
         }
 
-        else
+        const auto diff = diff_state(jit,ref);
+
+        if(!diff.empty())
+        {
+            return fmt::format("after step from {:x}: {}",pc,diff);
+        }
+    }
+
+    if(jit.cpu.pc != end)
+    {
+        return "never reached the end";
+    }
+
+    for(const u32 addr : {DIFF_DATA,DIFF_CODE + 0x800})
+    {
+        if(memcmp(&jit.mem.rd_ram[addr],&ref.mem.rd_ram[addr],0x800))
         {
-            spdlog::error("{}: {}",result,name);
+            return fmt::format("memory at {:x} differs",addr);
         }
     }
+
+    return "";
+}
+
+// reset wants a rom, tests that set up rdram themselves afterwards share a blank one
+std::string blank_test_rom()
+{
+    const std::string rom = (std::filesystem::temp_directory_path() / "albion_blank.z64").string();
+    const std::vector<char> blank(0x1000,0);
+    std::ofstream(rom,std::ios::binary).write(blank.data(),blank.size());
+
+    return rom;
+}
+
+void n64_add_dynarec_tests(std::vector<TestJob>& jobs)
+{
+    const std::string rom = blank_test_rom();
+
+    for(u32 j = 0; j < DYNAREC_DIFF_JOBS; j++)
+    {
+        jobs.push_back({"DYNAREC TEST",fmt::format("DYNAREC_DIFF_{}",j),[rom,j](u32 worker, TestResult& result)
+        {
+            UNUSED(worker);
+
+            auto jit = std::make_unique<nintendo64::N64>();
+            auto ref = std::make_unique<nintendo64::N64>();
+
+            if(!jit->dynarec.code)
+            {
+                result.status = test_status::aborted;
+                result.message = "dynarec unavailable on this host";
+                return;
+            }
+
+            for(u32 p = 0; p < DYNAREC_DIFF_PROGRAMS; p++)
+            {
+                const u32 seed = (j * DYNAREC_DIFF_PROGRAMS) + p;
+
+                std::mt19937 rng(seed);
+                const auto program = diff_program(rng);
+
+                diff_setup(*jit,rom,program,seed);
+                nintendo64::set_dynarec_enabled(*jit,true);
+
+                diff_setup(*ref,rom,program,seed);
+                nintendo64::set_dynarec_enabled(*ref,false);
+
+                const auto diff = diff_run(*jit,*ref);
+
+                if(!diff.empty())
+                {
+                    result.status = test_status::fail;
+                    result.message = fmt::format("seed {}: {}",seed,diff);
+                    return;
+                }
+            }
+
+            result.status = test_status::pass;
+        }});
+    }
 }
 
-void print_test_pass(const std::string& suite_name, const std::vector<std::string> test_list)
+// the closed form random against stepping it once a cycle, for every start and wired value
+void n64_add_random_test(std::vector<TestJob>& jobs)
 {
-    print_test_result(suite_name,test_list,true);
+    jobs.push_back({"COP0 TEST","COP0_RANDOM_CLOSED_FORM",[](u32 worker, TestResult& result)
+    {
+        UNUSED(worker);
+
+        for(u32 wired = 0; wired < 64; wired++)
+        {
+            for(u32 start = 0; start < 64; start++)
+            {
+                u32 random = start;
+
+                for(u64 cycles = 0; cycles < 256; cycles++)
+                {
+                    const u32 v = nintendo64::random_after(start,wired,cycles);
+
+                    if(v != random)
+                    {
+                        result.status = test_status::fail;
+                        result.message = fmt::format("wired {} start {} after {} cycles: {} != {}",wired,start,cycles,v,random);
+                        return;
+                    }
+
+                    random = random == wired? 31 : (random - 1) & 63;
+                }
+            }
+        }
+
+        result.status = test_status::pass;
+    }});
 }
 
-void print_test_fail(const std::string& suite_name, const std::vector<std::string> test_list)
+// every cp2 computational op the krom tests cover, run against a plain per lane model of it
+// operands, accumulators and flags are random, with the clamp edges mixed in
+static constexpr u32 RSP_CP2_ITERATIONS = 20000;
+
+struct Cp2Op
+{
+    const char* name;
+    u32 funct;
+};
+
+static constexpr Cp2Op RSP_CP2_OPS[] = 
+{
+    {"VMULF",0x00},{"VMULU",0x01},{"VMUDL",0x04},{"VMUDM",0x05},
+    {"VMUDN",0x06},{"VMUDH",0x07},{"VMACF",0x08},{"VMACU",0x09},
+    {"VMADL",0x0c},{"VMADM",0x0d},{"VMADN",0x0e},{"VMADH",0x0f},
+    {"VADD",0x10},{"VSUB",0x11},{"VABS",0x13},{"VADDC",0x14},
+    {"VSUBC",0x15},{"VLT",0x20},{"VEQ",0x21},{"VNE",0x22},
+    {"VGE",0x23},{"VCL",0x24},{"VCH",0x25},{"VCR",0x26},
+    {"VMRG",0x27},{"VAND",0x28},{"VNAND",0x29},{"VOR",0x2a},
+    {"VNOR",0x2b},{"VXOR",0x2c},{"VNXOR",0x2d},
+};
+
+// one lane of the vector unit
+struct Cp2Lane
+{
+    s64 acc = 0;
+    u16 vd = 0;
+
+    b32 vco_lo = false;
+    b32 vco_hi = false;
+    b32 vcc_lo = false;
+    b32 vcc_hi = false;
+    b32 vce = false;
+
+    bool operator==(const Cp2Lane& other) const = default;
+};
+
+s64 cp2_sext48(s64 v)
 {
-    print_test_result(suite_name,test_list,false);
+    return (v << 16) >> 16;
 }
 
+u16 cp2_clamp_signed(s64 v)
+{
+    return u16(std::clamp<s64>(v,-32768,32767));
+}
 
-void n64_run_tests()
+u16 cp2_clamp_unsigned(s64 v)
 {
-    const auto [cpu_pass,cpu_fail] = run_test_list("CPU TEST","N64/CPUTest/CPU",CPU_TESTS,CPU_TEST_SIZE);
-    const auto [cp0_pass,cp0_fail] = run_test_list("COP0 TEST","N64/CPUTest/CP0",COP0_TESTS,COP0_TEST_SIZE);
-    const auto [cp1_pass,cp1_fail] = run_test_list("COP1 TEST","N64/CPUTest/CP1",COP1_TESTS,COP1_TEST_SIZE);
-    const auto [exception_pass,exception_fail] = run_test_list("EXCEPTION TEST","N64/CPUTest/Exceptions",EXCEPTION_TESTS,EXCEPTION_TEST_SIZE);
+    return v < 0? 0 : (v > 32767? 0xffff : u16(v));
+}
 
-    // Print a list of passes 
-    print_test_pass("CPU TEST",cpu_pass);
-    print_test_pass("COP0 TEST",cp0_pass);
-    print_test_pass("COP1 TEST",cp1_pass);
-    print_test_pass("EXCEPTION TEST",exception_pass);
+// the low half of the accumulator, saturated on the 32 bits above it
+u16 cp2_clamp_low(s64 acc)
+{
+    const s64 hi = acc >> 16;
+    return hi < -32768? 0 : (hi > 32767? 0xffff : u16(acc));
+}
 
-    // And failures
-    print_test_fail("CPU TEST",cpu_fail);
-    print_test_fail("COP0 TEST",cp0_fail);
-    print_test_fail("COP1 TEST",cp1_fail);
-    print_test_fail("EXCEPTION TEST",exception_fail);
+void cp2_write_low(Cp2Lane& lane, u16 v)
+{
+    lane.acc = (lane.acc & ~s64(0xffff)) | v;
+    lane.vd = v;
 }
-#endif
 
-void run_tests()
+void cp2_reference(Cp2Lane& lane, u32 funct, u16 us, u16 ut)
 {
-#ifdef GB_ENABLED
-    gb_run_tests();    
-#endif
+    const s16 ss = s16(us);
+    const s16 st = s16(ut);
 
-#ifdef N64_ENABLED 
-    n64_run_tests();
-#endif
+    switch(funct)
+    {
+        case 0x00: lane.acc = cp2_sext48((s64(ss) * st * 2) + 0x8000); lane.vd = cp2_clamp_signed(lane.acc >> 16); break;
+        case 0x01: lane.acc = cp2_sext48((s64(ss) * st * 2) + 0x8000); lane.vd = cp2_clamp_unsigned(lane.acc >> 16); break;
+        case 0x08: lane.acc = cp2_sext48(lane.acc + (s64(ss) * st * 2)); lane.vd = cp2_clamp_signed(lane.acc >> 16); break;
+        case 0x09: lane.acc = cp2_sext48(lane.acc + (s64(ss) * st * 2)); lane.vd = cp2_clamp_unsigned(lane.acc >> 16); break;
+
+        case 0x04: lane.acc = (u32(us) * ut) >> 16; lane.vd = u16(lane.acc); break;
+        case 0x0c: lane.acc = cp2_sext48(lane.acc + ((u32(us) * ut) >> 16)); lane.vd = cp2_clamp_low(lane.acc); break;
+
+        case 0x05: lane.acc = s64(ss) * ut; lane.vd = cp2_clamp_signed(lane.acc >> 16); break;
+        case 0x0d: lane.acc = cp2_sext48(lane.acc + (s64(ss) * ut)); lane.vd = cp2_clamp_signed(lane.acc >> 16); break;
+
+        case 0x06: lane.acc = s64(us) * st; lane.vd = cp2_clamp_low(lane.acc); break;
+        case 0x0e: lane.acc = cp2_sext48(lane.acc + (s64(us) * st)); lane.vd = cp2_clamp_low(lane.acc); break;
+
+        case 0x07: lane.acc = cp2_sext48((s64(ss) * st) << 16); lane.vd = cp2_clamp_signed(lane.acc >> 16); break;
+        case 0x0f: lane.acc = cp2_sext48(lane.acc + ((s64(ss) * st) << 16)); lane.vd = cp2_clamp_signed(lane.acc >> 16); break;
+
+        // add and sub take the carry in, and saturate what goes to vd but not the accumulator
+        case 0x10: case 0x11:
+        {
+            const s32 v = funct == 0x10? s32(ss) + st + lane.vco_lo : s32(ss) - st - lane.vco_lo;
+            cp2_write_low(lane,u16(v));
+            lane.vd = cp2_clamp_signed(v);
+            lane.vco_lo = false;
+            lane.vco_hi = false;
+            break;
+        }
+
+        case 0x13:
+        {
+            const s32 v = ss < 0? -s32(st) : (ss == 0? 0 : st);
+            cp2_write_low(lane,u16(v));
+            lane.vd = cp2_clamp_signed(v);
+            break;
+        }
+
+        case 0x14:
+        {
+            const u32 v = u32(us) + ut;
+            cp2_write_low(lane,u16(v));
+            lane.vco_lo = v > 0xffff;
+            lane.vco_hi = false;
+            break;
+        }
+
+        case 0x15:
+        {
+            const s32 v = s32(us) - ut;
+            cp2_write_low(lane,u16(v));
+            lane.vco_lo = v < 0;
+            lane.vco_hi = v != 0;
+            break;
+        }
+
+        // compares, vco_hi is not equal and vco_lo the carry from a previous vsubc
+        case 0x20: case 0x21: case 0x22: case 0x23:
+        {
+            b32 cond = false;
+
+            switch(funct)
+            {
+                case 0x20: cond = ss < st || (ss == st && lane.vco_lo && lane.vco_hi); break;
+                case 0x21: cond = ss == st && !lane.vco_hi; break;
+                case 0x22: cond = ss != st || lane.vco_hi; break;
+                case 0x23: cond = ss > st || (ss == st && !(lane.vco_lo && lane.vco_hi)); break;
+            }
+
+            cp2_write_low(lane,cond? us : ut);
+            lane.vcc_lo = cond;
+            lane.vcc_hi = false;
+            lane.vco_lo = false;
+            lane.vco_hi = false;
+            break;
+        }
+
+        // low half of a double precision clip, picks up where vch left the flags
+        case 0x24:
+        {
+            if(lane.vco_lo)
+            {
+                if(!lane.vco_hi)
+                {
+                    const u32 sum = u32(us) + ut;
+                    const b32 zero = !u16(sum);
+                    const b32 carry = sum > 0xffff;
+                    lane.vcc_lo = lane.vce? (zero || !carry) : (zero && !carry);
+                }
+
+                cp2_write_low(lane,lane.vcc_lo? u16(-ut) : us);
+            }
+
+            else
+            {
+                if(!lane.vco_hi)
+                {
+                    lane.vcc_hi = s32(us) - s32(ut) >= 0;
+                }
+
+                cp2_write_low(lane,lane.vcc_hi? ut : us);
+            }
+
+            lane.vco_lo = false;
+            lane.vco_hi = false;
+            lane.vce = false;
+            break;
+        }
 
+        case 0x25:
+        {
+            const b32 sign = (ss ^ st) < 0;
+            const s32 v = sign? s32(ss) + st : s32(ss) - st;
+
+            if(sign)
+            {
+                lane.vcc_lo = v <= 0;
+                lane.vcc_hi = st < 0;
+                cp2_write_low(lane,lane.vcc_lo? u16(-ut) : us);
+            }
+
+            else
+            {
+                lane.vcc_lo = st < 0;
+                lane.vcc_hi = v >= 0;
+                cp2_write_low(lane,lane.vcc_hi? ut : us);
+            }
+
+            lane.vco_lo = sign;
+            lane.vco_hi = v != 0 && us != u16(~ut);
+            lane.vce = sign && v == -1;
+            break;
+        }
+
+        // single precision clip against the ones complement
+        case 0x26:
+        {
+            if((ss ^ st) < 0)
+            {
+                lane.vcc_hi = st < 0;
+                lane.vcc_lo = s32(ss) + st + 1 <= 0;
+                cp2_write_low(lane,lane.vcc_lo? u16(~ut) : us);
+            }
+
+            else
+            {
+                lane.vcc_lo = st < 0;
+                lane.vcc_hi = s32(ss) - st >= 0;
+                cp2_write_low(lane,lane.vcc_hi? ut : us);
+            }
+
+            lane.vco_lo = false;
+            lane.vco_hi = false;
+            lane.vce = false;
+            break;
+        }
+
+        case 0x27:
+        {
+            cp2_write_low(lane,lane.vcc_lo? us : ut);
+            lane.vco_lo = false;
+            lane.vco_hi = false;
+            break;
+        }
+
+        case 0x28: cp2_write_low(lane,us & ut); break;
+        case 0x29: cp2_write_low(lane,~(us & ut)); break;
+        case 0x2a: cp2_write_low(lane,us | ut); break;
+        case 0x2b: cp2_write_low(lane,~(us | ut)); break;
+        case 0x2c: cp2_write_low(lane,us ^ ut); break;
+        case 0x2d: cp2_write_low(lane,~(us ^ ut)); break;
+    }
+}
+
+// lane of vt an element specifier reads for each lane
+u32 cp2_element(u32 e, u32 lane)
+{
+    if(e < 2)
+    {
+        return lane;
+    }
+
+    if(e < 4)
+    {
+        return (lane & ~1) | (e & 1);
+    }
+
+    if(e < 8)
+    {
+        return (lane & ~3) | (e & 3);
+    }
+
+    return e & 7;
+}
+
+Cp2Lane cp2_read_lane(const nintendo64::VectorUnit& vu, u32 vd, u32 i)
+{
+    Cp2Lane lane;
+    lane.acc = cp2_sext48((s64(vu.acc_hi.lane[i]) << 32) | (s64(vu.acc_md.lane[i]) << 16) | vu.acc_lo.lane[i]);
+    lane.vd = vu.regs[vd].lane[i];
+
+    lane.vco_lo = vu.vco_lo.lane[i] != 0;
+    lane.vco_hi = vu.vco_hi.lane[i] != 0;
+    lane.vcc_lo = vu.vcc_lo.lane[i] != 0;
+    lane.vcc_hi = vu.vcc_hi.lane[i] != 0;
+    lane.vce = vu.vce.lane[i] != 0;
+
+    return lane;
+}
+
+void n64_add_rsp_tests(std::vector<TestJob>& jobs)
+{
+    for(const auto& op : RSP_CP2_OPS)
+    {
+        jobs.push_back({"RSP TEST",fmt::format("RSP_CP2_{}",op.name),[&op](u32 worker, TestResult& result)
+        {
+            UNUSED(worker);
+
+            auto n64 = std::make_unique<nintendo64::N64>();
+            auto& vu = n64->rsp.vu;
+
+            std::mt19937 rng(op.funct);
+
+            const auto operand = [&rng]() -> u16
+            {
+                static constexpr u16 EDGES[] = {0x0000,0x0001,0x7fff,0x8000,0x8001,0xffff};
+                return rng() & 1? EDGES[rng() % 6] : u16(rng());
+            };
+
+            const auto flag = [&rng]() -> u16
+            {
+                return rng() & 1? 0xffff : 0;
+            };
+
+            for(u32 it = 0; it < RSP_CP2_ITERATIONS; it++)
+            {
+                for(auto& reg : vu.regs)
+                {
+                    for(auto& v : reg.lane)
+                    {
+                        v = operand();
+                    }
+                }
+
+                for(u32 i = 0; i < 8; i++)
+                {
+                    // small accumulators as well so the clamps get hit from both sides
+                    const s64 acc = rng() & 1? cp2_sext48((s64(rng()) << 32) ^ rng()) : cp2_sext48(s64(s16(operand())) << 16);
+                    vu.acc_hi.lane[i] = u16(acc >> 32);
+                    vu.acc_md.lane[i] = u16(acc >> 16);
+                    vu.acc_lo.lane[i] = u16(acc);
+
+                    vu.vco_lo.lane[i] = flag();
+                    vu.vco_hi.lane[i] = flag();
+                    vu.vcc_lo.lane[i] = flag();
+                    vu.vcc_hi.lane[i] = flag();
+                    vu.vce.lane[i] = flag();
+                }
+
+                const u32 e = rng() % 16;
+                const u32 vt = rng() % 32;
+                const u32 vs = rng() % 32;
+                const u32 vd = rng() % 32;
+
+                // vd may be one of the sources
+                const auto source = vu.regs[vs];
+                Cp2Lane expected[8];
+
+                for(u32 i = 0; i < 8; i++)
+                {
+                    expected[i] = cp2_read_lane(vu,vd,i);
+                    cp2_reference(expected[i],op.funct,source.lane[i],vu.regs[vt].lane[cp2_element(e,i)]);
+                }
+
+                const u32 opcode = (0x12 << 26) | (1 << 25) | (e << 21) | (vt << 16) | (vs << 11) | (vd << 6) | op.funct;
+                nintendo64::rsp_cop2(*n64,opcode);
+
+                for(u32 i = 0; i < 8; i++)
+                {
+                    const auto lane = cp2_read_lane(vu,vd,i);
+
+                    if(lane != expected[i])
+                    {
+                        result.status = test_status::fail;
+                        result.message = fmt::format("e {} lane {} vs {:04x}: vd {:04x} != {:04x}, acc {:012x} != {:012x}, vco {:d}{:d} != {:d}{:d}, vcc {:d}{:d} != {:d}{:d}, vce {:d} != {:d}",
+                            e,i,source.lane[i],lane.vd,expected[i].vd,lane.acc & 0xffff'ffff'ffff,expected[i].acc & 0xffff'ffff'ffff,
+                            lane.vco_hi,lane.vco_lo,expected[i].vco_hi,expected[i].vco_lo,lane.vcc_hi,lane.vcc_lo,expected[i].vcc_hi,expected[i].vcc_lo,
+                            lane.vce,expected[i].vce);
+                        return;
+                    }
+                }
+            }
+
+            result.status = test_status::pass;
+        }});
+    }
+}
+
+// fill rectangles and fill triangles put through the dp regs and compared against a plain per pixel model
+// each list is rasterised on the calling thread and across the band workers, both have to match it
+// fill mode is what the krom fill tests use, the model samples pixel centres as the rasteriser does
+static constexpr u32 RDP_TEST_WIDTH = 320;
+static constexpr u32 RDP_TEST_HEIGHT = 240;
+static constexpr u32 RDP_TEST_LIST = 0x0000'1000;
+static constexpr u32 RDP_TEST_IMAGE = 0x0010'0000;
+static constexpr u32 RDP_TEST_DRAWS = 32;
+
+// pixel sizes as set color image encodes them
+static constexpr u32 RDP_IMAGE_SIZE_16 = 2;
+static constexpr u32 RDP_IMAGE_SIZE_32 = 3;
+
+// centres closer to an edge than this are left out, the edge walker steps in 16.16 fixed point
+static constexpr f64 RDP_TEST_EDGE_SLACK = 1.0 / 256.0;
+
+struct RdpTestList
+{
+    std::vector<u64> words;
+
+    // pixel value each pixel should end up with, -1 for ones too close to an edge to call
+    std::vector<s64> expected;
+};
+
+u64 rdp_command(u32 cmd)
+{
+    return u64(cmd) << 56;
+}
+
+u64 rdp_fill_rect(u32 xh, u32 yh, u32 xl, u32 yl)
+{
+    return rdp_command(0x36) | (u64(xl) << 44) | (u64(yl) << 32) | (u64(xh) << 12) | yh;
+}
+
+// pixel the fill color writes at x, 16 bit colors hold the even pixel in the top half
+u32 rdp_fill_pixel(u32 fill_color, u32 size, u32 x)
+{
+    return size == RDP_IMAGE_SIZE_16? ((x & 1)? fill_color & 0xffff : fill_color >> 16) : fill_color;
+}
+
+void rdp_model_fill(RdpTestList& list, u32 fill_color, u32 size, u32 x, u32 y)
+{
+    list.expected[(y * RDP_TEST_WIDTH) + x] = rdp_fill_pixel(fill_color,size,x);
+}
+
+RdpTestList rdp_test_list(u32 size, b32 triangles, u32 seed)
+{
+    std::mt19937 rng(seed);
+
+    RdpTestList list;
+    list.expected.resize(RDP_TEST_WIDTH * RDP_TEST_HEIGHT);
+
+    const auto color = [&rng]()
+    {
+        return u32(rng()) | 0x0001'0001;
+    };
+
+    list.words.push_back(rdp_command(0x3f) | (u64(size) << 51) | (u64(RDP_TEST_WIDTH - 1) << 32) | RDP_TEST_IMAGE);
+    list.words.push_back(rdp_command(0x2d) | (u64(RDP_TEST_WIDTH << 2) << 12) | (RDP_TEST_HEIGHT << 2));
+    list.words.push_back(rdp_command(0x2f) | (u64(u32(nintendo64::rdp_cycle::fill)) << 52));
+
+    // clear the screen first, fill rects include their far edges
+    u32 fill_color = color();
+    list.words.push_back(rdp_command(0x37) | fill_color);
+    list.words.push_back(rdp_fill_rect(0,0,(RDP_TEST_WIDTH - 1) << 2,(RDP_TEST_HEIGHT - 1) << 2));
+
+    for(u32 y = 0; y < RDP_TEST_HEIGHT; y++)
+    {
+        for(u32 x = 0; x < RDP_TEST_WIDTH; x++)
+        {
+            rdp_model_fill(list,fill_color,size,x,y);
+        }
+    }
+
+    for(u32 d = 0; d < RDP_TEST_DRAWS; d++)
+    {
+        fill_color = color();
+        list.words.push_back(rdp_command(0x37) | fill_color);
+
+        if(!triangles)
+        {
+            // odd and even edges, and some that run off the right and bottom of the scissor
+            const u32 x0 = rng() % RDP_TEST_WIDTH;
+            const u32 y0 = rng() % RDP_TEST_HEIGHT;
+            const u32 x1 = x0 + (rng() % 96);
+            const u32 y1 = y0 + (rng() % 64);
+
+            // the fraction bits are dropped in fill mode
+            list.words.push_back(rdp_fill_rect((x0 << 2) | (rng() & 3),(y0 << 2) | (rng() & 3),(x1 << 2) | (rng() & 3),(y1 << 2) | (rng() & 3)));
+
+            for(u32 y = y0; y <= std::min(y1,RDP_TEST_HEIGHT - 1); y++)
+            {
+                for(u32 x = x0; x <= std::min(x1,RDP_TEST_WIDTH - 1); x++)
+                {
+                    rdp_model_fill(list,fill_color,size,x,y);
+                }
+            }
+
+            continue;
+        }
+
+        // vertices on whole rows, at any eighth of a pixel across, sorted top to bottom
+        f64 vx[3];
+        s32 vy[3];
+
+        for(u32 i = 0; i < 3; i++)
+        {
+            vx[i] = f64(rng() % (RDP_TEST_WIDTH * 8)) / 8.0;
+            vy[i] = rng() % RDP_TEST_HEIGHT;
+        }
+
+        for(u32 i = 0; i < 2; i++)
+        {
+            for(u32 j = 0; j < 2 - i; j++)
+            {
+                if(vy[j] > vy[j + 1])
+                {
+                    std::swap(vy[j],vy[j + 1]);
+                    std::swap(vx[j],vx[j + 1]);
+                }
+            }
+        }
+
+        if(vy[0] == vy[2])
+        {
+            continue;
+        }
+
+        const auto fixed = [](f64 v)
+        {
+            return s32(std::lround(v * 65536.0));
+        };
+
+        const auto slope = [](f64 x0, s32 y0, f64 x1, s32 y1)
+        {
+            return y1 == y0? 0.0 : (x1 - x0) / f64(y1 - y0);
+        };
+
+        // the major edge runs top to bottom, the minor edges meet at the middle vertex
+        const s32 xh = fixed(vx[0]);
+        const s32 dxhdy = fixed(slope(vx[0],vy[0],vx[2],vy[2]));
+        const s32 xm = fixed(vx[0]);
+        const s32 dxmdy = fixed(slope(vx[0],vy[0],vx[1],vy[1]));
+        const s32 xl = fixed(vx[1]);
+        const s32 dxldy = fixed(slope(vx[1],vy[1],vx[2],vy[2]));
+
+        const auto edge = [](s32 x, s32 dxdy, f64 dy)
+        {
+            return (f64(x) + (f64(dxdy) * dy)) / 65536.0;
+        };
+
+        const b32 left_major = edge(xh,dxhdy,vy[1] - vy[0]) < f64(xl) / 65536.0;
+
+        list.words.push_back(rdp_command(0x08) | (u64(left_major) << 55) | (u64(vy[2] << 2) << 32) | (u64(vy[1] << 2) << 16) | u64(vy[0] << 2));
+        list.words.push_back((u64(u32(xl)) << 32) | u32(dxldy));
+        list.words.push_back((u64(u32(xh)) << 32) | u32(dxhdy));
+        list.words.push_back((u64(u32(xm)) << 32) | u32(dxmdy));
+
+        for(s32 y = vy[0]; y < vy[2]; y++)
+        {
+            const f64 centre_y = f64(y) + 0.5;
+            const f64 major = edge(xh,dxhdy,centre_y - vy[0]);
+            const f64 minor = centre_y < vy[1]? edge(xm,dxmdy,centre_y - vy[0]) : edge(xl,dxldy,centre_y - vy[1]);
+
+            const f64 left = left_major? major : minor;
+            const f64 right = left_major? minor : major;
+
+            for(u32 x = 0; x < RDP_TEST_WIDTH; x++)
+            {
+                const f64 centre_x = f64(x) + 0.5;
+
+                if(std::abs(centre_x - left) < RDP_TEST_EDGE_SLACK || std::abs(centre_x - right) < RDP_TEST_EDGE_SLACK)
+                {
+                    list.expected[(y * RDP_TEST_WIDTH) + x] = -1;
+                }
+
+                else if(centre_x > left && centre_x < right)
+                {
+                    rdp_model_fill(list,fill_color,size,x,y);
+                }
+            }
+        }
+    }
+
+    list.words.push_back(rdp_command(0x29));
+
+    return list;
+}
+
+u32 rdp_test_pixel(nintendo64::N64& n64, u32 size, u32 x, u32 y)
+{
+    const u32 addr = RDP_TEST_IMAGE + ((((y * RDP_TEST_WIDTH) + x) << size) >> 1);
+
+    // words are held in host order, with the even 16 bit pixel in the top half
+    u32 word = 0;
+    memcpy(&word,&n64.mem.rd_ram[addr & ~3],sizeof(word));
+
+    return size == RDP_IMAGE_SIZE_16? ((addr & 2)? word & 0xffff : word >> 16) : word;
+}
+
+// opaque rgba for a failure image
+u32 rdp_test_rgba(u32 size, u32 v)
+{
+    if(size == RDP_IMAGE_SIZE_16)
+    {
+        const auto channel = [v](u32 shift)
+        {
+            return ((v >> shift) & 0x1f) << 3;
+        };
+
+        return 0xff00'0000 | (channel(1) << 16) | (channel(6) << 8) | channel(11);
+    }
+
+    return 0xff00'0000 | ((v >> 8) & 0xff) << 16 | ((v >> 16) & 0xff) << 8 | (v >> 24);
+}
+
+std::string rdp_run_list(nintendo64::N64& n64, const RdpTestList& list, u32 size, u32 threads, const std::string& name)
+{
+    nintendo64::set_rdp_threads(n64,threads);
+    memset(&n64.mem.rd_ram[RDP_TEST_IMAGE],0,RDP_TEST_WIDTH * RDP_TEST_HEIGHT * sizeof(u32));
+
+    for(u32 i = 0; i < list.words.size(); i++)
+    {
+        const u32 hi = list.words[i] >> 32;
+        const u32 lo = u32(list.words[i]);
+        memcpy(&n64.mem.rd_ram[RDP_TEST_LIST + (i * 8) + 0],&hi,sizeof(hi));
+        memcpy(&n64.mem.rd_ram[RDP_TEST_LIST + (i * 8) + 4],&lo,sizeof(lo));
+    }
+
+    auto& dp = n64.mem.dp_regs;
+    dp.start = RDP_TEST_LIST;
+    dp.current = RDP_TEST_LIST;
+    dp.end = RDP_TEST_LIST + (list.words.size() * 8);
+
+    nintendo64::run_rdp_commands(n64);
+    nintendo64::flush_rdp(n64);
+
+    std::string diff;
+    u32 unchecked = 0;
+
+    for(u32 y = 0; y < RDP_TEST_HEIGHT && diff.empty(); y++)
+    {
+        for(u32 x = 0; x < RDP_TEST_WIDTH; x++)
+        {
+            const s64 expected = list.expected[(y * RDP_TEST_WIDTH) + x];
+            const u32 v = rdp_test_pixel(n64,size,x,y);
+
+            if(expected < 0)
+            {
+                unchecked++;
+            }
+
+            else if(v != u32(expected))
+            {
+                diff = fmt::format("{} threads: pixel ({},{}) {:x} != {:x}",threads,x,y,v,expected);
+                break;
+            }
+        }
+    }
+
+    if(!diff.empty())
+    {
+        std::vector<u32> screen(RDP_TEST_WIDTH * RDP_TEST_HEIGHT);
+
+        for(u32 i = 0; i < screen.size(); i++)
+        {
+            screen[i] = rdp_test_rgba(size,rdp_test_pixel(n64,size,i % RDP_TEST_WIDTH,i / RDP_TEST_WIDTH));
+        }
+
+        std::filesystem::create_directories("fail");
+        write_test_image(fmt::format("fail/{}.png",name),screen,RDP_TEST_WIDTH,RDP_TEST_HEIGHT);
+    }
+
+    // a model that can not call any pixel does not test anything
+    else if(unchecked > (RDP_TEST_WIDTH * RDP_TEST_HEIGHT) / 100)
+    {
+        diff = fmt::format("{} pixels too close to an edge to check",unchecked);
+    }
+
+    return diff;
+}
+
+struct RdpTest
+{
+    const char* name;
+    u32 size;
+    b32 triangles;
+};
+
+static constexpr RdpTest RDP_TESTS[] = 
+{
+    {"RDP_FILL_RECT_16BPP",RDP_IMAGE_SIZE_16,false},
+    {"RDP_FILL_RECT_32BPP",RDP_IMAGE_SIZE_32,false},
+    {"RDP_FILL_TRIANGLE_16BPP",RDP_IMAGE_SIZE_16,true},
+    {"RDP_FILL_TRIANGLE_32BPP",RDP_IMAGE_SIZE_32,true},
+};
+
+void n64_add_rdp_tests(std::vector<TestJob>& jobs)
+{
+    const std::string rom = blank_test_rom();
+
+    for(u32 t = 0; t < sizeof(RDP_TESTS) / sizeof(RdpTest); t++)
+    {
+        const RdpTest& test = RDP_TESTS[t];
+
+        jobs.push_back({"RDP TEST",test.name,[rom,&test,t](u32 worker, TestResult& result)
+        {
+            UNUSED(worker);
+
+            auto n64 = std::make_unique<nintendo64::N64>();
+            nintendo64::reset(*n64,rom);
+
+            const auto list = rdp_test_list(test.size,test.triangles,t);
+
+            for(const u32 threads : {0,4})
+            {
+                const auto diff = rdp_run_list(*n64,list,test.size,threads,test.name);
+
+                if(!diff.empty())
+                {
+                    result.status = test_status::fail;
+                    result.message = diff;
+                    return;
+                }
+            }
+
+            result.status = test_status::pass;
+        }});
+    }
+}
+
+void n64_add_suites(std::vector<TestJob>& jobs, std::vector<std::unique_ptr<nintendo64::N64>>& instances)
+{
+    n64_add_tests(jobs,instances,"CPU TEST","N64/CPUTest/CPU",CPU_TESTS,CPU_TEST_SIZE);
+    n64_add_tests(jobs,instances,"COP0 TEST","N64/CPUTest/CP0",COP0_TESTS,COP0_TEST_SIZE);
+    n64_add_tests(jobs,instances,"COP1 TEST","N64/CPUTest/CP1",COP1_TESTS,COP1_TEST_SIZE);
+    n64_add_tests(jobs,instances,"EXCEPTION TEST","N64/CPUTest/Exceptions",EXCEPTION_TESTS,EXCEPTION_TEST_SIZE);
+    n64_add_rsp_tests(jobs);
+    n64_add_rdp_tests(jobs);
+    n64_add_dynarec_tests(jobs);
+    n64_add_random_test(jobs);
+}
+#endif
+
+std::string json_escape(const std::string& str)
+{
+    std::string out;
+
+    for(const char c : str)
+    {
+        switch(c)
+        {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+
+            default:
+            {
+                if(u8(c) < 0x20)
+                {
+                    out += fmt::format("\\u{:04x}",u8(c));
+                }
+
+                else
+                {
+                    out += c;
+                }
+                break;
+            }
+        }
+    }
+
+    return out;
+}
+
+std::string xml_escape(const std::string& str)
+{
+    std::string out;
+
+    for(const char c : str)
+    {
+        switch(c)
+        {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            case '\'': out += "&apos;"; break;
+            default: out += c; break;
+        }
+    }
+
+    return out;
+}
+
+// results grouped by suite in the order the suites were added
+std::vector<std::pair<std::string,std::vector<const TestResult*>>> group_results(const std::vector<TestResult>& results)
+{
+    std::vector<std::pair<std::string,std::vector<const TestResult*>>> suites;
+
+    for(const auto& result : results)
+    {
+        if(suites.empty() || suites.back().first != result.suite)
+        {
+            suites.push_back({result.suite,{}});
+        }
+
+        suites.back().second.push_back(&result);
+    }
+
+    return suites;
+}
+
+void write_junit(const std::string& filename, const std::vector<TestResult>& results, f64 seconds)
+{
+    std::ofstream fp(filename);
+
+    if(!fp)
+    {
+        spdlog::error("cannot open junit output {}",filename);
+        return;
+    }
+
+    u32 failures = 0;
+    u32 errors = 0;
+
+    for(const auto& result : results)
+    {
+        failures += result.status == test_status::fail || result.status == test_status::timeout;
+        errors += result.status == test_status::aborted;
+    }
+
+    fp << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    fp << fmt::format("<testsuites tests=\"{}\" failures=\"{}\" errors=\"{}\" time=\"{:.3f}\">\n",results.size(),failures,errors,seconds);
+
+    for(const auto& [suite,tests] : group_results(results))
+    {
+        u32 suite_failures = 0;
+        u32 suite_errors = 0;
+        f64 suite_time = 0.0;
+
+        for(const auto* result : tests)
+        {
+            suite_failures += result->status == test_status::fail || result->status == test_status::timeout;
+            suite_errors += result->status == test_status::aborted;
+            suite_time += result->seconds;
+        }
+
+        fp << fmt::format("  <testsuite name=\"{}\" tests=\"{}\" failures=\"{}\" errors=\"{}\" time=\"{:.3f}\">\n",
+            xml_escape(suite),tests.size(),suite_failures,suite_errors,suite_time);
+
+        for(const auto* result : tests)
+        {
+            fp << fmt::format("    <testcase classname=\"{}\" name=\"{}\" time=\"{:.3f}\">\n",xml_escape(suite),xml_escape(result->name),result->seconds);
+            fp << fmt::format("      <properties><property name=\"frames\" value=\"{}\"/><property name=\"fps\" value=\"{:.1f}\"/></properties>\n",
+                result->frames,result->fps());
+
+            switch(result->status)
+            {
+                case test_status::pass: break;
+
+                case test_status::fail:
+                case test_status::timeout:
+                {
+                    fp << fmt::format("      <failure type=\"{}\" message=\"{}\"/>\n",test_status_name(result->status),xml_escape(result->message));
+                    break;
+                }
+
+                case test_status::aborted:
+                {
+                    fp << fmt::format("      <error type=\"aborted\" message=\"{}\"/>\n",xml_escape(result->message));
+                    break;
+                }
+            }
+
+            fp << "    </testcase>\n";
+        }
+
+        fp << "  </testsuite>\n";
+    }
+
+    fp << "</testsuites>\n";
+}
+
+void write_json(const std::string& filename, const std::vector<TestResult>& results, f64 seconds, u32 threads)
+{
+    std::ofstream fp(filename);
+
+    if(!fp)
+    {
+        spdlog::error("cannot open json output {}",filename);
+        return;
+    }
+
+    fp << fmt::format("{{\n  \"threads\": {},\n  \"time\": {:.3f},\n  \"tests\": [\n",threads,seconds);
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const auto& result = results[i];
+
+        fp << fmt::format("    {{\"suite\": \"{}\", \"name\": \"{}\", \"status\": \"{}\", \"message\": \"{}\", \"frames\": {}, \"time\": {:.3f}, \"fps\": {:.1f}}}{}\n",
+            json_escape(result.suite),json_escape(result.name),test_status_name(result.status),json_escape(result.message),
+            result.frames,result.seconds,result.fps(),i + 1 == results.size()? "" : ",");
+    }
+
+    fp << "  ]\n}\n";
+}
+
+void print_results(const std::vector<TestResult>& results)
+{
+    for(const auto& [suite,tests] : group_results(results))
+    {
+        u32 count[4] = {0};
+        u64 frames = 0;
+        f64 time = 0.0;
+
+        for(const auto* result : tests)
+        {
+            count[u32(result->status)]++;
+            frames += result->frames;
+            time += result->seconds;
+
+            // we are passing so many compared to fails at this point
+            // it doesnt make sense to print them
+            if(result->status != test_status::pass)
+            {
+                spdlog::error("{}: {} {} ({} frames, {:.1f} fps)",result->name,test_status_name(result->status),
+                    result->message,result->frames,result->fps());
+            }
+        }
+
+        spdlog::info("---------- {} ({}) -------",suite,tests.size());
+        spdlog::info("pass: {}",count[u32(test_status::pass)]);
+        spdlog::info("fail: {}",count[u32(test_status::fail)]);
+        spdlog::info("abort: {}",count[u32(test_status::aborted)]);
+        spdlog::info("timeout: {}",count[u32(test_status::timeout)]);
+        spdlog::info("emulated {} frames in {:.3f}s of worker time ({:.1f} fps)",frames,time,time > 0.0? f64(frames) / time : 0.0);
+    }
+}
+
+// thread count for -j, anything we cant use falls back to the default
+u32 parse_test_threads(const std::string& str)
+{
+    const s64 max_threads = std::max(1u,std::thread::hardware_concurrency());
+    s64 threads = 0;
+
+    try
+    {
+        size_t len = 0;
+        threads = std::stoll(str,&len);
+
+        if(len != str.size())
+        {
+            threads = 0;
+        }
+    }
+
+    catch(...)
+    {
+        threads = 0;
+    }
+
+    if(threads <= 0)
+    {
+        spdlog::error("invalid thread count {}, using {}",str,max_threads);
+        return 0;
+    }
+
+    // more workers than cores just fight over them
+    if(threads > max_threads)
+    {
+        spdlog::warn("thread count {} capped to {}",threads,max_threads);
+        return u32(max_threads);
+    }
+
+    return u32(threads);
+}
+
+// -t [-j threads] [--junit file] [--json file]
+TestOptions parse_test_options(int argc, char *argv[])
+{
+    TestOptions options;
+
+    for(int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if(i + 1 >= argc)
+        {
+            spdlog::error("test option {} is missing its value",arg);
+            break;
+        }
+
+        if(arg == "-j")
+        {
+            options.threads = parse_test_threads(argv[++i]);
+        }
+
+        else if(arg == "--junit")
+        {
+            options.junit_path = argv[++i];
+        }
+
+        else if(arg == "--json")
+        {
+            options.json_path = argv[++i];
+        }
+
+        else
+        {
+            spdlog::error("unknown test option {}",arg);
+        }
+    }
+
+    return options;
+}
+
+void run_tests(const TestOptions& options)
+{
+    ThreadPool pool(options.threads);
+
+    std::vector<TestJob> jobs;
+
+#ifdef GB_ENABLED
+    std::vector<std::unique_ptr<gameboy::GB>> gb_instances(pool.size());
+    gb_add_suites(jobs,gb_instances);
+#endif
+
+#ifdef N64_ENABLED
+    std::vector<std::unique_ptr<nintendo64::N64>> n64_instances(pool.size());
+    n64_add_suites(jobs,n64_instances);
+#endif
+
+    spdlog::info("running {} tests on {} threads",jobs.size(),pool.size());
+
+    std::vector<TestResult> results(jobs.size());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        pool.submit([&jobs,&results,i](u32 worker)
+        {
+            auto& job = jobs[i];
+            auto& result = results[i];
+
+            result.suite = job.suite;
+            result.name = job.name;
+
+            const auto test_start = std::chrono::steady_clock::now();
+
+            try
+            {
+                job.run(worker,result);
+            }
+
+            catch(std::exception &ex)
+            {
+                result.status = test_status::aborted;
+                result.message = ex.what();
+            }
+
+            const auto test_end = std::chrono::steady_clock::now();
+            result.seconds = f64(std::chrono::duration_cast<std::chrono::microseconds>(test_end - test_start).count()) / 1000'000.0;
+        });
+    }
+
+    pool.wait();
+
+    const auto end = std::chrono::steady_clock::now();
+    const f64 seconds = f64(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()) / 1000.0;
+
+    print_results(results);
+    spdlog::info("total: {} tests in {:.3f}s",results.size(),seconds);
+
+    if(!options.junit_path.empty())
+    {
+        write_junit(options.junit_path,results,seconds);
+    }
+
+    if(!options.json_path.empty())
+    {
+        write_json(options.json_path,results,seconds,pool.size());
+    }
 }